@@ -0,0 +1,54 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   bench.h                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:09:38 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 18:51:03 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef BENCH_H
+# define BENCH_H
+
+# include "nm.h"
+# include <stdio.h>
+# include <time.h>
+# if defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+# endif
+
+# define BENCH_SEED	42
+
+typedef struct s_bench_clock
+{
+	uint64_t	ns;
+	uint64_t	cycles;
+}	t_bench_clock;
+
+/* BENCH_MAIN */
+uint64_t	bench_now_ns(void);
+uint64_t	bench_now_cycles(void);
+uint32_t	bench_rand(uint32_t *state);
+void		bench_start(t_bench_clock *clock);
+void		bench_report(const char *name, const t_bench_clock *start, size_t ops, size_t bytes);
+char		*bench_corpus(size_t count, size_t *offsets, size_t *lens, size_t *total);
+
+/* BENCH_COLLATE */
+int			bench_collate_verify(void);
+void		bench_collate_run(void);
+
+/* BENCH_NAMES */
+int			bench_names_verify(void);
+void		bench_names_run(void);
+
+/* BENCH_CLASSIFY */
+int			bench_classify_verify(void);
+void		bench_classify_run(void);
+
+/* BENCH_FORMAT */
+void		bench_format_run(void);
+
+#endif
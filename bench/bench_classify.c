@@ -0,0 +1,147 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   bench_classify.c                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:48:01 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 18:51:03 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "bench.h"
+
+#define SYMBOLS		1000000
+#define SECTIONS	24
+#define REPEAT		20
+
+/**
+ * Builds a seeded section header table covering the classes nm tells apart:
+ * code, data, read-only data, bss, TLS and other sections.
+ * @param	shdrs	The table to fill, SECTIONS entries.
+ */
+static void	build_sections(Elf64_Shdr *shdrs)
+{
+	static const struct {
+		uint32_t	type;
+		uint64_t	flags;
+	}				kinds[] = {
+		{SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR}, {SHT_PROGBITS, SHF_ALLOC | SHF_WRITE},
+		{SHT_PROGBITS, SHF_ALLOC}, {SHT_NOBITS, SHF_ALLOC | SHF_WRITE},
+		{SHT_NOBITS, SHF_ALLOC | SHF_WRITE | SHF_TLS}, {SHT_INIT_ARRAY, SHF_ALLOC | SHF_WRITE},
+		{SHT_DYNAMIC, SHF_ALLOC | SHF_WRITE}, {SHT_PROGBITS, 0}, {SHT_NOTE, SHF_ALLOC},
+	};
+	uint32_t		seed = BENCH_SEED;
+
+	ft_bzero(shdrs, sizeof(Elf64_Shdr) * SECTIONS);
+	for (size_t i = 1; i < SECTIONS; i++)
+	{
+		size_t	k = bench_rand(&seed) % (sizeof(kinds) / sizeof(*kinds));
+
+		shdrs[i].sh_type = kinds[k].type;
+		shdrs[i].sh_flags = kinds[k].flags;
+	}
+}
+
+/**
+ * Builds a seeded symbol table: mostly global and local functions and
+ * objects, with weak, undefined, absolute and common symbols mixed in.
+ * @return	The symbols, or NULL.
+ */
+static Elf64_Sym	*build_symbols(void)
+{
+	static const uint8_t	binds[] = {STB_LOCAL, STB_GLOBAL, STB_GLOBAL, STB_WEAK, STB_GNU_UNIQUE};
+	static const uint8_t	types[] = {STT_FUNC, STT_OBJECT, STT_NOTYPE, STT_TLS, STT_GNU_IFUNC, STT_SECTION};
+	Elf64_Sym				*syms = ft_calloc(SYMBOLS, sizeof(Elf64_Sym));
+	uint32_t				seed = BENCH_SEED;
+
+	for (size_t i = 0; syms && i < SYMBOLS; i++)
+	{
+		uint32_t	r = bench_rand(&seed);
+
+		syms[i].st_info = ELF64_ST_INFO(binds[r % sizeof(binds)], types[(r >> 8) % sizeof(types)]);
+		syms[i].st_shndx = (r >> 16) % (SECTIONS + 2);
+		if (syms[i].st_shndx == SECTIONS)
+			syms[i].st_shndx = SHN_ABS;
+		else if (syms[i].st_shndx == SECTIONS + 1)
+			syms[i].st_shndx = SHN_COMMON;
+	}
+	return (syms);
+}
+
+/**
+ * Checks the table-driven classifier against ft_define_symbol64, symbol by
+ * symbol, on the seeded table.
+ * @return	0 if every letter matches, 1 otherwise.
+ */
+int	bench_classify_verify(void)
+{
+	Elf64_Shdr		shdrs[SECTIONS];
+	Elf64_Sym		*syms = build_symbols();
+	t_classifier	c;
+	unsigned char	letters[CLASSIFY_BLOCK];
+	int				ret = 0;
+
+	build_sections(shdrs);
+	if (syms == NULL || ft_classify_init(&c, shdrs, SECTIONS, 1, NULL))
+	{
+		free(syms);
+		return (1);
+	}
+	for (size_t i = 0; !ret && i < SYMBOLS; i += CLASSIFY_BLOCK)
+	{
+		size_t	n = (SYMBOLS - i < CLASSIFY_BLOCK) ? SYMBOLS - i : CLASSIFY_BLOCK;
+
+		ft_classify_block64(&c, syms + i, n, ELFDATA2LSB, letters);
+		for (size_t k = 0; !ret && k < n; k++)
+			if (letters[k] != ft_define_symbol64(&syms[i + k], shdrs, ELFDATA2LSB))
+			{
+				printf("classify: '%c' instead of '%c' for symbol %zu\n", letters[k],
+					ft_define_symbol64(&syms[i + k], shdrs, ELFDATA2LSB), i + k);
+				ret = 1;
+			}
+	}
+	if (!ret)
+		printf("classify: block classifier matches define_symbol64 on %d symbols\n", SYMBOLS);
+	ft_classify_free(&c);
+	free(syms);
+	return (ret);
+}
+
+/**
+ * Times the classification of the seeded table: the per-symbol rules of
+ * ft_define_symbol64, then the block classifier.
+ */
+void	bench_classify_run(void)
+{
+	Elf64_Shdr		shdrs[SECTIONS];
+	Elf64_Sym		*syms = build_symbols();
+	unsigned char	*letters = malloc(SYMBOLS);
+	t_classifier	c;
+	t_bench_clock	start;
+	long			sink = 0;
+
+	build_sections(shdrs);
+	if (syms && letters && !ft_classify_init(&c, shdrs, SECTIONS, 1, NULL))
+	{
+		bench_start(&start);
+		for (int r = 0; r < REPEAT; r++)
+			for (size_t i = 0; i < SYMBOLS; i++)
+				letters[i] = ft_define_symbol64(&syms[i], shdrs, ELFDATA2LSB);
+		bench_report("define_symbol64", &start, (size_t)SYMBOLS * REPEAT, 0);
+		sink += letters[SYMBOLS - 1];
+		bench_start(&start);
+		for (int r = 0; r < REPEAT; r++)
+			for (size_t i = 0; i < SYMBOLS; i += CLASSIFY_BLOCK)
+				ft_classify_block64(&c, syms + i, (SYMBOLS - i < CLASSIFY_BLOCK) ? SYMBOLS - i : CLASSIFY_BLOCK,
+					ELFDATA2LSB, letters + i);
+		bench_report("classify_block64", &start, (size_t)SYMBOLS * REPEAT, 0);
+		sink += letters[SYMBOLS - 1];
+		ft_classify_free(&c);
+	}
+	if (sink == 0)
+		printf("(no letters)\n");
+	free(letters);
+	free(syms);
+}
@@ -0,0 +1,151 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   bench_collate.c                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:09:38 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 18:51:03 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "bench.h"
+
+#define NAMES		200000
+#define MAX_VERIFY	96
+#define REPEAT		20
+
+typedef size_t	(*t_key_fn)(char *dst, const char *src, size_t len);
+
+typedef struct s_kernel
+{
+	const char	*name;
+	t_key_fn	fn;
+}	t_kernel;
+
+/**
+ * Lists the key builders this CPU can run, the scalar reference first.
+ * @param	kernels	The array to fill (at least 3 entries).
+ * @return	The number of kernels.
+ */
+static int	list_kernels(t_kernel *kernels)
+{
+	int	n = 0;
+
+	kernels[n++] = (t_kernel){"collate_key scalar", ft_collate_key_scalar};
+#if defined(__x86_64__) || defined(__i386__)
+	if (ft_cpu_has_sse2())
+		kernels[n++] = (t_kernel){"collate_key sse2", ft_collate_key_sse2};
+	if (ft_cpu_has_avx2())
+		kernels[n++] = (t_kernel){"collate_key avx2", ft_collate_key_avx2};
+#endif
+	return (n);
+}
+
+/**
+ * Runs every kernel on one name and compares the keys with the reference.
+ * @param	kernels	The kernels, the reference first.
+ * @param	n		The number of kernels.
+ * @param	name	The name.
+ * @param	len		The length of the name.
+ * @return	0 if all keys match, 1 otherwise.
+ */
+static int	check_name(t_kernel *kernels, int n, const char *name, size_t len)
+{
+	char	ref[MAX_VERIFY + COLLATE_SLACK];
+	char	got[MAX_VERIFY + COLLATE_SLACK];
+	size_t	ref_len = kernels[0].fn(ref, name, len);
+
+	for (int k = 1; k < n; k++)
+	{
+		size_t	got_len = kernels[k].fn(got, name, len);
+
+		if (got_len != ref_len || ft_memcmp(got, ref, ref_len) != 0)
+		{
+			printf("%s: mismatch on a %zu-byte name\n", kernels[k].name, len);
+			return (1);
+		}
+	}
+	return (0);
+}
+
+/**
+ * Exhaustive equivalence check of the SIMD key builders: for every length up
+ * to MAX_VERIFY, every position and every non-NUL byte value, on fillers of
+ * lowercase, uppercase, ignored and mixed characters.
+ * @return	0 if every kernel matches the scalar reference, 1 otherwise.
+ */
+int	bench_collate_verify(void)
+{
+	static const char	*fillers[] = {"a", "Z", "_", "aB_.c@D9"};
+	t_kernel			kernels[3];
+	int					n = list_kernels(kernels);
+	char				name[MAX_VERIFY];
+	size_t				checked = 0;
+
+	for (size_t f = 0; f < sizeof(fillers) / sizeof(*fillers); f++)
+	{
+		size_t	flen = ft_strlen(fillers[f]);
+
+		for (size_t len = 0; len <= MAX_VERIFY; len++)
+		{
+			for (size_t i = 0; i < len; i++)
+				name[i] = fillers[f][i % flen];
+			if (check_name(kernels, n, name, len))
+				return (1);
+			for (size_t pos = 0; pos < len; pos++)
+			{
+				char	saved = name[pos];
+
+				for (int c = 1; c < 256; c++)
+				{
+					name[pos] = (char)c;
+					if (check_name(kernels, n, name, len))
+						return (1);
+					checked++;
+				}
+				name[pos] = saved;
+			}
+		}
+	}
+	printf("collate_key: %d kernels match the reference on %zu names\n", n, checked);
+	return (0);
+}
+
+/**
+ * Times every key builder over the corpus.
+ */
+void	bench_collate_run(void)
+{
+	size_t		*offsets = malloc(sizeof(size_t) * NAMES);
+	size_t		*lens = malloc(sizeof(size_t) * NAMES);
+	size_t		total;
+	char		*corpus = bench_corpus(NAMES, offsets, lens, &total);
+	char		*keys = malloc(total + COLLATE_SLACK);
+	t_kernel	kernels[3];
+	int			n = list_kernels(kernels);
+
+	for (int k = 0; k < n; k++)
+	{
+		t_bench_clock	start;
+		size_t			sink = 0;
+
+		bench_start(&start);
+		for (int r = 0; r < REPEAT; r++)
+		{
+			char	*dst = keys;
+
+			for (size_t i = 0; i < NAMES; i++)
+				dst += kernels[k].fn(dst, corpus + offsets[i], lens[i]);
+			sink += dst - keys;
+		}
+		bench_report(kernels[k].name, &start, (size_t)NAMES * REPEAT, total * REPEAT);
+		if (sink == 0)
+			printf("(empty corpus)\n");
+	}
+	free(keys);
+	free(corpus);
+	free(lens);
+	free(offsets);
+}
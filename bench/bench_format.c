@@ -0,0 +1,61 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   bench_format.c                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:48:02 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 18:51:03 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "bench.h"
+
+#define SYMBOLS		200000
+#define REPEAT		10
+
+static const char	g_types[] = "TtDdBbRrUWwVA";
+
+/**
+ * Times the formatting of a sorted listing, as ft_print_symbols_list writes
+ * it, into a memory writer so that no system call is timed: the BSD lines of
+ * a 64-bit and a 32-bit file, and the ndjson objects.
+ */
+void	bench_format_run(void)
+{
+	static t_nm		nm;
+	static t_ftnm	handle;
+	size_t			*offsets = malloc(sizeof(size_t) * SYMBOLS);
+	size_t			*lens = malloc(sizeof(size_t) * SYMBOLS);
+	size_t			total;
+	char			*corpus = bench_corpus(SYMBOLS, offsets, lens, &total);
+	uint32_t		seed = BENCH_SEED;
+	t_bench_clock	start;
+
+	handle.symbols = ft_calloc(SYMBOLS, sizeof(t_symbol));
+	handle.count = SYMBOLS;
+	for (size_t i = 0; corpus && handle.symbols && i < SYMBOLS; i++)
+		handle.symbols[i] = (t_symbol){.name = corpus + offsets[i], .name_len = lens[i],
+			.type = g_types[bench_rand(&seed) % (sizeof(g_types) - 1)], .value = bench_rand(&seed) & 0xFFFFFF,
+			.size = bench_rand(&seed) % 512, .section = ".text"};
+	ft_writer_init_memory(&nm.out);
+	for (int run = 0; corpus && handle.symbols && run < 3; run++)
+	{
+		handle.bits = (run == 1) ? 32 : 64;
+		nm.opts.format = (run == 2) ? FORMAT_NDJSON : FORMAT_BSD;
+		bench_start(&start);
+		for (int r = 0; r < REPEAT; r++)
+		{
+			nm.out.mem_len = 0;
+			ft_print_symbols_list(&handle, "bench.o", &nm);
+		}
+		bench_report((run == 0) ? "format bsd 64" : (run == 1) ? "format bsd 32" : "format ndjson", &start,
+			(size_t)SYMBOLS * REPEAT, nm.out.mem_len * REPEAT);
+	}
+	ft_writer_free_memory(&nm.out);
+	free(handle.symbols);
+	free(corpus);
+	free(lens);
+	free(offsets);
+}
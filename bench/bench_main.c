@@ -0,0 +1,145 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   bench_main.c                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:09:38 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 18:51:03 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "bench.h"
+
+/**
+ * Reads the monotonic clock.
+ * @return	The current time in nanoseconds.
+ */
+uint64_t	bench_now_ns(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+/**
+ * Small xorshift generator, so that every run works on the same inputs.
+ * @param	state	The generator state, seeded with BENCH_SEED.
+ * @return	The next pseudo-random number.
+ */
+uint32_t	bench_rand(uint32_t *state)
+{
+	uint32_t	x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return (x);
+}
+
+/**
+ * Reads the time stamp counter, which runs at a fixed rate close to the
+ * nominal clock of the CPU. Other architectures report no cycles.
+ * @return	The counter, or 0 if there is none.
+ */
+uint64_t	bench_now_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return (__rdtsc());
+#else
+	return (0);
+#endif
+}
+
+/**
+ * Starts timing a kernel.
+ * @param	clock	Filled with the current time and cycle count.
+ */
+void	bench_start(t_bench_clock *clock)
+{
+	clock->cycles = bench_now_cycles();
+	clock->ns = bench_now_ns();
+}
+
+/**
+ * Prints the timing of a kernel since bench_start: nanoseconds and cycles
+ * per operation, and the throughput if the kernel reads a byte stream.
+ * @param	name	The name of the kernel.
+ * @param	start	The clock taken by bench_start.
+ * @param	ops		The number of operations done.
+ * @param	bytes	The number of input bytes processed, 0 if not relevant.
+ */
+void	bench_report(const char *name, const t_bench_clock *start, size_t ops, size_t bytes)
+{
+	uint64_t	ns = bench_now_ns() - start->ns;
+	uint64_t	cycles = bench_now_cycles() - start->cycles;
+
+	if (ns == 0)
+		ns = 1;
+	printf("%-32s %10.2f ns/op", name, (double)ns / ops);
+	if (start->cycles)
+		printf(" %10.2f cycles/op", (double)cycles / ops);
+	if (bytes)
+		printf(" %10.1f MB/s", (double)bytes * 1000.0 / ns);
+	printf("\n");
+}
+
+/**
+ * Builds a seeded corpus of C++-like mangled names, each followed by a NUL
+ * byte so that the corpus also reads as a string table.
+ * @param	count	The number of names.
+ * @param	offsets	Filled with the start of every name in the corpus.
+ * @param	lens	Filled with the length of every name.
+ * @param	total	Set to the total size of the corpus.
+ * @return	The corpus (with COLLATE_SLACK bytes of room), or NULL.
+ */
+char	*bench_corpus(size_t count, size_t *offsets, size_t *lens, size_t *total)
+{
+	static const char	*parts[] = {"_ZN", "4llvm", "12DenseMapBase", "INS_", "8DenseMap",
+		"IjPNS_", "5Value", "EEE", "St6vector", "IiSaIiEE", "9push_back", "ERKi",
+		"__cxa", "_atexit", ".constprop.0", "@GLIBC_2.2.5", "Get", "Handler", "E"};
+	size_t				nparts = sizeof(parts) / sizeof(*parts);
+	uint32_t			seed = BENCH_SEED;
+	char				*corpus = malloc(count * 136 + COLLATE_SLACK);
+	size_t				pos = 0;
+
+	if (corpus == NULL)
+		return (NULL);
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t	nwords = 2 + bench_rand(&seed) % 8;
+
+		offsets[i] = pos;
+		for (size_t p = 0; p < nwords; p++)
+		{
+			const char	*part = parts[bench_rand(&seed) % nparts];
+			size_t		len = ft_strlen(part);
+
+			ft_memcpy(corpus + pos, part, len);
+			pos += len;
+		}
+		lens[i] = pos - offsets[i];
+		corpus[pos++] = '\0';
+	}
+	*total = pos;
+	return (corpus);
+}
+
+/**
+ * Checks the optimized kernels against their references, then times every
+ * kernel on fixed, seeded inputs.
+ * @return	0 if every kernel matches its reference, 1 otherwise.
+ */
+int	main(void)
+{
+	if (bench_collate_verify() || bench_names_verify() || bench_classify_verify())
+		return (1);
+	bench_collate_run();
+	bench_names_run();
+	bench_classify_run();
+	bench_format_run();
+	return (0);
+}
@@ -0,0 +1,187 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   bench_names.c                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:48:01 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 18:56:38 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "bench.h"
+
+#define NAMES		200000
+#define VALUES		1000000
+#define REPEAT		20
+
+/**
+ * Checks ft_strtab_name_len against strlen from every offset of the corpus
+ * read as a string table, and ft_st_value_to_string against printf.
+ * @return	0 if both match their references, 1 otherwise.
+ */
+int	bench_names_verify(void)
+{
+	size_t		*offsets = malloc(sizeof(size_t) * NAMES);
+	size_t		*lens = malloc(sizeof(size_t) * NAMES);
+	size_t		total;
+	char		*corpus = bench_corpus(NAMES, offsets, lens, &total);
+	t_strtab	st;
+	uint32_t	seed = BENCH_SEED;
+	int			ret = (corpus == NULL || ft_strtab_init(&st, corpus, total, NULL));
+
+	for (size_t i = 0; !ret && i < total; i++)
+		if (ft_strtab_name_len(&st, i) != (long)ft_strlen(corpus + i))
+		{
+			printf("strtab_name_len: wrong length at offset %zu\n", i);
+			ret = 1;
+		}
+	for (size_t i = 0; !ret && i < VALUES; i++)
+	{
+		unsigned long long	value = ((unsigned long long)bench_rand(&seed) << 32) | bench_rand(&seed);
+		char				got[17];
+		char				ref[17];
+
+		ft_st_value_to_string(got, value, 16);
+		snprintf(ref, sizeof(ref), "%016llx", value);
+		if (value && ft_memcmp(got, ref, 17) != 0)
+		{
+			printf("st_value_to_string: wrong digits for %s\n", ref);
+			ret = 1;
+		}
+	}
+	if (!ret)
+		printf("names: strtab_name_len and st_value_to_string match the reference\n");
+	if (corpus)
+		ft_strtab_free(&st);
+	free(corpus);
+	free(lens);
+	free(offsets);
+	return (ret);
+}
+
+/**
+ * Times the name comparisons of the sort: ft_strncasecmp (the collation of
+ * the fallback path, through tolower_cmp) and ft_collate_after (the
+ * comparator over prebuilt keys), on neighbouring names of the corpus, which
+ * share their first parts often enough to scan past them.
+ * @param	list	The symbols of the corpus, their keys built.
+ */
+static void	run_compare(const t_symbol *list)
+{
+	t_bench_clock	start;
+	long			sink = 0;
+
+	bench_start(&start);
+	for (int r = 0; r < REPEAT; r++)
+		for (size_t i = 0; i + 1 < NAMES; i++)
+		{
+			size_t	len = (list[i].name_len < list[i + 1].name_len) ? list[i].name_len : list[i + 1].name_len;
+
+			sink += ft_strncasecmp(list[i].name, list[i + 1].name, len + 1);
+		}
+	bench_report("strncasecmp", &start, (size_t)(NAMES - 1) * REPEAT, 0);
+	bench_start(&start);
+	for (int r = 0; r < REPEAT; r++)
+		for (size_t i = 0; i + 1 < NAMES; i++)
+			sink += ft_collate_after(&list[i], &list[i + 1], FTNM_COLLATE_COMPAT);
+	bench_report("collate_after", &start, (size_t)(NAMES - 1) * REPEAT, 0);
+	if (sink == 0)
+		printf("(equal names)\n");
+}
+
+/**
+ * Times the scan of a string table into its terminator bitmap, the length
+ * lookups that follow it, and strlen for reference.
+ * @param	corpus	The corpus, read as a string table.
+ * @param	offsets	The start of every name.
+ * @param	total	The size of the corpus.
+ */
+static void	run_name_len(const char *corpus, const size_t *offsets, size_t total)
+{
+	t_bench_clock	start;
+	t_strtab		st;
+	long			sink = 0;
+
+	bench_start(&start);
+	for (int r = 0; r < REPEAT; r++)
+	{
+		if (ft_strtab_init(&st, corpus, total, NULL))
+			return;
+		sink += st.nul_bits[0] & 1;
+		if (r + 1 < REPEAT)
+			ft_strtab_free(&st);
+	}
+	bench_report("strtab scan", &start, (size_t)NAMES * REPEAT, total * REPEAT);
+	bench_start(&start);
+	for (int r = 0; r < REPEAT; r++)
+		for (size_t i = 0; i < NAMES; i++)
+			sink += ft_strtab_name_len(&st, offsets[i]);
+	bench_report("strtab_name_len", &start, (size_t)NAMES * REPEAT, 0);
+	bench_start(&start);
+	for (int r = 0; r < REPEAT; r++)
+		for (size_t i = 0; i < NAMES; i++)
+			sink += ft_strlen(corpus + offsets[i]);
+	bench_report("strlen (reference)", &start, (size_t)NAMES * REPEAT, 0);
+	ft_strtab_free(&st);
+	if (sink == 0)
+		printf("(empty corpus)\n");
+}
+
+/**
+ * Times the hexadecimal formatting of symbol values, on 16 and 8 digits.
+ */
+static void	run_hex(void)
+{
+	uint64_t		*values = malloc(sizeof(uint64_t) * VALUES);
+	uint32_t		seed = BENCH_SEED;
+	t_bench_clock	start;
+	char			buf[17];
+	long			sink = 0;
+
+	if (values == NULL)
+		return;
+	for (size_t i = 0; i < VALUES; i++)
+		values[i] = bench_rand(&seed) & ((i & 1) ? 0xFFFFFFFF : 0xFFFFFF);
+	for (int digits = 16; digits >= 8; digits -= 8)
+	{
+		bench_start(&start);
+		for (size_t i = 0; i < VALUES; i++)
+		{
+			ft_st_value_to_string(buf, values[i], digits);
+			sink += buf[digits - 1];
+		}
+		bench_report((digits == 16) ? "st_value_to_string 16" : "st_value_to_string 8", &start, VALUES, 0);
+	}
+	if (sink == 0)
+		printf("(no digits)\n");
+	free(values);
+}
+
+/**
+ * Times the name kernels over the corpus.
+ */
+void	bench_names_run(void)
+{
+	size_t		*offsets = malloc(sizeof(size_t) * NAMES);
+	size_t		*lens = malloc(sizeof(size_t) * NAMES);
+	t_symbol	*list = ft_calloc(NAMES, sizeof(t_symbol));
+	size_t		total;
+	char		*corpus = bench_corpus(NAMES, offsets, lens, &total);
+	char		*keys = NULL;
+
+	for (size_t i = 0; corpus && list && i < NAMES; i++)
+		list[i] = (t_symbol){.name = corpus + offsets[i], .name_len = lens[i], .type = 'T'};
+	if (corpus && list && (keys = ft_collate_build_keys(list, NAMES, NULL)) != NULL)
+	{
+		run_compare(list);
+		run_name_len(corpus, offsets, total);
+		run_hex();
+	}
+	free(keys);
+	free(corpus);
+	free(list);
+	free(lens);
+	free(offsets);
+}
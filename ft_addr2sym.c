@@ -0,0 +1,517 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_addr2sym.c                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:45:11 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:49:23 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/*
+ * The address index of a file: one interval per start address, in address
+ * order, with the hits of each symbol for --counts.
+ */
+typedef struct s_addr_index
+{
+	uint64_t			*starts;
+	uint64_t			*ends;
+	const t_symbol		**symbols;
+	size_t				*hits;
+	size_t				count;
+	size_t				misses;
+	int					digits;
+}	t_addr_index;
+
+typedef struct s_addr_query
+{
+	uint64_t			addr;
+	size_t				order;
+}	t_addr_query;
+
+typedef struct s_addr_batch
+{
+	uint64_t			addrs[ADDR_BATCH];
+	t_addr_query		queries[ADDR_BATCH];
+	size_t				slots[ADDR_BATCH];
+	size_t				count;
+}	t_addr_batch;
+
+/*
+ * Where a token was read, for the messages of invalid addresses.
+ */
+typedef struct s_addr_where
+{
+	const char			*name;
+	t_addr_index		*index;
+	size_t				line;
+}	t_addr_where;
+
+typedef struct s_addr_count
+{
+	size_t				hits;
+	size_t				slot;
+}	t_addr_count;
+
+/**
+ * Tells if a symbol has an address a sample can fall at: defined, not
+ * absolute nor common, and listed by the run.
+ * @param	symbol	The symbol.
+ * @param	opts	The options of the run.
+ * @return	1 if the symbol is indexed, 0 otherwise.
+ */
+static int	is_indexed(const t_symbol *symbol, const t_options *opts)
+{
+	t_ftnm_symbol	listed = {.type = symbol->type, .value = symbol->value};
+
+	if (ft_strchr("UwvNCaA", symbol->type) || ft_symbol_is_hidden(&listed, opts))
+		return (0);
+	return (1);
+}
+
+/**
+ * Orders symbols by address, then the one a start address is named after
+ * first: a sized symbol before a label, a global one before a local one,
+ * then by name.
+ * @param	a	The first symbol.
+ * @param	b	The second symbol.
+ * @return	A negative, null or positive value, as for qsort.
+ */
+static int	symbol_cmp(const void *a, const void *b)
+{
+	const t_symbol	*x = *(const t_symbol **)a;
+	const t_symbol	*y = *(const t_symbol **)b;
+	size_t			len = (x->name_len < y->name_len) ? x->name_len : y->name_len;
+	int				global_x = (x->type >= 'A' && x->type <= 'Z');
+	int				global_y = (y->type >= 'A' && y->type <= 'Z');
+	int				ret;
+
+	if (x->value != y->value)
+		return ((x->value < y->value) ? -1 : 1);
+	if ((x->size == 0) != (y->size == 0))
+		return ((x->size == 0) ? 1 : -1);
+	if (global_x != global_y)
+		return (global_x ? -1 : 1);
+	ret = ft_memcmp(x->name, y->name, len);
+	if (ret == 0 && x->name_len != y->name_len)
+		ret = (x->name_len < y->name_len) ? -1 : 1;
+	return (ret);
+}
+
+/**
+ * Builds the address index of a file. The symbols are sorted by address and
+ * each start address keeps one of them; a symbol covers its st_size bytes,
+ * or up to the next start address if it has no size (the last one only its
+ * own address).
+ * @param	handle	The handle of the file.
+ * @param	opts	The options of the run.
+ * @param	index	The index to fill, freed with free_index.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	build_index(const t_ftnm *handle, const t_options *opts, t_addr_index *index)
+{
+	size_t	n = 0;
+
+	ft_bzero(index, sizeof(t_addr_index));
+	index->digits = (handle->bits == 64) ? 16 : 8;
+	index->symbols = malloc(sizeof(t_symbol *) * (handle->count + 1));
+	index->starts = malloc(sizeof(uint64_t) * (handle->count + 1));
+	index->ends = malloc(sizeof(uint64_t) * (handle->count + 1));
+	index->hits = ft_calloc(handle->count + 1, sizeof(size_t));
+	if (!index->symbols || !index->starts || !index->ends || !index->hits)
+		return (1);
+	for (size_t i = 0; i < handle->count; i++)
+		if (is_indexed(&handle->symbols[i], opts))
+			index->symbols[n++] = &handle->symbols[i];
+	qsort(index->symbols, n, sizeof(t_symbol *), symbol_cmp);
+	for (size_t i = 0; i < n; i++)
+		if (index->count == 0 || index->symbols[i]->value != index->starts[index->count - 1])
+		{
+			index->symbols[index->count] = index->symbols[i];
+			index->starts[index->count++] = index->symbols[i]->value;
+		}
+	for (size_t i = 0; i < index->count; i++)
+	{
+		const t_symbol	*symbol = index->symbols[i];
+
+		if (symbol->size)
+			index->ends[i] = (symbol->value + symbol->size < symbol->value) ? UINT64_MAX
+				: symbol->value + symbol->size;
+		else
+			index->ends[i] = (i + 1 < index->count) ? index->starts[i + 1] : symbol->value + 1;
+	}
+	return (0);
+}
+
+/**
+ * Frees an address index.
+ * @param	index	The index.
+ */
+static void	free_index(t_addr_index *index)
+{
+	free(index->symbols);
+	free(index->starts);
+	free(index->ends);
+	free(index->hits);
+}
+
+/**
+ * Finds the interval holding an address by binary search. The loop halves
+ * the range with a conditional move instead of a branch, so it runs the same
+ * log2(n) steps whatever the address and never mispredicts.
+ * @param	index	The index, not empty.
+ * @param	addr	The address.
+ * @return	The slot of the interval, or SIZE_MAX if none holds the address.
+ */
+static size_t	find_slot(const t_addr_index *index, uint64_t addr)
+{
+	const uint64_t	*base = index->starts;
+	size_t			n = index->count;
+	size_t			slot;
+
+	while (n > 1)
+	{
+		size_t	half = n / 2;
+
+		base = (base[half] <= addr) ? base + half : base;
+		n -= half;
+	}
+	slot = base - index->starts;
+	return ((*base <= addr && addr < index->ends[slot]) ? slot : SIZE_MAX);
+}
+
+/**
+ * Compares two queries by address, for qsort.
+ * @param	a	The first query.
+ * @param	b	The second query.
+ * @return	A negative, null or positive value.
+ */
+static int	query_cmp(const void *a, const void *b)
+{
+	const t_addr_query	*x = a;
+	const t_addr_query	*y = b;
+
+	if (x->addr != y->addr)
+		return ((x->addr < y->addr) ? -1 : 1);
+	return ((x->order < y->order) ? -1 : (x->order > y->order));
+}
+
+/**
+ * Resolves a batch of addresses. A batch large against the index is sorted
+ * and merge-walked along it in one pass, which reads the index sequentially;
+ * a smaller one is searched address by address.
+ * @param	index	The index.
+ * @param	batch	The batch, its slots filled in input order.
+ */
+static void	resolve_batch(t_addr_index *index, t_addr_batch *batch)
+{
+	size_t	j = 0;
+
+	if (index->count == 0)
+	{
+		for (size_t i = 0; i < batch->count; i++)
+			batch->slots[i] = SIZE_MAX;
+		return;
+	}
+	if (batch->count < ADDR_MERGE_MIN || batch->count * ADDR_MERGE_RATIO < index->count)
+	{
+		for (size_t i = 0; i < batch->count; i++)
+			batch->slots[i] = find_slot(index, batch->queries[i].addr);
+		return;
+	}
+	qsort(batch->queries, batch->count, sizeof(t_addr_query), query_cmp);
+	for (size_t i = 0; i < batch->count; i++)
+	{
+		uint64_t	addr = batch->queries[i].addr;
+
+		while (j + 1 < index->count && index->starts[j + 1] <= addr)
+			j++;
+		batch->slots[batch->queries[i].order] = (index->starts[j] <= addr && addr < index->ends[j]) ? j
+			: SIZE_MAX;
+	}
+}
+
+/**
+ * Writes a value in hexadecimal.
+ * @param	out		The writer.
+ * @param	value	The value.
+ * @param	width	The number of digits to pad to with zeros, 0 for none.
+ */
+static void	put_hex(t_writer *out, uint64_t value, int width)
+{
+	char	buf[16];
+	int		i = 16;
+
+	do
+	{
+		buf[--i] = "0123456789abcdef"[value & 0xF];
+		value >>= 4;
+	} while (value);
+	while (16 - i < width)
+		buf[--i] = '0';
+	ft_writer_put(out, buf + i, 16 - i);
+}
+
+/**
+ * Reports a resolved batch: one "address symbol+0xoffset" line per address,
+ * in input order ("??" for an address no symbol holds), or only the hits of
+ * each symbol with --counts.
+ * @param	index	The index.
+ * @param	batch	The batch, resolved.
+ * @param	nm		The run context.
+ */
+static void	report_batch(t_addr_index *index, const t_addr_batch *batch, t_nm *nm)
+{
+	for (size_t i = 0; i < batch->count; i++)
+	{
+		size_t	slot = batch->slots[i];
+
+		if (slot == SIZE_MAX)
+			index->misses++;
+		else
+			index->hits[slot]++;
+		if (nm->opts.counts)
+			continue;
+		put_hex(&nm->out, batch->addrs[i], index->digits);
+		ft_writer_putc(&nm->out, ' ');
+		if (slot == SIZE_MAX)
+			ft_writer_put(&nm->out, "??", 2);
+		else
+		{
+			ft_writer_put(&nm->out, index->symbols[slot]->name, index->symbols[slot]->name_len);
+			ft_writer_put(&nm->out, "+0x", 3);
+			put_hex(&nm->out, batch->addrs[i] - index->starts[slot], 0);
+		}
+		ft_writer_putc(&nm->out, '\n');
+	}
+}
+
+/**
+ * Orders the symbols of the --counts report: most hits first, then in
+ * address order.
+ * @param	a	The first count.
+ * @param	b	The second count.
+ * @return	A negative, null or positive value, as for qsort.
+ */
+static int	count_cmp(const void *a, const void *b)
+{
+	const t_addr_count	*x = a;
+	const t_addr_count	*y = b;
+
+	if (x->hits != y->hits)
+		return ((x->hits > y->hits) ? -1 : 1);
+	return ((x->slot < y->slot) ? -1 : (x->slot > y->slot));
+}
+
+/**
+ * Writes the --counts report: "hits symbol" for each symbol hit, by
+ * decreasing hits, then "hits ??" for the addresses no symbol holds.
+ * @param	index	The index, its hits counted.
+ * @param	out		The writer.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	report_counts(const t_addr_index *index, t_writer *out)
+{
+	t_addr_count	*counts;
+	size_t			n = 0;
+
+	counts = malloc(sizeof(t_addr_count) * (index->count + 1));
+	if (counts == NULL)
+		return (1);
+	for (size_t i = 0; i < index->count; i++)
+		if (index->hits[i])
+			counts[n++] = (t_addr_count){index->hits[i], i};
+	qsort(counts, n, sizeof(t_addr_count), count_cmp);
+	for (size_t i = 0; i < n; i++)
+	{
+		ft_writer_putnbr(out, counts[i].hits);
+		ft_writer_putc(out, ' ');
+		ft_writer_put(out, index->symbols[counts[i].slot]->name, index->symbols[counts[i].slot]->name_len);
+		ft_writer_putc(out, '\n');
+	}
+	if (index->misses)
+	{
+		ft_writer_putnbr(out, index->misses);
+		ft_writer_put(out, " ??\n", 4);
+	}
+	free(counts);
+	return (0);
+}
+
+/**
+ * Resolves and reports the addresses of the batch, and empties it.
+ * @param	index	The index.
+ * @param	batch	The batch.
+ * @param	nm		The run context.
+ */
+static void	flush_batch(t_addr_index *index, t_addr_batch *batch, t_nm *nm)
+{
+	resolve_batch(index, batch);
+	report_batch(index, batch, nm);
+	batch->count = 0;
+}
+
+/**
+ * Adds an address to the batch, resolving and reporting the batch once it
+ * is full. An address is made of hexadecimal digits, with an optional "0x"
+ * prefix. A token longer than the token buffer comes with its full length
+ * and only its first ADDR_TOKEN_MAX bytes.
+ * @param	token	The address as read.
+ * @param	len		Its length.
+ * @param	index	The index.
+ * @param	batch	The batch.
+ * @param	nm		The run context.
+ * @return	0 on success, 1 if the token is not an address.
+ */
+static int	add_address(const char *token, size_t len, t_addr_index *index, t_addr_batch *batch, t_nm *nm)
+{
+	uint64_t	addr = 0;
+	size_t		i = 0;
+
+	if (len > 2 && token[0] == '0' && (token[1] == 'x' || token[1] == 'X'))
+		i = 2;
+	if (len - i > 16)
+		return (1);
+	for (; i < len; i++)
+	{
+		int	c = ft_tolower(token[i]);
+
+		if (!ft_isdigit(c) && (c < 'a' || c > 'f'))
+			return (1);
+		addr = (addr << 4) | (uint64_t)(ft_isdigit(c) ? c - '0' : c - 'a' + 10);
+	}
+	batch->addrs[batch->count] = addr;
+	batch->queries[batch->count] = (t_addr_query){addr, batch->count};
+	if (++batch->count == ADDR_BATCH)
+		flush_batch(index, batch, nm);
+	return (0);
+}
+
+/**
+ * Adds the token ending at a separator, or reports it if it is not an
+ * address. The addresses before it are reported first, so that the message
+ * comes in its place in the output, and the token is skipped.
+ * @param	token	The token, see add_address.
+ * @param	len		Its length (0 for none).
+ * @param	where	The name of the stream and the line of the token.
+ * @param	batch	The batch.
+ * @param	nm		The run context.
+ * @return	0 if the token was added or there was none, 1 if it was skipped.
+ */
+static int	take_token(const char *token, size_t len, const t_addr_where *where, t_addr_batch *batch,
+	t_nm *nm)
+{
+	if (len == 0 || !add_address(token, len, where->index, batch, nm))
+		return (0);
+	flush_batch(where->index, batch, nm);
+	ft_writer_flush(&nm->out);
+	ft_putstr_fd("nm: ", STDERR_FILENO);
+	ft_putstr_fd((char *)where->name, STDERR_FILENO);
+	ft_putchar_fd(':', STDERR_FILENO);
+	ft_putnbr_fd((int)where->line, STDERR_FILENO);
+	ft_putstr_fd(": invalid address\n", STDERR_FILENO);
+	return (1);
+}
+
+/**
+ * Reads the addresses of a stream, separated by whitespace or commas, and
+ * resolves them by batches of ADDR_BATCH as they come, so that a pipe is
+ * answered without being read whole. A token that is not an address is
+ * reported with its line and skipped; the others are still mapped.
+ * @param	fd		The stream.
+ * @param	name	Its name, for messages.
+ * @param	index	The index.
+ * @param	nm		The run context.
+ * @return	0 on success, 1 if a token was invalid or on error (message
+ * 			printed).
+ */
+static int	read_addresses(int fd, const char *name, t_addr_index *index, t_nm *nm)
+{
+	t_addr_where	where = {name, index, 1};
+	t_addr_batch	*batch;
+	char			buf[ADDR_READ_SIZE];
+	char			token[ADDR_TOKEN_MAX];
+	size_t			len = 0;
+	ssize_t			got;
+	int				invalid = 0;
+
+	batch = malloc(sizeof(t_addr_batch));
+	if (batch == NULL)
+	{
+		ft_putstr_fd("Error allocating memory\n", STDERR_FILENO);
+		return (1);
+	}
+	batch->count = 0;
+	while ((got = read(fd, buf, sizeof(buf))) > 0 || (got < 0 && errno == EINTR))
+		for (ssize_t i = 0; i < got; i++)
+		{
+			if (ft_strchr(" \t\n\r\v\f,", buf[i]) && buf[i])
+			{
+				invalid |= take_token(token, len, &where, batch, nm);
+				where.line += (buf[i] == '\n');
+				len = 0;
+			}
+			else if (len++ < ADDR_TOKEN_MAX)
+				token[len - 1] = buf[i];
+		}
+	if (got == 0)
+		invalid |= take_token(token, len, &where, batch, nm);
+	flush_batch(index, batch, nm);
+	free(batch);
+	if (got < 0)
+	{
+		ft_writer_flush(&nm->out);
+		ft_putstr_fd("nm: ", STDERR_FILENO);
+		ft_putstr_fd((char *)name, STDERR_FILENO);
+		ft_putstr_fd(": read error\n", STDERR_FILENO);
+	}
+	return (invalid || got < 0);
+}
+
+/**
+ * Maps the addresses read from a file ("-" for the standard input) to the
+ * symbols of a binary, as a profiler does with its samples: each address
+ * gets the symbol whose interval holds it and its offset in it, or with
+ * --counts each symbol gets the number of addresses it holds.
+ * @param	handle	The handle of the binary.
+ * @param	path	The file of addresses.
+ * @param	nm		The run context.
+ * @return	0 on success, 1 on error (message printed).
+ */
+int	ft_addr2sym(const t_ftnm *handle, const char *path, t_nm *nm)
+{
+	t_addr_index	index;
+	int				fd = STDIN_FILENO;
+	int				ret;
+
+	if (ft_strncmp(path, "-", 2) != 0 && (fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+	{
+		ft_putstr_fd("nm: ", STDERR_FILENO);
+		ft_putstr_fd((char *)path, STDERR_FILENO);
+		ft_putstr_fd(": No such file\n", STDERR_FILENO);
+		return (1);
+	}
+	if (build_index(handle, &nm->opts, &index))
+	{
+		free_index(&index);
+		if (fd != STDIN_FILENO)
+			close(fd);
+		ft_putstr_fd("Error allocating memory\n", STDERR_FILENO);
+		return (1);
+	}
+	ret = read_addresses(fd, path, &index, nm);
+	if (nm->opts.counts && report_counts(&index, &nm->out))
+	{
+		ft_putstr_fd("Error allocating memory\n", STDERR_FILENO);
+		ret = 1;
+	}
+	ft_writer_flush(&nm->out);
+	free_index(&index);
+	if (fd != STDIN_FILENO)
+		close(fd);
+	return (ret);
+}
@@ -0,0 +1,294 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_api.c                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:24:11 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:50:07 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+static const t_ftnm_config	g_default_config;
+
+/**
+ * Allocates a handle, from the arena of the configuration if it has one, and
+ * picks the buffer pool it reads with. The arena is then taken until the
+ * handle is closed, since closing it resets the arena.
+ * @param	handle	Set to the new handle, or NULL on error.
+ * @param	config	The configuration of the handle, NULL for the default.
+ * @param	pool	Set to the pool of the configuration, or the own pool of
+ * 					the handle.
+ * @return	FTNM_OK, FTNM_ERR_BUSY if the arena serves another open handle,
+ * 			or FTNM_ERR_MEMORY.
+ */
+static int	new_handle(t_ftnm **handle, const t_ftnm_config *config, t_input_pool **pool)
+{
+	t_arena	*arena = (config && !config->max_memory) ? config->arena : NULL;
+
+	*handle = NULL;
+	if (arena && arena->busy)
+		return (FTNM_ERR_BUSY);
+	*handle = ft_arena_alloc(arena, sizeof(t_ftnm));
+	if (*handle == NULL)
+		return (FTNM_ERR_MEMORY);
+	ft_bzero(*handle, sizeof(t_ftnm));
+	(*handle)->arena = arena;
+	(*handle)->fd = -1;
+	(*handle)->collation = config ? config->collation : FTNM_COLLATE_COMPAT;
+	*pool = (config && config->pool) ? config->pool : &(*handle)->own_pool;
+	if (arena)
+		arena->busy = 1;
+	return (FTNM_OK);
+}
+
+/**
+ * Reads the symbols of a handle whose input is open, and releases the handle
+ * if they cannot be read.
+ * @param	handle	Pointer to the handle, set to NULL on failure.
+ * @param	config	The configuration of the handle, NULL for the default.
+ * @return	FTNM_OK, or the error of ft_check.
+ */
+static int	load_handle(t_ftnm **handle, const t_ftnm_config *config)
+{
+	int	ret = ft_check(*handle, config ? config : &g_default_config);
+
+	if (ret != FTNM_OK)
+	{
+		ftnm_close(*handle);
+		*handle = NULL;
+	}
+	return (ret);
+}
+
+/**
+ * Opens an ELF file from a file descriptor and reads its symbols. The
+ * descriptor stays owned by the caller and may be a pipe.
+ * @param	handle	Set to the new handle, or NULL on error.
+ * @param	fd		The file descriptor.
+ * @param	config	The configuration of the handle, NULL for the default.
+ * @return	FTNM_OK or an FTNM_ERR_* code.
+ */
+int	ftnm_open_fd(t_ftnm **handle, int fd, const t_ftnm_config *config)
+{
+	t_input_pool	*pool;
+	int				ret;
+
+	ret = new_handle(handle, config, &pool);
+	if (ret != FTNM_OK)
+		return (ret);
+	ret = ft_input_open(&(*handle)->in, fd, pool, (config && config->populate) ? INPUT_POPULATE : 0);
+	if (ret != 0)
+	{
+		ftnm_close(*handle);
+		*handle = NULL;
+		if (ret == INPUT_ERR_STAT)
+			return (FTNM_ERR_STAT);
+		if (ret == INPUT_ERR_MAP || ret == INPUT_ERR_EMPTY)
+			return (FTNM_ERR_MAP);
+		return (FTNM_ERR_READ);
+	}
+	return (load_handle(handle, config));
+}
+
+/**
+ * Opens an ELF file from its path and reads its symbols.
+ * @param	handle	Set to the new handle, or NULL on error.
+ * @param	path	The path of the file.
+ * @param	config	The configuration of the handle, NULL for the default.
+ * @return	FTNM_OK or an FTNM_ERR_* code.
+ */
+int	ftnm_open_path(t_ftnm **handle, const char *path, const t_ftnm_config *config)
+{
+	int	fd = open(path, O_RDONLY | O_CLOEXEC);
+	int	ret;
+
+	*handle = NULL;
+	if (fd < 0)
+		return ((errno == ENOENT) ? FTNM_ERR_NOENT : FTNM_ERR_OPEN);
+	ret = ftnm_open_fd(handle, fd, config);
+	if (ret != FTNM_OK)
+		close(fd);
+	else
+		(*handle)->fd = fd;
+	return (ret);
+}
+
+/**
+ * Opens an ELF file already in memory and reads its symbols. The buffer is
+ * borrowed and must outlive the handle.
+ * @param	handle	Set to the new handle, or NULL on error.
+ * @param	data	The contents of the file.
+ * @param	size	The size of the buffer.
+ * @param	config	The configuration of the handle, NULL for the default.
+ * @return	FTNM_OK or an FTNM_ERR_* code.
+ */
+int	ftnm_open_memory(t_ftnm **handle, const void *data, size_t size, const t_ftnm_config *config)
+{
+	t_input_pool	*pool;
+	int				ret;
+
+	ret = new_handle(handle, config, &pool);
+	if (ret != FTNM_OK)
+		return (ret);
+	ft_input_open_memory(&(*handle)->in, data, size, pool);
+	return (load_handle(handle, config));
+}
+
+/**
+ * Sorts the symbols of a handle by name, the order of nm in the collation of
+ * its configuration. Iterators started afterwards follow the sorted order.
+ * @param	handle	The handle.
+ * @return	FTNM_OK, or FTNM_ERR_MEMORY if the collation keys cannot be built
+ * 			(the symbols then keep the order of the file).
+ */
+int	ftnm_sort(t_ftnm *handle)
+{
+	if (handle->sorted)
+		return (FTNM_OK);
+	if (ft_sort_symbols_by_name(handle->symbols, handle->count, handle->collation, handle->arena))
+		return (FTNM_ERR_MEMORY);
+	handle->sorted = 1;
+	return (FTNM_OK);
+}
+
+/**
+ * Tells the class of the file of a handle.
+ * @param	handle	The handle.
+ * @return	32 or 64.
+ */
+int	ftnm_class(const t_ftnm *handle)
+{
+	return (handle->bits);
+}
+
+/**
+ * Tells the number of symbols of a handle, filters applied.
+ * @param	handle	The handle.
+ * @return	The number of symbols.
+ */
+size_t	ftnm_count(const t_ftnm *handle)
+{
+	return (handle->count);
+}
+
+/**
+ * Starts an iteration over the symbols of a handle. The symbols of a handle
+ * that spilled them are merged from its runs, one iteration at a time.
+ * @param	iter	The iterator.
+ * @param	handle	The handle.
+ */
+void	ftnm_iter_init(t_ftnm_iter *iter, const t_ftnm *handle)
+{
+	iter->handle = handle;
+	iter->pos = 0;
+	if (handle->spill)
+		ft_spill_rewind(handle->spill);
+}
+
+/**
+ * Fetches the next symbol of an iteration. For a handle that spilled its
+ * symbols, the name is only valid until the next call.
+ * @param	iter	The iterator.
+ * @param	symbol	Filled with the symbol.
+ * @return	1 if a symbol was fetched, 0 at the end of the symbols.
+ */
+int	ftnm_iter_next(t_ftnm_iter *iter, t_ftnm_symbol *symbol)
+{
+	const t_symbol	*entry;
+
+	if (iter->pos >= iter->handle->count)
+		return (0);
+	if (iter->handle->spill)
+	{
+		iter->pos++;
+		return (ft_spill_next(iter->handle->spill, symbol));
+	}
+	entry = &iter->handle->symbols[iter->pos++];
+	symbol->name = entry->name;
+	symbol->name_len = entry->name_len;
+	symbol->value = entry->value;
+	symbol->size = entry->size;
+	symbol->type = entry->type;
+	symbol->section = entry->section;
+	symbol->file = entry->line ? entry->line->file : NULL;
+	symbol->line = entry->line ? entry->line->line : 0;
+	return (1);
+}
+
+/**
+ * Reports how many bytes of the file of a handle were mapped and read.
+ * @param	handle	The handle.
+ * @param	mapped	Set to the number of bytes mapped.
+ * @param	read	Set to the number of bytes read.
+ */
+void	ftnm_io_counters(const t_ftnm *handle, uint64_t *mapped, uint64_t *read)
+{
+	*mapped = handle->in.mapped;
+	*read = handle->in.read;
+}
+
+/**
+ * Releases a handle: its symbols, the mappings of its input and the file
+ * descriptor it opened, if any, and the versioned names and line tables it
+ * owns. Names, sections and source files become invalid. A handle
+ * allocated from an arena is released with everything allocated for it by
+ * resetting the arena, which can then serve the next handle.
+ * @param	handle	The handle, may be NULL.
+ */
+void	ftnm_close(t_ftnm *handle)
+{
+	t_arena	*arena;
+
+	if (handle == NULL)
+		return;
+	arena = handle->arena;
+	ft_arena_drop(arena, handle->symbols);
+	ft_spill_free(handle->spill);
+	ft_arena_free(&handle->names);
+	if (handle->dwarf)
+		ft_dwarf_free(handle->dwarf);
+	free(handle->dwarf);
+	ft_input_close(&handle->in);
+	ft_input_pool_free(&handle->own_pool);
+	if (handle->fd >= 0)
+		close(handle->fd);
+	ft_arena_drop(arena, handle);
+	if (arena)
+	{
+		arena->busy = 0;
+		ft_arena_reset(arena);
+	}
+}
+
+/**
+ * Describes an error code.
+ * @param	code	An FTNM_* code.
+ * @return	A static description of the code.
+ */
+const char	*ftnm_strerror(int code)
+{
+	static const char	*messages[] = {
+		"success",
+		"no such file",
+		"cannot open file",
+		"fstat error",
+		"mmap error",
+		"read error",
+		"file format not recognized",
+		"file too short",
+		"corrupt section or symbol tables",
+		"no symbols",
+		"out of memory",
+		"invalid pattern",
+		"cannot write temporary file",
+		"arena in use by another handle",
+	};
+
+	if (code < 0 || (size_t)code >= sizeof(messages) / sizeof(messages[0]))
+		return ("unknown error");
+	return (messages[code]);
+}
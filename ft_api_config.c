@@ -0,0 +1,146 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_api_config.c                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 19:26:16 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:25:46 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/**
+ * Builds a matcher from a list of patterns, as given to --match: a pattern
+ * with a wildcard ('*', '?' or a bracket expression) is a glob matching the
+ * whole name, any other matches anywhere in the name. The matcher is not
+ * changed once built, so handles opened from several threads may share it.
+ * @param	matcher		Set to the new matcher, or NULL on error.
+ * @param	patterns	The patterns, NUL-terminated.
+ * @param	count		The number of patterns.
+ * @return	FTNM_OK, FTNM_ERR_PATTERN for a glob over 63 characters, or
+ * 			FTNM_ERR_MEMORY.
+ */
+int	ftnm_matcher_new(t_ftnm_matcher **matcher, const char *const *patterns, size_t count)
+{
+	int	ret = FTNM_OK;
+
+	*matcher = ft_calloc(1, sizeof(t_matcher));
+	if (*matcher == NULL)
+		return (FTNM_ERR_MEMORY);
+	(*matcher)->active = 1;
+	for (size_t i = 0; ret == FTNM_OK && i < count; i++)
+		ret = ft_matcher_add(*matcher, patterns[i], ft_strlen(patterns[i]));
+	if (ret == FTNM_OK)
+		ret = ft_matcher_finish(*matcher);
+	if (ret != FTNM_OK)
+	{
+		ftnm_matcher_free(*matcher);
+		*matcher = NULL;
+	}
+	return (ret);
+}
+
+/**
+ * Releases a matcher.
+ * @param	matcher	The matcher, may be NULL.
+ */
+void	ftnm_matcher_free(t_ftnm_matcher *matcher)
+{
+	if (matcher == NULL)
+		return;
+	ft_matcher_free(matcher);
+	free(matcher);
+}
+
+/**
+ * Makes an empty buffer pool.
+ * @param	pool	Set to the new pool, or NULL on error.
+ * @return	FTNM_OK or FTNM_ERR_MEMORY.
+ */
+int	ftnm_pool_new(t_ftnm_pool **pool)
+{
+	*pool = ft_calloc(1, sizeof(t_input_pool));
+	return (*pool ? FTNM_OK : FTNM_ERR_MEMORY);
+}
+
+/**
+ * Releases a buffer pool and its buffers, once no open handle uses it.
+ * @param	pool	The pool, may be NULL.
+ */
+void	ftnm_pool_free(t_ftnm_pool *pool)
+{
+	if (pool == NULL)
+		return;
+	ft_input_pool_free(pool);
+	free(pool);
+}
+
+/**
+ * Makes an empty summary.
+ * @param	summary	Set to the new summary, or NULL on error.
+ * @return	FTNM_OK or FTNM_ERR_MEMORY.
+ */
+int	ftnm_summary_new(t_ftnm_summary **summary)
+{
+	*summary = ft_calloc(1, sizeof(t_summary));
+	return (*summary ? FTNM_OK : FTNM_ERR_MEMORY);
+}
+
+/**
+ * Reads the counts of a summary, those of the last file opened with it.
+ * @param	summary	The summary.
+ * @param	counts	Filled with the counts; its arrays point into the
+ * 					summary.
+ */
+void	ftnm_summary_get(const t_ftnm_summary *summary, t_ftnm_counts *counts)
+{
+	counts->symbols = summary->symbols;
+	counts->undefined = summary->undefined;
+	ft_memcpy(counts->types, summary->types, sizeof(counts->types));
+	ft_memcpy(counts->bindings, summary->bindings, sizeof(counts->bindings));
+	ft_memcpy(counts->visibility, summary->visibility, sizeof(counts->visibility));
+	counts->nsections = summary->nslots;
+	counts->section_names = summary->names;
+	counts->section_counts = summary->counts;
+	counts->section_sizes = summary->sizes;
+}
+
+/**
+ * Releases a summary.
+ * @param	summary	The summary, may be NULL.
+ */
+void	ftnm_summary_free(t_ftnm_summary *summary)
+{
+	if (summary == NULL)
+		return;
+	ft_summary_free(summary);
+	free(summary);
+}
+
+/**
+ * Makes an empty arena; its first block is allocated by the first handle
+ * opened with it.
+ * @param	arena	Set to the new arena, or NULL on error.
+ * @return	FTNM_OK or FTNM_ERR_MEMORY.
+ */
+int	ftnm_arena_new(t_ftnm_arena **arena)
+{
+	*arena = ft_calloc(1, sizeof(t_arena));
+	return (*arena ? FTNM_OK : FTNM_ERR_MEMORY);
+}
+
+/**
+ * Releases an arena and its blocks, once every handle opened with it is
+ * closed.
+ * @param	arena	The arena, may be NULL.
+ */
+void	ftnm_arena_free(t_ftnm_arena *arena)
+{
+	if (arena == NULL)
+		return;
+	ft_arena_free(arena);
+	free(arena);
+}
@@ -0,0 +1,175 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_arena.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:51:04 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:46:28 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/*
+ * A block outgrown during the current file, kept until the reset since
+ * pointers into it are still in use.
+ */
+typedef struct s_arena_block
+{
+	struct s_arena_block	*next;
+}	t_arena_block;
+
+/* The heap allocations made for the files read, for --stats. */
+static uint64_t	g_heap_allocs = 0;
+
+/**
+ * Allocates memory from the heap for a file being read, counting the
+ * allocation: the engine allocates through here (or ft_heap_calloc) rather
+ * than malloc, so that --stats can tell how many allocations a file cost.
+ * @param	size	The size to allocate.
+ * @return	The memory, or NULL on failure.
+ */
+void	*ft_heap_alloc(size_t size)
+{
+	void	*ptr = malloc(size);
+
+	if (ptr)
+		__atomic_fetch_add(&g_heap_allocs, 1, __ATOMIC_RELAXED);
+	return (ptr);
+}
+
+/**
+ * Allocates zeroed memory from the heap, counted as ft_heap_alloc does.
+ * @param	count	The number of elements.
+ * @param	size	The size of an element.
+ * @return	The memory, or NULL on failure (or if the size overflows).
+ */
+void	*ft_heap_calloc(size_t count, size_t size)
+{
+	void	*ptr;
+
+	if (size && count > SIZE_MAX / size)
+		return (NULL);
+	ptr = ft_heap_alloc(count * size);
+	if (ptr)
+		ft_bzero(ptr, count * size);
+	return (ptr);
+}
+
+/**
+ * Gives the number of heap allocations made through ft_heap_alloc so far, by
+ * every thread.
+ * @return	The counter.
+ */
+uint64_t	ft_heap_allocs(void)
+{
+	return (__atomic_load_n(&g_heap_allocs, __ATOMIC_RELAXED));
+}
+
+/**
+ * Moves the arena to a new block big enough for a request, retiring the
+ * current one until the next reset.
+ * @param	arena	The arena.
+ * @param	size	The size of the request.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	grow(t_arena *arena, size_t size)
+{
+	size_t	want = arena->size * 2;
+	char	*base;
+
+	if (want < arena->next_size)
+		want = arena->next_size;
+	if (want < ARENA_MIN)
+		want = ARENA_MIN;
+	if (want < size + ARENA_ALIGN)
+		want = size + ARENA_ALIGN;
+	base = ft_heap_alloc(want);
+	if (base == NULL)
+		return (1);
+	if (arena->base)
+	{
+		((t_arena_block *)arena->base)->next = arena->retired;
+		arena->retired = (t_arena_block *)arena->base;
+		arena->retired_used += arena->used;
+	}
+	arena->base = base;
+	arena->size = want;
+	arena->used = ARENA_ALIGN;
+	return (0);
+}
+
+/**
+ * Allocates memory for the file being read: bumped from the arena, or
+ * malloc'ed without one.
+ * @param	arena	The arena, or NULL.
+ * @param	size	The size to allocate.
+ * @return	The memory (16-byte aligned), or NULL on failure.
+ */
+void	*ft_arena_alloc(t_arena *arena, size_t size)
+{
+	void	*ptr;
+
+	if (arena == NULL)
+		return (ft_heap_alloc(size));
+	size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+	if (size > arena->size - arena->used && grow(arena, size))
+		return (NULL);
+	ptr = arena->base + arena->used;
+	arena->used += size;
+	return (ptr);
+}
+
+/**
+ * Releases memory from ft_arena_alloc: freed without an arena, left to the
+ * next reset with one.
+ * @param	arena	The arena, or NULL.
+ * @param	ptr		The memory, may be NULL.
+ */
+void	ft_arena_drop(t_arena *arena, void *ptr)
+{
+	if (arena == NULL)
+		free(ptr);
+}
+
+/**
+ * Releases everything allocated from the arena at once, keeping its block for
+ * the next file. If the file outgrew the block, the blocks are freed and the
+ * next one is sized for all it used, so that a file of the same size is then
+ * served without any malloc.
+ * @param	arena	The arena.
+ */
+void	ft_arena_reset(t_arena *arena)
+{
+	if (arena->retired)
+	{
+		arena->next_size = arena->retired_used + arena->used;
+		while (arena->retired)
+		{
+			t_arena_block	*next = arena->retired->next;
+
+			free(arena->retired);
+			arena->retired = next;
+		}
+		free(arena->base);
+		arena->base = NULL;
+		arena->size = 0;
+		arena->retired_used = 0;
+	}
+	arena->used = (arena->base != NULL) ? ARENA_ALIGN : 0;
+}
+
+/**
+ * Frees the blocks of an arena at the end of the run.
+ * @param	arena	The arena.
+ */
+void	ft_arena_free(t_arena *arena)
+{
+	ft_arena_reset(arena);
+	free(arena->base);
+	arena->base = NULL;
+	arena->size = 0;
+	arena->used = 0;
+}
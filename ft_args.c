@@ -0,0 +1,246 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_args.c                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:29:11 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 17:31:42 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/**
+ * Reads a whole file (or the standard input for "-") through the input
+ * layer.
+ * @param	path	The path of the file.
+ * @param	in		The input to open; closed by the caller on success.
+ * @param	fd		Set to the descriptor to close once done, or -1.
+ * @param	pool	The buffer pool of the run.
+ * @return	The contents of the file (NULL for an empty file, with in->size
+ * 			set to 0), or NULL with fd set to -2 if it cannot be read.
+ */
+static const char	*read_whole(const char *path, t_input *in, int *fd, t_input_pool *pool)
+{
+	const char	*data;
+	int			ret;
+
+	*fd = -1;
+	if (ft_strncmp(path, "-", 2) != 0 && (*fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+	{
+		*fd = -2;
+		return (NULL);
+	}
+	ret = ft_input_open(in, (*fd >= 0) ? *fd : STDIN_FILENO, pool, 0);
+	if (ret == INPUT_ERR_EMPTY)
+	{
+		in->size = 0;
+		return (NULL);
+	}
+	data = (ret == 0) ? ft_input_range(in, 0, in->size) : NULL;
+	if (data == NULL)
+	{
+		ft_input_close(in);
+		if (*fd >= 0)
+			close(*fd);
+		*fd = -2;
+	}
+	return (data);
+}
+
+/**
+ * Splits the contents of a response file into arguments, as binutils does:
+ * arguments are separated by whitespace, and single quotes, double quotes
+ * and backslashes protect the characters they cover.
+ * @param	data	The contents of the file.
+ * @param	size	The size of the contents.
+ * @param	out		The list the arguments are appended to.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	split_response(const char *data, size_t size, t_pathlist *out)
+{
+	size_t	i = 0;
+
+	while (i < size)
+	{
+		char	*arg;
+		size_t	len = 0;
+		char	quote = 0;
+
+		while (i < size && ft_strchr(" \t\n\r\v\f", data[i]) && data[i])
+			i++;
+		if (i >= size)
+			break;
+		arg = malloc(size - i + 1);
+		if (arg == NULL)
+			return (1);
+		for (; i < size && (quote || !ft_strchr(" \t\n\r\v\f", data[i]) || !data[i]); i++)
+		{
+			if (data[i] == '\\' && i + 1 < size)
+				arg[len++] = data[++i];
+			else if (quote && data[i] == quote)
+				quote = 0;
+			else if (!quote && (data[i] == '\'' || data[i] == '"'))
+				quote = data[i];
+			else
+				arg[len++] = data[i];
+		}
+		arg[len] = '\0';
+		if (ft_pathlist_add(out, arg))
+		{
+			free(arg);
+			return (1);
+		}
+	}
+	return (0);
+}
+
+/**
+ * Appends a copy of an argument to the expanded list.
+ * @param	arg		The argument.
+ * @param	args	The expanded list.
+ * @return	0 on success, 1 on allocation failure (message printed).
+ */
+static int	add_copy(const char *arg, t_pathlist *args)
+{
+	char	*copy = ft_strdup(arg);
+
+	if (copy == NULL || ft_pathlist_add(args, copy))
+	{
+		free(copy);
+		ft_printf("Error allocating memory\n");
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * Appends an argument to the expanded list, replacing "@file" by the
+ * arguments the file holds. As with binutils, "@file" is kept as is if the
+ * file cannot be read. The file is split and closed before its own "@"
+ * arguments are expanded.
+ * @param	arg		The argument.
+ * @param	args	The expanded list.
+ * @param	pool	The buffer pool of the run.
+ * @param	depth	The nesting level of response files.
+ * @return	0 on success, 1 on error (message printed).
+ */
+static int	expand_arg(const char *arg, t_pathlist *args, t_input_pool *pool, int depth)
+{
+	t_pathlist	inner;
+	t_input		in;
+	const char	*data;
+	int			fd;
+	int			ret = 0;
+
+	if (arg[0] != '@' || arg[1] == '\0')
+		return (add_copy(arg, args));
+	if (depth >= ARGS_MAX_DEPTH)
+	{
+		ft_printf("nm: %s: too many nested response files\n", (char *)arg);
+		return (1);
+	}
+	data = read_whole(arg + 1, &in, &fd, pool);
+	if (data == NULL && fd == -2)
+		return (add_copy(arg, args));
+	ft_bzero(&inner, sizeof(inner));
+	if (data && split_response(data, in.size, &inner))
+	{
+		ft_printf("Error allocating memory\n");
+		ret = 1;
+	}
+	if (data)
+		ft_input_close(&in);
+	if (fd >= 0)
+		close(fd);
+	for (size_t i = 0; !ret && i < inner.count; i++)
+		ret = expand_arg(inner.paths[i], args, pool, depth + 1);
+	ft_pathlist_free(&inner);
+	return (ret);
+}
+
+/**
+ * Expands the "@file" arguments of the command line. The result is a copy of
+ * argv with every response file replaced by its arguments, NULL-terminated
+ * past its count, whose strings are owned by the list.
+ * @param	argc	The number of command line arguments.
+ * @param	argv	The command line arguments.
+ * @param	args	The list to fill.
+ * @param	pool	The buffer pool of the run, used to read response files.
+ * @return	0 on success, 1 on error (message printed).
+ */
+int	ft_expand_args(int argc, char **argv, t_pathlist *args, t_input_pool *pool)
+{
+	ft_bzero(args, sizeof(t_pathlist));
+	for (int i = 0; i < argc; i++)
+		if ((i == 0) ? add_copy(argv[i], args) : expand_arg(argv[i], args, pool, 0))
+			return (1);
+	if (ft_pathlist_add(args, NULL))
+	{
+		ft_printf("Error allocating memory\n");
+		return (1);
+	}
+	args->count--;
+	return (0);
+}
+
+/**
+ * Reads a list of paths from a file ("-" for the standard input), as given
+ * to --files-from. Paths are separated by NUL bytes if the list holds any,
+ * by newlines otherwise; empty entries are skipped.
+ * @param	path	The path of the list.
+ * @param	out		The list the paths are appended to, owning them.
+ * @param	pool	The buffer pool of the run.
+ * @return	0 on success, 1 on error (message printed).
+ */
+int	ft_read_file_list(const char *path, t_pathlist *out, t_input_pool *pool)
+{
+	t_input		in;
+	const char	*data;
+	char		sep;
+	int			fd;
+	int			ret = 0;
+
+	data = read_whole(path, &in, &fd, pool);
+	if (data == NULL)
+	{
+		if (fd >= 0)
+			close(fd);
+		if (fd == -2)
+			ft_printf("nm: %s: cannot read file list\n", (char *)path);
+		return (fd == -2);
+	}
+	sep = ft_memchr(data, '\0', in.size) ? '\0' : '\n';
+	for (size_t start = 0, end; !ret && start < in.size; start = end + 1)
+	{
+		char	*entry;
+		size_t	len;
+
+		end = start;
+		while (end < in.size && data[end] != sep)
+			end++;
+		len = end - start;
+		if (sep == '\n' && len && data[start + len - 1] == '\r')
+			len--;
+		if (len == 0)
+			continue;
+		entry = malloc(len + 1);
+		if (entry)
+		{
+			ft_memcpy(entry, data + start, len);
+			entry[len] = '\0';
+		}
+		if (entry == NULL || ft_pathlist_add(out, entry))
+		{
+			free(entry);
+			ft_printf("Error allocating memory\n");
+			ret = 1;
+		}
+	}
+	ft_input_close(&in);
+	if (fd >= 0)
+		close(fd);
+	return (ret);
+}
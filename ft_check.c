@@ -6,7 +6,7 @@
 /*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
 /*                                                +#+#+#+#+#+   +#+           */
 /*   Created: 2023/08/09 13:56:02 by jbertin           #+#    #+#             */
-/*   Updated: 2023/08/10 20:13:19 by jbertin          ###   ########.fr       */
+/*   Updated: 2026/10/19 19:46:28 by jbertin          ###   ########.fr       */
 /*                                                                            */
 /* ************************************************************************** */
 
@@ -89,42 +89,49 @@ static int	check_arch(Elf64_Ehdr *ehdr, int *arch)
  *  Verifying its endianness (little or big endian).
  *  Ensuring its EI_VERSION matches EV_CURRENT.
  *  Confirming its ELF magic number is correct.
- * @param	fd			File descriptor of the ELF file.
- * @param	filename	Name of the ELF file.
- * @return	Returns 0 if the file is a valid ELF file, otherwise returns 1.
+ * then reads its symbols with ft_nm32 or ft_nm64. The input of the handle is
+ * already open. With a memory budget, the handle keeps a spill state only if
+ * its symbols were spilled; they are then already sorted. With -l, it keeps
+ * the DWARF context the source lines of its symbols point into.
+ * @param	handle		The handle of the file.
+ * @param	config		The filters applied to the symbols.
+ * @return	FTNM_OK, FTNM_ERR_FORMAT if the file is not a valid ELF file, or
+ * 			the error of ft_nm32/ft_nm64.
  */
-int	ft_check(int fd, char *filename, int multiple_files)
+int	ft_check(t_ftnm *handle, const t_ftnm_config *config)
 {
-	void		*map;
-	struct stat	st;
+	Elf64_Ehdr	*ehdr = (Elf64_Ehdr *)handle->in.header;
 	int			arch;
 	int			data;
+	int			ret;
 
-	if (fstat(fd, &st) < 0)
-	{
-		ft_printf("nm: fstat error\n");
-		return (1);
-	}
+	if (check_ei_version(ehdr) || check_elfmag(ehdr)
+		|| !check_arch(ehdr, &arch) || !check_data(ehdr, &data))
+		return (FTNM_ERR_FORMAT);
 
-	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
-	if (map == MAP_FAILED)
+	handle->bits = (arch == 1) ? 32 : 64;
+	if (config->max_memory && !config->summary)
 	{
-		ft_printf("nm: mmap error\n");
-		return (1);
+		handle->spill = ft_heap_alloc(sizeof(t_spill));
+		if (handle->spill == NULL)
+			return (FTNM_ERR_MEMORY);
+		ft_spill_init(handle->spill, config->max_memory, config->collation);
 	}
-
-	if (check_ei_version(map) || check_elfmag(map)
-		|| !check_arch(map, &arch) || !check_data(map, &data))
+	if (config->line_numbers && !config->summary)
 	{
-		ft_printf("nm: %s: file format not recognized\n", filename);
-		return (1);
+		handle->dwarf = ft_heap_calloc(1, sizeof(t_dwarf));
+		if (handle->dwarf == NULL)
+			return (FTNM_ERR_MEMORY);
 	}
-
 	if (arch == 1)
-		ft_nm32(map, filename, st.st_size, multiple_files);
-	else if (arch == 2)
-		ft_nm64(map, filename, st.st_size, multiple_files);
-
-	munmap(map, st.st_size);
-	return (0);
+		ret = ft_nm32(handle, config);
+	else
+		ret = ft_nm64(handle, config);
+	if (handle->spill && handle->spill->nbounds == 0)
+	{
+		ft_spill_free(handle->spill);
+		handle->spill = NULL;
+	}
+	handle->sorted = (handle->spill != NULL);
+	return (ret);
 }
@@ -0,0 +1,243 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_classify.c                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:11:35 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:45:13 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/*
+** Symbol classes computed once per section. A symbol's type letter is then a
+** pure table lookup on (class, binding, symbol type), without any branch on
+** the symbol itself.
+*/
+#define CLS_UNDEF	0
+#define CLS_ABS		1
+#define CLS_COMMON	2
+#define CLS_TEXT	3
+#define CLS_DATA	4
+#define CLS_RODATA	5
+#define CLS_BSS		6
+#define CLS_TLSBSS	7
+#define CLS_OTHER	8
+#define CLS_OTHER23	9
+#define CLS_TLSBSS23	10
+#define CLS_COUNT	11
+
+#define BIND_LOCAL	0
+#define BIND_GLOBAL	1
+#define BIND_WEAK	2
+#define BIND_OTHER	3
+
+#define STT_SLOT_OBJECT	0
+#define STT_SLOT_TLS	1
+#define STT_SLOT_OTHER	2
+
+/* Binding of st_info (high nibble) to binding slot. */
+static const uint8_t	g_bind_slot[16] = {
+	BIND_LOCAL, BIND_GLOBAL, BIND_WEAK, BIND_OTHER, BIND_OTHER, BIND_OTHER, BIND_OTHER, BIND_OTHER,
+	BIND_OTHER, BIND_OTHER, BIND_OTHER, BIND_OTHER, BIND_OTHER, BIND_OTHER, BIND_OTHER, BIND_OTHER};
+
+/* Symbol type of st_info (low nibble) to type slot. */
+static const uint8_t	g_type_slot[16] = {
+	STT_SLOT_OTHER, STT_SLOT_OBJECT, STT_SLOT_OTHER, STT_SLOT_OTHER, STT_SLOT_OTHER, STT_SLOT_OTHER,
+	STT_SLOT_TLS, STT_SLOT_OTHER, STT_SLOT_OTHER, STT_SLOT_OTHER, STT_SLOT_OTHER, STT_SLOT_OTHER,
+	STT_SLOT_OTHER, STT_SLOT_OTHER, STT_SLOT_OTHER, STT_SLOT_OTHER};
+
+/* Type letters of ELF64 symbols, same rules as ft_define_symbol64. */
+static const unsigned char	g_letters64[CLS_COUNT][4][3] = {
+	[CLS_UNDEF] =		{{'U', 'U', 'U'}, {'U', 'U', 'U'}, {'v', 'w', 'w'}, {'U', 'U', 'U'}},
+	[CLS_ABS] =			{{'a', 'a', 'a'}, {'A', 'A', 'A'}, {'V', 'W', 'W'}, {'A', 'A', 'A'}},
+	[CLS_COMMON] =		{{'C', 'C', 'C'}, {'C', 'C', 'C'}, {'V', 'W', 'W'}, {'C', 'C', 'C'}},
+	[CLS_TEXT] =		{{'t', 't', 't'}, {'T', 'T', 'T'}, {'V', 'W', 'W'}, {'T', 'T', 'T'}},
+	[CLS_DATA] =		{{'d', 'd', 'd'}, {'D', 'D', 'D'}, {'V', 'W', 'W'}, {'D', 'D', 'D'}},
+	[CLS_RODATA] =		{{'r', 'r', 'r'}, {'R', 'R', 'R'}, {'V', 'W', 'W'}, {'R', 'R', 'R'}},
+	[CLS_BSS] =			{{'b', 'b', 'b'}, {'B', 'B', 'B'}, {'V', 'W', 'W'}, {'B', 'B', 'B'}},
+	[CLS_TLSBSS] =		{{'r', 'b', 'r'}, {'R', 'B', 'R'}, {'V', 'W', 'W'}, {'?', 'B', '?'}},
+	[CLS_OTHER] =		{{'r', 'r', 'r'}, {'R', 'R', 'R'}, {'V', 'W', 'W'}, {'?', '?', '?'}},
+	[CLS_OTHER23] =		{{'D', 'r', 'r'}, {'D', 'R', 'R'}, {'V', 'W', 'W'}, {'D', '?', '?'}},
+	[CLS_TLSBSS23] =	{{'D', 'b', 'r'}, {'D', 'B', 'R'}, {'V', 'W', 'W'}, {'D', 'B', '?'}},
+};
+
+/* Type letters of ELF32 symbols, same rules as ft_define_symbol32. */
+static const unsigned char	g_letters32[CLS_COUNT][4][3] = {
+	[CLS_UNDEF] =		{{'U', 'U', 'U'}, {'U', 'U', 'U'}, {'v', 'w', 'w'}, {'U', 'U', 'U'}},
+	[CLS_ABS] =			{{'a', 'a', 'a'}, {'A', 'A', 'A'}, {'V', 'W', 'W'}, {'A', 'A', 'A'}},
+	[CLS_COMMON] =		{{'C', 'C', 'C'}, {'C', 'C', 'C'}, {'V', 'W', 'W'}, {'C', 'C', 'C'}},
+	[CLS_TEXT] =		{{'t', 't', 't'}, {'T', 'T', 'T'}, {'V', 'W', 'W'}, {'T', 'T', 'T'}},
+	[CLS_DATA] =		{{'d', 'd', 'd'}, {'D', 'D', 'D'}, {'V', 'W', 'W'}, {'D', 'D', 'D'}},
+	[CLS_RODATA] =		{{'r', 'r', 'r'}, {'R', 'R', 'R'}, {'V', 'W', 'W'}, {'R', 'R', 'R'}},
+	[CLS_BSS] =			{{'b', 'b', 'b'}, {'B', 'B', 'B'}, {'V', 'W', 'W'}, {'B', 'B', 'B'}},
+};
+
+/**
+ * Gives the class of an ELF64 section, following the section rules of
+ * ft_define_symbol64.
+ * @param	shdr	The section header.
+ * @param	index	The index of the section.
+ * @return	The class of the section.
+ */
+static uint8_t	section_class64(Elf64_Shdr *shdr, size_t index)
+{
+	if (index == SHN_UNDEF)
+		return (CLS_UNDEF);
+	if (shdr->sh_type == SHT_PROGBITS || shdr->sh_type == SHT_FINI_ARRAY
+		|| shdr->sh_type == SHT_INIT_ARRAY || shdr->sh_type == SHT_DYNAMIC)
+	{
+		if (shdr->sh_flags == (SHF_ALLOC | SHF_EXECINSTR))
+			return (CLS_TEXT);
+		if (shdr->sh_flags == (SHF_ALLOC | SHF_WRITE))
+			return (CLS_DATA);
+		if (shdr->sh_flags == SHF_ALLOC)
+			return (CLS_RODATA);
+	}
+	else if (shdr->sh_type == SHT_NOBITS)
+	{
+		if (shdr->sh_flags == (SHF_ALLOC | SHF_WRITE))
+			return (CLS_BSS);
+		return ((index == 23) ? CLS_TLSBSS23 : CLS_TLSBSS);
+	}
+	return ((index == 23) ? CLS_OTHER23 : CLS_OTHER);
+}
+
+/**
+ * Gives the class of an ELF32 section, following the section rules of
+ * ft_define_symbol32.
+ * @param	shdr	The section header.
+ * @param	index	The index of the section.
+ * @return	The class of the section.
+ */
+static uint8_t	section_class32(Elf32_Shdr *shdr, size_t index)
+{
+	if (index == SHN_UNDEF)
+		return (CLS_UNDEF);
+	if (shdr->sh_type == SHT_PROGBITS)
+	{
+		if (shdr->sh_flags == (SHF_ALLOC | SHF_EXECINSTR))
+			return (CLS_TEXT);
+		if ((shdr->sh_flags & (SHF_ALLOC | SHF_WRITE)) == (SHF_ALLOC | SHF_WRITE))
+			return (CLS_DATA);
+		if (shdr->sh_flags == SHF_ALLOC)
+			return (CLS_RODATA);
+	}
+	if (shdr->sh_type == SHT_NOBITS && (shdr->sh_flags & (SHF_ALLOC | SHF_WRITE)) == (SHF_ALLOC | SHF_WRITE))
+		return (CLS_BSS);
+	if ((shdr->sh_type == SHT_FINI_ARRAY || shdr->sh_type == SHT_INIT_ARRAY || shdr->sh_type == SHT_DYNAMIC)
+		&& shdr->sh_flags != SHF_ALLOC)
+		return (CLS_DATA);
+	if (shdr->sh_type == SHT_INIT_ARRAY || shdr->sh_type == SHT_FINI_ARRAY || shdr->sh_type == SHT_PREINIT_ARRAY)
+		return (CLS_BSS);
+	return (CLS_RODATA);
+}
+
+/**
+ * Builds the per-section class table of a file. The extra last slot is the
+ * class of out-of-range indexes.
+ * @param	c			The classifier to initialize.
+ * @param	shdrs		The section header table.
+ * @param	shnum		The number of sections.
+ * @param	is_64		1 for ELF64, 0 for ELF32.
+ * @param	arena		The arena of the file the table is allocated from, or
+ * 						NULL.
+ * @return	0 on success, 1 if the table cannot be allocated.
+ */
+int	ft_classify_init(t_classifier *c, void *shdrs, size_t shnum, int is_64, t_arena *arena)
+{
+	c->shnum = shnum;
+	c->letters = is_64 ? g_letters64 : g_letters32;
+	c->arena = arena;
+	c->sec_class = ft_arena_alloc(arena, shnum + 1);
+	if (c->sec_class == NULL)
+		return (1);
+	for (size_t i = 0; i < shnum; i++)
+	{
+		if (is_64)
+			c->sec_class[i] = section_class64((Elf64_Shdr *)shdrs + i, i);
+		else
+			c->sec_class[i] = section_class32((Elf32_Shdr *)shdrs + i, i);
+	}
+	c->sec_class[shnum] = is_64 ? CLS_OTHER : CLS_RODATA;
+	return (0);
+}
+
+/**
+ * Releases the class table of a classifier.
+ * @param	c	The classifier.
+ */
+void	ft_classify_free(t_classifier *c)
+{
+	ft_arena_drop(c->arena, c->sec_class);
+	c->sec_class = NULL;
+}
+
+/**
+ * Maps gathered (st_info, st_shndx) pairs to type letters. Every step is a
+ * table lookup or a conditional move, so the loop has no data-dependent
+ * branch and independent symbols overlap in the pipeline.
+ * @param	c		The classifier of the file.
+ * @param	info	The st_info of each symbol.
+ * @param	shndx	The st_shndx of each symbol, in host byte order.
+ * @param	n		The number of symbols.
+ * @param	letters	Filled with the type letter of each symbol.
+ */
+static void	classify_gathered(t_classifier *c, const uint8_t *info, const uint16_t *shndx, size_t n, unsigned char *letters)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		size_t	idx = (shndx[i] < c->shnum) ? shndx[i] : c->shnum;
+		uint8_t	cls = c->sec_class[idx];
+
+		cls = (shndx[i] == SHN_ABS) ? CLS_ABS : cls;
+		cls = (shndx[i] == SHN_COMMON) ? CLS_COMMON : cls;
+		letters[i] = c->letters[cls][g_bind_slot[info[i] >> 4]][g_type_slot[info[i] & 0xF]];
+	}
+}
+
+/**
+ * Classifies a block of up to CLASSIFY_BLOCK ELF64 symbols: st_info and
+ * st_shndx are gathered into small arrays first, then mapped to letters.
+ * @param	c		The classifier of the file.
+ * @param	syms	The first symbol of the block.
+ * @param	n		The number of symbols (at most CLASSIFY_BLOCK).
+ * @param	endian	Endianness of the ELF file.
+ * @param	letters	Filled with the type letter of each symbol.
+ */
+void	ft_classify_block64(t_classifier *c, Elf64_Sym *syms, size_t n, int endian, unsigned char *letters)
+{
+	uint8_t		info[CLASSIFY_BLOCK];
+	uint16_t	shndx[CLASSIFY_BLOCK];
+
+	for (size_t i = 0; i < n; i++)
+	{
+		info[i] = syms[i].st_info;
+		shndx[i] = ft_read_uint16(&syms[i].st_shndx, endian);
+	}
+	classify_gathered(c, info, shndx, n, letters);
+}
+
+/**
+ * Classifies a block of up to CLASSIFY_BLOCK ELF32 symbols.
+ * @param	c		The classifier of the file.
+ * @param	syms	The first symbol of the block.
+ * @param	n		The number of symbols (at most CLASSIFY_BLOCK).
+ * @param	endian	Endianness of the ELF file.
+ * @param	letters	Filled with the type letter of each symbol.
+ */
+void	ft_classify_block32(t_classifier *c, Elf32_Sym *syms, size_t n, int endian, unsigned char *letters)
+{
+	uint8_t		info[CLASSIFY_BLOCK];
+	uint16_t	shndx[CLASSIFY_BLOCK];
+
+	for (size_t i = 0; i < n; i++)
+	{
+		info[i] = syms[i].st_info;
+		shndx[i] = ft_read_uint16(&syms[i].st_shndx, endian);
+	}
+	classify_gathered(c, info, shndx, n, letters);
+}
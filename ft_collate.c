@@ -0,0 +1,825 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_collate.c                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:07:29 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:46:28 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+# define COLLATE_X86 1
+#endif
+
+typedef size_t	(*t_key_builder)(char *dst, const char *src, size_t len);
+typedef int		(*t_symbol_order)(const t_symbol *a, const t_symbol *b);
+
+/**
+ * Tells if a character is ignored by the name collation.
+ * @param	c	The character.
+ * @return	1 for '_', '.' and '@', 0 otherwise.
+ */
+static int	is_ignored(char c)
+{
+	return (c == '_' || c == '.' || c == '@');
+}
+
+/**
+ * Scalar reference of the collation key: the name lowercased, without its
+ * '_', '.' and '@' characters.
+ * @param	dst	The destination of the key (at least len bytes).
+ * @param	src	The name.
+ * @param	len	The length of the name.
+ * @return	The length of the key.
+ */
+size_t	ft_collate_key_scalar(char *dst, const char *src, size_t len)
+{
+	size_t	j = 0;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		if (!is_ignored(src[i]))
+			dst[j++] = ft_tolower((unsigned char)src[i]);
+	}
+	return (j);
+}
+
+#ifdef COLLATE_X86
+
+/**
+ * Lowercases the ASCII letters of 16 bytes: 'A'..'Z' is moved to the bottom
+ * of the signed range so that a single signed compare selects it.
+ * @param	v	The bytes.
+ * @return	The lowercased bytes.
+ */
+__attribute__((target("sse2")))
+static __m128i	lower_sse2(__m128i v)
+{
+	__m128i	shifted = _mm_add_epi8(v, _mm_set1_epi8(0x80 - 'A'));
+	__m128i	upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+
+	return (_mm_add_epi8(v, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+}
+
+/**
+ * Flags the ignored characters of 16 bytes.
+ * @param	v	The bytes.
+ * @return	A byte mask, 0xff where the byte is '_', '.' or '@'.
+ */
+__attribute__((target("sse2")))
+static __m128i	ignored_sse2(__m128i v)
+{
+	return (_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')),
+		_mm_cmpeq_epi8(v, _mm_set1_epi8('.'))), _mm_cmpeq_epi8(v, _mm_set1_epi8('@'))));
+}
+
+/**
+ * Stores the lowercased kept bytes of a 16-byte block. A full keep mask, the
+ * usual case, is a single store; otherwise the block is compacted by walking
+ * the bits of the mask. May write up to 16 bytes at dst.
+ * @param	dst		The destination.
+ * @param	v		The 16 bytes of the name.
+ * @param	keep	The mask of the bytes to keep.
+ * @return	The number of bytes kept.
+ */
+__attribute__((target("sse2")))
+static size_t	store_block_sse2(char *dst, __m128i v, uint32_t keep)
+{
+	char	lowered[16];
+	size_t	j = 0;
+
+	if (keep == 0xFFFF)
+	{
+		_mm_storeu_si128((__m128i *)dst, lower_sse2(v));
+		return (16);
+	}
+	_mm_storeu_si128((__m128i *)lowered, lower_sse2(v));
+	while (keep)
+	{
+		dst[j++] = lowered[__builtin_ctz(keep)];
+		keep &= keep - 1;
+	}
+	return (j);
+}
+
+/**
+ * SSE2 key builder: the name is lowercased and filtered 16 bytes at a time,
+ * the tail going through a zero-padded copy with a shortened keep mask.
+ * May write up to 15 bytes past the key.
+ * @param	dst	The destination of the key (len + 32 bytes).
+ * @param	src	The name.
+ * @param	len	The length of the name.
+ * @return	The length of the key.
+ */
+__attribute__((target("sse2")))
+size_t	ft_collate_key_sse2(char *dst, const char *src, size_t len)
+{
+	size_t	i = 0;
+	size_t	j = 0;
+	__m128i	v;
+
+	for (; i + 16 <= len; i += 16)
+	{
+		v = _mm_loadu_si128((const __m128i *)(src + i));
+		j += store_block_sse2(dst + j, v, ~_mm_movemask_epi8(ignored_sse2(v)) & 0xFFFF);
+	}
+	if (i < len)
+	{
+		char	tail[16] = {0};
+
+		ft_memcpy(tail, src + i, len - i);
+		v = _mm_loadu_si128((const __m128i *)tail);
+		j += store_block_sse2(dst + j, v, ~_mm_movemask_epi8(ignored_sse2(v)) & ((1u << (len - i)) - 1));
+	}
+	return (j);
+}
+
+static pthread_once_t	g_compact_once = PTHREAD_ONCE_INIT;
+static uint64_t			g_compact[256];
+
+/**
+ * Fills the table of shuffle controls that pack the kept bytes of an 8-byte
+ * group to its front, one for each of the 256 keep masks.
+ */
+static void	build_compact_table(void)
+{
+	for (int mask = 0; mask < 256; mask++)
+	{
+		uint64_t	ctrl = 0;
+		int			k = 0;
+
+		for (int b = 0; b < 8; b++)
+		{
+			if (mask & (1 << b))
+				ctrl |= (uint64_t)b << (8 * k++);
+		}
+		for (; k < 8; k++)
+			ctrl |= (uint64_t)0x80 << (8 * k);
+		g_compact[mask] = ctrl;
+	}
+}
+
+/**
+ * Gives the table of shuffle controls, built by the first caller of any
+ * thread.
+ * @return	The table of 256 shuffle controls.
+ */
+static const uint64_t	*compact_table(void)
+{
+	pthread_once(&g_compact_once, build_compact_table);
+	return (g_compact);
+}
+
+/**
+ * AVX2 key builder: 32 bytes per iteration. Blocks without ignored characters
+ * are lowercased and stored at once; the others are compacted 8 bytes at a
+ * time with a pshufb driven by the keep mask. May write up to 31 bytes past
+ * the key.
+ * @param	dst	The destination of the key (len + 32 bytes).
+ * @param	src	The name.
+ * @param	len	The length of the name.
+ * @return	The length of the key.
+ */
+__attribute__((target("avx2")))
+size_t	ft_collate_key_avx2(char *dst, const char *src, size_t len)
+{
+	const uint64_t	*table = compact_table();
+	size_t			i = 0;
+	size_t			j = 0;
+
+	for (; i + 32 <= len; i += 32)
+	{
+		__m256i		v = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i		ign = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')),
+						_mm256_cmpeq_epi8(v, _mm256_set1_epi8('.'))), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('@')));
+		__m256i		shifted = _mm256_add_epi8(v, _mm256_set1_epi8(0x80 - 'A'));
+		__m256i		upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+		uint32_t	keep = ~(uint32_t)_mm256_movemask_epi8(ign);
+
+		v = _mm256_add_epi8(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+		if (keep == 0xFFFFFFFFu)
+		{
+			_mm256_storeu_si256((__m256i *)(dst + j), v);
+			j += 32;
+			continue;
+		}
+		for (int g = 0; g < 4; g++)
+		{
+			uint8_t	k = (keep >> (8 * g)) & 0xFF;
+			__m128i	half = (g < 2) ? _mm256_castsi256_si128(v) : _mm256_extracti128_si256(v, 1);
+			__m128i	group = (g & 1) ? _mm_srli_si128(half, 8) : half;
+
+			group = _mm_shuffle_epi8(group, _mm_loadl_epi64((const __m128i *)&table[k]));
+			_mm_storel_epi64((__m128i *)(dst + j), group);
+			j += __builtin_popcount(k);
+		}
+	}
+	return (j + ft_collate_key_sse2(dst + j, src + i, len - i));
+}
+
+#endif
+
+static pthread_once_t	g_builder_once = PTHREAD_ONCE_INIT;
+static t_key_builder	g_builder;
+
+/**
+ * Picks the widest key builder the CPU supports.
+ */
+static void	pick_builder(void)
+{
+	g_builder = ft_collate_key_scalar;
+#ifdef COLLATE_X86
+	if (ft_cpu_has_avx2())
+		g_builder = ft_collate_key_avx2;
+	else if (ft_cpu_has_sse2())
+		g_builder = ft_collate_key_sse2;
+#endif
+}
+
+/**
+ * Gives the key builder, picked once per run by the first caller of any
+ * thread.
+ * @return	The key builder to use.
+ */
+static t_key_builder	select_builder(void)
+{
+	pthread_once(&g_builder_once, pick_builder);
+	return (g_builder);
+}
+
+/**
+ * Builds the keys of every symbol of a file into a single block, sized from
+ * the total length of the names.
+ * @param	list	The array of symbols.
+ * @param	count	The number of symbols.
+ * @param	arena	The arena of the file the block is allocated from, or NULL.
+ * @return	The block holding the keys (to drop once sorted), or NULL.
+ */
+char	*ft_collate_build_keys(t_symbol *list, size_t count, t_arena *arena)
+{
+	t_key_builder	builder = select_builder();
+	size_t			total = COLLATE_SLACK;
+	char			*keys;
+	char			*pos;
+
+	for (size_t i = 0; i < count; i++)
+		total += list[i].name_len;
+	keys = ft_arena_alloc(arena, total);
+	if (keys == NULL)
+		return (NULL);
+	pos = keys;
+	for (size_t i = 0; i < count; i++)
+	{
+		list[i].key = pos;
+		list[i].key_len = builder(pos, list[i].name, list[i].name_len);
+		pos += list[i].key_len;
+	}
+	return (keys);
+}
+
+/**
+ * Builds the strxfrm keys of every symbol of a file, in the collation of the
+ * current locale (LC_COLLATE), so that comparing two keys with memcmp orders
+ * the names as strcoll does. The block is sized from the names and moved to
+ * a bigger one if a key does not fit; the keys are placed by offset until
+ * the block is final.
+ * @param	list	The array of symbols, their names NUL-terminated.
+ * @param	count	The number of symbols.
+ * @param	arena	The arena of the file the block is allocated from, or NULL.
+ * @return	The block holding the keys (to drop once sorted), or NULL.
+ */
+char	*ft_collate_build_locale_keys(t_symbol *list, size_t count, t_arena *arena)
+{
+	size_t	cap = COLLATE_SLACK;
+	size_t	used = 0;
+	char	*keys;
+
+	for (size_t i = 0; i < count; i++)
+		cap += list[i].name_len * COLLATE_LOCALE_RATIO + COLLATE_LOCALE_EXTRA;
+	keys = ft_arena_alloc(arena, cap);
+	for (size_t i = 0; keys && i < count; i++)
+	{
+		size_t	len = strxfrm(keys + used, list[i].name, cap - used);
+
+		if (len >= cap - used)
+		{
+			size_t	grown = (cap * 2 > used + len + 1) ? cap * 2 : used + len + 1;
+			char	*moved = ft_arena_alloc(arena, grown);
+
+			if (moved)
+				ft_memcpy(moved, keys, used);
+			ft_arena_drop(arena, keys);
+			keys = moved;
+			cap = grown;
+			if (keys == NULL)
+				break;
+			strxfrm(keys + used, list[i].name, cap - used);
+		}
+		list[i].key = (const char *)(uintptr_t)used;
+		list[i].key_len = len;
+		used += len;
+	}
+	for (size_t i = 0; keys && i < count; i++)
+		list[i].key = keys + (uintptr_t)list[i].key;
+	return (keys);
+}
+
+/**
+ * Tells if the first symbol sorts after the second one. Symbols are ordered by
+ * collation key (case-folded, '_', '.' and '@' ignored). On equal keys, names
+ * that only differ by ignored characters are ordered by their raw bytes;
+ * names of the same type that only differ by case are ordered by reversed raw
+ * bytes; the type letter breaks the remaining ties.
+ * @param	a	The first symbol.
+ * @param	b	The second symbol.
+ * @return	1 if a must be placed after b, 0 otherwise.
+ */
+static int	symbol_after(const t_symbol *a, const t_symbol *b)
+{
+	size_t	n = (a->key_len < b->key_len) ? a->key_len : b->key_len;
+	int		comparison = ft_memcmp(a->key, b->key, n);
+
+	if (comparison == 0 && a->key_len != b->key_len)
+		comparison = (a->key_len < b->key_len) ? -1 : 1;
+	if (comparison == 0)
+	{
+		size_t	len = ((a->name_len < b->name_len) ? a->name_len : b->name_len) + 1;
+		int		raw = ft_strncmp(a->name, b->name, len);
+		size_t	i = 0;
+		size_t	j = 0;
+
+		while (1)
+		{
+			while (i < a->name_len && (a->name[i] == '_' || a->name[i] == '.' || a->name[i] == '@'))
+				i++;
+			while (j < b->name_len && (b->name[j] == '_' || b->name[j] == '.' || b->name[j] == '@'))
+				j++;
+			if (i == a->name_len || j == b->name_len || a->name[i] != b->name[j])
+				break;
+			i++;
+			j++;
+		}
+		if (i == a->name_len && j == b->name_len && raw != 0)
+			comparison = raw;
+		else if (a->type == b->type && ft_strncasecmp(a->name, b->name, len) == 0)
+			comparison = -raw;
+	}
+	return (comparison > 0 || (comparison == 0 && a->type > b->type));
+}
+
+/**
+ * Compares the names of two symbols in a total order that follows the name
+ * collation: by collation key first, then by raw bytes. Unlike the listing
+ * order, it never looks at the type, so that two tables sorted with it can be
+ * merge-joined on the names.
+ * @param	a	The first symbol.
+ * @param	b	The second symbol.
+ * @return	A negative, null or positive value as a sorts before, with or
+ * 			after b.
+ */
+int	ft_collate_cmp_names(const t_symbol *a, const t_symbol *b)
+{
+	size_t	n = (a->key_len < b->key_len) ? a->key_len : b->key_len;
+	int		comparison = ft_memcmp(a->key, b->key, n);
+
+	if (comparison == 0 && a->key_len != b->key_len)
+		return ((a->key_len < b->key_len) ? -1 : 1);
+	if (comparison == 0)
+	{
+		n = (a->name_len < b->name_len) ? a->name_len : b->name_len;
+		comparison = ft_memcmp(a->name, b->name, n);
+		if (comparison == 0 && a->name_len != b->name_len)
+			comparison = (a->name_len < b->name_len) ? -1 : 1;
+	}
+	return (comparison);
+}
+
+/**
+ * Tells if the first symbol sorts after the second one in the locale
+ * collation: by strxfrm key, then by raw bytes for names the locale finds
+ * equal, then by type letter.
+ * @param	a	The first symbol.
+ * @param	b	The second symbol.
+ * @return	1 if a must be placed after b, 0 otherwise.
+ */
+static int	locale_after(const t_symbol *a, const t_symbol *b)
+{
+	size_t	n = (a->key_len < b->key_len) ? a->key_len : b->key_len;
+	int		comparison = ft_memcmp(a->key, b->key, n);
+
+	if (comparison == 0 && a->key_len != b->key_len)
+		comparison = (a->key_len < b->key_len) ? -1 : 1;
+	if (comparison == 0)
+	{
+		n = (a->name_len < b->name_len) ? a->name_len : b->name_len;
+		comparison = ft_memcmp(a->name, b->name, n);
+		if (comparison == 0 && a->name_len != b->name_len)
+			comparison = (a->name_len < b->name_len) ? -1 : 1;
+	}
+	return (comparison > 0 || (comparison == 0 && a->type > b->type));
+}
+
+/**
+ * Tells if the first symbol sorts after the second one in byte order: by
+ * the bytes of the names, a prefix first, then by type letter.
+ * @param	a	The first symbol.
+ * @param	b	The second symbol.
+ * @return	1 if a must be placed after b, 0 otherwise.
+ */
+static int	c_after(const t_symbol *a, const t_symbol *b)
+{
+	size_t	n = (a->name_len < b->name_len) ? a->name_len : b->name_len;
+	int		comparison = ft_memcmp(a->name, b->name, n);
+
+	if (comparison == 0 && a->name_len != b->name_len)
+		comparison = (a->name_len < b->name_len) ? -1 : 1;
+	return (comparison > 0 || (comparison == 0 && a->type > b->type));
+}
+
+/**
+ * Tells if the first symbol sorts after the second one in the join order:
+ * by name (ft_collate_cmp_names), then by type and value.
+ * @param	a	The first symbol.
+ * @param	b	The second symbol.
+ * @return	1 if a must be placed after b, 0 otherwise.
+ */
+static int	join_after(const t_symbol *a, const t_symbol *b)
+{
+	int	comparison = ft_collate_cmp_names(a, b);
+
+	if (comparison == 0 && a->type != b->type)
+		return (a->type > b->type);
+	return (comparison > 0 || (comparison == 0 && a->value > b->value));
+}
+
+/**
+ * Stable merge sort of the symbols, bottom-up, ping-ponging between the array
+ * and a scratch buffer of the same size. Inlined into each caller so that the
+ * order is a direct call, not one through a pointer per comparison.
+ * @param	list	The array of symbols.
+ * @param	tmp		The scratch buffer.
+ * @param	count	The number of symbols.
+ * @param	after	The order of the symbols.
+ */
+static inline __attribute__((always_inline)) void	merge_sort(t_symbol *list, t_symbol *tmp, size_t count, t_symbol_order after)
+{
+	t_symbol	*src = list;
+	t_symbol	*dst = tmp;
+	t_symbol	*swap;
+
+	for (size_t width = 1; width < count; width *= 2)
+	{
+		for (size_t lo = 0; lo < count; lo += 2 * width)
+		{
+			size_t	mid = (lo + width < count) ? lo + width : count;
+			size_t	hi = (lo + 2 * width < count) ? lo + 2 * width : count;
+			size_t	i = lo;
+			size_t	j = mid;
+			size_t	k = lo;
+
+			while (i < mid && j < hi)
+				dst[k++] = after(&src[i], &src[j]) ? src[j++] : src[i++];
+			while (i < mid)
+				dst[k++] = src[i++];
+			while (j < hi)
+				dst[k++] = src[j++];
+		}
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+	if (src != list)
+		ft_memcpy(list, src, sizeof(t_symbol) * count);
+}
+
+/**
+ * Builds the keys of the symbols for an order: the strxfrm keys in the
+ * locale collation, none in byte order (the name is the key), the collation
+ * keys otherwise.
+ * @param	list		The array of symbols.
+ * @param	count		The number of symbols.
+ * @param	collation	The FTNM_COLLATE_* order.
+ * @param	arena		The arena the keys are allocated from, or NULL.
+ * @param	keys		Set to the block of the keys, NULL if there is none.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	build_keys(t_symbol *list, size_t count, int collation, t_arena *arena, char **keys)
+{
+	*keys = NULL;
+	if (collation == FTNM_COLLATE_C)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			list[i].key = list[i].name;
+			list[i].key_len = 0;
+		}
+		return (0);
+	}
+	if (collation == FTNM_COLLATE_LOCALE)
+		*keys = ft_collate_build_locale_keys(list, count, arena);
+	else
+		*keys = ft_collate_build_keys(list, count, arena);
+	return (*keys == NULL);
+}
+
+/**
+ * Gives the byte of a name the radix sort buckets it by at a depth: 0 once
+ * the name has ended, so that a prefix sorts first, the byte plus 1 before.
+ * @param	symbol	The symbol.
+ * @param	depth	The depth.
+ * @return	The bucket, from 0 to 256.
+ */
+static inline size_t	radix_bucket(const t_symbol *symbol, size_t depth)
+{
+	return ((depth < symbol->name_len) ? (unsigned char)symbol->name[depth] + 1 : 0);
+}
+
+/**
+ * Total order of the radix sort fallback: byte order, then the position in
+ * the array, so that qsort gives the result of a stable sort.
+ * @param	a	The first symbol pointer.
+ * @param	b	The second symbol pointer.
+ * @return	A negative or positive value.
+ */
+static int	radix_cmp(const void *a, const void *b)
+{
+	const t_symbol	*x = *(const t_symbol **)a;
+	const t_symbol	*y = *(const t_symbol **)b;
+
+	if (c_after(x, y))
+		return (1);
+	if (c_after(y, x))
+		return (-1);
+	return ((x < y) ? -1 : 1);
+}
+
+/**
+ * Stable insertion sort of a few symbols in byte order.
+ * @param	ptrs	The symbols.
+ * @param	n		Their number.
+ */
+static void	insertion_sort(const t_symbol **ptrs, size_t n)
+{
+	for (size_t i = 1; i < n; i++)
+	{
+		const t_symbol	*x = ptrs[i];
+		size_t			j = i;
+
+		for (; j > 0 && c_after(ptrs[j - 1], x); j--)
+			ptrs[j] = ptrs[j - 1];
+		ptrs[j] = x;
+	}
+}
+
+/**
+ * Sorts equal names by type letter, with a stable counting pass.
+ * @param	ptrs	The symbols, their names equal.
+ * @param	tmp		A scratch array of the same size.
+ * @param	n		Their number.
+ */
+static void	sort_by_type(const t_symbol **ptrs, const t_symbol **tmp, size_t n)
+{
+	size_t	counts[256];
+	size_t	pos = 0;
+
+	if (n < COLLATE_RADIX_MIN)
+	{
+		insertion_sort(ptrs, n);
+		return;
+	}
+	ft_bzero(counts, sizeof(counts));
+	for (size_t i = 0; i < n; i++)
+		counts[ptrs[i]->type]++;
+	for (size_t b = 0; b < 256; b++)
+	{
+		size_t	c = counts[b];
+
+		counts[b] = pos;
+		pos += c;
+	}
+	for (size_t i = 0; i < n; i++)
+		tmp[counts[ptrs[i]->type]++] = ptrs[i];
+	ft_memcpy(ptrs, tmp, sizeof(t_symbol *) * n);
+}
+
+/**
+ * MSD radix sort of symbols in byte order: a stable counting pass splits
+ * them by the byte at the depth, a run sharing it moves on to the next byte
+ * in place, and each bucket is sorted on its own. Small buckets go to
+ * insertion sort, and past COLLATE_RADIX_LEVELS nested buckets (names with
+ * very long prefixes in common) the rest is left to qsort.
+ * @param	ptrs	The symbols, their first depth bytes equal.
+ * @param	tmp		A scratch array of the same size.
+ * @param	n		Their number.
+ * @param	depth	The byte the symbols are split by.
+ * @param	level	The nesting of the call.
+ */
+static void	radix_sort(const t_symbol **ptrs, const t_symbol **tmp, size_t n, size_t depth, int level)
+{
+	size_t	counts[257];
+	size_t	starts[257];
+	size_t	pos = 0;
+	size_t	first;
+
+	if (n < COLLATE_RADIX_MIN || level >= COLLATE_RADIX_LEVELS)
+	{
+		if (n < COLLATE_RADIX_MIN)
+			insertion_sort(ptrs, n);
+		else
+			qsort(ptrs, n, sizeof(t_symbol *), radix_cmp);
+		return;
+	}
+	do
+	{
+		ft_bzero(counts, sizeof(counts));
+		for (size_t i = 0; i < n; i++)
+			counts[radix_bucket(ptrs[i], depth)]++;
+		first = radix_bucket(ptrs[0], depth);
+	} while (counts[first] == n && first != 0 && ++depth);
+	if (counts[first] == n)
+	{
+		sort_by_type(ptrs, tmp, n);
+		return;
+	}
+	for (size_t b = 0; b < 257; b++)
+	{
+		starts[b] = pos;
+		pos += counts[b];
+	}
+	for (size_t i = 0; i < n; i++)
+		tmp[starts[radix_bucket(ptrs[i], depth)]++] = ptrs[i];
+	ft_memcpy(ptrs, tmp, sizeof(t_symbol *) * n);
+	pos = 0;
+	for (size_t b = 0; b < 257; pos += counts[b++])
+	{
+		if (counts[b] < 2)
+			continue;
+		if (b == 0)
+			sort_by_type(ptrs, tmp, counts[0]);
+		else
+			radix_sort(ptrs + pos, tmp, counts[b], depth + 1, level + 1);
+	}
+}
+
+/**
+ * Sorts symbols in byte order with the radix sort, through an array of
+ * pointers, then moves them into place.
+ * @param	list	The array of symbols.
+ * @param	count	The number of symbols.
+ * @param	arena	The arena the scratch arrays are allocated from, or NULL.
+ * @return	0 on success, 1 on allocation failure (the array is then left
+ * 			unsorted).
+ */
+static int	sort_bytes(t_symbol *list, size_t count, t_arena *arena)
+{
+	const t_symbol	**ptrs = ft_arena_alloc(arena, sizeof(t_symbol *) * count * 2);
+	t_symbol		*sorted = ft_arena_alloc(arena, sizeof(t_symbol) * count);
+
+	if (ptrs && sorted)
+	{
+		for (size_t i = 0; i < count; i++)
+			ptrs[i] = &list[i];
+		radix_sort(ptrs, ptrs + count, count, 0, 0);
+		for (size_t i = 0; i < count; i++)
+			sorted[i] = *ptrs[i];
+		ft_memcpy(list, sorted, sizeof(t_symbol) * count);
+	}
+	ft_arena_drop(arena, ptrs);
+	ft_arena_drop(arena, sorted);
+	return (ptrs == NULL || sorted == NULL);
+}
+
+/**
+ * Sorts the symbols in the listing order of a collation, their keys built.
+ * @param	list		The array of symbols.
+ * @param	count		The number of symbols.
+ * @param	collation	The FTNM_COLLATE_* order.
+ * @param	arena		The arena the scratch buffer is allocated from, or
+ * 						NULL.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	sort_listing(t_symbol *list, size_t count, int collation, t_arena *arena)
+{
+	t_symbol	*tmp;
+
+	if (collation == FTNM_COLLATE_C)
+		return (sort_bytes(list, count, arena));
+	tmp = ft_arena_alloc(arena, sizeof(t_symbol) * count);
+	if (tmp == NULL)
+		return (1);
+	if (collation == FTNM_COLLATE_LOCALE)
+		merge_sort(list, tmp, count, locale_after);
+	else
+		merge_sort(list, tmp, count, symbol_after);
+	ft_arena_drop(arena, tmp);
+	return (0);
+}
+
+/**
+ * Sorts symbols by their name, in the listing order of a collation. The
+ * default, FTNM_COLLATE_COMPAT, follows GNU nm under en_US.UTF-8: names
+ * compared case-insensitively without their underscores, ties broken by type.
+ * FTNM_COLLATE_LOCALE follows strcoll in the current locale and
+ * FTNM_COLLATE_C the bytes of the names. The keys of every name are built
+ * once into a per-file block, so that comparisons only fall back to the raw
+ * names on equal keys.
+ * @param	list		The array of symbols.
+ * @param	count		The number of symbols in the array.
+ * @param	collation	The FTNM_COLLATE_* order.
+ * @param	arena		The arena of the file, or NULL.
+ * @return	0 on success, 1 if the keys cannot be allocated (the array is then
+ * 			left unsorted).
+ */
+int	ft_sort_symbols_by_name(t_symbol *list, size_t count, int collation, t_arena *arena)
+{
+	char	*keys;
+	int		ret;
+
+	if (count < 2)
+		return (0);
+	if (build_keys(list, count, collation, arena, &keys))
+		return (1);
+	ret = sort_listing(list, count, collation, arena);
+	ft_arena_drop(arena, keys);
+	return (ret);
+}
+
+/**
+ * Sorts symbols in the join order of --diff: by collation key, raw name,
+ * type and value. The keys are kept, in an arena the caller frees, for
+ * ft_collate_cmp_names.
+ * @param	list	The array of symbols.
+ * @param	count	The number of symbols in the array.
+ * @param	keys	Set to the arena of the keys, NULL if there is no symbol.
+ * @return	0 on success, 1 on allocation failure.
+ */
+int	ft_sort_symbols_for_join(t_symbol *list, size_t count, char **keys)
+{
+	t_symbol	*tmp;
+
+	*keys = NULL;
+	if (count == 0)
+		return (0);
+	*keys = ft_collate_build_keys(list, count, NULL);
+	tmp = ft_heap_alloc(sizeof(t_symbol) * count);
+	if (*keys == NULL || tmp == NULL)
+	{
+		free(*keys);
+		free(tmp);
+		*keys = NULL;
+		return (1);
+	}
+	merge_sort(list, tmp, count, join_after);
+	free(tmp);
+	return (0);
+}
+
+/**
+ * Sorts symbols in the listing order, like ft_sort_symbols_by_name, but keeps
+ * their keys, in an arena the caller frees: a spilled run stores them so that
+ * its merge compares keys as the in-memory sort does.
+ * @param	list		The array of symbols.
+ * @param	count		The number of symbols in the array.
+ * @param	collation	The FTNM_COLLATE_* order.
+ * @param	keys		Set to the arena of the keys, NULL if there is none.
+ * @return	0 on success, 1 on allocation failure.
+ */
+int	ft_sort_symbols_with_keys(t_symbol *list, size_t count, int collation, char **keys)
+{
+	if (count == 0)
+	{
+		*keys = NULL;
+		return (0);
+	}
+	if (build_keys(list, count, collation, NULL, keys))
+		return (1);
+	if (sort_listing(list, count, collation, NULL))
+	{
+		free(*keys);
+		*keys = NULL;
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * Tells if a symbol sorts after another one in the listing order of a
+ * collation, their keys being built.
+ * @param	a			The first symbol.
+ * @param	b			The second symbol.
+ * @param	collation	The FTNM_COLLATE_* order.
+ * @return	1 if a must be placed after b, 0 otherwise.
+ */
+int	ft_collate_after(const t_symbol *a, const t_symbol *b, int collation)
+{
+	if (collation == FTNM_COLLATE_C)
+		return (c_after(a, b));
+	if (collation == FTNM_COLLATE_LOCALE)
+		return (locale_after(a, b));
+	return (symbol_after(a, b));
+}
@@ -0,0 +1,424 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_dedup.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:59:45 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:22:13 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/*
+ * An input as sorted to find the ones sharing a key: (dev, inode) or size.
+ */
+typedef struct s_dedup_key
+{
+	uint64_t	a;
+	uint64_t	b;
+	size_t		index;
+}	t_dedup_key;
+
+/*
+ * What is done with each range a listing depends on: hashed, or compared
+ * with the same range of an earlier input.
+ */
+typedef struct s_dedup_walk
+{
+	uint64_t	*hash;
+	t_input		*twin;
+}	t_dedup_walk;
+
+/**
+ * Orders keys by value, then by input index.
+ * @param	a	The first key.
+ * @param	b	The second key.
+ * @return	A negative, zero or positive value.
+ */
+static int	key_cmp(const void *a, const void *b)
+{
+	const t_dedup_key	*x = a;
+	const t_dedup_key	*y = b;
+
+	if (x->a != y->a)
+		return ((x->a < y->a) ? -1 : 1);
+	if (x->b != y->b)
+		return ((x->b < y->b) ? -1 : 1);
+	return ((x->index > y->index) - (x->index < y->index));
+}
+
+/**
+ * Chains the inputs sharing a key (inode or size) to the previous one, and
+ * extends the reach of each to the last input of its chain.
+ * @param	dd		The deduplication state, its files stat'ed.
+ * @param	keys	A scratch array of one key per input.
+ * @param	inode	1 to chain by (dev, inode), 0 by size.
+ */
+static void	link_files(t_dedup *dd, t_dedup_key *keys, int inode)
+{
+	size_t	n = 0;
+
+	for (size_t i = 0; i < dd->count; i++)
+	{
+		if (!dd->files[i].known)
+			continue;
+		keys[n].a = inode ? (uint64_t)dd->files[i].dev : (uint64_t)dd->files[i].size;
+		keys[n].b = inode ? (uint64_t)dd->files[i].ino : 0;
+		keys[n++].index = i;
+	}
+	qsort(keys, n, sizeof(t_dedup_key), key_cmp);
+	for (size_t start = 0, end; start < n; start = end)
+	{
+		size_t	last;
+
+		end = start + 1;
+		while (end < n && keys[end].a == keys[start].a && keys[end].b == keys[start].b)
+			end++;
+		last = keys[end - 1].index;
+		for (size_t j = start; j < end; j++)
+		{
+			t_dedup_file	*f = &dd->files[keys[j].index];
+
+			if (j > start && inode)
+				f->prev_inode = keys[j - 1].index;
+			else if (j > start)
+				f->prev_size = keys[j - 1].index;
+			if (f->last < last)
+				f->last = last;
+		}
+	}
+}
+
+/**
+ * Prepares the deduplication of the inputs of a run: each regular file is
+ * stat'ed once, and inputs naming the same inode (through hard or symbolic
+ * links) are chained, as are, when content is set, inputs of the same size.
+ * Only the listing of an input some later input may share is kept.
+ * @param	dd			The deduplication state to set up.
+ * @param	inputs		The paths of the inputs.
+ * @param	count		The number of inputs.
+ * @param	content		1 to also match byte-identical copies.
+ * @param	syscalls	Counter of system calls, increased by the stat calls.
+ * @return	0 on success, 1 on allocation failure (the inputs are then all
+ * 			processed).
+ */
+int	ft_dedup_init(t_dedup *dd, char **inputs, size_t count, int content, uint64_t *syscalls)
+{
+	t_dedup_key	*keys;
+	struct stat	st;
+
+	ft_bzero(dd, sizeof(t_dedup));
+	if (count < 2)
+		return (0);
+	dd->files = malloc(sizeof(t_dedup_file) * count);
+	keys = malloc(sizeof(t_dedup_key) * count);
+	if (dd->files == NULL || keys == NULL)
+	{
+		free(dd->files);
+		free(keys);
+		dd->files = NULL;
+		return (1);
+	}
+	dd->inputs = inputs;
+	dd->count = count;
+	dd->content = content;
+	for (size_t i = 0; i < count; i++)
+	{
+		t_dedup_file	*f = &dd->files[i];
+
+		ft_bzero(f, sizeof(t_dedup_file));
+		f->prev_inode = DEDUP_NONE;
+		f->prev_size = DEDUP_NONE;
+		f->last = i;
+		if (ft_strncmp(inputs[i], "-", 2) == 0)
+			continue;
+		(*syscalls)++;
+		if (stat(inputs[i], &st) == 0 && S_ISREG(st.st_mode))
+			*f = (t_dedup_file){st.st_dev, st.st_ino, st.st_size, 1, DEDUP_NONE, DEDUP_NONE, i, 0, {0, 0},
+				0, NULL, 0};
+	}
+	link_files(dd, keys, 1);
+	if (content)
+		link_files(dd, keys, 0);
+	free(keys);
+	return (0);
+}
+
+/**
+ * Mixes bytes into a 128-bit hash, a word at a time.
+ * @param	h	The two lanes of the hash.
+ * @param	p	The bytes.
+ * @param	n	The number of bytes.
+ */
+static void	hash_bytes(uint64_t h[2], const unsigned char *p, size_t n)
+{
+	uint64_t	w;
+
+	for (; n >= 8; p += 8, n -= 8)
+	{
+		ft_memcpy(&w, p, 8);
+		h[0] = (h[0] ^ w) * DEDUP_PRIME0;
+		h[0] ^= h[0] >> 32;
+		h[1] = (h[1] + w) * DEDUP_PRIME1;
+		h[1] ^= h[1] >> 29;
+	}
+	w = n;
+	for (size_t i = 0; i < n; i++)
+		w = (w << 8) | p[i];
+	h[0] = (h[0] ^ w) * DEDUP_PRIME0;
+	h[0] ^= h[0] >> 32;
+	h[1] = (h[1] + w) * DEDUP_PRIME1;
+	h[1] ^= h[1] >> 29;
+}
+
+/**
+ * Hashes a range of the input of a handle, or compares it with the same range
+ * of the twin input.
+ * @param	walk	The hash, or the twin input.
+ * @param	in		The input.
+ * @param	offset	The start of the range.
+ * @param	size	The size of the range.
+ * @return	0 on success, 1 if the range cannot be read or differs.
+ */
+static int	walk_range(t_dedup_walk *walk, t_input *in, uint64_t offset, uint64_t size)
+{
+	const unsigned char	*data = ft_input_range(in, offset, size);
+	const unsigned char	*other;
+
+	if (data == NULL)
+		return (1);
+	if (walk->twin == NULL)
+	{
+		hash_bytes(walk->hash, data, size);
+		return (0);
+	}
+	other = ft_input_range(walk->twin, offset, size);
+	return (other == NULL || ft_memcmp(data, other, size) != 0);
+}
+
+/**
+ * Walks what the listing of a file depends on: its ELF and section headers
+ * and the contents of its symbol, string and version tables. With -l, which
+ * reads the debug sections, and for files not in the byte order of the host,
+ * the whole file is walked instead. The tables were validated when the
+ * handle was opened.
+ * @param	handle	The handle of the file.
+ * @param	whole	1 to walk the whole file.
+ * @param	walk	What to do with each range.
+ * @return	0 on success, 1 if a range cannot be read or differs.
+ */
+static int	walk_content(t_ftnm *handle, int whole, t_dedup_walk *walk)
+{
+	int					is_64 = (handle->bits == 64);
+	size_t				ehdr_size = is_64 ? sizeof(Elf64_Ehdr) : sizeof(Elf32_Ehdr);
+	const unsigned char	*ehdr = ft_input_range(&handle->in, 0, ehdr_size);
+	uint64_t			shoff;
+	size_t				shnum;
+	const void			*shdrs;
+	t_section			sec;
+
+	if (ehdr == NULL)
+		return (1);
+	if (whole || ehdr[EI_DATA] != ELFDATA2LSB)
+		return (walk_range(walk, &handle->in, 0, handle->in.size));
+	shoff = is_64 ? ((const Elf64_Ehdr *)ehdr)->e_shoff : ((const Elf32_Ehdr *)ehdr)->e_shoff;
+	shnum = is_64 ? ((const Elf64_Ehdr *)ehdr)->e_shnum : ((const Elf32_Ehdr *)ehdr)->e_shnum;
+	if (walk_range(walk, &handle->in, 0, ehdr_size)
+		|| walk_range(walk, &handle->in, shoff, shnum * (is_64 ? sizeof(Elf64_Shdr) : sizeof(Elf32_Shdr))))
+		return (1);
+	shdrs = ft_input_range(&handle->in, shoff, shnum * (is_64 ? sizeof(Elf64_Shdr) : sizeof(Elf32_Shdr)));
+	for (size_t i = 0; i < shnum; i++)
+	{
+		ft_section_header(shdrs, i, is_64, &sec);
+		if ((sec.type == SHT_SYMTAB || sec.type == SHT_DYNSYM || sec.type == SHT_STRTAB
+				|| sec.type == SHT_GNU_versym || sec.type == SHT_GNU_verdef || sec.type == SHT_GNU_verneed)
+			&& sec.size && walk_range(walk, &handle->in, sec.offset, sec.size))
+			return (1);
+	}
+	return (0);
+}
+
+/**
+ * Hashes what the listing of a file depends on (see walk_content).
+ * @param	handle	The handle of the file.
+ * @param	whole	1 to hash the whole file.
+ * @param	h		Set to the hash.
+ * @return	0 on success, 1 if a range cannot be read.
+ */
+static int	content_hash(t_ftnm *handle, int whole, uint64_t h[2])
+{
+	t_dedup_walk	walk = {h, NULL};
+
+	h[0] = DEDUP_PRIME1 ^ handle->in.size;
+	h[1] = DEDUP_PRIME0;
+	return (walk_content(handle, whole, &walk));
+}
+
+/**
+ * Confirms that an earlier input whose hash matches really has the same
+ * bytes as the file, by comparing the hashed ranges of both. The earlier
+ * input is opened again, its handle being closed by now.
+ * @param	handle	The handle of the file.
+ * @param	whole	1 to compare the whole files.
+ * @param	path	The path of the earlier input.
+ * @param	nm		The run context, for the system call counter.
+ * @return	1 if the ranges are identical, 0 otherwise.
+ */
+static int	content_equal(t_ftnm *handle, int whole, const char *path, t_nm *nm)
+{
+	t_input_pool	pool;
+	t_input			twin;
+	t_dedup_walk	walk = {NULL, &twin};
+	int				fd = open(path, O_RDONLY | O_CLOEXEC);
+	int				same = 0;
+
+	nm->stats.syscalls++;
+	if (fd < 0)
+		return (0);
+	ft_bzero(&pool, sizeof(pool));
+	if (ft_input_open(&twin, fd, &pool, 0) == 0)
+	{
+		same = (twin.size == handle->in.size && walk_content(handle, whole, &walk) == 0);
+		nm->stats.syscalls += twin.syscalls;
+		ft_input_close(&twin);
+	}
+	ft_input_pool_free(&pool);
+	close(fd);
+	nm->stats.syscalls++;
+	return (same);
+}
+
+/**
+ * Replays the kept listing of an earlier input identical to this one under
+ * its filename header. Before the file is opened (no handle), the inputs
+ * sharing its inode are looked at; once it is opened, with content matching,
+ * its hash is taken and compared to the earlier inputs of the same size, and
+ * an earlier input with the same hash is only used once its bytes are found
+ * to be the same.
+ * @param	dd			The deduplication state.
+ * @param	index		The index of the input.
+ * @param	handle		The handle of the opened file, or NULL.
+ * @param	filename	The name of the input.
+ * @param	nm			The run context.
+ * @return	1 if the listing was replayed, 0 if the file must be listed.
+ */
+int	ft_dedup_replay(t_dedup *dd, size_t index, t_ftnm *handle, char *filename, t_nm *nm)
+{
+	t_dedup_file		*f;
+	const t_dedup_file	*twin = NULL;
+
+	if (dd->files == NULL)
+		return (0);
+	f = &dd->files[index];
+	if (handle == NULL)
+	{
+		for (size_t i = f->prev_inode; twin == NULL && i != DEDUP_NONE; i = dd->files[i].prev_inode)
+			if (dd->files[i].kept)
+				twin = &dd->files[i];
+	}
+	else if (dd->content && (f->prev_size != DEDUP_NONE || f->last > index)
+		&& content_hash(handle, nm->opts.config.line_numbers, f->hash) == 0)
+	{
+		f->hashed = 1;
+		for (size_t i = f->prev_size; twin == NULL && i != DEDUP_NONE; i = dd->files[i].prev_size)
+			if (dd->files[i].kept && dd->files[i].hashed
+				&& dd->files[i].hash[0] == f->hash[0] && dd->files[i].hash[1] == f->hash[1]
+				&& content_equal(handle, nm->opts.config.line_numbers, dd->inputs[i], nm))
+				twin = &dd->files[i];
+	}
+	if (twin == NULL)
+		return (0);
+	ft_print_file_header(filename, nm);
+	ft_writer_put(&nm->out, twin->body, twin->body_len);
+	ft_writer_flush(&nm->out);
+	return (1);
+}
+
+/**
+ * Prints the BSD listing of a file. When a later input may share it, the
+ * listing is formatted into memory first and kept for ft_dedup_replay; if
+ * that memory cannot be had, it is printed as usual.
+ * @param	dd			The deduplication state.
+ * @param	index		The index of the input.
+ * @param	handle		The handle of the file, sorted.
+ * @param	filename	The name of the input.
+ * @param	nm			The run context.
+ */
+void	ft_dedup_print(t_dedup *dd, size_t index, const t_ftnm *handle, char *filename, t_nm *nm)
+{
+	t_dedup_file	*f;
+	t_writer		*mem;
+
+	if (dd->files == NULL || dd->files[index].last <= index
+		|| (mem = malloc(sizeof(t_writer))) == NULL)
+	{
+		ft_print_symbols_list(handle, filename, nm);
+		return;
+	}
+	f = &dd->files[index];
+	ft_writer_init_memory(mem);
+	ft_print_symbols(handle, mem, &nm->opts);
+	if (mem->failed)
+	{
+		ft_writer_free_memory(mem);
+		free(mem);
+		ft_print_symbols_list(handle, filename, nm);
+		return;
+	}
+	ft_print_file_header(filename, nm);
+	ft_writer_put(&nm->out, mem->mem, mem->mem_len);
+	ft_writer_flush(&nm->out);
+	f->kept = 1;
+	f->body = mem->mem;
+	f->body_len = mem->mem_len;
+	free(mem);
+}
+
+/**
+ * Frees the kept listing of an input.
+ * @param	f	The input.
+ */
+static void	drop_body(t_dedup_file *f)
+{
+	free(f->body);
+	f->body = NULL;
+	f->body_len = 0;
+	f->kept = 0;
+}
+
+/**
+ * Frees the listings no input after this one may share: its own if nothing
+ * follows it, and those of the earlier inputs it was the last one of.
+ * @param	dd		The deduplication state.
+ * @param	index	The index of the input just processed.
+ */
+void	ft_dedup_done(t_dedup *dd, size_t index)
+{
+	t_dedup_file	*files = dd->files;
+
+	if (files == NULL)
+		return;
+	if (files[index].last <= index)
+		drop_body(&files[index]);
+	for (size_t i = files[index].prev_inode; i != DEDUP_NONE; i = files[i].prev_inode)
+		if (files[i].last <= index)
+			drop_body(&files[i]);
+	for (size_t i = files[index].prev_size; i != DEDUP_NONE; i = files[i].prev_size)
+		if (files[i].last <= index)
+			drop_body(&files[i]);
+}
+
+/**
+ * Frees the deduplication state at the end of the run.
+ * @param	dd	The deduplication state.
+ */
+void	ft_dedup_free(t_dedup *dd)
+{
+	for (size_t i = 0; dd->files && i < dd->count; i++)
+		drop_body(&dd->files[i]);
+	free(dd->files);
+	dd->files = NULL;
+}
@@ -6,7 +6,7 @@
 /*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
 /*                                                +#+#+#+#+#+   +#+           */
 /*   Created: 2023/08/09 13:56:30 by jbertin           #+#    #+#             */
-/*   Updated: 2023/08/10 17:12:41 by jbertin          ###   ########.fr       */
+/*   Updated: 2026/10/19 19:45:13 by jbertin          ###   ########.fr       */
 /*                                                                            */
 /* ************************************************************************** */
 
@@ -41,7 +41,7 @@ unsigned char	ft_define_symbol32(Elf32_Sym *symtab, Elf32_Shdr *o_shdr, int endi
 	if (st_shndx == SHN_UNDEF) return 'U';
 
 	if (st_shndx == SHN_ABS)
-		return ((type == STT_OBJECT) && (bind == STB_LOCAL)) ? 'a' : 'A';
+		return (bind == STB_LOCAL) ? 'a' : 'A';
 
 	if (related_shdr->sh_type == SHT_PROGBITS)
 	{
@@ -94,7 +94,7 @@ unsigned char	ft_define_symbol64(Elf64_Sym *symtab, Elf64_Shdr *o_shdr, int endi
 
 	else if (st_shndx == SHN_COMMON) return ('C');
 
-	else if (st_shndx == SHN_ABS) return ('A');
+	else if (st_shndx == SHN_ABS) return (bind == STB_LOCAL) ? 'a' : 'A';
 
 	else if (st_shndx == SHN_UNDEF) return ('U');
 
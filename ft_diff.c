@@ -0,0 +1,255 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_diff.c                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:38:22 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 17:39:24 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+typedef struct s_diff
+{
+	t_writer			*out;
+	int					digits;
+	size_t				added;
+	size_t				removed;
+	size_t				retyped;
+	size_t				resized;
+	size_t				moved;
+}	t_diff;
+
+/**
+ * Writes a value column: the value in hexadecimal on the width of the
+ * files, or blanks for undefined symbols, which have none.
+ * @param	diff	The diff context.
+ * @param	value	The value.
+ * @param	type	The type letter of the symbol.
+ */
+static void	put_value(t_diff *diff, uint64_t value, char type)
+{
+	char	buf[16];
+
+	for (int i = diff->digits - 1; i >= 0; --i, value >>= 4)
+		buf[i] = (type == 'U' || type == 'w' || type == 'v') ? ' ' : "0123456789abcdef"[value & 0xF];
+	ft_writer_put(diff->out, buf, diff->digits);
+}
+
+/**
+ * Reports a symbol found in one file only, as "+ value type name" for the
+ * new file or "- value type name" for the old one.
+ * @param	diff	The diff context.
+ * @param	mark	'+' or '-'.
+ * @param	symbol	The symbol.
+ */
+static void	put_symbol(t_diff *diff, char mark, const t_symbol *symbol)
+{
+	ft_writer_putc(diff->out, mark);
+	ft_writer_putc(diff->out, ' ');
+	put_value(diff, symbol->value, symbol->type);
+	ft_writer_putc(diff->out, ' ');
+	ft_writer_putc(diff->out, symbol->type);
+	ft_writer_putc(diff->out, ' ');
+	ft_writer_put(diff->out, symbol->name, symbol->name_len);
+	ft_writer_putc(diff->out, '\n');
+	if (mark == '+')
+		diff->added++;
+	else
+		diff->removed++;
+}
+
+/**
+ * Compares a symbol of the old file with the symbol of the same name in the
+ * new one, and reports what changed on a single "~ name: ..." line: the
+ * type, the size and, for symbols defined in both files, the address.
+ * @param	diff	The diff context.
+ * @param	old		The symbol in the old file.
+ * @param	new		The symbol in the new file.
+ */
+static void	compare_pair(t_diff *diff, const t_symbol *old, const t_symbol *new)
+{
+	int	retyped = (old->type != new->type);
+	int	resized = (old->size != new->size);
+	int	moved = (old->value != new->value && old->type != 'U' && new->type != 'U');
+	int	first = 1;
+
+	if (!retyped && !resized && !moved)
+		return;
+	ft_writer_put(diff->out, "~ ", 2);
+	ft_writer_put(diff->out, old->name, old->name_len);
+	ft_writer_putc(diff->out, ':');
+	if (retyped)
+	{
+		ft_writer_put(diff->out, " type ", 6);
+		ft_writer_putc(diff->out, old->type);
+		ft_writer_put(diff->out, " -> ", 4);
+		ft_writer_putc(diff->out, new->type);
+		first = 0;
+	}
+	if (resized)
+	{
+		ft_writer_put(diff->out, first ? " size " : ", size ", first ? 6 : 7);
+		ft_writer_putnbr(diff->out, old->size);
+		ft_writer_put(diff->out, " -> ", 4);
+		ft_writer_putnbr(diff->out, new->size);
+		first = 0;
+	}
+	if (moved)
+	{
+		ft_writer_put(diff->out, first ? " address " : ", address ", first ? 9 : 10);
+		put_value(diff, old->value, old->type);
+		ft_writer_put(diff->out, " -> ", 4);
+		put_value(diff, new->value, new->type);
+	}
+	ft_writer_putc(diff->out, '\n');
+	diff->retyped += retyped;
+	diff->resized += resized;
+	diff->moved += moved;
+}
+
+/**
+ * Diffs the symbols sharing a name in both files. A name defined once on
+ * each side, by far the usual case, is a single pair; otherwise (local
+ * symbols of several translation units) the symbols are paired by type, in
+ * address order, and the ones left over are reported as added or removed.
+ * @param	diff	The diff context.
+ * @param	old		The symbols of the name in the old file.
+ * @param	nold	Their number.
+ * @param	new		The symbols of the name in the new file.
+ * @param	nnew	Their number.
+ */
+static void	diff_run(t_diff *diff, const t_symbol *old, size_t nold, const t_symbol *new, size_t nnew)
+{
+	size_t	i = 0;
+	size_t	j = 0;
+
+	if (nold == 1 && nnew == 1)
+	{
+		compare_pair(diff, old, new);
+		return;
+	}
+	while (i < nold && j < nnew)
+	{
+		if (old[i].type == new[j].type)
+			compare_pair(diff, &old[i++], &new[j++]);
+		else if (old[i].type < new[j].type)
+			put_symbol(diff, '-', &old[i++]);
+		else
+			put_symbol(diff, '+', &new[j++]);
+	}
+	while (i < nold)
+		put_symbol(diff, '-', &old[i++]);
+	while (j < nnew)
+		put_symbol(diff, '+', &new[j++]);
+}
+
+/**
+ * Drops the symbols the listing would hide (null absolute symbols without
+ * -a), keeping the others in place.
+ * @param	handle	The handle.
+ * @param	opts	The options of the run.
+ */
+static void	drop_hidden(t_ftnm *handle, const t_options *opts)
+{
+	size_t	kept = 0;
+
+	for (size_t i = 0; i < handle->count; i++)
+	{
+		t_ftnm_symbol	symbol = {.type = handle->symbols[i].type, .value = handle->symbols[i].value};
+
+		if (!ft_symbol_is_hidden(&symbol, opts))
+			handle->symbols[kept++] = handle->symbols[i];
+	}
+	handle->count = kept;
+}
+
+/**
+ * Writes the counts of the report.
+ * @param	diff	The diff context.
+ */
+static void	put_summary(t_diff *diff)
+{
+	ft_writer_put(diff->out, "added ", 6);
+	ft_writer_putnbr(diff->out, diff->added);
+	ft_writer_put(diff->out, ", removed ", 10);
+	ft_writer_putnbr(diff->out, diff->removed);
+	ft_writer_put(diff->out, ", type changed ", 15);
+	ft_writer_putnbr(diff->out, diff->retyped);
+	ft_writer_put(diff->out, ", size changed ", 15);
+	ft_writer_putnbr(diff->out, diff->resized);
+	ft_writer_put(diff->out, ", moved ", 8);
+	ft_writer_putnbr(diff->out, diff->moved);
+	ft_writer_putc(diff->out, '\n');
+}
+
+/**
+ * Reports the differences between the symbol tables of two files. Both
+ * tables are sorted in the name collation (ft_sort_symbols_for_join), then
+ * merge-joined in a single linear pass: names found on one side only are
+ * added or removed symbols, names found on both sides are compared. The
+ * filters of the run (-g, -u, -U, -D, --match) apply to both files.
+ * @param	old			The handle of the old file.
+ * @param	new			The handle of the new file.
+ * @param	names		The names of the old and new files, for the header.
+ * @param	nm			The run context.
+ * @return	0 if the tables match, 1 if they differ, 2 on allocation failure.
+ */
+int	ft_diff(t_ftnm *old, t_ftnm *new, char **names, t_nm *nm)
+{
+	t_diff	diff;
+	char	*keys[2];
+	size_t	i = 0;
+	size_t	j = 0;
+
+	ft_bzero(&diff, sizeof(t_diff));
+	diff.out = &nm->out;
+	diff.digits = (ftnm_class(old) == 64 || ftnm_class(new) == 64) ? 16 : 8;
+	drop_hidden(old, &nm->opts);
+	drop_hidden(new, &nm->opts);
+	if (ft_sort_symbols_for_join(old->symbols, old->count, &keys[0])
+		|| ft_sort_symbols_for_join(new->symbols, new->count, &keys[1]))
+	{
+		free(keys[0]);
+		ft_printf("Error allocating memory\n");
+		return (2);
+	}
+	ft_writer_put(diff.out, "--- ", 4);
+	ft_writer_putstr(diff.out, names[0]);
+	ft_writer_put(diff.out, "\n+++ ", 5);
+	ft_writer_putstr(diff.out, names[1]);
+	ft_writer_putc(diff.out, '\n');
+	while (i < old->count || j < new->count)
+	{
+		int		comparison;
+		size_t	ni = 1;
+		size_t	nj = 1;
+
+		if (i == old->count || j == new->count)
+			comparison = (i == old->count) ? 1 : -1;
+		else
+			comparison = ft_collate_cmp_names(&old->symbols[i], &new->symbols[j]);
+		if (comparison < 0)
+			put_symbol(&diff, '-', &old->symbols[i++]);
+		else if (comparison > 0)
+			put_symbol(&diff, '+', &new->symbols[j++]);
+		else
+		{
+			while (i + ni < old->count && ft_collate_cmp_names(&old->symbols[i], &old->symbols[i + ni]) == 0)
+				ni++;
+			while (j + nj < new->count && ft_collate_cmp_names(&new->symbols[j], &new->symbols[j + nj]) == 0)
+				nj++;
+			diff_run(&diff, &old->symbols[i], ni, &new->symbols[j], nj);
+			i += ni;
+			j += nj;
+		}
+	}
+	put_summary(&diff);
+	ft_writer_flush(diff.out);
+	free(keys[0]);
+	free(keys[1]);
+	return (diff.added || diff.removed || diff.retyped || diff.resized || diff.moved);
+}
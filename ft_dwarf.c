@@ -0,0 +1,247 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_dwarf.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:21:19 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:46:28 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+#define DWARF_NSECTIONS	10
+
+static const char	*g_debug_sections[DWARF_NSECTIONS] = {".debug_info", ".debug_abbrev", ".debug_line",
+	".debug_line_str", ".debug_str", ".debug_str_offsets", ".debug_addr", ".debug_aranges", ".debug_ranges",
+	".debug_rnglists"};
+
+/**
+ * Makes room for one more element in a table grown by doubling from 64
+ * elements, its capacity following from its count.
+ * @param	table	The table, may be NULL while empty.
+ * @param	count	The number of elements in the table.
+ * @param	size	The size of an element.
+ * @return	0 on success, 1 on allocation failure.
+ */
+int	ft_dwarf_grow(void **table, size_t count, size_t size)
+{
+	void	*grown;
+
+	if (count != 0 && (count < 64 || (count & (count - 1)) != 0))
+		return (0);
+	grown = ft_heap_alloc(size * (count ? count * 2 : 64));
+	if (grown == NULL)
+		return (1);
+	if (count)
+		ft_memcpy(grown, *table, size * count);
+	free(*table);
+	*table = grown;
+	return (0);
+}
+
+/**
+ * Finds the debug sections of the file by name, relocating them in a
+ * relocatable file. Compressed sections are left out, as are string
+ * sections that do not end with a NUL byte.
+ * @param	d	The DWARF context.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	load_sections(t_dwarf *d)
+{
+	t_dwarf_section	*slots[DWARF_NSECTIONS] = {&d->info, &d->abbrev, &d->line, &d->line_str, &d->str,
+		&d->str_offsets, &d->addr, &d->aranges, &d->rangelists, &d->rnglists};
+	t_section		sec;
+
+	for (size_t i = 1; d->shstrtab && i < d->shnum; i++)
+	{
+		size_t	k = 0;
+
+		ft_section_header(d->shdrs, i, d->is_64, &sec);
+		if (sec.type == SHT_NOBITS || (sec.flags & SHF_COMPRESSED))
+			continue;
+		while (k < DWARF_NSECTIONS && ft_strncmp(d->shstrtab + sec.name, g_debug_sections[k],
+				ft_strlen(g_debug_sections[k]) + 1) != 0)
+			k++;
+		if (k == DWARF_NSECTIONS || slots[k]->data != NULL
+			|| (slots[k]->data = ft_dwarf_image(d, sec.offset, sec.size)) == NULL)
+			continue;
+		slots[k]->size = sec.size;
+		if (d->rel && ft_dwarf_relocate(d, i, slots[k]))
+			return (1);
+	}
+	if (d->str.size == 0 || d->str.data[d->str.size - 1] != '\0')
+		d->str = (t_dwarf_section){NULL, 0, NULL, 0};
+	if (d->line_str.size == 0 || d->line_str.data[d->line_str.size - 1] != '\0')
+		d->line_str = (t_dwarf_section){NULL, 0, NULL, 0};
+	return (0);
+}
+
+/**
+ * Reads the header of a unit of .debug_info. Type units and units of an
+ * unknown version or address size are left out.
+ * @param	d		The DWARF context.
+ * @param	offset	The offset of the unit.
+ * @param	u		The unit to fill.
+ * @return	0 for a unit to keep, 1 for a unit to skip, -1 if the section
+ * 			ends.
+ */
+static int	read_unit(const t_dwarf *d, uint64_t offset, t_dwarf_unit *u)
+{
+	t_dwarf_cursor	c;
+	int				offset_size;
+	uint64_t		length;
+	uint8_t			type = DW_UT_compile;
+
+	ft_dwarf_cursor(&c, &d->info, offset, d->info.size, d->endian);
+	length = ft_dwarf_length(&c, &offset_size);
+	if (c.bad || length > (uint64_t)(c.end - c.pos))
+		return (-1);
+	ft_bzero(u, sizeof(t_dwarf_unit));
+	u->offset = offset;
+	u->end = (c.pos - c.base) + length;
+	c.end = c.base + u->end;
+	u->offset_size = offset_size;
+	u->version = ft_dwarf_fixed(&c, 2);
+	if (u->version >= 5)
+	{
+		type = ft_dwarf_fixed(&c, 1);
+		u->addr_size = ft_dwarf_fixed(&c, 1);
+		u->abbrev = ft_dwarf_fixed(&c, offset_size);
+		if (type == DW_UT_skeleton || type == DW_UT_split_compile)
+			ft_dwarf_fixed(&c, 8);
+	}
+	else
+	{
+		u->abbrev = ft_dwarf_fixed(&c, offset_size);
+		u->addr_size = ft_dwarf_fixed(&c, 1);
+	}
+	u->die = c.pos - c.base;
+	if (c.bad || u->version < 2 || u->version > 5 || (u->addr_size != 4 && u->addr_size != 8))
+		return (1);
+	return (type != DW_UT_compile && type != DW_UT_partial && type != DW_UT_skeleton);
+}
+
+/**
+ * Reads the root DIE of a unit: its line program, compilation directory,
+ * base address, and the bases of its string, address and range list
+ * indexes.
+ * @param	d	The DWARF context.
+ * @param	u	The unit.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	read_root(t_dwarf *d, t_dwarf_unit *u)
+{
+	t_dwarf_abbrev	*abbrevs;
+	t_dwarf_die		die;
+	size_t			count;
+
+	abbrevs = ft_dwarf_abbrevs(d, u->abbrev, &count);
+	if (abbrevs == NULL)
+		return (d->failed = 1);
+	if (!ft_dwarf_die(d, u, abbrevs, count, u->die, &die))
+	{
+		if ((die.present & (1u << DWARF_DIE_STR_OFFSETS)) && die.attrs[DWARF_DIE_STR_OFFSETS].kind == DWARF_NUM)
+			u->str_offsets_base = die.attrs[DWARF_DIE_STR_OFFSETS].num;
+		if ((die.present & (1u << DWARF_DIE_ADDR_BASE)) && die.attrs[DWARF_DIE_ADDR_BASE].kind == DWARF_NUM)
+			u->addr_base = die.attrs[DWARF_DIE_ADDR_BASE].num;
+		if ((die.present & (1u << DWARF_DIE_RNGLISTS)) && die.attrs[DWARF_DIE_RNGLISTS].kind == DWARF_NUM)
+			u->rnglists_base = die.attrs[DWARF_DIE_RNGLISTS].num;
+		if ((die.present & (1u << DWARF_DIE_LOW_PC)) && die.attrs[DWARF_DIE_LOW_PC].kind == DWARF_ADDR)
+		{
+			u->low_pc = die.attrs[DWARF_DIE_LOW_PC].num;
+			u->low_shndx = die.attrs[DWARF_DIE_LOW_PC].shndx;
+		}
+		else if ((die.present & (1u << DWARF_DIE_LOW_PC)) && die.attrs[DWARF_DIE_LOW_PC].kind == DWARF_ADDRX)
+			u->low_pc = ft_dwarf_addrx(d, u, die.attrs[DWARF_DIE_LOW_PC].num, &u->low_shndx);
+		if ((die.present & (1u << DWARF_DIE_STMT_LIST)) && die.attrs[DWARF_DIE_STMT_LIST].kind == DWARF_NUM)
+		{
+			u->has_lines = 1;
+			u->stmt_list = die.attrs[DWARF_DIE_STMT_LIST].num;
+		}
+		if (die.present & (1u << DWARF_DIE_COMP_DIR))
+			u->comp_dir = ft_dwarf_value_string(d, u, &die.attrs[DWARF_DIE_COMP_DIR]);
+	}
+	free(abbrevs);
+	return (0);
+}
+
+/**
+ * Lists the units of .debug_info with what their root DIE tells, in order
+ * of offset: a first pass counts them, a second one reads them.
+ * @param	d	The DWARF context.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	scan_units(t_dwarf *d)
+{
+	t_dwarf_unit	u;
+	size_t			n = 0;
+	int				ret;
+
+	for (uint64_t offset = 0; offset < d->info.size && (ret = read_unit(d, offset, &u)) >= 0; offset = u.end)
+		n += (ret == 0);
+	if (n == 0)
+		return (0);
+	d->units = ft_arena_alloc(d->arena, sizeof(t_dwarf_unit) * n);
+	if (d->units == NULL)
+		return (d->failed = 1);
+	for (uint64_t offset = 0; offset < d->info.size && (ret = read_unit(d, offset, &u)) >= 0; offset = u.end)
+	{
+		if (ret != 0)
+			continue;
+		d->units[d->nunits] = u;
+		if (read_root(d, &d->units[d->nunits++]))
+			return (1);
+	}
+	return (0);
+}
+
+/**
+ * Prepares the decoding of the DWARF line information of an ELF file for -l:
+ * the debug sections are found (and relocated in a relocatable file) and
+ * the units listed. Line programs and DIEs are only decoded once a symbol
+ * needs them.
+ * @param	d			The context to initialize.
+ * @param	elf			The ELF file, its tables validated.
+ * @param	is_64		1 for ELF64, 0 for ELF32.
+ * @param	symtab		The index of the symbol table listed.
+ * @param	arena		The arena of the file, or NULL to use the own arena of
+ * 						the context.
+ * @return	0 on success (the file may have no line information), 1 on
+ * 			allocation failure.
+ */
+int	ft_dwarf_init(t_dwarf *d, t_elf *elf, int is_64, size_t symtab, t_arena *arena)
+{
+	ft_bzero(d, sizeof(t_dwarf));
+	d->arena = arena ? arena : &d->own;
+	d->shdrs = elf->shdrs;
+	d->shnum = elf->shnum;
+	d->shstrtab = elf->shstrtab;
+	d->symtab = elf->symtab;
+	d->nsyms = elf->nsyms;
+	d->symtab_index = symtab;
+	d->is_64 = is_64;
+	d->endian = elf->endian;
+	d->rel = (ft_read_uint16(elf->in->header + 16, d->endian) == ET_REL);
+	d->machine = ft_read_uint16(elf->in->header + 18, d->endian);
+	d->image = ft_input_range(elf->in, 0, elf->in->size);
+	if (d->image == NULL)
+		return (0);
+	d->image_size = elf->in->size;
+	return (load_sections(d) || scan_units(d));
+}
+
+/**
+ * Releases what a DWARF context holds. Locations it returned become invalid.
+ * @param	d	The DWARF context.
+ */
+void	ft_dwarf_free(t_dwarf *d)
+{
+	free(d->ranges);
+	free(d->decls);
+	free(d->undefined);
+	ft_arena_free(&d->own);
+	ft_bzero(d, sizeof(t_dwarf));
+}
@@ -0,0 +1,576 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_dwarf_die.c                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:18:29 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:46:28 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+#include "includes/nm.h"
+
+#define DWARF_MAX_ABBREV	65536
+#define DWARF_MAX_ORIGINS	4
+
+/**
+ * Skips the attribute specifications of an abbreviation, up to the null
+ * pair ending them.
+ * @param	c	The cursor, at the first specification.
+ */
+static void	skip_specs(t_dwarf_cursor *c)
+{
+	while (!c->bad)
+	{
+		uint64_t	name = ft_dwarf_uleb(c);
+		uint64_t	form = ft_dwarf_uleb(c);
+
+		if (form == DW_FORM_implicit_const)
+			ft_dwarf_sleb(c);
+		if (name == 0 && form == 0)
+			break;
+	}
+}
+
+/**
+ * Reads the abbreviation table of a unit into an array indexed by code, each
+ * entry keeping the offset of its attribute specifications, which are read
+ * again for every DIE using it. Codes past DWARF_MAX_ABBREV are left out.
+ * @param	d		The DWARF context.
+ * @param	offset	The offset of the table in .debug_abbrev.
+ * @param	count	Set to the size of the array.
+ * @return	The array (to free), or NULL on allocation failure.
+ */
+t_dwarf_abbrev	*ft_dwarf_abbrevs(const t_dwarf *d, uint64_t offset, size_t *count)
+{
+	t_dwarf_cursor	c;
+	t_dwarf_abbrev	*table;
+	uint64_t		code;
+	size_t			max = 0;
+
+	*count = 0;
+	ft_dwarf_cursor(&c, &d->abbrev, offset, d->abbrev.size, d->endian);
+	while (!c.bad && (code = ft_dwarf_uleb(&c)) != 0)
+	{
+		ft_dwarf_uleb(&c);
+		ft_dwarf_fixed(&c, 1);
+		skip_specs(&c);
+		if (code < DWARF_MAX_ABBREV && code > max)
+			max = code;
+	}
+	table = ft_heap_calloc(max + 1, sizeof(t_dwarf_abbrev));
+	if (table == NULL)
+		return (NULL);
+	ft_dwarf_cursor(&c, &d->abbrev, offset, d->abbrev.size, d->endian);
+	while (!c.bad && (code = ft_dwarf_uleb(&c)) != 0)
+	{
+		uint64_t	tag = ft_dwarf_uleb(&c);
+		uint8_t		children = ft_dwarf_fixed(&c, 1);
+
+		if (code <= max && table[code].tag == 0)
+			table[code] = (t_dwarf_abbrev){tag, c.pos - c.base, children};
+		skip_specs(&c);
+	}
+	*count = max + 1;
+	return (table);
+}
+
+/**
+ * Maps a DWARF attribute to the slot of a DIE it is kept in.
+ * @param	name	The attribute.
+ * @return	The slot, or -1 for an attribute the decoder has no use for.
+ */
+static int	attr_slot(uint64_t name)
+{
+	if (name == DW_AT_name)
+		return (DWARF_DIE_NAME);
+	if (name == DW_AT_linkage_name || name == DW_AT_MIPS_linkage_name)
+		return (DWARF_DIE_LINKAGE);
+	if (name == DW_AT_decl_file)
+		return (DWARF_DIE_FILE);
+	if (name == DW_AT_decl_line)
+		return (DWARF_DIE_LINE);
+	if (name == DW_AT_low_pc)
+		return (DWARF_DIE_LOW_PC);
+	if (name == DW_AT_high_pc)
+		return (DWARF_DIE_HIGH_PC);
+	if (name == DW_AT_external)
+		return (DWARF_DIE_EXTERNAL);
+	if (name == DW_AT_ranges)
+		return (DWARF_DIE_RANGES);
+	if (name == DW_AT_rnglists_base)
+		return (DWARF_DIE_RNGLISTS);
+	if (name == DW_AT_location)
+		return (DWARF_DIE_LOCATION);
+	if (name == DW_AT_specification || name == DW_AT_abstract_origin)
+		return (DWARF_DIE_ORIGIN);
+	if (name == DW_AT_stmt_list)
+		return (DWARF_DIE_STMT_LIST);
+	if (name == DW_AT_comp_dir)
+		return (DWARF_DIE_COMP_DIR);
+	if (name == DW_AT_str_offsets_base)
+		return (DWARF_DIE_STR_OFFSETS);
+	if (name == DW_AT_addr_base)
+		return (DWARF_DIE_ADDR_BASE);
+	return (-1);
+}
+
+/**
+ * Reads the DIE at an offset of a unit, keeping the attributes the decoder
+ * uses in their slots (a bit of present is set for each) and skipping the
+ * others.
+ * @param	d		The DWARF context.
+ * @param	u		The unit.
+ * @param	abbrevs	The abbreviation table of the unit.
+ * @param	count	The size of the table.
+ * @param	offset	The offset of the DIE in .debug_info.
+ * @param	die		The DIE to fill: its tag is 0 for a null entry, next is
+ * 					the offset of the following DIE.
+ * @return	0 on success, 1 if the DIE is malformed.
+ */
+int	ft_dwarf_die(const t_dwarf *d, const t_dwarf_unit *u, const t_dwarf_abbrev *abbrevs, size_t count,
+	uint64_t offset, t_dwarf_die *die)
+{
+	t_dwarf_cursor	c;
+	t_dwarf_cursor	specs;
+	t_dwarf_value	skipped;
+	uint64_t		code;
+
+	ft_dwarf_cursor(&c, &d->info, offset, u->end, d->endian);
+	code = ft_dwarf_uleb(&c);
+	die->tag = 0;
+	die->present = 0;
+	die->next = c.pos - c.base;
+	if (c.bad || code == 0)
+		return (c.bad);
+	if (code >= count || abbrevs[code].tag == 0)
+		return (1);
+	die->tag = abbrevs[code].tag;
+	ft_dwarf_cursor(&specs, &d->abbrev, abbrevs[code].specs, d->abbrev.size, d->endian);
+	while (1)
+	{
+		uint64_t	name = ft_dwarf_uleb(&specs);
+		uint64_t	form = ft_dwarf_uleb(&specs);
+		int64_t		implicit = (form == DW_FORM_implicit_const) ? ft_dwarf_sleb(&specs) : 0;
+		int			slot = attr_slot(name);
+
+		if (specs.bad)
+			return (1);
+		if (name == 0 && form == 0)
+			break;
+		if (ft_dwarf_form(d, u, &c, form, implicit, (slot < 0) ? &skipped : &die->attrs[slot]))
+			return (1);
+		if (slot >= 0)
+			die->present |= 1u << slot;
+	}
+	die->next = c.pos - c.base;
+	return (0);
+}
+
+/**
+ * Resolves a string attribute, read in place or through .debug_str_offsets.
+ * @param	d	The DWARF context.
+ * @param	u	The unit.
+ * @param	v	The value.
+ * @return	The string, or NULL if the value is not a string.
+ */
+const char	*ft_dwarf_value_string(const t_dwarf *d, const t_dwarf_unit *u, const t_dwarf_value *v)
+{
+	if (v->kind == DWARF_STRX)
+		return (ft_dwarf_strx(d, u, v->num));
+	return ((v->kind == DWARF_STR) ? v->str : NULL);
+}
+
+/**
+ * Reads the address of a pc attribute of a DIE.
+ * @param	d		The DWARF context.
+ * @param	u		The unit.
+ * @param	v		The value of the attribute.
+ * @param	shndx	Set to the section the address is in.
+ * @return	The address.
+ */
+static uint64_t	die_pc(const t_dwarf *d, const t_dwarf_unit *u, const t_dwarf_value *v, uint16_t *shndx)
+{
+	*shndx = v->shndx;
+	return ((v->kind == DWARF_ADDRX) ? ft_dwarf_addrx(d, u, v->num, shndx) : v->num);
+}
+
+/**
+ * Reads the addresses a function or variable DIE covers: the [low_pc,
+ * high_pc) range of a function or inlined instance, the DW_OP_addr or
+ * DW_OP_addrx a variable is located by. Other variables have no address,
+ * except that binutils places the external ones (declarations, TLS) at 0.
+ * @param	d		The DWARF context.
+ * @param	u		The unit.
+ * @param	die		The DIE.
+ * @param	decl	The declaration whose range and section are set.
+ * @return	1 if the DIE covers addresses, 0 otherwise.
+ */
+static int	die_address(const t_dwarf *d, const t_dwarf_unit *u, const t_dwarf_die *die, t_dwarf_decl *decl)
+{
+	const t_dwarf_value	*v;
+	t_dwarf_cursor		c;
+	unsigned char		op;
+	uint16_t			shndx;
+	int					located = 0;
+
+	if (die->tag == DW_TAG_subprogram || die->tag == DW_TAG_inlined_subroutine)
+	{
+		v = &die->attrs[DWARF_DIE_HIGH_PC];
+		if (!(die->present & (1u << DWARF_DIE_LOW_PC)) || !(die->present & (1u << DWARF_DIE_HIGH_PC))
+			|| (die->attrs[DWARF_DIE_LOW_PC].kind != DWARF_ADDR && die->attrs[DWARF_DIE_LOW_PC].kind != DWARF_ADDRX)
+			|| (v->kind != DWARF_NUM && v->kind != DWARF_ADDR && v->kind != DWARF_ADDRX))
+			return (0);
+		decl->loc.addr = die_pc(d, u, &die->attrs[DWARF_DIE_LOW_PC], &decl->loc.shndx);
+		decl->hi = (v->kind == DWARF_NUM) ? decl->loc.addr + v->num : die_pc(d, u, v, &shndx);
+		return (decl->loc.addr < decl->hi);
+	}
+	if (die->tag != DW_TAG_variable)
+		return (0);
+	v = &die->attrs[DWARF_DIE_LOCATION];
+	if ((die->present & (1u << DWARF_DIE_LOCATION)) && v->kind == DWARF_BLOCK && v->len >= 2)
+	{
+		c = (t_dwarf_cursor){d->info.data, v->block + 1, v->block + v->len, d->endian, 0};
+		op = v->block[0];
+		located = (op == DW_OP_addr && v->len == 1 + (size_t)u->addr_size);
+		if (located)
+		{
+			decl->loc.shndx = ft_dwarf_site(&d->info, c.pos - c.base);
+			decl->loc.addr = ft_dwarf_fixed(&c, u->addr_size);
+		}
+		else if (op == DW_OP_addrx || op == DW_OP_GNU_addr_index)
+		{
+			decl->loc.addr = ft_dwarf_addrx(d, u, ft_dwarf_uleb(&c), &decl->loc.shndx);
+			located = 1;
+		}
+		if (c.bad)
+			return (0);
+	}
+	if (!located && !((die->present & (1u << DWARF_DIE_EXTERNAL)) && die->attrs[DWARF_DIE_EXTERNAL].num))
+		return (0);
+	decl->hi = decl->loc.addr + 1;
+	return (decl->hi != 0);
+}
+
+/**
+ * Completes a declaration from a DIE: the linkage name, the name, the file
+ * and the line are each taken from the first DIE of the chain that has them
+ * (the definition, then what it specifies or is an instance of).
+ * @param	d			The DWARF context.
+ * @param	u			The unit, its files read.
+ * @param	die			The DIE.
+ * @param	decl		The declaration.
+ * @param	linkage		The linkage name found so far.
+ */
+static void	merge_decl(const t_dwarf *d, const t_dwarf_unit *u, const t_dwarf_die *die, t_dwarf_decl *decl,
+	const char **linkage)
+{
+	const t_dwarf_value	*file = &die->attrs[DWARF_DIE_FILE];
+	const t_dwarf_value	*line = &die->attrs[DWARF_DIE_LINE];
+
+	if (*linkage == NULL && (die->present & (1u << DWARF_DIE_LINKAGE)))
+		*linkage = ft_dwarf_value_string(d, u, &die->attrs[DWARF_DIE_LINKAGE]);
+	if (decl->name == NULL && (die->present & (1u << DWARF_DIE_NAME)))
+		decl->name = ft_dwarf_value_string(d, u, &die->attrs[DWARF_DIE_NAME]);
+	if (decl->loc.file == NULL && (die->present & (1u << DWARF_DIE_FILE)) && file->kind == DWARF_NUM)
+		decl->loc.file = (file->num < u->nfiles) ? u->files[file->num] : "<unknown>";
+	if (decl->loc.line == 0 && (die->present & (1u << DWARF_DIE_LINE)) && line->kind == DWARF_NUM)
+		decl->loc.line = line->num;
+}
+
+/**
+ * Appends a declaration to the table of the context, moving the addresses
+ * of a relocatable file to its flat layout.
+ * @param	d		The DWARF context.
+ * @param	decl	The declaration.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	add_decl(t_dwarf *d, const t_dwarf_decl *decl)
+{
+	t_dwarf_decl	*added;
+
+	if (ft_dwarf_grow((void **)&d->decls, d->ndecls, sizeof(t_dwarf_decl)))
+		return (d->failed = 1);
+	added = &d->decls[d->ndecls];
+	*added = *decl;
+	if (d->rel && added->loc.shndx < d->shnum)
+	{
+		added->loc.addr += d->vmas[added->loc.shndx];
+		added->hi += d->vmas[added->loc.shndx];
+	}
+	added->loc.shndx = 0;
+	added->order = d->ndecls;
+	d->ndecls++;
+	return (0);
+}
+
+/**
+ * Appends a declaration for one range of a function.
+ * @param	d		The DWARF context.
+ * @param	decl	The declaration, whose range is set.
+ * @param	shndx	The section of the range.
+ * @param	lo		The start of the range.
+ * @param	hi		The end of the range.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	add_range_decl(t_dwarf *d, t_dwarf_decl *decl, uint16_t shndx, uint64_t lo, uint64_t hi)
+{
+	if (lo >= hi)
+		return (0);
+	decl->loc.shndx = shndx;
+	decl->loc.addr = lo;
+	decl->hi = hi;
+	return (add_decl(d, decl));
+}
+
+/**
+ * Appends a declaration for each range of a DWARF 2 to 4 range list of
+ * .debug_ranges: address pairs relative to a base address, the unit's
+ * unless an entry selects another, up to a (0, 0) pair.
+ * @param	d		The DWARF context.
+ * @param	u		The unit.
+ * @param	offset	The offset of the list.
+ * @param	decl	The declaration.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	add_ranges_v4(t_dwarf *d, const t_dwarf_unit *u, uint64_t offset, t_dwarf_decl *decl)
+{
+	uint64_t		max = (u->addr_size == 8) ? UINT64_MAX : UINT32_MAX;
+	uint64_t		base = u->low_pc;
+	uint16_t		base_shndx = u->low_shndx;
+	t_dwarf_cursor	c;
+
+	ft_dwarf_cursor(&c, &d->rangelists, offset, d->rangelists.size, d->endian);
+	while (!c.bad && !d->failed)
+	{
+		uint16_t	shndx = ft_dwarf_site(&d->rangelists, c.pos - c.base);
+		uint64_t	lo = ft_dwarf_fixed(&c, u->addr_size);
+		uint16_t	hi_shndx = ft_dwarf_site(&d->rangelists, c.pos - c.base);
+		uint64_t	hi = ft_dwarf_fixed(&c, u->addr_size);
+
+		if (c.bad || (lo == 0 && hi == 0))
+			break;
+		if (lo == max)
+		{
+			base = hi;
+			base_shndx = hi_shndx;
+		}
+		else if (add_range_decl(d, decl, shndx ? shndx : base_shndx, base + lo, base + hi))
+			return (1);
+	}
+	return (d->failed);
+}
+
+/**
+ * Appends a declaration for each range of a DWARF 5 range list of
+ * .debug_rnglists, up to its DW_RLE_end_of_list entry.
+ * @param	d		The DWARF context.
+ * @param	u		The unit.
+ * @param	v		The DW_AT_ranges value: an offset, or an index into the
+ * 					offsets that follow the unit's DW_AT_rnglists_base.
+ * @param	decl	The declaration.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	add_ranges(t_dwarf *d, const t_dwarf_unit *u, const t_dwarf_value *v, t_dwarf_decl *decl)
+{
+	uint64_t		base = u->low_pc;
+	uint16_t		base_shndx = u->low_shndx;
+	uint64_t		offset = v->num;
+	t_dwarf_cursor	c;
+	uint8_t			kind = DW_RLE_base_address;
+
+	if (u->version < 5)
+		return ((v->kind == DWARF_NUM) ? add_ranges_v4(d, u, offset, decl) : 0);
+	if (v->kind == DWARF_LISTX)
+	{
+		ft_dwarf_cursor(&c, &d->rnglists, u->rnglists_base + offset * u->offset_size, d->rnglists.size, d->endian);
+		offset = u->rnglists_base + ft_dwarf_fixed(&c, u->offset_size);
+		if (c.bad)
+			return (0);
+	}
+	else if (v->kind != DWARF_NUM)
+		return (0);
+	ft_dwarf_cursor(&c, &d->rnglists, offset, d->rnglists.size, d->endian);
+	while (!c.bad && !d->failed && kind != DW_RLE_end_of_list)
+	{
+		uint16_t	shndx = base_shndx;
+		uint16_t	hi_shndx;
+		uint64_t	lo = 0;
+		uint64_t	hi = 0;
+
+		kind = ft_dwarf_fixed(&c, 1);
+		if (kind == DW_RLE_base_addressx)
+			base = ft_dwarf_addrx(d, u, ft_dwarf_uleb(&c), &base_shndx);
+		else if (kind == DW_RLE_base_address)
+		{
+			base_shndx = ft_dwarf_site(&d->rnglists, c.pos - c.base);
+			base = ft_dwarf_fixed(&c, u->addr_size);
+		}
+		else if (kind == DW_RLE_startx_endx || kind == DW_RLE_startx_length)
+		{
+			lo = ft_dwarf_addrx(d, u, ft_dwarf_uleb(&c), &shndx);
+			hi = (kind == DW_RLE_startx_endx) ? ft_dwarf_addrx(d, u, ft_dwarf_uleb(&c), &hi_shndx)
+				: lo + ft_dwarf_uleb(&c);
+		}
+		else if (kind == DW_RLE_offset_pair)
+		{
+			lo = base + ft_dwarf_uleb(&c);
+			hi = base + ft_dwarf_uleb(&c);
+		}
+		else if (kind == DW_RLE_start_end || kind == DW_RLE_start_length)
+		{
+			shndx = ft_dwarf_site(&d->rnglists, c.pos - c.base);
+			lo = ft_dwarf_fixed(&c, u->addr_size);
+			hi = (kind == DW_RLE_start_end) ? ft_dwarf_fixed(&c, u->addr_size) : lo + ft_dwarf_uleb(&c);
+		}
+		else if (kind != DW_RLE_end_of_list)
+			break;
+		if (!c.bad && add_range_decl(d, decl, shndx, lo, hi))
+			return (1);
+	}
+	return (d->failed);
+}
+
+/**
+ * Records the declaration of a function, inlined instance or variable DIE
+ * defined at an address, following DW_AT_specification and
+ * DW_AT_abstract_origin within the unit for what the DIE itself lacks. As
+ * binutils does, a declaration is only kept with a file, a function by its
+ * linkage name if it has one and a variable by its own name if it has one.
+ * A function with DW_AT_ranges gets a declaration per range.
+ * @param	d		The DWARF context.
+ * @param	u		The unit.
+ * @param	abbrevs	The abbreviation table of the unit.
+ * @param	count	The size of the table.
+ * @param	die		The DIE.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	scan_decl(t_dwarf *d, const t_dwarf_unit *u, const t_dwarf_abbrev *abbrevs, size_t count,
+	const t_dwarf_die *die)
+{
+	t_dwarf_decl	decl;
+	t_dwarf_die		origin;
+	const char		*linkage = NULL;
+	t_dwarf_value	ref;
+	int				has_ref;
+	int				ranged;
+
+	ft_bzero(&decl, sizeof(t_dwarf_decl));
+	ranged = (die->tag != DW_TAG_variable && (die->present & (1u << DWARF_DIE_RANGES)));
+	if (!ranged && !die_address(d, u, die, &decl))
+		return (0);
+	decl.func = (die->tag != DW_TAG_variable);
+	merge_decl(d, u, die, &decl, &linkage);
+	ref = die->attrs[DWARF_DIE_ORIGIN];
+	has_ref = (die->present & (1u << DWARF_DIE_ORIGIN)) && ref.kind == DWARF_REF;
+	for (int depth = 0; has_ref && depth < DWARF_MAX_ORIGINS; depth++)
+	{
+		if (ref.num < u->die || ref.num >= u->end || ft_dwarf_die(d, u, abbrevs, count, ref.num, &origin))
+			break;
+		merge_decl(d, u, &origin, &decl, &linkage);
+		ref = origin.attrs[DWARF_DIE_ORIGIN];
+		has_ref = (origin.present & (1u << DWARF_DIE_ORIGIN)) && ref.kind == DWARF_REF;
+	}
+	if (linkage && (decl.func || !(die->present & (1u << DWARF_DIE_NAME))))
+		decl.name = linkage;
+	if (decl.name == NULL || decl.loc.file == NULL)
+		return (0);
+	if (ranged)
+		return (add_ranges(d, u, &die->attrs[DWARF_DIE_RANGES], &decl));
+	return (add_decl(d, &decl));
+}
+
+/**
+ * Compares two declarations by address, then by place in .debug_info.
+ * @param	a	A declaration.
+ * @param	b	Another declaration.
+ * @return	A negative or positive number.
+ */
+static int	decl_cmp(const void *a, const void *b)
+{
+	const t_dwarf_decl	*da = a;
+	const t_dwarf_decl	*db = b;
+
+	if (da->loc.addr != db->loc.addr)
+		return ((da->loc.addr < db->loc.addr) ? -1 : 1);
+	return ((da->order < db->order) ? -1 : 1);
+}
+
+/**
+ * Lays the sections of a relocatable file out as binutils does to look its
+ * symbols up: the allocated sections one after the other from address 0 in
+ * section order, aligned, and every other section at 0. The allocated
+ * sections are also listed by address.
+ * @param	d	The DWARF context.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	lay_out(t_dwarf *d)
+{
+	t_section	sec;
+	uint64_t	vma = 0;
+
+	d->vmas = ft_arena_alloc(d->arena, sizeof(uint64_t) * d->shnum);
+	d->places = ft_arena_alloc(d->arena, sizeof(t_dwarf_range) * d->shnum);
+	if (d->vmas == NULL || d->places == NULL)
+		return (d->failed = 1);
+	for (size_t i = 0; i < d->shnum; i++)
+	{
+		ft_section_header(d->shdrs, i, d->is_64, &sec);
+		d->vmas[i] = 0;
+		if (i == 0 || !(sec.flags & SHF_ALLOC))
+			continue;
+		if (sec.addralign > 1 && !(sec.addralign & (sec.addralign - 1)))
+			vma = (vma + sec.addralign - 1) & ~(sec.addralign - 1);
+		d->vmas[i] = vma;
+		d->places[d->nplaces++] = (t_dwarf_range){vma, vma + sec.size, 0, 0, i};
+		vma += sec.size;
+	}
+	return (0);
+}
+
+/**
+ * Scans the DIEs of every unit for the functions and variables defined at an
+ * address, with the file and line they are declared at, into a table sorted
+ * by start address where each entry also records the furthest end of the
+ * entries up to it. A unit whose DIEs are malformed is left where it breaks.
+ * The addresses of a relocatable file are those of its flat layout.
+ * @param	d	The DWARF context.
+ * @return	0 on success, 1 on allocation failure.
+ */
+int	ft_dwarf_scan_decls(t_dwarf *d)
+{
+	t_dwarf_die	die;
+
+	if (d->rel && lay_out(d))
+		return (1);
+	for (size_t i = 0; i < d->nunits && !d->failed; i++)
+	{
+		t_dwarf_unit	*u = &d->units[i];
+		size_t			count;
+		t_dwarf_abbrev	*abbrevs;
+
+		if (ft_dwarf_unit_files(d, u))
+			break;
+		abbrevs = ft_dwarf_abbrevs(d, u->abbrev, &count);
+		if (abbrevs == NULL)
+			return (d->failed = 1);
+		for (uint64_t offset = u->die; offset < u->end && !d->failed; offset = die.next)
+		{
+			if (ft_dwarf_die(d, u, abbrevs, count, offset, &die))
+				break;
+			if (die.tag == DW_TAG_subprogram || die.tag == DW_TAG_inlined_subroutine || die.tag == DW_TAG_variable)
+				scan_decl(d, u, abbrevs, count, &die);
+		}
+		free(abbrevs);
+	}
+	if (d->ndecls)
+		qsort(d->decls, d->ndecls, sizeof(t_dwarf_decl), decl_cmp);
+	for (size_t i = 0; i < d->ndecls; i++)
+	{
+		d->decls[i].reach = d->decls[i].hi;
+		if (i && d->decls[i - 1].reach > d->decls[i].reach)
+			d->decls[i].reach = d->decls[i - 1].reach;
+	}
+	return (d->failed);
+}
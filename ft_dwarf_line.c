@@ -0,0 +1,497 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_dwarf_line.c                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:12:35 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:46:28 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+#define LINE_MAX_FORMATS	16
+
+/*
+ * The fields of a line program header the state machine needs.
+ */
+typedef struct s_line_header
+{
+	uint64_t				program;
+	uint64_t				end;
+	const unsigned char		*lengths;
+	uint16_t				version;
+	uint8_t					min_inst;
+	int8_t					line_base;
+	uint8_t					line_range;
+	uint8_t					opcode_base;
+	uint8_t					addr_size;
+}	t_line_header;
+
+/*
+ * An entry of the directory or file name table of a line program header.
+ */
+typedef struct s_line_entry
+{
+	const char				*name;
+	uint64_t				dir;
+}	t_line_entry;
+
+/*
+ * A sequence of rows, in program order, while they are sorted.
+ */
+typedef struct s_line_seq
+{
+	uint64_t				addr;
+	size_t					start;
+	size_t					count;
+	uint16_t				shndx;
+}	t_line_seq;
+
+static const char	*g_unknown = "<unknown>";
+
+/**
+ * Builds the path of a file of the line program as binutils does: a relative
+ * name is put under its directory, and a relative directory under the
+ * compilation directory of the unit.
+ * @param	d		The DWARF context.
+ * @param	u		The unit (DWARF version, compilation directory).
+ * @param	file	The file entry.
+ * @param	dirs	The directory table.
+ * @param	ndirs	The number of directories.
+ * @return	The path, "<unknown>" without a name, or NULL on allocation
+ * 			failure (flagged in the context).
+ */
+static const char	*file_path(t_dwarf *d, const t_dwarf_unit *u, const t_line_entry *file, const t_line_entry *dirs,
+	size_t ndirs)
+{
+	const char	*dir = NULL;
+	const char	*sub = NULL;
+	uint64_t	index = file->dir - (u->version < 5);
+	size_t		len[3];
+	char		*path;
+
+	if (file->name == NULL)
+		return (g_unknown);
+	if (file->name[0] == '/')
+		return (file->name);
+	if (index < ndirs)
+		sub = dirs[index].name;
+	if (sub == NULL || sub[0] != '/')
+		dir = u->comp_dir;
+	if (dir == NULL)
+	{
+		dir = sub;
+		sub = NULL;
+	}
+	if (dir == NULL)
+		return (file->name);
+	len[0] = ft_strlen(dir);
+	len[1] = sub ? ft_strlen(sub) + 1 : 0;
+	len[2] = ft_strlen(file->name);
+	path = ft_arena_alloc(d->arena, len[0] + len[1] + len[2] + 2);
+	if (path == NULL)
+	{
+		d->failed = 1;
+		return (NULL);
+	}
+	ft_memcpy(path, dir, len[0]);
+	if (sub)
+	{
+		path[len[0]] = '/';
+		ft_memcpy(path + len[0] + 1, sub, len[1] - 1);
+	}
+	path[len[0] + len[1]] = '/';
+	ft_memcpy(path + len[0] + len[1] + 1, file->name, len[2] + 1);
+	return (path);
+}
+
+/**
+ * Reads a DWARF 5 directory or file name table: a list of entry formats
+ * (content type and form), then the entries.
+ * @param	d		The DWARF context.
+ * @param	lu		The unit, with the offset size of the line program.
+ * @param	c		The cursor, at the format count.
+ * @param	entries	Set to the table, allocated from the arena.
+ * @param	count	Set to the number of entries.
+ * @return	0 on success, 1 if the table is malformed or cannot be allocated.
+ */
+static int	read_v5_table(t_dwarf *d, const t_dwarf_unit *lu, t_dwarf_cursor *c, t_line_entry **entries,
+	size_t *count)
+{
+	uint64_t		formats[LINE_MAX_FORMATS][2];
+	uint8_t			nformats = ft_dwarf_fixed(c, 1);
+	t_dwarf_value	v;
+
+	if (nformats > LINE_MAX_FORMATS)
+		return (1);
+	for (uint8_t i = 0; i < nformats; i++)
+	{
+		formats[i][0] = ft_dwarf_uleb(c);
+		formats[i][1] = ft_dwarf_uleb(c);
+	}
+	*count = ft_dwarf_uleb(c);
+	if (c->bad || *count > (size_t)(c->end - c->pos))
+		return (1);
+	*entries = ft_arena_alloc(d->arena, sizeof(t_line_entry) * (*count ? *count : 1));
+	if (*entries == NULL)
+		return (d->failed = 1);
+	for (size_t i = 0; i < *count; i++)
+	{
+		(*entries)[i] = (t_line_entry){NULL, 0};
+		for (uint8_t k = 0; k < nformats; k++)
+		{
+			if (ft_dwarf_form(d, lu, c, formats[k][1], 0, &v))
+				return (1);
+			if (v.kind == DWARF_STRX)
+				v.str = ft_dwarf_strx(d, lu, v.num);
+			if (formats[k][0] == DW_LNCT_path && (v.kind == DWARF_STR || v.kind == DWARF_STRX))
+				(*entries)[i].name = v.str;
+			else if (formats[k][0] == DW_LNCT_directory_index && v.kind == DWARF_NUM)
+				(*entries)[i].dir = v.num;
+		}
+	}
+	return (0);
+}
+
+/**
+ * Reads a DWARF 2 to 4 directory or file name table: NUL-terminated entries
+ * up to an empty one, files followed by their directory index and two
+ * ignored numbers.
+ * @param	d		The DWARF context.
+ * @param	c		The cursor, at the first entry.
+ * @param	files	1 for the file table, 0 for the directory table.
+ * @param	entries	Set to the table, allocated from the arena.
+ * @param	count	Set to the number of entries.
+ * @return	0 on success, 1 if the table is malformed or cannot be allocated.
+ */
+static int	read_v4_table(t_dwarf *d, t_dwarf_cursor *c, int files, t_line_entry **entries, size_t *count)
+{
+	t_dwarf_cursor	scan = *c;
+
+	*count = 0;
+	while (!scan.bad && scan.pos < scan.end && *scan.pos)
+	{
+		ft_dwarf_cstr(&scan);
+		for (int k = 0; files && k < 3; k++)
+			ft_dwarf_uleb(&scan);
+		(*count)++;
+	}
+	if (scan.bad)
+		return (1);
+	*entries = ft_arena_alloc(d->arena, sizeof(t_line_entry) * (*count ? *count : 1));
+	if (*entries == NULL)
+		return (d->failed = 1);
+	for (size_t i = 0; i < *count; i++)
+	{
+		(*entries)[i].name = ft_dwarf_cstr(c);
+		(*entries)[i].dir = files ? ft_dwarf_uleb(c) : 0;
+		for (int k = 0; files && k < 2; k++)
+			ft_dwarf_uleb(c);
+	}
+	ft_dwarf_fixed(c, 1);
+	return (c->bad);
+}
+
+/**
+ * Reads the header of the line program of a unit and, if asked, builds the
+ * paths of its files, indexed as the program refers to them (from 1 before
+ * DWARF 5, the slot 0 then being unknown).
+ * @param	d			The DWARF context.
+ * @param	u			The unit, its stmt_list read.
+ * @param	h			The header to fill.
+ * @param	files_too	1 to build the file paths, 0 if they are already built.
+ * @return	0 on success, 1 if the header is malformed or memory runs out.
+ */
+static int	read_header(t_dwarf *d, t_dwarf_unit *u, t_line_header *h, int files_too)
+{
+	t_dwarf_cursor	c;
+	t_dwarf_unit	lu = *u;
+	t_line_entry	*dirs;
+	t_line_entry	*files;
+	size_t			ndirs;
+	size_t			nfiles;
+	int				offset_size;
+	uint64_t		length;
+
+	ft_dwarf_cursor(&c, &d->line, u->stmt_list, d->line.size, d->endian);
+	length = ft_dwarf_length(&c, &offset_size);
+	if (c.bad || length > (uint64_t)(c.end - c.pos))
+		return (1);
+	h->end = (c.pos - c.base) + length;
+	c.end = c.base + h->end;
+	h->version = ft_dwarf_fixed(&c, 2);
+	if (h->version < 2 || h->version > 5)
+		return (1);
+	h->addr_size = u->addr_size;
+	if (h->version >= 5)
+	{
+		h->addr_size = ft_dwarf_fixed(&c, 1);
+		ft_dwarf_fixed(&c, 1);
+	}
+	h->program = ft_dwarf_fixed(&c, offset_size);
+	h->program += c.pos - c.base;
+	h->min_inst = ft_dwarf_fixed(&c, 1);
+	if (h->version >= 4)
+		ft_dwarf_fixed(&c, 1);
+	ft_dwarf_fixed(&c, 1);
+	h->line_base = (int8_t)ft_dwarf_fixed(&c, 1);
+	h->line_range = ft_dwarf_fixed(&c, 1);
+	h->opcode_base = ft_dwarf_fixed(&c, 1);
+	h->lengths = c.pos;
+	if (h->line_range == 0 || h->opcode_base == 0 || h->program > h->end)
+		return (1);
+	c.pos += h->opcode_base - 1;
+	if (!files_too)
+		return (c.pos > c.end);
+	lu.offset_size = offset_size;
+	lu.version = h->version;
+	if (c.pos > c.end || (h->version >= 5
+			? read_v5_table(d, &lu, &c, &dirs, &ndirs) || read_v5_table(d, &lu, &c, &files, &nfiles)
+			: read_v4_table(d, &c, 0, &dirs, &ndirs) || read_v4_table(d, &c, 1, &files, &nfiles)))
+		return (1);
+	u->nfiles = nfiles + (h->version < 5);
+	u->files = ft_arena_alloc(d->arena, sizeof(char *) * u->nfiles);
+	if (u->files == NULL)
+		return (d->failed = 1);
+	u->files[0] = g_unknown;
+	for (size_t i = 0; i < nfiles; i++)
+		if ((u->files[i + (h->version < 5)] = file_path(d, u, &files[i], dirs, ndirs)) == NULL)
+			return (1);
+	return (0);
+}
+
+/**
+ * Gives the file a sequence starts in. The register starts at 1, but as
+ * binutils reads it, a DWARF 5 sequence is in file 0 (the unit's own file)
+ * until it sets one, and nm -l prints the same.
+ * @param	h	The header of the program.
+ * @return	The index of the file.
+ */
+static uint64_t	first_file(const t_line_header *h)
+{
+	return (h->version >= 5 ? 0 : 1);
+}
+
+/**
+ * Runs the line number state machine of a program, storing its rows or only
+ * counting them. The section of an address set by a relocation is kept with
+ * its rows.
+ * @param	d		The DWARF context.
+ * @param	u		The unit, its files read.
+ * @param	h		The header of the program.
+ * @param	rows	The rows to fill, or NULL to count them.
+ * @return	The number of rows.
+ */
+static size_t	run_program(t_dwarf *d, const t_dwarf_unit *u, const t_line_header *h, t_line_row *rows)
+{
+	t_dwarf_cursor	c;
+	t_line_row		state = {0, NULL, 1, 0, 0};
+	uint64_t		file = first_file(h);
+	size_t			n = 0;
+
+	ft_dwarf_cursor(&c, &d->line, h->program, h->end, d->endian);
+	while (!c.bad && c.pos < c.end)
+	{
+		unsigned char	op = ft_dwarf_fixed(&c, 1);
+		int				emit = 0;
+
+		if (op >= h->opcode_base)
+		{
+			op -= h->opcode_base;
+			state.addr += (op / h->line_range) * h->min_inst;
+			state.line += h->line_base + op % h->line_range;
+			emit = 1;
+		}
+		else if (op == 0)
+		{
+			uint64_t		len = ft_dwarf_uleb(&c);
+			t_dwarf_cursor	ext = c;
+			unsigned char	sub = ft_dwarf_fixed(&ext, 1);
+
+			if (c.bad || len == 0 || len > (uint64_t)(c.end - c.pos))
+				break;
+			c.pos += len;
+			if (sub == DW_LNE_end_sequence)
+			{
+				state.end = 1;
+				emit = 1;
+			}
+			else if (sub == DW_LNE_set_address && len - 1 <= 8)
+			{
+				state.shndx = ft_dwarf_site(&d->line, ext.pos - ext.base);
+				state.addr = ft_dwarf_fixed(&ext, len - 1);
+			}
+		}
+		else if (op == DW_LNS_copy)
+			emit = 1;
+		else if (op == DW_LNS_advance_pc)
+			state.addr += ft_dwarf_uleb(&c) * h->min_inst;
+		else if (op == DW_LNS_advance_line)
+			state.line += ft_dwarf_sleb(&c);
+		else if (op == DW_LNS_set_file)
+			file = ft_dwarf_uleb(&c);
+		else if (op == DW_LNS_const_add_pc)
+			state.addr += ((255 - h->opcode_base) / h->line_range) * h->min_inst;
+		else if (op == DW_LNS_fixed_advance_pc)
+			state.addr += ft_dwarf_fixed(&c, 2);
+		else
+			for (unsigned char k = 0; k < h->lengths[op - 1]; k++)
+				ft_dwarf_uleb(&c);
+		if (!emit)
+			continue;
+		if (rows)
+		{
+			rows[n] = state;
+			rows[n].file = (file < u->nfiles) ? u->files[file] : g_unknown;
+		}
+		n++;
+		if (state.end)
+		{
+			state = (t_line_row){0, NULL, 1, 0, 0};
+			file = first_file(h);
+		}
+	}
+	return (n);
+}
+
+/**
+ * Compares two sequences by section, then by start address, then by their
+ * place in the program.
+ * @param	a	A sequence.
+ * @param	b	Another sequence.
+ * @return	A negative or positive number.
+ */
+static int	seq_cmp(const void *a, const void *b)
+{
+	const t_line_seq	*sa = a;
+	const t_line_seq	*sb = b;
+
+	if (sa->shndx != sb->shndx)
+		return ((sa->shndx < sb->shndx) ? -1 : 1);
+	if (sa->addr != sb->addr)
+		return ((sa->addr < sb->addr) ? -1 : 1);
+	return ((sa->start < sb->start) ? -1 : 1);
+}
+
+/**
+ * Puts the rows of a unit in address order, sequence by sequence: rows are
+ * ordered within a sequence, so sorting the sequences by their start gives
+ * the address-range table of the unit, in which the row of an address is
+ * the last one at or below it.
+ * @param	d	The DWARF context.
+ * @param	u	The unit, its rows decoded.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	sort_rows(t_dwarf *d, t_dwarf_unit *u)
+{
+	t_line_seq	*seqs;
+	t_line_row	*sorted;
+	size_t		nseqs = 0;
+	size_t		n = 0;
+
+	for (size_t i = 0; i < u->nrows; i++)
+		nseqs += (u->rows[i].end || i + 1 == u->nrows);
+	seqs = ft_heap_alloc(sizeof(t_line_seq) * (nseqs ? nseqs : 1));
+	sorted = ft_arena_alloc(d->arena, sizeof(t_line_row) * (u->nrows ? u->nrows : 1));
+	if (seqs == NULL || sorted == NULL)
+	{
+		free(seqs);
+		return (d->failed = 1);
+	}
+	nseqs = 0;
+	for (size_t i = 0, start = 0; i < u->nrows; i++)
+	{
+		if (u->rows[i].end || i + 1 == u->nrows)
+		{
+			seqs[nseqs++] = (t_line_seq){u->rows[start].addr, start, i + 1 - start, u->rows[start].shndx};
+			start = i + 1;
+		}
+	}
+	qsort(seqs, nseqs, sizeof(t_line_seq), seq_cmp);
+	for (size_t i = 0; i < nseqs; i++)
+	{
+		ft_memcpy(sorted + n, u->rows + seqs[i].start, sizeof(t_line_row) * seqs[i].count);
+		n += seqs[i].count;
+	}
+	free(seqs);
+	ft_arena_drop(d->arena, u->rows);
+	u->rows = sorted;
+	return (0);
+}
+
+/**
+ * Reads the header of the line program of a unit, building its file paths
+ * the first time.
+ * @param	d	The DWARF context.
+ * @param	u	The unit.
+ * @param	h	The header to fill.
+ * @return	0 on success, 1 if the unit has no usable line program.
+ */
+static int	load_header(t_dwarf *d, t_dwarf_unit *u, t_line_header *h)
+{
+	int	files_too = !(u->state & DWARF_FILES);
+
+	u->state |= DWARF_FILES;
+	if (!u->has_lines)
+		return (1);
+	if (read_header(d, u, h, files_too))
+	{
+		u->has_lines = 0;
+		u->nfiles = 0;
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * Builds the file paths of the line program of a unit, once.
+ * @param	d	The DWARF context.
+ * @param	u	The unit.
+ * @return	0 on success (the unit may have no line program), 1 on
+ * 			allocation failure.
+ */
+int	ft_dwarf_unit_files(t_dwarf *d, t_dwarf_unit *u)
+{
+	t_line_header	h;
+
+	if (!(u->state & DWARF_FILES))
+		load_header(d, u, &h);
+	return (d->failed);
+}
+
+/**
+ * Decodes the line program of a unit into its address-range table, once:
+ * the program is run a first time to count its rows, then a second time to
+ * store them, and the rows are put in address order.
+ * @param	d	The DWARF context.
+ * @param	u	The unit.
+ * @return	0 on success (the unit may have no rows), 1 on allocation
+ * 			failure.
+ */
+int	ft_dwarf_unit_rows(t_dwarf *d, t_dwarf_unit *u)
+{
+	t_line_header	h;
+
+	if (u->state & DWARF_ROWS)
+		return (d->failed);
+	u->state |= DWARF_ROWS;
+	if (load_header(d, u, &h))
+		return (d->failed);
+	u->nrows = run_program(d, u, &h, NULL);
+	if (u->nrows == 0)
+		return (0);
+	u->rows = ft_arena_alloc(d->arena, sizeof(t_line_row) * u->nrows);
+	if (u->rows == NULL)
+		d->failed = 1;
+	else
+	{
+		run_program(d, u, &h, u->rows);
+		sort_rows(d, u);
+	}
+	if (d->failed)
+		u->nrows = 0;
+	return (d->failed);
+}
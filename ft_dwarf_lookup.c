@@ -0,0 +1,368 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_dwarf_lookup.c                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:21:19 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 18:44:04 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/**
+ * Appends a range of addresses to the table of the context.
+ * @param	d		The DWARF context.
+ * @param	range	The range.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	add_range(t_dwarf *d, t_dwarf_range range)
+{
+	if (ft_dwarf_grow((void **)&d->ranges, d->nranges, sizeof(t_dwarf_range)))
+		return (d->failed = 1);
+	d->ranges[d->nranges++] = range;
+	return (0);
+}
+
+/**
+ * Finds the unit at an offset of .debug_info.
+ * @param	d		The DWARF context.
+ * @param	offset	The offset.
+ * @return	The index of the unit, or nunits if there is none.
+ */
+static size_t	find_unit(const t_dwarf *d, uint64_t offset)
+{
+	size_t	lo = 0;
+	size_t	hi = d->nunits;
+
+	while (lo < hi)
+	{
+		size_t	mid = lo + (hi - lo) / 2;
+
+		if (d->units[mid].offset < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return ((lo < d->nunits && d->units[lo].offset == offset) ? lo : d->nunits);
+}
+
+/**
+ * Reads the address ranges of .debug_aranges, marking the units they cover.
+ * @param	d	The DWARF context.
+ */
+static void	read_aranges(t_dwarf *d)
+{
+	t_dwarf_cursor	c;
+	uint64_t		set_end;
+
+	for (uint64_t offset = 0; offset < d->aranges.size && !d->failed; offset = set_end)
+	{
+		int			offset_size;
+		uint64_t	length;
+		size_t		unit;
+		uint8_t		addr_size;
+		size_t		tuple;
+
+		ft_dwarf_cursor(&c, &d->aranges, offset, d->aranges.size, d->endian);
+		length = ft_dwarf_length(&c, &offset_size);
+		if (c.bad || length > (uint64_t)(c.end - c.pos))
+			return;
+		set_end = (c.pos - c.base) + length;
+		c.end = c.base + set_end;
+		ft_dwarf_fixed(&c, 2);
+		unit = find_unit(d, ft_dwarf_fixed(&c, offset_size));
+		addr_size = ft_dwarf_fixed(&c, 1);
+		if (c.bad || unit == d->nunits || (addr_size != 4 && addr_size != 8) || ft_dwarf_fixed(&c, 1) != 0)
+			continue;
+		tuple = 2 * addr_size;
+		c.pos += (tuple - (c.pos - c.base - offset) % tuple) % tuple;
+		while (!c.bad && (size_t)(c.end - c.pos) >= tuple)
+		{
+			uint16_t	shndx = ft_dwarf_site(&d->aranges, c.pos - c.base);
+			uint64_t	lo = ft_dwarf_fixed(&c, addr_size);
+			uint64_t	len = ft_dwarf_fixed(&c, addr_size);
+
+			if (lo == 0 && len == 0)
+				break;
+			if (len && add_range(d, (t_dwarf_range){lo, lo + len, 0, unit, shndx}))
+				return;
+			d->units[unit].state |= DWARF_COVERED;
+		}
+	}
+}
+
+/**
+ * Adds the sequences of the line program of a unit as ranges.
+ * @param	d		The DWARF context.
+ * @param	unit	The index of the unit.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	add_sequences(t_dwarf *d, size_t unit)
+{
+	t_dwarf_unit	*u = &d->units[unit];
+	size_t			start = 0;
+
+	if (ft_dwarf_unit_rows(d, u))
+		return (1);
+	for (size_t i = 0; i < u->nrows; i++)
+	{
+		if (!u->rows[i].end)
+			continue;
+		if (u->rows[i].addr > u->rows[start].addr && add_range(d, (t_dwarf_range){u->rows[start].addr,
+				u->rows[i].addr, 0, unit, u->rows[start].shndx}))
+			return (1);
+		start = i + 1;
+	}
+	return (0);
+}
+
+/**
+ * Compares two ranges by section, then by start address.
+ * @param	a	A range.
+ * @param	b	Another range.
+ * @return	A negative, null or positive number.
+ */
+static int	range_cmp(const void *a, const void *b)
+{
+	const t_dwarf_range	*ra = a;
+	const t_dwarf_range	*rb = b;
+
+	if (ra->shndx != rb->shndx)
+		return ((ra->shndx < rb->shndx) ? -1 : 1);
+	if (ra->lo != rb->lo)
+		return ((ra->lo < rb->lo) ? -1 : 1);
+	return ((ra->unit < rb->unit) ? -1 : (ra->unit > rb->unit));
+}
+
+/**
+ * Builds the table mapping address ranges to units, once: from
+ * .debug_aranges when the file has it, so that only the units holding a
+ * looked up address get their line program decoded, and from the sequences
+ * of the line programs of the units it does not cover. Each range keeps the
+ * highest end of the ranges up to it in its section, which bounds the
+ * search for overlapping ranges.
+ * @param	d	The DWARF context.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	build_ranges(t_dwarf *d)
+{
+	d->state |= DWARF_RANGES;
+	read_aranges(d);
+	for (size_t i = 0; i < d->nunits && !d->failed; i++)
+		if (!(d->units[i].state & DWARF_COVERED) && d->units[i].has_lines)
+			add_sequences(d, i);
+	if (d->failed)
+		return (1);
+	if (d->nranges)
+		qsort(d->ranges, d->nranges, sizeof(t_dwarf_range), range_cmp);
+	for (size_t i = 0; i < d->nranges; i++)
+	{
+		d->ranges[i].reach = d->ranges[i].hi;
+		if (i && d->ranges[i - 1].shndx == d->ranges[i].shndx && d->ranges[i - 1].reach > d->ranges[i].hi)
+			d->ranges[i].reach = d->ranges[i - 1].reach;
+	}
+	return (0);
+}
+
+/**
+ * Finds the row of the line table of a unit covering an address: the last
+ * row at or below it in its section, unless it ends a sequence.
+ * @param	d		The DWARF context.
+ * @param	u		The unit.
+ * @param	shndx	The section of the address (0 outside relocatable files).
+ * @param	addr	The address.
+ * @return	The row, or NULL if the unit has none for the address.
+ */
+static const t_line_row	*unit_row(t_dwarf *d, t_dwarf_unit *u, uint16_t shndx, uint64_t addr)
+{
+	size_t	lo = 0;
+	size_t	hi;
+
+	if (ft_dwarf_unit_rows(d, u))
+		return (NULL);
+	hi = u->nrows;
+	while (lo < hi)
+	{
+		size_t				mid = lo + (hi - lo) / 2;
+		const t_line_row	*row = &u->rows[mid];
+
+		if (row->shndx < shndx || (row->shndx == shndx && row->addr <= addr))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == 0 || u->rows[lo - 1].shndx != shndx || u->rows[lo - 1].end)
+		return (NULL);
+	return (&u->rows[lo - 1]);
+}
+
+/**
+ * Finds the line an address comes from, as binutils' nearest line lookup:
+ * the ranges holding the address are searched from the closest start down,
+ * and the first unit with a row for it gives the line.
+ * @param	d		The DWARF context.
+ * @param	shndx	The section of the address (0 outside relocatable files).
+ * @param	addr	The address.
+ * @return	The row, or NULL if no line is known for the address.
+ */
+const t_line_row	*ft_dwarf_address(t_dwarf *d, uint16_t shndx, uint64_t addr)
+{
+	size_t				lo = 0;
+	size_t				hi;
+	const t_line_row	*row;
+
+	if (!(d->state & DWARF_RANGES) && build_ranges(d))
+		return (NULL);
+	hi = d->nranges;
+	while (lo < hi)
+	{
+		size_t				mid = lo + (hi - lo) / 2;
+		const t_dwarf_range	*range = &d->ranges[mid];
+
+		if (range->shndx < shndx || (range->shndx == shndx && range->lo <= addr))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	while (lo-- > 0 && d->ranges[lo].shndx == shndx && d->ranges[lo].reach > addr)
+		if (d->ranges[lo].hi > addr && (row = unit_row(d, &d->units[d->ranges[lo].unit], shndx, addr)))
+			return (row);
+	return (NULL);
+}
+
+/**
+ * Scans the declarations of the file the first time they are needed.
+ * @param	d	The DWARF context.
+ * @return	0 on success, 1 on failure.
+ */
+static int	load_decls(t_dwarf *d)
+{
+	if (d->image == NULL || d->failed)
+		return (1);
+	if (!(d->state & DWARF_DECLS))
+	{
+		d->state |= DWARF_DECLS;
+		return (ft_dwarf_scan_decls(d));
+	}
+	return (0);
+}
+
+/**
+ * Finds the declaration binutils gives a symbol: among the declarations
+ * whose range holds its address (the exact address for a variable) and
+ * whose name the symbol's contains (so that "count.0" finds the static
+ * "count"), the tightest one, the last in .debug_info on a tie. In a
+ * relocatable file, the address is the one of the flat layout.
+ * @param	d			The DWARF context.
+ * @param	shndx		The section index of the symbol.
+ * @param	addr		The value of the symbol.
+ * @param	name		The name of the symbol.
+ * @param	name_len	The length of the name.
+ * @param	func		1 for a function symbol, 0 otherwise.
+ * @return	The location of the declaration, or NULL if there is none.
+ */
+const t_line_row	*ft_dwarf_decl(t_dwarf *d, uint16_t shndx, uint64_t addr, const char *name, size_t name_len,
+	int func)
+{
+	const t_dwarf_decl	*best = NULL;
+	size_t				lo = 0;
+	size_t				hi;
+
+	if (load_decls(d) || (d->rel && shndx >= d->shnum))
+		return (NULL);
+	if (d->rel)
+		addr += d->vmas[shndx];
+	hi = d->ndecls;
+	while (lo < hi)
+	{
+		size_t	mid = lo + (hi - lo) / 2;
+
+		if (d->decls[mid].loc.addr <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	for (; lo > 0 && d->decls[lo - 1].reach > addr; lo--)
+	{
+		const t_dwarf_decl	*decl = &d->decls[lo - 1];
+
+		if (decl->func != func || decl->hi <= addr || !ft_strnstr(name, decl->name, name_len))
+			continue;
+		if (best == NULL || decl->hi - decl->loc.addr < best->hi - best->loc.addr
+			|| (decl->hi - decl->loc.addr == best->hi - best->loc.addr && decl->order > best->order))
+			best = decl;
+	}
+	return (best ? &best->loc : NULL);
+}
+
+/**
+ * Finds the line of a place in a section as binutils' nearest line lookup
+ * does. A place of a section without code that a symbol is defined at is
+ * looked up as that symbol (the first global one there, the last one
+ * otherwise) and has no line unless it is declared; any other place has the
+ * line its address comes from, a non-allocated section of a relocatable
+ * file lying at 0 in the flat layout.
+ * @param	d		The DWARF context.
+ * @param	shndx	The section index.
+ * @param	offset	The offset in the section.
+ * @return	The location, or NULL if none is known (d->failed is set on
+ * 			allocation failure).
+ */
+const t_line_row	*ft_dwarf_nearest(t_dwarf *d, uint16_t shndx, uint64_t offset)
+{
+	const t_dwarf_symbol	*alias;
+	t_section				sec;
+	size_t					lo = 0;
+	size_t					hi;
+
+	if (load_decls(d) || shndx >= d->shnum)
+		return (NULL);
+	ft_section_header(d->shdrs, shndx, d->is_64, &sec);
+	if (!(sec.flags & SHF_EXECINSTR))
+	{
+		alias = ft_dwarf_alias(d, shndx, offset);
+		if (alias)
+			return (alias->name ? ft_dwarf_decl(d, shndx, offset, alias->name, ft_strlen(alias->name), alias->func)
+				: NULL);
+	}
+	if (!d->rel || (sec.flags & SHF_ALLOC))
+		return (d->failed ? NULL : ft_dwarf_address(d, d->rel ? shndx : 0, offset));
+	hi = d->nplaces;
+	while (lo < hi)
+	{
+		size_t	mid = lo + (hi - lo) / 2;
+
+		if (d->places[mid].lo <= offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (d->failed || lo == 0 || d->places[lo - 1].hi <= offset)
+		return (NULL);
+	return (ft_dwarf_address(d, d->places[lo - 1].shndx, offset - d->places[lo - 1].lo));
+}
+
+/**
+ * Finds the line of a defined symbol, as nm -l does: the declaration of the
+ * symbol, the nearest line of its place if it has none. A location with no
+ * line is not returned.
+ * @param	d			The DWARF context.
+ * @param	shndx		The section index of the symbol.
+ * @param	addr		The value of the symbol.
+ * @param	entry		The symbol (name span).
+ * @param	func		1 for a function symbol, 0 otherwise.
+ * @return	The location, or NULL if none is known (d->failed is set on
+ * 			allocation failure).
+ */
+const t_line_row	*ft_dwarf_symbol(t_dwarf *d, uint16_t shndx, uint64_t addr, const t_symbol *entry, int func)
+{
+	const t_line_row	*row;
+
+	row = ft_dwarf_decl(d, shndx, addr, entry->name, entry->name_len, func);
+	if (row == NULL)
+		row = ft_dwarf_nearest(d, shndx, addr);
+	return ((row && row->file && row->line) ? row : NULL);
+}
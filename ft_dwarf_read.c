@@ -0,0 +1,397 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_dwarf_read.c                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:10:59 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 18:44:04 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/**
+ * Starts reading a DWARF section at an offset. Every read past the end of
+ * the range marks the cursor bad and yields zeros, so that decoders only
+ * check it once per entry.
+ * @param	c		The cursor.
+ * @param	sec		The section.
+ * @param	offset	The offset to start at.
+ * @param	end		The offset to stop at, clamped to the section.
+ * @param	endian	The data encoding of the file (ELFDATA2LSB or ELFDATA2MSB).
+ */
+void	ft_dwarf_cursor(t_dwarf_cursor *c, const t_dwarf_section *sec, uint64_t offset, uint64_t end, int endian)
+{
+	if (end > sec->size)
+		end = sec->size;
+	c->base = sec->data;
+	c->bad = (sec->data == NULL || offset > end);
+	c->pos = c->bad ? sec->data : sec->data + offset;
+	c->end = c->bad ? sec->data : sec->data + end;
+	c->endian = endian;
+}
+
+/**
+ * Reads a fixed-size unsigned integer.
+ * @param	c		The cursor.
+ * @param	size	Its size in bytes, up to 8.
+ * @return	The integer, or 0 past the end.
+ */
+uint64_t	ft_dwarf_fixed(t_dwarf_cursor *c, int size)
+{
+	uint64_t	value = 0;
+
+	if (c->bad || (size_t)(c->end - c->pos) < (size_t)size)
+	{
+		c->bad = 1;
+		return (0);
+	}
+	for (int i = 0; i < size; i++)
+	{
+		if (c->endian == ELFDATA2MSB)
+			value = (value << 8) | c->pos[i];
+		else
+			value |= (uint64_t)c->pos[i] << (8 * i);
+	}
+	c->pos += size;
+	return (value);
+}
+
+/**
+ * Reads an unsigned LEB128 number. Bits past the 64th are dropped.
+ * @param	c	The cursor.
+ * @return	The number, or 0 past the end.
+ */
+uint64_t	ft_dwarf_uleb(t_dwarf_cursor *c)
+{
+	uint64_t	value = 0;
+	int			shift = 0;
+
+	while (!c->bad)
+	{
+		unsigned char	byte;
+
+		if (c->pos >= c->end)
+		{
+			c->bad = 1;
+			return (0);
+		}
+		byte = *c->pos++;
+		if (shift < 64)
+			value |= (uint64_t)(byte & 0x7f) << shift;
+		shift += 7;
+		if (!(byte & 0x80))
+			break;
+	}
+	return (value);
+}
+
+/**
+ * Reads a signed LEB128 number.
+ * @param	c	The cursor.
+ * @return	The number, or 0 past the end.
+ */
+int64_t	ft_dwarf_sleb(t_dwarf_cursor *c)
+{
+	uint64_t		value = 0;
+	int				shift = 0;
+	unsigned char	byte = 0;
+
+	while (!c->bad)
+	{
+		if (c->pos >= c->end)
+		{
+			c->bad = 1;
+			return (0);
+		}
+		byte = *c->pos++;
+		if (shift < 64)
+			value |= (uint64_t)(byte & 0x7f) << shift;
+		shift += 7;
+		if (!(byte & 0x80))
+			break;
+	}
+	if (shift < 64 && (byte & 0x40))
+		value |= ~(uint64_t)0 << shift;
+	return ((int64_t)value);
+}
+
+/**
+ * Reads a NUL-terminated string in place.
+ * @param	c	The cursor.
+ * @return	The string, or NULL if it is not terminated within the range.
+ */
+const char	*ft_dwarf_cstr(t_dwarf_cursor *c)
+{
+	const unsigned char	*start = c->pos;
+	const unsigned char	*nul;
+
+	if (c->bad || (nul = ft_memchr(start, '\0', c->end - start)) == NULL)
+	{
+		c->bad = 1;
+		return (NULL);
+	}
+	c->pos = nul + 1;
+	return ((const char *)start);
+}
+
+/**
+ * Reads the initial length of a unit, telling 32-bit DWARF from 64-bit DWARF.
+ * @param	c			The cursor, at the start of the unit.
+ * @param	offset_size	Set to 4 or 8, the size of section offsets in the unit.
+ * @return	The length of the unit past its initial length.
+ */
+uint64_t	ft_dwarf_length(t_dwarf_cursor *c, int *offset_size)
+{
+	uint64_t	length = ft_dwarf_fixed(c, 4);
+
+	*offset_size = 4;
+	if (length == 0xffffffff)
+	{
+		*offset_size = 8;
+		length = ft_dwarf_fixed(c, 8);
+	}
+	return (length);
+}
+
+/**
+ * Finds a range of the file.
+ * @param	d		The DWARF context.
+ * @param	offset	The offset of the range.
+ * @param	size	The size of the range.
+ * @return	The range, or NULL if it does not fit in the file.
+ */
+const unsigned char	*ft_dwarf_image(const t_dwarf *d, uint64_t offset, uint64_t size)
+{
+	if (offset > d->image_size || size > d->image_size - offset)
+		return (NULL);
+	return (d->image + offset);
+}
+
+/**
+ * Finds a string in a string section (.debug_str or .debug_line_str). Those
+ * sections end with a NUL byte, so every string in range is terminated.
+ * @param	sec		The string section.
+ * @param	offset	The offset of the string.
+ * @return	The string, or NULL if it is out of the section.
+ */
+const char	*ft_dwarf_string(const t_dwarf_section *sec, uint64_t offset)
+{
+	if (sec->data == NULL || offset >= sec->size)
+		return (NULL);
+	return ((const char *)sec->data + offset);
+}
+
+/**
+ * Finds the section a relocated address of a relocatable file points into,
+ * from the relocation applied at its offset.
+ * @param	sec		The section the address was read from.
+ * @param	offset	The offset of the address in the section.
+ * @return	The index of the section of the address, or 0 if it was not
+ * 			relocated.
+ */
+uint16_t	ft_dwarf_site(const t_dwarf_section *sec, uint64_t offset)
+{
+	size_t	lo = 0;
+	size_t	hi = sec->nsites;
+
+	while (lo < hi)
+	{
+		size_t	mid = lo + (hi - lo) / 2;
+
+		if (sec->sites[mid].offset < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < sec->nsites && sec->sites[lo].offset == offset)
+		return (sec->sites[lo].shndx);
+	return (0);
+}
+
+/**
+ * Resolves a string index (DW_FORM_strx*) through .debug_str_offsets.
+ * @param	d		The DWARF context.
+ * @param	u		The unit, with its DW_AT_str_offsets_base.
+ * @param	index	The index.
+ * @return	The string, or NULL if it cannot be resolved.
+ */
+const char	*ft_dwarf_strx(const t_dwarf *d, const t_dwarf_unit *u, uint64_t index)
+{
+	t_dwarf_cursor	c;
+	uint64_t		base = u->str_offsets_base ? u->str_offsets_base : (uint64_t)u->offset_size * 2;
+
+	ft_dwarf_cursor(&c, &d->str_offsets, base + index * u->offset_size, d->str_offsets.size, d->endian);
+	index = ft_dwarf_fixed(&c, u->offset_size);
+	return (c.bad ? NULL : ft_dwarf_string(&d->str, index));
+}
+
+/**
+ * Resolves an address index (DW_FORM_addrx*, DW_OP_addrx) through
+ * .debug_addr.
+ * @param	d		The DWARF context.
+ * @param	u		The unit, with its DW_AT_addr_base.
+ * @param	index	The index.
+ * @param	shndx	Set to the section of the address in a relocatable file.
+ * @return	The address, 0 if it cannot be resolved.
+ */
+uint64_t	ft_dwarf_addrx(const t_dwarf *d, const t_dwarf_unit *u, uint64_t index, uint16_t *shndx)
+{
+	t_dwarf_cursor	c;
+	uint64_t		offset = u->addr_base + index * u->addr_size;
+
+	ft_dwarf_cursor(&c, &d->addr, offset, d->addr.size, d->endian);
+	*shndx = ft_dwarf_site(&d->addr, offset);
+	return (ft_dwarf_fixed(&c, u->addr_size));
+}
+
+/**
+ * Reads a block of a given length.
+ * @param	c	The cursor.
+ * @param	v	The value, set to the block.
+ * @param	len	The length of the block.
+ */
+static void	read_block(t_dwarf_cursor *c, t_dwarf_value *v, uint64_t len)
+{
+	v->kind = DWARF_BLOCK;
+	if (c->bad || len > (uint64_t)(c->end - c->pos))
+	{
+		c->bad = 1;
+		return;
+	}
+	v->block = c->pos;
+	v->len = len;
+	c->pos += len;
+}
+
+/**
+ * Reads the string forms of an attribute value.
+ * @param	d		The DWARF context.
+ * @param	u		The unit.
+ * @param	c		The cursor.
+ * @param	form	The form.
+ * @param	v		The value, set to the string (NULL if it cannot be found).
+ * @return	1 if the form is a string form, 0 otherwise.
+ */
+static int	read_string(const t_dwarf *d, const t_dwarf_unit *u, t_dwarf_cursor *c, uint64_t form,
+	t_dwarf_value *v)
+{
+	v->kind = DWARF_STR;
+	if (form == DW_FORM_string)
+		v->str = ft_dwarf_cstr(c);
+	else if (form == DW_FORM_strp)
+		v->str = ft_dwarf_string(&d->str, ft_dwarf_fixed(c, u->offset_size));
+	else if (form == DW_FORM_line_strp)
+		v->str = ft_dwarf_string(&d->line_str, ft_dwarf_fixed(c, u->offset_size));
+	else if (form == DW_FORM_strp_sup || form == DW_FORM_GNU_strp_alt)
+		ft_dwarf_fixed(c, u->offset_size);
+	else if (form == DW_FORM_strx || form == DW_FORM_GNU_str_index)
+		v->num = ft_dwarf_uleb(c);
+	else if (form >= DW_FORM_strx1 && form <= DW_FORM_strx4)
+		v->num = ft_dwarf_fixed(c, form - DW_FORM_strx1 + 1);
+	else
+		return (0);
+	if (form == DW_FORM_strx || form == DW_FORM_GNU_str_index
+		|| (form >= DW_FORM_strx1 && form <= DW_FORM_strx4))
+		v->kind = DWARF_STRX;
+	return (1);
+}
+
+/**
+ * Reads the address and reference forms of an attribute value. References
+ * are made relative to .debug_info; addresses carry the section they were
+ * relocated against.
+ * @param	d		The DWARF context.
+ * @param	u		The unit.
+ * @param	c		The cursor.
+ * @param	form	The form.
+ * @param	v		The value to fill.
+ * @return	1 if the form is one of them, 0 otherwise.
+ */
+static int	read_address(const t_dwarf *d, const t_dwarf_unit *u, t_dwarf_cursor *c, uint64_t form,
+	t_dwarf_value *v)
+{
+	v->kind = DWARF_REF;
+	if (form == DW_FORM_addr)
+	{
+		v->kind = DWARF_ADDR;
+		v->shndx = ft_dwarf_site(&d->info, c->pos - c->base);
+		v->num = ft_dwarf_fixed(c, u->addr_size);
+	}
+	else if (form == DW_FORM_addrx || form == DW_FORM_GNU_addr_index
+		|| (form >= DW_FORM_addrx1 && form <= DW_FORM_addrx4))
+	{
+		v->kind = DWARF_ADDRX;
+		v->num = (form >= DW_FORM_addrx1) ? ft_dwarf_fixed(c, form - DW_FORM_addrx1 + 1) : ft_dwarf_uleb(c);
+	}
+	else if (form == DW_FORM_ref_addr)
+		v->num = ft_dwarf_fixed(c, (u->version <= 2) ? u->addr_size : u->offset_size);
+	else if (form >= DW_FORM_ref1 && form <= DW_FORM_ref8)
+		v->num = u->offset + ft_dwarf_fixed(c, 1 << (form - DW_FORM_ref1));
+	else if (form == DW_FORM_ref_udata)
+		v->num = u->offset + ft_dwarf_uleb(c);
+	else
+		return (0);
+	return (1);
+}
+
+/**
+ * Reads an attribute value of any form. Values of forms the decoder has no
+ * use for are skipped and read as numbers.
+ * @param	d			The DWARF context.
+ * @param	u			The unit (offset and address sizes, version).
+ * @param	c			The cursor, at the value.
+ * @param	form		The form of the value.
+ * @param	implicit	The value of a DW_FORM_implicit_const, from the
+ * 						abbreviation.
+ * @param	v			The value to fill.
+ * @return	0 on success, 1 for an unknown form or a value out of the section.
+ */
+int	ft_dwarf_form(const t_dwarf *d, const t_dwarf_unit *u, t_dwarf_cursor *c, uint64_t form, int64_t implicit,
+	t_dwarf_value *v)
+{
+	ft_bzero(v, sizeof(t_dwarf_value));
+	if (form == DW_FORM_indirect)
+		form = ft_dwarf_uleb(c);
+	if (read_string(d, u, c, form, v) || read_address(d, u, c, form, v))
+		return (c->bad);
+	v->kind = DWARF_NUM;
+	if (form == DW_FORM_data1 || form == DW_FORM_flag)
+		v->num = ft_dwarf_fixed(c, 1);
+	else if (form == DW_FORM_data2)
+		v->num = ft_dwarf_fixed(c, 2);
+	else if (form == DW_FORM_data4 || form == DW_FORM_ref_sup4)
+		v->num = ft_dwarf_fixed(c, 4);
+	else if (form == DW_FORM_data8 || form == DW_FORM_ref_sig8 || form == DW_FORM_ref_sup8)
+		v->num = ft_dwarf_fixed(c, 8);
+	else if (form == DW_FORM_sdata)
+		v->num = ft_dwarf_sleb(c);
+	else if (form == DW_FORM_udata)
+		v->num = ft_dwarf_uleb(c);
+	else if (form == DW_FORM_loclistx || form == DW_FORM_rnglistx)
+	{
+		v->kind = DWARF_LISTX;
+		v->num = ft_dwarf_uleb(c);
+	}
+	else if (form == DW_FORM_sec_offset || form == DW_FORM_GNU_ref_alt)
+		v->num = ft_dwarf_fixed(c, u->offset_size);
+	else if (form == DW_FORM_implicit_const)
+		v->num = implicit;
+	else if (form == DW_FORM_flag_present)
+		v->num = 1;
+	else if (form == DW_FORM_data16)
+		read_block(c, v, 16);
+	else if (form == DW_FORM_block1)
+		read_block(c, v, ft_dwarf_fixed(c, 1));
+	else if (form == DW_FORM_block2)
+		read_block(c, v, ft_dwarf_fixed(c, 2));
+	else if (form == DW_FORM_block4)
+		read_block(c, v, ft_dwarf_fixed(c, 4));
+	else if (form == DW_FORM_block || form == DW_FORM_exprloc)
+		read_block(c, v, ft_dwarf_uleb(c));
+	else
+		return (1);
+	return (c->bad);
+}
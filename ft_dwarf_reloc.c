@@ -0,0 +1,346 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_dwarf_reloc.c                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:21:19 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:46:28 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/*
+ * A relocation section, with the symbol table it refers to.
+ */
+typedef struct s_reloc_table
+{
+	t_dwarf_section		entries;
+	t_dwarf_section		syms;
+	size_t				count;
+	size_t				entsize;
+	size_t				nsyms;
+	int					rela;
+}	t_reloc_table;
+
+/*
+ * A relocation, read whatever its class.
+ */
+typedef struct s_reloc
+{
+	uint64_t			offset;
+	uint64_t			sym;
+	uint32_t			type;
+	int64_t				addend;
+}	t_reloc;
+
+/*
+ * A relocation section, as ordered for the walk of undefined symbols.
+ */
+typedef struct s_reloc_order
+{
+	uint32_t			target;
+	uint32_t			index;
+}	t_reloc_order;
+
+/**
+ * Gives the size of the field a relocation writes in a debug section, for
+ * the absolute and TLS-offset relocations compilers emit there.
+ * @param	machine	The e_machine of the file.
+ * @param	type	The type of the relocation.
+ * @return	4 or 8, or 0 for a relocation that is not applied.
+ */
+static int	reloc_width(int machine, uint32_t type)
+{
+	if (machine == EM_X86_64 && (type == R_X86_64_64 || type == R_X86_64_DTPOFF64))
+		return (8);
+	if (machine == EM_X86_64 && (type == R_X86_64_32 || type == R_X86_64_32S || type == R_X86_64_DTPOFF32))
+		return (4);
+	if (machine == EM_386 && (type == R_386_32 || type == R_386_TLS_LDO_32))
+		return (4);
+	if (machine == EM_AARCH64 && type == R_AARCH64_ABS64)
+		return (8);
+	if (machine == EM_AARCH64 && type == R_AARCH64_ABS32)
+		return (4);
+	return (0);
+}
+
+/**
+ * Opens a relocation section and the symbol table it links to.
+ * @param	d		The DWARF context.
+ * @param	sec		The header of the relocation section.
+ * @param	t		The table to fill.
+ * @return	0 on success, 1 if the sections are malformed.
+ */
+static int	reloc_open(const t_dwarf *d, const t_section *sec, t_reloc_table *t)
+{
+	size_t		sym_size = d->is_64 ? sizeof(Elf64_Sym) : sizeof(Elf32_Sym);
+	t_section	link;
+
+	ft_bzero(t, sizeof(t_reloc_table));
+	t->rela = (sec->type == SHT_RELA);
+	if (d->is_64)
+		t->entsize = t->rela ? sizeof(Elf64_Rela) : sizeof(Elf64_Rel);
+	else
+		t->entsize = t->rela ? sizeof(Elf32_Rela) : sizeof(Elf32_Rel);
+	if (sec->entsize != t->entsize || sec->link == 0 || sec->link >= d->shnum)
+		return (1);
+	ft_section_header(d->shdrs, sec->link, d->is_64, &link);
+	if (link.entsize != sym_size)
+		return (1);
+	t->count = sec->size / t->entsize;
+	t->nsyms = link.size / sym_size;
+	t->entries.size = t->count * t->entsize;
+	t->syms.size = t->nsyms * sym_size;
+	t->entries.data = ft_dwarf_image(d, sec->offset, t->entries.size);
+	t->syms.data = ft_dwarf_image(d, link.offset, t->syms.size);
+	return (t->entries.data == NULL || t->syms.data == NULL);
+}
+
+/**
+ * Reads a relocation of a table.
+ * @param	d	The DWARF context.
+ * @param	t	The table.
+ * @param	k	The index of the relocation.
+ * @param	r	The relocation to fill.
+ */
+static void	reloc_read(const t_dwarf *d, const t_reloc_table *t, size_t k, t_reloc *r)
+{
+	t_dwarf_cursor	c;
+	int				word = d->is_64 ? 8 : 4;
+	uint64_t		info;
+
+	ft_dwarf_cursor(&c, &t->entries, k * t->entsize, t->entries.size, d->endian);
+	r->offset = ft_dwarf_fixed(&c, word);
+	info = ft_dwarf_fixed(&c, word);
+	r->addend = 0;
+	if (t->rela)
+		r->addend = d->is_64 ? (int64_t)ft_dwarf_fixed(&c, 8) : (int32_t)ft_dwarf_fixed(&c, 4);
+	r->sym = d->is_64 ? info >> 32 : info >> 8;
+	r->type = d->is_64 ? (uint32_t)info : (info & 0xff);
+}
+
+/**
+ * Compares two relocation sites by offset.
+ * @param	a	A site.
+ * @param	b	Another site.
+ * @return	A negative, null or positive number.
+ */
+static int	site_cmp(const void *a, const void *b)
+{
+	const t_dwarf_site	*sa = a;
+	const t_dwarf_site	*sb = b;
+
+	if (sa->offset != sb->offset)
+		return ((sa->offset < sb->offset) ? -1 : 1);
+	return (0);
+}
+
+/**
+ * Applies the relocations of a relocation section to the copy of a debug
+ * section, keeping as a site the section every address written points into.
+ * @param	d		The DWARF context.
+ * @param	sec		The header of the relocation section.
+ * @param	slot	The debug section, its data a writable copy.
+ * @param	cap		The number of sites slot->sites has room for.
+ */
+static void	apply_relocations(t_dwarf *d, const t_section *sec, t_dwarf_section *slot, size_t cap)
+{
+	unsigned char	*data = (unsigned char *)slot->data;
+	t_reloc_table	t;
+	t_reloc			r;
+	t_section		target;
+
+	if (reloc_open(d, sec, &t))
+		return;
+	for (size_t k = 0; k < t.count; k++)
+	{
+		Elf64_Sym	sym;
+		uint64_t	value;
+		int			width;
+
+		reloc_read(d, &t, k, &r);
+		width = reloc_width(d->machine, r.type);
+		if (width == 0 || r.sym >= t.nsyms || r.offset > slot->size || (uint64_t)width > slot->size - r.offset)
+			continue;
+		ft_dwarf_read_symbol(d, &t.syms, r.sym, &sym);
+		value = sym.st_value;
+		if (!t.rela)
+		{
+			t_dwarf_cursor	c;
+
+			ft_dwarf_cursor(&c, slot, r.offset, slot->size, d->endian);
+			r.addend = ft_dwarf_fixed(&c, width);
+		}
+		value += r.addend;
+		for (int i = 0; i < width; i++)
+			data[r.offset + ((d->endian == ELFDATA2MSB) ? width - 1 - i : i)] = value >> (8 * i);
+		if (sym.st_shndx == SHN_UNDEF || sym.st_shndx >= d->shnum)
+			continue;
+		ft_section_header(d->shdrs, sym.st_shndx, d->is_64, &target);
+		if ((target.flags & SHF_ALLOC) && slot->nsites < cap)
+			slot->sites[slot->nsites++] = (t_dwarf_site){r.offset, sym.st_shndx};
+	}
+}
+
+/**
+ * Counts the relocations that apply to a debug section, in the relocation
+ * sections reloc_open accepts.
+ * @param	d		The DWARF context.
+ * @param	index	The index of the debug section.
+ * @param	total	The number of relocations, set.
+ * @return	0 on success, 1 if the count overflows.
+ */
+static int	count_relocations(const t_dwarf *d, size_t index, size_t *total)
+{
+	t_section		sec;
+	t_reloc_table	t;
+
+	*total = 0;
+	for (size_t i = 1; i < d->shnum; i++)
+	{
+		ft_section_header(d->shdrs, i, d->is_64, &sec);
+		if ((sec.type != SHT_RELA && sec.type != SHT_REL) || sec.info != index || reloc_open(d, &sec, &t))
+			continue;
+		if (t.count > SIZE_MAX / sizeof(t_dwarf_site) - *total)
+			return (1);
+		*total += t.count;
+	}
+	return (0);
+}
+
+/**
+ * Relocates a debug section of a relocatable file: the section is copied,
+ * every relocation section applying to it is applied to the copy, and the
+ * sites of its relocated addresses are sorted by offset.
+ * @param	d		The DWARF context.
+ * @param	index	The index of the debug section.
+ * @param	slot	The debug section.
+ * @return	0 on success, 1 on allocation failure.
+ */
+int	ft_dwarf_relocate(t_dwarf *d, size_t index, t_dwarf_section *slot)
+{
+	t_section		sec;
+	size_t			total;
+	unsigned char	*copy;
+
+	if (count_relocations(d, index, &total) || total == 0)
+		return (0);
+	copy = ft_arena_alloc(d->arena, slot->size ? slot->size : 1);
+	slot->sites = ft_arena_alloc(d->arena, sizeof(t_dwarf_site) * total);
+	if (copy == NULL || slot->sites == NULL)
+		return (d->failed = 1);
+	ft_memcpy(copy, slot->data, slot->size);
+	slot->data = copy;
+	for (size_t i = 1; i < d->shnum; i++)
+	{
+		ft_section_header(d->shdrs, i, d->is_64, &sec);
+		if ((sec.type == SHT_RELA || sec.type == SHT_REL) && sec.info == index)
+			apply_relocations(d, &sec, slot, total);
+	}
+	qsort(slot->sites, slot->nsites, sizeof(t_dwarf_site), site_cmp);
+	return (0);
+}
+
+/**
+ * Compares two relocation sections by target section, then by index.
+ * @param	a	A relocation section.
+ * @param	b	Another relocation section.
+ * @return	A negative or positive number.
+ */
+static int	order_cmp(const void *a, const void *b)
+{
+	const t_reloc_order	*oa = a;
+	const t_reloc_order	*ob = b;
+
+	if (oa->target != ob->target)
+		return ((oa->target < ob->target) ? -1 : 1);
+	return ((oa->index < ob->index) ? -1 : (oa->index > ob->index));
+}
+
+/**
+ * Gives an undefined symbol the line of the first relocation against it
+ * whose place has one, walking the relocations of the allocated sections in
+ * section order, as nm -l does. A place DWARF has no line for is placed in
+ * a file from the symbol table instead.
+ * @param	d		The DWARF context.
+ * @param	order	The relocation sections, sorted.
+ * @param	n		The number of relocation sections.
+ */
+static void	walk_undefined(t_dwarf *d, const t_reloc_order *order, size_t n)
+{
+	t_section		sec;
+	t_reloc_table	t;
+	t_reloc			r;
+
+	for (size_t i = 0; i < n && !d->failed; i++)
+	{
+		ft_section_header(d->shdrs, order[i].index, d->is_64, &sec);
+		if (reloc_open(d, &sec, &t))
+			continue;
+		for (size_t k = 0; k < t.count && !d->failed; k++)
+		{
+			const t_line_row	*row;
+			Elf64_Sym			sym;
+
+			reloc_read(d, &t, k, &r);
+			if (r.sym >= d->nsyms || r.sym >= t.nsyms || d->undefined[r.sym])
+				continue;
+			ft_dwarf_read_symbol(d, &t.syms, r.sym, &sym);
+			if (sym.st_shndx != SHN_UNDEF)
+				continue;
+			row = ft_dwarf_nearest(d, order[i].target, r.offset);
+			if (row == NULL || row->file == NULL)
+				row = ft_dwarf_elf_function(d, order[i].target, r.offset);
+			d->undefined[r.sym] = row;
+		}
+	}
+}
+
+/**
+ * Finds the line of an undefined symbol of a relocatable file, from the
+ * places it is relocated at. The lines of every undefined symbol are found
+ * in a single walk over the relocations, the first time one is asked for.
+ * @param	d		The DWARF context.
+ * @param	index	The index of the symbol in the symbol table listed.
+ * @return	The location, or NULL if none is known (d->failed is set on
+ * 			allocation failure).
+ */
+const t_line_row	*ft_dwarf_undefined(t_dwarf *d, size_t index)
+{
+	t_reloc_order	*order;
+	t_section		sec;
+	t_section		target;
+	size_t			n = 0;
+
+	if (d->image == NULL || !d->rel || index >= d->nsyms || d->failed)
+		return (NULL);
+	if (!(d->state & DWARF_UNDEFINED))
+	{
+		d->state |= DWARF_UNDEFINED;
+		d->undefined = ft_heap_calloc(d->nsyms, sizeof(t_line_row *));
+		order = ft_heap_alloc(sizeof(t_reloc_order) * d->shnum);
+		if (d->undefined == NULL || order == NULL)
+		{
+			free(order);
+			d->failed = 1;
+			return (NULL);
+		}
+		for (size_t i = 1; i < d->shnum; i++)
+		{
+			ft_section_header(d->shdrs, i, d->is_64, &sec);
+			if ((sec.type != SHT_RELA && sec.type != SHT_REL) || sec.link != d->symtab_index
+				|| sec.info == 0 || sec.info >= d->shnum)
+				continue;
+			ft_section_header(d->shdrs, sec.info, d->is_64, &target);
+			if (target.flags & SHF_ALLOC)
+				order[n++] = (t_reloc_order){sec.info, i};
+		}
+		qsort(order, n, sizeof(t_reloc_order), order_cmp);
+		walk_undefined(d, order, n);
+		free(order);
+	}
+	return (d->undefined ? d->undefined[index] : NULL);
+}
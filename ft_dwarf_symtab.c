@@ -0,0 +1,265 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_dwarf_symtab.c                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 18:37:51 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 18:44:04 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/**
+ * Reads a symbol of a table, of either class.
+ * @param	d		The DWARF context.
+ * @param	syms	The symbol table.
+ * @param	index	The index of the symbol, in range.
+ * @param	sym		Filled with the fields of the symbol.
+ */
+void	ft_dwarf_read_symbol(const t_dwarf *d, const t_dwarf_section *syms, uint64_t index, Elf64_Sym *sym)
+{
+	t_dwarf_cursor	c;
+
+	ft_bzero(sym, sizeof(Elf64_Sym));
+	if (d->is_64)
+	{
+		ft_dwarf_cursor(&c, syms, index * sizeof(Elf64_Sym), syms->size, d->endian);
+		sym->st_name = ft_dwarf_fixed(&c, 4);
+		sym->st_info = ft_dwarf_fixed(&c, 1);
+		sym->st_other = ft_dwarf_fixed(&c, 1);
+		sym->st_shndx = ft_dwarf_fixed(&c, 2);
+		sym->st_value = ft_dwarf_fixed(&c, 8);
+		sym->st_size = ft_dwarf_fixed(&c, 8);
+		return;
+	}
+	ft_dwarf_cursor(&c, syms, index * sizeof(Elf32_Sym), syms->size, d->endian);
+	sym->st_name = ft_dwarf_fixed(&c, 4);
+	sym->st_value = ft_dwarf_fixed(&c, 4);
+	sym->st_size = ft_dwarf_fixed(&c, 4);
+	sym->st_info = ft_dwarf_fixed(&c, 1);
+	sym->st_other = ft_dwarf_fixed(&c, 1);
+	sym->st_shndx = ft_dwarf_fixed(&c, 2);
+}
+
+/**
+ * Compares two symbols by section, value, then index.
+ * @param	a	A symbol.
+ * @param	b	Another symbol.
+ * @return	A negative or positive number.
+ */
+static int	symbol_cmp(const void *a, const void *b)
+{
+	const t_dwarf_symbol	*sa = a;
+	const t_dwarf_symbol	*sb = b;
+
+	if (sa->shndx != sb->shndx)
+		return ((sa->shndx < sb->shndx) ? -1 : 1);
+	if (sa->value != sb->value)
+		return ((sa->value < sb->value) ? -1 : 1);
+	return ((sa->index < sb->index) ? -1 : (sa->index > sb->index));
+}
+
+/**
+ * Gives the name of a symbol, if the string table holds it whole.
+ * @param	strtab	The string table.
+ * @param	size	The size of the string table.
+ * @param	offset	The offset of the name.
+ * @return	The name, or NULL.
+ */
+static const char	*symbol_name(const char *strtab, size_t size, uint32_t offset)
+{
+	if (offset >= size || !ft_memchr(strtab + offset, '\0', size - offset))
+		return (NULL);
+	return (strtab + offset);
+}
+
+/**
+ * Lists the symbols defined in a section, sorted, into the two tables of the
+ * context: the aliases, every symbol but section symbols, and the functions,
+ * the code and untyped symbols bfd places an address in when DWARF has no
+ * line for it. Each function gets the file of the last STT_FILE symbol
+ * before it, except that a global one gets none if a STT_FILE symbol
+ * follows another symbol before it, since the file may then not be its own.
+ * @param	d	The DWARF context.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	list_symbols(t_dwarf *d)
+{
+	size_t			sym_size = d->is_64 ? sizeof(Elf64_Sym) : sizeof(Elf32_Sym);
+	t_dwarf_section	syms = {0};
+	t_section		sec;
+	t_section		link;
+	const char		*strtab;
+	const char		*file = NULL;
+	int				state = 0;
+
+	ft_section_header(d->shdrs, d->symtab_index, d->is_64, &sec);
+	if (sec.entsize != sym_size || sec.link == 0 || sec.link >= d->shnum)
+		return (0);
+	ft_section_header(d->shdrs, sec.link, d->is_64, &link);
+	syms.size = ((sec.size / sym_size < d->nsyms) ? sec.size / sym_size : d->nsyms) * sym_size;
+	syms.data = ft_dwarf_image(d, sec.offset, syms.size);
+	strtab = (const char *)ft_dwarf_image(d, link.offset, link.size);
+	if (syms.data == NULL || strtab == NULL || syms.size == 0)
+		return (0);
+	d->aliases = ft_arena_alloc(d->arena, sizeof(t_dwarf_symbol) * (syms.size / sym_size));
+	d->funcs = ft_arena_alloc(d->arena, sizeof(t_dwarf_symbol) * (syms.size / sym_size));
+	if (d->aliases == NULL || d->funcs == NULL)
+		return (d->failed = 1);
+	for (size_t i = 1; i < syms.size / sym_size; i++)
+	{
+		Elf64_Sym		sym;
+		t_dwarf_symbol	entry;
+		int				type;
+
+		ft_dwarf_read_symbol(d, &syms, i, &sym);
+		type = ELF64_ST_TYPE(sym.st_info);
+		if (type == STT_FILE)
+		{
+			file = symbol_name(strtab, link.size, sym.st_name);
+			state += (state == 1);
+			continue;
+		}
+		state += (state == 0);
+		if (sym.st_shndx == SHN_UNDEF || sym.st_shndx >= d->shnum || type == STT_SECTION)
+			continue;
+		entry = (t_dwarf_symbol){sym.st_value, sym.st_size ? sym.st_size : 1,
+			symbol_name(strtab, link.size, sym.st_name), NULL, i, sym.st_shndx,
+			(type == STT_FUNC || type == STT_GNU_IFUNC), (ELF64_ST_BIND(sym.st_info) == STB_GLOBAL)};
+		d->aliases[d->naliases++] = entry;
+		if (type == STT_OBJECT || type == STT_COMMON || type == STT_TLS)
+			continue;
+		entry.file = (ELF64_ST_BIND(sym.st_info) == STB_LOCAL || state != 2) ? file : NULL;
+		d->funcs[d->nfuncs++] = entry;
+	}
+	qsort(d->aliases, d->naliases, sizeof(t_dwarf_symbol), symbol_cmp);
+	qsort(d->funcs, d->nfuncs, sizeof(t_dwarf_symbol), symbol_cmp);
+	return (0);
+}
+
+/**
+ * Finds the first symbol of a sorted table placed after a place.
+ * @param	table	The table.
+ * @param	n		The number of symbols.
+ * @param	shndx	The section index.
+ * @param	value	The value.
+ * @return	The index of the symbol, n if there is none.
+ */
+static size_t	symbol_after(const t_dwarf_symbol *table, size_t n, uint16_t shndx, uint64_t value)
+{
+	size_t	lo = 0;
+	size_t	hi = n;
+
+	while (lo < hi)
+	{
+		size_t	mid = lo + (hi - lo) / 2;
+
+		if (table[mid].shndx < shndx || (table[mid].shndx == shndx && table[mid].value <= value))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return (lo);
+}
+
+/**
+ * Tells if a symbol placed at the same value as the best one so far fits an
+ * offset better, with the rules of bfd: the one covering more wins if the
+ * best does not reach the offset, a function wins over an untyped symbol if
+ * both do, the smaller one wins otherwise.
+ * @param	best	The best symbol so far.
+ * @param	f		The next symbol, at the same value.
+ * @param	offset	The offset.
+ * @return	1 if f fits better, 0 otherwise.
+ */
+static int	better_fit(const t_dwarf_symbol *best, const t_dwarf_symbol *f, uint64_t offset)
+{
+	if (offset - best->value >= best->size)
+		return (f->size > best->size);
+	if (offset - f->value >= f->size)
+		return (0);
+	if (best->func != f->func)
+		return (f->func);
+	return (f->size < best->size);
+}
+
+/**
+ * Places an offset of a section in a file from the symbol table, for an
+ * address DWARF has no line for: the file of the closest function or
+ * untyped symbol at or below it, with line 0.
+ * @param	d		The DWARF context.
+ * @param	shndx	The section index.
+ * @param	offset	The offset in the section.
+ * @return	The location, or NULL if none is known (d->failed is set on
+ * 			allocation failure).
+ */
+const t_line_row	*ft_dwarf_elf_function(t_dwarf *d, uint16_t shndx, uint64_t offset)
+{
+	const t_dwarf_symbol	*best;
+	t_line_row				*row;
+	size_t					last;
+	size_t					first;
+
+	if (!(d->state & DWARF_SYMBOLS))
+	{
+		d->state |= DWARF_SYMBOLS;
+		if (list_symbols(d))
+			return (NULL);
+	}
+	last = symbol_after(d->funcs, d->nfuncs, shndx, offset);
+	if (last == 0 || d->funcs[last - 1].shndx != shndx)
+		return (NULL);
+	first = last - 1;
+	while (first > 0 && d->funcs[first - 1].shndx == shndx && d->funcs[first - 1].value == d->funcs[last - 1].value)
+		first--;
+	best = &d->funcs[first];
+	for (size_t i = first + 1; i < last; i++)
+		if (better_fit(best, &d->funcs[i], offset))
+			best = &d->funcs[i];
+	if (best->file == NULL)
+		return (NULL);
+	row = ft_arena_alloc(d->arena, sizeof(t_line_row));
+	if (row == NULL)
+	{
+		d->failed = 1;
+		return (NULL);
+	}
+	*row = (t_line_row){offset, best->file, 0, shndx, 0};
+	return (row);
+}
+
+/**
+ * Finds the symbol bfd stands for an address of a data section when asked
+ * for its line: among the symbols at exactly that place, the first global
+ * one, the last one otherwise.
+ * @param	d		The DWARF context.
+ * @param	shndx	The section index.
+ * @param	value	The offset in the section.
+ * @return	The symbol, or NULL if there is none (d->failed is set on
+ * 			allocation failure).
+ */
+const t_dwarf_symbol	*ft_dwarf_alias(t_dwarf *d, uint16_t shndx, uint64_t value)
+{
+	const t_dwarf_symbol	*last = NULL;
+	size_t					i;
+
+	if (!(d->state & DWARF_SYMBOLS))
+	{
+		d->state |= DWARF_SYMBOLS;
+		if (list_symbols(d))
+			return (NULL);
+	}
+	i = symbol_after(d->aliases, d->naliases, shndx, value);
+	while (i > 0 && d->aliases[i - 1].shndx == shndx && d->aliases[i - 1].value == value)
+		i--;
+	for (; i < d->naliases && d->aliases[i].shndx == shndx && d->aliases[i].value == value; i++)
+	{
+		if (d->aliases[i].global)
+			return (&d->aliases[i]);
+		last = &d->aliases[i];
+	}
+	return (last);
+}
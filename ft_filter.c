@@ -0,0 +1,40 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_filter.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:18:33 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 17:25:31 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/**
+ * Tells if a symbol passes the filters of the command line. Only the fields
+ * of the symbol table entry are used, so the decision is taken before any
+ * name lookup or classification. Symbols without a name are kept only for -a
+ * and only if they stand for a section, whose name they take.
+ * @param	config	The filters and the -a flag.
+ * @param	st_name	The name offset of the symbol.
+ * @param	st_info	The binding and type of the symbol.
+ * @param	shndx	The section index of the symbol.
+ * @return	1 if the symbol is listed, 0 otherwise.
+ */
+int	ft_filter_keep(const t_ftnm_config *config, uint32_t st_name, unsigned char st_info, uint16_t shndx)
+{
+	int	bind = ELF64_ST_BIND(st_info);
+
+	if (st_name == 0 && !(config->debug_syms && ELF64_ST_TYPE(st_info) == STT_SECTION))
+		return (0);
+	if ((config->filter & FTNM_FILTER_UNDEFINED) && shndx != SHN_UNDEF)
+		return (0);
+	if ((config->filter & FTNM_FILTER_DEFINED) && shndx == SHN_UNDEF)
+		return (0);
+	if ((config->filter & FTNM_FILTER_EXTERNAL)
+		&& bind != STB_GLOBAL && bind != STB_WEAK && bind != STB_GNU_UNIQUE)
+		return (0);
+	return (1);
+}
@@ -0,0 +1,292 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_format.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 19:02:10 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:46:28 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+#define FORMAT_MAX_WORKERS	8
+#define FORMAT_PARALLEL_MIN	65536
+#define FORMAT_SLICE_MIN	16384
+
+/*
+ * A slice of the symbols of a handle formatted by one thread: measured first,
+ * then written from dst, its offset in the output.
+ */
+typedef struct s_format_slice
+{
+	const t_ftnm		*handle;
+	const t_options		*opts;
+	size_t				lo;
+	size_t				hi;
+	size_t				bytes;
+	char				*dst;
+}	t_format_slice;
+
+/**
+ * Tells if a null value is printed as zeros rather than blanks: with -a, for
+ * every defined symbol (the section and file symbols it brings in
+ * included), as nm does.
+ * @param	symbol	The symbol.
+ * @param	opts	The options of the run.
+ * @return	1 to print zeros, 0 otherwise.
+ */
+static int	shows_zero(const t_ftnm_symbol *symbol, const t_options *opts)
+{
+	return (opts->config.debug_syms && symbol->value == 0
+		&& symbol->type != 'U' && symbol->type != 'w' && symbol->type != 'v');
+}
+
+/**
+ * Picks the value column of the BSD line of a symbol: its value as 8 or 16
+ * hexadecimal digits, blanks for undefined symbols, or none for a symbol left
+ * out of the listing.
+ * @param	buf		A buffer of at least 17 bytes for the formatted value.
+ * @param	symbol	The symbol.
+ * @param	bits	The class of the file, 32 or 64.
+ * @param	opts	The options of the run.
+ * @return	The column, or NULL if the symbol is not displayed.
+ */
+const char	*ft_format_value(char *buf, const t_ftnm_symbol *symbol, int bits, const t_options *opts)
+{
+	if (bits == 32)
+	{
+		if (symbol->type == 'w')
+			return ("        ");
+		if (ft_symbol_is_hidden(symbol, opts))
+			return (NULL);
+		if (shows_zero(symbol, opts))
+			return ("00000000");
+		ft_st_value_to_string(buf, symbol->value, 8);
+		return (buf);
+	}
+	if (symbol->type == 'U')
+		return ("                ");
+	if (ft_symbol_is_hidden(symbol, opts))
+		return (NULL);
+	if (((symbol->type == 'T' || symbol->type == 'b') && symbol->value == 0) || shows_zero(symbol, opts))
+		return ("0000000000000000");
+	ft_st_value_to_string(buf, symbol->value, 16);
+	return (buf);
+}
+
+/**
+ * Counts the decimal digits of a number.
+ * @param	n	The number.
+ * @return	The number of digits.
+ */
+static size_t	count_digits(uint64_t n)
+{
+	size_t	digits = 1;
+
+	while (n >= 10)
+	{
+		n /= 10;
+		digits++;
+	}
+	return (digits);
+}
+
+/**
+ * Tells the exact length of the BSD line of a symbol, newline included.
+ * @param	value	The value column.
+ * @param	symbol	The symbol.
+ * @return	The length of the line.
+ */
+size_t	ft_format_line_length(const char *value, const t_ftnm_symbol *symbol)
+{
+	size_t	len = ft_strlen(value) + 4 + symbol->name_len;
+
+	if (symbol->file)
+		len += ft_strlen(symbol->file) + 2 + count_digits(symbol->line);
+	return (len);
+}
+
+/**
+ * Writes the "value type name" BSD line of a symbol, followed by
+ * "<tab>file:line" when -l found its source, into memory holding
+ * ft_format_line_length bytes.
+ * @param	dst		The destination.
+ * @param	value	The value column.
+ * @param	symbol	The symbol.
+ * @return	The end of the line written.
+ */
+char	*ft_format_line(char *dst, const char *value, const t_ftnm_symbol *symbol)
+{
+	size_t	len = ft_strlen(value);
+
+	ft_memcpy(dst, value, len);
+	dst += len;
+	*dst++ = ' ';
+	*dst++ = symbol->type;
+	*dst++ = ' ';
+	ft_memcpy(dst, symbol->name, symbol->name_len);
+	dst += symbol->name_len;
+	if (symbol->file)
+	{
+		uint64_t	n = symbol->line;
+		size_t		digits = count_digits(n);
+
+		*dst++ = '\t';
+		len = ft_strlen(symbol->file);
+		ft_memcpy(dst, symbol->file, len);
+		dst += len;
+		*dst++ = ':';
+		for (size_t i = digits; i-- > 0; n /= 10)
+			dst[i] = '0' + (n % 10);
+		dst += digits;
+	}
+	*dst++ = '\n';
+	return (dst);
+}
+
+/**
+ * Measures a slice (dst NULL) or writes its lines from dst.
+ * @param	arg	The slice.
+ * @return	NULL.
+ */
+static void	*format_slice(void *arg)
+{
+	t_format_slice	*s = arg;
+	t_ftnm_iter		iter;
+	t_ftnm_symbol	symbol;
+	int				bits = ftnm_class(s->handle);
+	char			buf[17];
+	char			*dst = s->dst;
+
+	ftnm_iter_init(&iter, s->handle);
+	iter.pos = s->lo;
+	while (iter.pos < s->hi && ftnm_iter_next(&iter, &symbol))
+	{
+		const char	*value = ft_format_value(buf, &symbol, bits, s->opts);
+
+		if (value == NULL)
+			continue;
+		if (dst)
+			dst = ft_format_line(dst, value, &symbol);
+		else
+			s->bytes += ft_format_line_length(value, &symbol);
+	}
+	return (NULL);
+}
+
+/**
+ * Runs one pass over the slices, one thread each, the first one in the
+ * calling thread (as are those whose thread cannot be started).
+ * @param	slices	The slices.
+ * @param	n		The number of slices.
+ */
+static void	run_slices(t_format_slice *slices, size_t n)
+{
+	pthread_t	workers[FORMAT_MAX_WORKERS];
+	int			started[FORMAT_MAX_WORKERS];
+
+	for (size_t i = 1; i < n; i++)
+		started[i] = (pthread_create(&workers[i], NULL, format_slice, &slices[i]) == 0);
+	format_slice(&slices[0]);
+	for (size_t i = 1; i < n; i++)
+	{
+		if (started[i])
+			pthread_join(workers[i], NULL);
+		else
+			format_slice(&slices[i]);
+	}
+}
+
+/**
+ * Grows the output file by the size of a listing and maps that range, from
+ * the current offset of its descriptor.
+ * @param	fd		The descriptor of the output file, opened for reading and
+ * 					writing.
+ * @param	total	The size of the listing (not 0).
+ * @param	map		Set to the mapping, left NULL on failure.
+ * @param	len		Set to the length of the mapping.
+ * @return	Where the listing starts in the mapping, or NULL if the file
+ * 			cannot be mapped (its size is then left as it was).
+ */
+static char	*map_output(int fd, size_t total, void **map, size_t *len)
+{
+	off_t	pos = lseek(fd, 0, SEEK_CUR);
+	off_t	page = sysconf(_SC_PAGESIZE);
+	off_t	start = pos & ~(page - 1);
+
+	if (pos < 0 || ftruncate(fd, pos + total) < 0)
+		return (NULL);
+	*len = total + (pos - start);
+	*map = mmap(NULL, *len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, start);
+	if (*map == MAP_FAILED)
+	{
+		*map = NULL;
+		ftruncate(fd, pos);
+		return (NULL);
+	}
+	return ((char *)*map + (pos - start));
+}
+
+/**
+ * Formats the BSD listing of a big in-memory table on several threads. A
+ * first pass measures the lines of each slice of the table; an exclusive
+ * prefix sum of the slice sizes gives where each slice starts, and a second
+ * pass writes every slice in place: into the output file given with -o,
+ * mapped and grown once, or into a single buffer sent with one write.
+ * @param	handle	The handle of the file, sorted.
+ * @param	out		The output writer.
+ * @param	opts	The options of the run.
+ * @return	0 if the listing was written, 1 if it must be formatted serially
+ * 			(a small or spilled table, a single processor, or no memory).
+ */
+int	ft_format_parallel(const t_ftnm *handle, t_writer *out, const t_options *opts)
+{
+	t_format_slice	slices[FORMAT_MAX_WORKERS];
+	long			nworkers = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t			total = 0;
+	void			*map = NULL;
+	size_t			map_len = 0;
+	char			*dst = NULL;
+
+	if (handle->spill || handle->count < FORMAT_PARALLEL_MIN)
+		return (1);
+	if (nworkers > FORMAT_MAX_WORKERS)
+		nworkers = FORMAT_MAX_WORKERS;
+	if ((size_t)nworkers > handle->count / FORMAT_SLICE_MIN)
+		nworkers = handle->count / FORMAT_SLICE_MIN;
+	if (nworkers < 2)
+		return (1);
+	for (long i = 0; i < nworkers; i++)
+		slices[i] = (t_format_slice){handle, opts, handle->count * i / nworkers,
+			handle->count * (i + 1) / nworkers, 0, NULL};
+	run_slices(slices, nworkers);
+	for (long i = 0; i < nworkers; i++)
+	{
+		size_t	bytes = slices[i].bytes;
+
+		slices[i].bytes = total;
+		total += bytes;
+	}
+	if (total == 0)
+		return (0);
+	ft_writer_flush(out);
+	if (opts->output && out->fd >= 0)
+		dst = map_output(out->fd, total, &map, &map_len);
+	if (dst == NULL && (dst = ft_heap_alloc(total)) == NULL)
+		return (1);
+	for (long i = 0; i < nworkers; i++)
+		slices[i].dst = dst + slices[i].bytes;
+	run_slices(slices, nworkers);
+	if (map)
+	{
+		munmap(map, map_len);
+		lseek(out->fd, total, SEEK_CUR);
+		return (0);
+	}
+	ft_writer_put(out, dst, total);
+	free(dst);
+	return (0);
+}
@@ -0,0 +1,375 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_input.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:13:16 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:46:28 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/**
+ * Copies a non-seekable input (pipe, terminal, socket) into an unlinked
+ * temporary file, so that it can then be read by ranges like a regular file.
+ * @param	fd			The file descriptor to drain.
+ * @param	syscalls	The system call counter of the input.
+ * @return	The file descriptor of the temporary file, or -1 on error.
+ */
+static int	spool_to_tmpfile(int fd, uint64_t *syscalls)
+{
+	const char	*dir = getenv("TMPDIR");
+	char		path[PATH_MAX];
+	char		buf[65536];
+	ssize_t		ret;
+	int			tmp;
+
+	ft_strlcpy(path, (dir && *dir) ? dir : "/tmp", sizeof(path));
+	if (ft_strlcat(path, "/ft_nm.XXXXXX", sizeof(path)) >= sizeof(path))
+		return (-1);
+	tmp = mkstemp(path);
+	*syscalls += 4;
+	if (tmp >= 0)
+		unlink(path);
+	if (tmp < 0)
+		return (-1);
+	while ((ret = read(fd, buf, sizeof(buf))) != 0)
+	{
+		*syscalls += 2;
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0 || write(tmp, buf, ret) != ret)
+		{
+			close(tmp);
+			return (-1);
+		}
+	}
+	return (tmp);
+}
+
+/**
+ * Reads exactly size bytes at offset, retrying on short reads.
+ * @param	fd			The file descriptor.
+ * @param	buf			The destination.
+ * @param	size		The number of bytes to read.
+ * @param	offset		The position in the file.
+ * @param	syscalls	The system call counter of the input.
+ * @return	0 on success, 1 on error or early end of file.
+ */
+static int	pread_full(int fd, void *buf, size_t size, uint64_t offset, uint64_t *syscalls)
+{
+	ssize_t	ret;
+
+	while (size > 0)
+	{
+		ret = pread(fd, buf, size, offset);
+		(*syscalls)++;
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return (1);
+		buf = (char *)buf + ret;
+		size -= ret;
+		offset += ret;
+	}
+	return (0);
+}
+
+/**
+ * Opens an input on a file descriptor. The access strategy is chosen from
+ * the file type: small regular files are mapped whole, bigger ones only get
+ * the ranges nm needs mapped, block devices are read by ranges with pread
+ * into pooled buffers, and inputs that cannot seek (pipes, stdin) are first
+ * spooled to a temporary file. The first bytes of the file are always copied,
+ * zero-padded, to header. The system calls made on the input are counted,
+ * a mapping accounting for both its mmap and its munmap.
+ * @param	in		The input to initialize.
+ * @param	fd		The file descriptor, owned by the caller.
+ * @param	pool	The buffer pool shared by the inputs of the run.
+ * @param	flags	INPUT_POPULATE to prefault mapped ranges with MAP_POPULATE
+ * 					instead of asking for readahead.
+ * @return	0 on success, or one of the INPUT_ERR_* codes.
+ */
+int	ft_input_open(t_input *in, int fd, t_input_pool *pool, int flags)
+{
+	struct stat	st;
+
+	ft_bzero(in, sizeof(t_input));
+	in->fd = fd;
+	in->owned_fd = -1;
+	in->flags = flags;
+	in->pool = pool;
+	pool->used = 0;
+	in->syscalls = 1;
+	if (fstat(fd, &st) < 0)
+		return (INPUT_ERR_STAT);
+	if (!S_ISREG(st.st_mode) && !S_ISBLK(st.st_mode))
+	{
+		in->owned_fd = spool_to_tmpfile(fd, &in->syscalls);
+		if (in->owned_fd < 0 || fstat(in->owned_fd, &st) < 0)
+		{
+			ft_input_close(in);
+			return (INPUT_ERR_SPOOL);
+		}
+		in->fd = in->owned_fd;
+	}
+	in->syscalls += S_ISBLK(st.st_mode);
+	in->size = S_ISBLK(st.st_mode) ? (uint64_t)lseek(fd, 0, SEEK_END) : (uint64_t)st.st_size;
+	if (in->size == 0)
+	{
+		ft_input_close(in);
+		return (INPUT_ERR_EMPTY);
+	}
+	in->mode = S_ISREG(st.st_mode) ? INPUT_MMAP_RANGES : INPUT_PREAD;
+	if (in->mode == INPUT_MMAP_RANGES && in->size <= INPUT_WHOLE_MAX)
+	{
+		in->map = mmap(NULL, in->size, PROT_READ, MAP_PRIVATE, in->fd, 0);
+		in->syscalls += 2;
+		if (in->map == MAP_FAILED)
+		{
+			in->map = NULL;
+			ft_input_close(in);
+			return (INPUT_ERR_MAP);
+		}
+		in->mode = INPUT_MMAP;
+		in->mapped = in->size;
+	}
+	if (in->mode == INPUT_MMAP)
+		ft_memcpy(in->header, in->map, (in->size < INPUT_HEADER) ? in->size : INPUT_HEADER);
+	else if (pread_full(in->fd, in->header, (in->size < INPUT_HEADER) ? in->size : INPUT_HEADER, 0,
+			&in->syscalls))
+	{
+		ft_input_close(in);
+		return (INPUT_ERR_READ);
+	}
+	return (0);
+}
+
+/**
+ * Initializes an input over a buffer already in memory. The buffer is
+ * borrowed: it must outlive the input and is not unmapped on close.
+ * @param	in		The input to initialize.
+ * @param	data	The contents of the file.
+ * @param	size	The size of the buffer.
+ * @param	pool	The buffer pool shared by the inputs of the run.
+ */
+void	ft_input_open_memory(t_input *in, const void *data, size_t size, t_input_pool *pool)
+{
+	ft_bzero(in, sizeof(t_input));
+	in->fd = -1;
+	in->owned_fd = -1;
+	in->mode = INPUT_MEMORY;
+	in->size = size;
+	in->map = (void *)data;
+	in->pool = pool;
+	pool->used = 0;
+	ft_memcpy(in->header, data, (size < INPUT_HEADER) ? size : INPUT_HEADER);
+}
+
+/**
+ * Takes the next buffer of the pool, adding one when every buffer is already
+ * holding a range of the input: a file needs as many as it has ranges read.
+ * @param	pool	The pool.
+ * @return	The buffer, or NULL on allocation failure.
+ */
+static t_pooled	*next_buffer(t_input_pool *pool)
+{
+	t_pooled	*grown;
+	size_t		cap;
+
+	if (pool->used == pool->count)
+	{
+		cap = pool->count ? pool->count * 2 : INPUT_RANGES_MIN;
+		grown = ft_heap_alloc(sizeof(t_pooled) * cap);
+		if (grown == NULL)
+			return (NULL);
+		ft_memcpy(grown, pool->bufs, sizeof(t_pooled) * pool->count);
+		ft_bzero(grown + pool->count, sizeof(t_pooled) * (cap - pool->count));
+		free(pool->bufs);
+		pool->bufs = grown;
+		pool->count = cap;
+	}
+	return (&pool->bufs[pool->used]);
+}
+
+/**
+ * Reads a range into the next buffer of the pool, reusing (and growing if
+ * needed) the buffers of previous files. A NUL byte is added past the range.
+ * @param	in		The input.
+ * @param	offset	The start of the range in the file.
+ * @param	size	The size of the range.
+ * @return	The buffer holding the range, or NULL on error.
+ */
+static void	*read_range(t_input *in, uint64_t offset, uint64_t size)
+{
+	t_pooled	*slot = next_buffer(in->pool);
+
+	if (slot == NULL)
+		return (NULL);
+	if (slot->cap < size + 1)
+	{
+		free(slot->buf);
+		slot->buf = ft_heap_alloc(size + 1);
+		slot->cap = slot->buf ? size + 1 : 0;
+		if (slot->buf == NULL)
+			return (NULL);
+	}
+	if (pread_full(in->fd, slot->buf, size, offset, &in->syscalls))
+		return (NULL);
+	((char *)slot->buf)[size] = '\0';
+	in->pool->used++;
+	in->read += size;
+	return (slot->buf);
+}
+
+/**
+ * Makes room for one more mapping in the list of an input.
+ * @param	in	The input.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	add_mapping_slot(t_input *in)
+{
+	t_mapping	*grown;
+	size_t		cap;
+
+	if (in->nmaps < in->maps_cap)
+		return (0);
+	cap = in->maps_cap ? in->maps_cap * 2 : INPUT_RANGES_MIN;
+	grown = ft_heap_alloc(sizeof(t_mapping) * cap);
+	if (grown == NULL)
+		return (1);
+	ft_memcpy(grown, in->maps, sizeof(t_mapping) * in->nmaps);
+	free(in->maps);
+	in->maps = grown;
+	in->maps_cap = cap;
+	return (0);
+}
+
+/**
+ * Maps a single range of the file, from the page holding its first byte.
+ * The kernel is told the range will be read soon and sequentially, so that
+ * its pages are read ahead instead of faulting in one at a time; with
+ * INPUT_POPULATE they are prefaulted by mmap itself.
+ * @param	in		The input.
+ * @param	offset	The start of the range in the file.
+ * @param	size	The size of the range (not 0).
+ * @return	A pointer to the range, or NULL if it cannot be mapped.
+ */
+static void	*map_range(t_input *in, uint64_t offset, uint64_t size)
+{
+	uint64_t	page = sysconf(_SC_PAGESIZE);
+	uint64_t	start = offset & ~(page - 1);
+	size_t		len = size + (offset - start);
+	int			flags = MAP_PRIVATE;
+	char		*addr;
+
+	if (add_mapping_slot(in))
+		return (NULL);
+	if (in->flags & INPUT_POPULATE)
+		flags |= MAP_POPULATE;
+	addr = mmap(NULL, len, PROT_READ, flags, in->fd, start);
+	in->syscalls++;
+	if (addr == MAP_FAILED)
+		return (NULL);
+	in->syscalls++;
+	if (!(in->flags & INPUT_POPULATE))
+	{
+		in->syscalls += 2;
+		madvise(addr, len, MADV_SEQUENTIAL);
+		madvise(addr, len, MADV_WILLNEED);
+	}
+	in->maps[in->nmaps].addr = addr;
+	in->maps[in->nmaps].len = len;
+	in->nmaps++;
+	in->mapped += len;
+	return (addr + (offset - start));
+}
+
+/**
+ * Gives access to a range of the input. Inputs mapped whole return a pointer
+ * into the mapping; big regular files get just that range mapped (falling
+ * back to a read if mmap fails); other inputs read the range into a pooled
+ * buffer. Ranges stay valid until the input is closed.
+ * @param	in		The input.
+ * @param	offset	The start of the range in the file.
+ * @param	size	The size of the range.
+ * @return	A pointer to the range, or NULL if it does not fit in the file or
+ * 			cannot be read.
+ */
+void	*ft_input_range(t_input *in, uint64_t offset, uint64_t size)
+{
+	void	*range;
+
+	if (offset > in->size || size > in->size - offset)
+		return (NULL);
+	if (in->mode == INPUT_MMAP || in->mode == INPUT_MEMORY)
+		return ((char *)in->map + offset);
+	if (size == 0)
+		return (in->header);
+	if (in->mode == INPUT_MMAP_RANGES)
+	{
+		range = map_range(in, offset, size);
+		if (range)
+			return (range);
+	}
+	return (read_range(in, offset, size));
+}
+
+/**
+ * Drops the pages of the mappings of an input from memory, once what was read
+ * from them is no longer needed: they are read again from the page cache if
+ * touched later. Inputs held in buffers are left as they are.
+ * @param	in	The input.
+ */
+void	ft_input_release(t_input *in)
+{
+	if (in->mode == INPUT_MMAP)
+	{
+		madvise(in->map, in->size, MADV_DONTNEED);
+		in->syscalls++;
+	}
+	for (size_t i = 0; i < in->nmaps; i++)
+	{
+		madvise(in->maps[i].addr, in->maps[i].len, MADV_DONTNEED);
+		in->syscalls++;
+	}
+}
+
+/**
+ * Closes an input: unmaps it and closes the spool file if any. Pooled
+ * buffers are kept for the next input.
+ * @param	in	The input.
+ */
+void	ft_input_close(t_input *in)
+{
+	if (in->map && in->mode != INPUT_MEMORY)
+		munmap(in->map, in->size);
+	for (size_t i = 0; i < in->nmaps; i++)
+		munmap(in->maps[i].addr, in->maps[i].len);
+	if (in->owned_fd >= 0)
+		close(in->owned_fd);
+	free(in->maps);
+	in->map = NULL;
+	in->maps = NULL;
+	in->nmaps = 0;
+	in->maps_cap = 0;
+	in->owned_fd = -1;
+	in->pool->used = 0;
+}
+
+/**
+ * Releases the buffers of a pool at the end of the run.
+ * @param	pool	The pool.
+ */
+void	ft_input_pool_free(t_input_pool *pool)
+{
+	for (size_t i = 0; i < pool->count; i++)
+		free(pool->bufs[i].buf);
+	free(pool->bufs);
+	pool->bufs = NULL;
+	pool->count = 0;
+	pool->used = 0;
+}
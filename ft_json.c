@@ -0,0 +1,377 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_json.c                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:04:16 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:43:24 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+#define SWAR_ONES	0x0101010101010101ULL
+#define SWAR_HIGHS	0x8080808080808080ULL
+
+/**
+ * Tells if a byte has to be escaped inside a JSON string: quote, backslash
+ * and control characters below 0x20.
+ * @param	c	The byte to check.
+ * @return	1 if the byte needs escaping, 0 otherwise.
+ */
+static int	json_needs_escape(unsigned char c)
+{
+	return (c < 0x20 || c == '"' || c == '\\');
+}
+
+/**
+ * Flags, in a word of 8 bytes, every byte that may need escaping. The test
+ * can report false positives above a real hit but never misses one, so a
+ * null result proves the whole word can be copied as is.
+ * @param	word	8 bytes of the string.
+ * @return	0 if none of the 8 bytes needs escaping.
+ */
+static uint64_t	swar_escape_mask(uint64_t word)
+{
+	uint64_t	quote = word ^ (SWAR_ONES * '"');
+	uint64_t	bslash = word ^ (SWAR_ONES * '\\');
+	uint64_t	hits;
+
+	hits = (word - SWAR_ONES * 0x20) & ~word;
+	hits |= (quote - SWAR_ONES) & ~quote;
+	hits |= (bslash - SWAR_ONES) & ~bslash;
+	return (hits & SWAR_HIGHS);
+}
+
+/**
+ * Returns the length of the longest prefix of s that can be copied without
+ * escaping. Scans 16 bytes at a time with SSE2 when available, then 8 bytes
+ * at a time with SWAR, then byte by byte for the remaining tail. A word the
+ * SWAR test flags is checked byte by byte, and the scan goes on with the
+ * next word if the flag was a false positive.
+ * @param	s	The string to scan.
+ * @param	len	The length of the string.
+ * @return	The index of the first byte needing escaping, or len.
+ */
+static size_t	json_clean_prefix(const char *s, size_t len)
+{
+	size_t		i = 0;
+	uint64_t	word;
+
+#ifdef __SSE2__
+	const __m128i	quote = _mm_set1_epi8('"');
+	const __m128i	bslash = _mm_set1_epi8('\\');
+	const __m128i	ctrl = _mm_set1_epi8(0x1f);
+
+	for (; i + 16 <= len; i += 16)
+	{
+		__m128i	v = _mm_loadu_si128((const __m128i *)(s + i));
+		__m128i	m = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash));
+		int		mask;
+
+		m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v));
+		mask = _mm_movemask_epi8(m);
+		if (mask)
+			return (i + __builtin_ctz(mask));
+	}
+#endif
+	for (; i + 8 <= len; i += 8)
+	{
+		ft_memcpy(&word, s + i, 8);
+		if (swar_escape_mask(word) == 0)
+			continue;
+		for (size_t k = i; k < i + 8; k++)
+		{
+			if (json_needs_escape(s[k]))
+				return (k);
+		}
+	}
+	for (; i < len; i++)
+	{
+		if (json_needs_escape(s[i]))
+			return (i);
+	}
+	return (len);
+}
+
+/**
+ * Writes the escape sequence of a single byte.
+ * @param	w	The output writer.
+ * @param	c	The byte to escape.
+ */
+static void	json_put_escaped(t_writer *w, unsigned char c)
+{
+	char	seq[6] = {'\\', 'u', '0', '0', 0, 0};
+
+	if (c == '"' || c == '\\')
+		seq[1] = c;
+	else if (c == '\n')
+		seq[1] = 'n';
+	else if (c == '\t')
+		seq[1] = 't';
+	else if (c == '\r')
+		seq[1] = 'r';
+	else if (c == '\b')
+		seq[1] = 'b';
+	else if (c == '\f')
+		seq[1] = 'f';
+	else
+	{
+		seq[4] = "0123456789abcdef"[c >> 4];
+		seq[5] = "0123456789abcdef"[c & 0xF];
+		ft_writer_put(w, seq, 6);
+		return;
+	}
+	ft_writer_put(w, seq, 2);
+}
+
+/**
+ * Writes s as the content of a JSON string (without the surrounding quotes).
+ * Runs of bytes that need no escaping, which is almost every symbol name,
+ * are copied in bulk.
+ * @param	w	The output writer.
+ * @param	s	The string to escape.
+ * @param	len	The length of the string.
+ */
+void	ft_json_escape(t_writer *w, const char *s, size_t len)
+{
+	size_t	n;
+
+	while (len)
+	{
+		n = json_clean_prefix(s, len);
+		ft_writer_put(w, s, n);
+		if (n == len)
+			break;
+		json_put_escaped(w, s[n]);
+		s += n + 1;
+		len -= n + 1;
+	}
+}
+
+/**
+ * Writes a quoted and escaped JSON string of known length, or null for a NULL
+ * pointer.
+ * @param	w	The output writer.
+ * @param	s	The string to write.
+ * @param	len	The length of the string.
+ */
+static void	json_put_span(t_writer *w, const char *s, size_t len)
+{
+	if (s == NULL)
+	{
+		ft_writer_put(w, "null", 4);
+		return;
+	}
+	ft_writer_putc(w, '"');
+	ft_json_escape(w, s, len);
+	ft_writer_putc(w, '"');
+}
+
+/**
+ * Writes a quoted and escaped JSON string, or null for a NULL pointer.
+ * @param	w	The output writer.
+ * @param	s	The string to write.
+ */
+static void	json_put_string(t_writer *w, const char *s)
+{
+	json_put_span(w, s, s ? ft_strlen(s) : 0);
+}
+
+/**
+ * Writes a value as a zero-padded hexadecimal JSON string.
+ * @param	w		The output writer.
+ * @param	value	The value to write.
+ * @param	digits	The number of digits (8 or 16).
+ */
+static void	json_put_hex(t_writer *w, uint64_t value, int digits)
+{
+	char	buf[18];
+
+	buf[0] = '"';
+	for (int i = digits; i > 0; --i, value >>= 4)
+		buf[i] = "0123456789abcdef"[value & 0xF];
+	buf[digits + 1] = '"';
+	ft_writer_put(w, buf, digits + 2);
+}
+
+/**
+ * Opens the output of a run: the JSON format wraps every object of every file
+ * in a single array.
+ * @param	nm	The run context.
+ */
+void	ft_json_begin(t_nm *nm)
+{
+	if (nm->opts.format == FORMAT_JSON)
+		ft_writer_put(&nm->out, "[\n", 2);
+	nm->json_count = 0;
+}
+
+/**
+ * Closes the output of a run and flushes it.
+ * @param	nm	The run context.
+ */
+void	ft_json_end(t_nm *nm)
+{
+	if (nm->opts.format == FORMAT_JSON)
+	{
+		if (nm->json_count)
+			ft_writer_putc(&nm->out, '\n');
+		ft_writer_put(&nm->out, "]\n", 2);
+	}
+	ft_writer_flush(&nm->out);
+}
+
+/**
+ * Prints the symbols of a file as JSON objects (name, value, size, type,
+ * section, file, member, and source_file and source_line with -l), either
+ * as elements of the run array or one per line for NDJSON. Symbols hidden
+ * from the BSD listing are left out too.
+ * @param	handle		The handle of the file.
+ * @param	filename	The name of the file containing the symbols.
+ * @param	nm			The run context.
+ */
+void	ft_print_symbols_json(const t_ftnm *handle, char *filename, t_nm *nm)
+{
+	t_writer		*out = &nm->out;
+	int				digits = (ftnm_class(handle) == 32) ? 8 : 16;
+	t_ftnm_iter		iter;
+	t_ftnm_symbol	symbol;
+	t_ftnm_symbol	*tmp = &symbol;
+
+	ftnm_iter_init(&iter, handle);
+	while (ftnm_iter_next(&iter, tmp))
+	{
+		if (ft_symbol_is_hidden(tmp, &nm->opts))
+			continue;
+		if (nm->opts.format == FORMAT_JSON && nm->json_count)
+			ft_writer_put(out, ",\n", 2);
+		ft_writer_put(out, "{\"name\":", 8);
+		json_put_span(out, tmp->name, tmp->name_len);
+		ft_writer_put(out, ",\"value\":", 9);
+		json_put_hex(out, tmp->value, digits);
+		ft_writer_put(out, ",\"size\":", 8);
+		ft_writer_putnbr(out, tmp->size);
+		ft_writer_put(out, ",\"type\":\"", 9);
+		ft_writer_putc(out, tmp->type);
+		ft_writer_put(out, "\",\"section\":", 12);
+		json_put_string(out, tmp->section);
+		ft_writer_put(out, ",\"file\":", 8);
+		json_put_string(out, filename);
+		ft_writer_put(out, ",\"member\":null", 14);
+		if (nm->opts.config.line_numbers)
+		{
+			ft_writer_put(out, ",\"source_file\":", 15);
+			json_put_string(out, tmp->file);
+			ft_writer_put(out, ",\"source_line\":", 15);
+			if (tmp->file)
+				ft_writer_putnbr(out, tmp->line);
+			else
+				ft_writer_put(out, "null", 4);
+		}
+		ft_writer_putc(out, '}');
+		if (nm->opts.format == FORMAT_NDJSON)
+			ft_writer_putc(out, '\n');
+		nm->json_count++;
+	}
+	ft_writer_flush(out);
+}
+
+/**
+ * Writes the non-zero counters of a list as the members of a JSON object.
+ * @param	w		The output writer.
+ * @param	names	The names of the counters.
+ * @param	counts	The counters.
+ * @param	n		The number of counters.
+ */
+static void	json_put_counts(t_writer *w, const char **names, const uint64_t *counts, size_t n)
+{
+	int	first = 1;
+
+	ft_writer_putc(w, '{');
+	for (size_t i = 0; i < n; i++)
+	{
+		if (counts[i] == 0)
+			continue;
+		if (!first)
+			ft_writer_putc(w, ',');
+		json_put_string(w, names[i]);
+		ft_writer_putc(w, ':');
+		ft_writer_putnbr(w, counts[i]);
+		first = 0;
+	}
+	ft_writer_putc(w, '}');
+}
+
+/**
+ * Prints the summary of a file as a JSON object: file, symbols, undefined,
+ * types, bindings and visibility (objects of counts), and sections (an array
+ * of name, symbols and size), as an element of the run array or on its own
+ * line for NDJSON.
+ * @param	filename	The name of the file.
+ * @param	nm			The run context.
+ */
+void	ft_print_summary_json(char *filename, t_nm *nm)
+{
+	static const char	*bindings[] = {"local", "global", "weak", "unique", "other"};
+	static const char	*visibility[] = {"default", "internal", "hidden", "protected"};
+	t_summary			*summary = &nm->summary;
+	t_writer			*out = &nm->out;
+	uint64_t			binds[5] = {0};
+	int					first = 1;
+
+	for (int i = 0; i < 16; i++)
+		binds[(i <= STB_WEAK) ? i : (i == STB_GNU_UNIQUE) ? 3 : 4] += summary->bindings[i];
+	if (nm->opts.format == FORMAT_JSON && nm->json_count)
+		ft_writer_put(out, ",\n", 2);
+	ft_writer_put(out, "{\"file\":", 8);
+	json_put_string(out, filename);
+	ft_writer_put(out, ",\"symbols\":", 11);
+	ft_writer_putnbr(out, summary->symbols);
+	ft_writer_put(out, ",\"undefined\":", 13);
+	ft_writer_putnbr(out, summary->undefined);
+	ft_writer_put(out, ",\"types\":{", 10);
+	for (int c = 0; c < 256; c++)
+	{
+		char	letter = c;
+
+		if (summary->types[c] == 0)
+			continue;
+		if (!first)
+			ft_writer_putc(out, ',');
+		ft_writer_putc(out, '"');
+		ft_json_escape(out, &letter, 1);
+		ft_writer_put(out, "\":", 2);
+		ft_writer_putnbr(out, summary->types[c]);
+		first = 0;
+	}
+	ft_writer_put(out, "},\"bindings\":", 13);
+	json_put_counts(out, bindings, binds, 5);
+	ft_writer_put(out, ",\"visibility\":", 14);
+	json_put_counts(out, visibility, summary->visibility, 4);
+	ft_writer_put(out, ",\"sections\":[", 13);
+	first = 1;
+	for (size_t i = 0; i < summary->nslots; i++)
+	{
+		if (summary->counts[i] == 0)
+			continue;
+		ft_writer_put(out, first ? "{\"name\":" : ",{\"name\":", first ? 8 : 9);
+		json_put_string(out, summary->names[i]);
+		ft_writer_put(out, ",\"symbols\":", 11);
+		ft_writer_putnbr(out, summary->counts[i]);
+		ft_writer_put(out, ",\"size\":", 8);
+		ft_writer_putnbr(out, summary->sizes[i]);
+		ft_writer_putc(out, '}');
+		first = 0;
+	}
+	ft_writer_put(out, "]}", 2);
+	if (nm->opts.format == FORMAT_NDJSON)
+		ft_writer_putc(out, '\n');
+	nm->json_count++;
+	ft_writer_flush(out);
+}
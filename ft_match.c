@@ -0,0 +1,585 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_match.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:20:30 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:23:42 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+#define ATOM_NONE	0
+#define ATOM_CHAR	1
+#define ATOM_STAR	2
+
+#define MATCH_CANDIDATES	32
+
+/**
+ * Makes sure an array can hold `need` elements, doubling its capacity.
+ * @param	array	Pointer to the array.
+ * @param	cap		Pointer to the capacity, in elements.
+ * @param	need	The number of elements needed.
+ * @param	elem	The size of an element.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	reserve(void **array, size_t *cap, size_t need, size_t elem)
+{
+	size_t	new_cap = *cap ? *cap : 16;
+	void	*grown;
+
+	if (need <= *cap)
+		return (0);
+	while (new_cap < need)
+		new_cap *= 2;
+	grown = malloc(new_cap * elem);
+	if (grown == NULL)
+		return (1);
+	ft_memcpy(grown, *array, *cap * elem);
+	ft_bzero((char *)grown + *cap * elem, (new_cap - *cap) * elem);
+	free(*array);
+	*array = grown;
+	*cap = new_cap;
+	return (0);
+}
+
+/**
+ * Parses a bracket expression ("[abc]", "[!a-z]", "[^]x]") into a byte set.
+ * @param	p		The pattern.
+ * @param	len		The length of the pattern.
+ * @param	i		The index of the '['; moved past the ']'.
+ * @param	set		The 256-bit set to fill.
+ * @return	1 if the expression is complete, 0 if there is no closing ']'
+ * 			(the '[' is then a plain character).
+ */
+static int	parse_bracket(const unsigned char *p, size_t len, size_t *i, uint64_t set[4])
+{
+	size_t	j = *i + 1;
+	int		negate = 0;
+	int		first = 1;
+
+	if (j < len && (p[j] == '!' || p[j] == '^'))
+	{
+		negate = 1;
+		j++;
+	}
+	ft_bzero(set, sizeof(uint64_t) * 4);
+	while (j < len && (p[j] != ']' || first))
+	{
+		unsigned char	lo = p[j];
+		unsigned char	hi = lo;
+
+		if (j + 2 < len && p[j + 1] == '-' && p[j + 2] != ']')
+		{
+			hi = p[j + 2];
+			j += 2;
+		}
+		for (unsigned int c = lo; c <= hi; c++)
+			set[c >> 6] |= 1ULL << (c & 63);
+		first = 0;
+		j++;
+	}
+	if (j >= len)
+		return (0);
+	if (negate)
+		for (int w = 0; w < 4; w++)
+			set[w] = ~set[w];
+	*i = j + 1;
+	return (1);
+}
+
+/**
+ * Reads the next atom of a glob: a star, or a set of bytes matching one
+ * character ('?', a bracket expression, an escaped or a plain character).
+ * @param	p		The pattern.
+ * @param	len		The length of the pattern.
+ * @param	i		The index of the atom; moved past it.
+ * @param	set		Filled with the bytes matched by a character atom.
+ * @param	is_meta	Set to 1 if the atom is not a plain character.
+ * @return	ATOM_STAR, ATOM_CHAR, or ATOM_NONE at the end of the pattern.
+ */
+static int	next_atom(const unsigned char *p, size_t len, size_t *i, uint64_t set[4], int *is_meta)
+{
+	unsigned char	c;
+
+	*is_meta = 1;
+	if (*i >= len)
+		return (ATOM_NONE);
+	if (p[*i] == '*')
+	{
+		(*i)++;
+		return (ATOM_STAR);
+	}
+	if (p[*i] == '?')
+	{
+		ft_memset(set, 0xff, sizeof(uint64_t) * 4);
+		(*i)++;
+		return (ATOM_CHAR);
+	}
+	if (p[*i] == '[' && parse_bracket(p, len, i, set))
+		return (ATOM_CHAR);
+	*is_meta = 0;
+	if (p[*i] == '\\' && *i + 1 < len)
+		(*i)++;
+	c = p[(*i)++];
+	ft_bzero(set, sizeof(uint64_t) * 4);
+	set[c >> 6] |= 1ULL << (c & 63);
+	return (ATOM_CHAR);
+}
+
+/**
+ * Makes room for one more string in the literal set.
+ * @param	m		The matcher.
+ * @param	len		The length of the string.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	reserve_literal(t_matcher *m, size_t len)
+{
+	return (reserve((void **)&m->lits, &m->lits_cap, m->lits_len + len, 1)
+		|| reserve((void **)&m->lit_lens, &m->lit_lens_cap, m->nlits + 1, sizeof(size_t))
+		|| reserve((void **)&m->lit_words, &m->lit_words_cap, m->nlits + 1, sizeof(int32_t)));
+}
+
+/**
+ * Adds a pattern without wildcards to the literal set, escapes removed.
+ * @param	m		The matcher.
+ * @param	p		The pattern.
+ * @param	len		The length of the pattern.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	add_literal(t_matcher *m, const unsigned char *p, size_t len)
+{
+	uint64_t	set[4];
+	size_t		i = 0;
+	size_t		start = m->lits_len;
+	int			is_meta;
+
+	if (reserve_literal(m, len))
+		return (1);
+	while (next_atom(p, len, &i, set, &is_meta) == ATOM_CHAR)
+		m->lits[m->lits_len++] = p[i - 1];
+	m->lit_words[m->nlits] = -1;
+	m->lit_lens[m->nlits++] = m->lits_len - start;
+	return (0);
+}
+
+/**
+ * Finds the longest run of plain characters of a glob: any name the glob
+ * matches holds it, so it guards the glob in the Aho-Corasick automaton.
+ * @param	p		The pattern.
+ * @param	len		The length of the pattern.
+ * @param	factor	Filled with the run, escapes removed (at most 63 bytes).
+ * @return	The length of the run, 0 if the glob has no plain character.
+ */
+static size_t	longest_factor(const unsigned char *p, size_t len, unsigned char factor[64])
+{
+	unsigned char	run[64];
+	uint64_t		set[4];
+	size_t			i = 0;
+	size_t			n = 0;
+	size_t			best = 0;
+	int				atom;
+	int				is_meta;
+
+	while ((atom = next_atom(p, len, &i, set, &is_meta)) != ATOM_NONE)
+	{
+		if (is_meta)
+			n = 0;
+		else
+			run[n++] = p[i - 1];
+		if (n > best)
+		{
+			best = n;
+			ft_memcpy(factor, run, n);
+		}
+	}
+	return (best);
+}
+
+/**
+ * Gives the word a glob of natoms character atoms is packed into: the last
+ * word of globs of the same kind (guarded or not) if it has room, or a new
+ * one.
+ * @param	m		The matcher.
+ * @param	natoms	The number of character atoms of the glob.
+ * @param	guarded	1 if the glob is guarded by a factor.
+ * @return	The word, or NULL on allocation failure.
+ */
+static t_globword	*glob_word(t_matcher *m, size_t natoms, int guarded)
+{
+	size_t	*last = guarded ? &m->last_guarded : &m->last_free;
+
+	if (*last == 0 || m->globs[*last - 1].used + natoms + 1 > 64)
+	{
+		if (reserve((void **)&m->globs, &m->globs_cap, m->nglobs + 1, sizeof(t_globword)))
+			return (NULL);
+		m->globs[m->nglobs].guarded = guarded;
+		*last = ++m->nglobs;
+	}
+	return (&m->globs[*last - 1]);
+}
+
+/**
+ * Compiles a glob into the bit-parallel automaton: the glob takes one start
+ * bit and one bit per character atom in a 64-bit word, a star making the bit
+ * before it loop on any byte. Globs are packed into words without crossing
+ * word boundaries, so several globs advance with a single shift per word.
+ * The longest plain run of the glob, if any, goes into the Aho-Corasick
+ * automaton tagged with the word: the word is then only run on names the
+ * run was found in.
+ * @param	m		The matcher.
+ * @param	p		The pattern.
+ * @param	len		The length of the pattern.
+ * @param	natoms	The number of character atoms of the glob.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	add_glob(t_matcher *m, const unsigned char *p, size_t len, size_t natoms)
+{
+	unsigned char	factor[64];
+	size_t			flen = longest_factor(p, len, factor);
+	t_globword		*word = glob_word(m, natoms, flen > 0);
+	uint64_t		set[4];
+	size_t			i = 0;
+	int				bit;
+	int				atom;
+	int				is_meta;
+
+	if (word == NULL || (flen && reserve_literal(m, flen)))
+		return (1);
+	if (flen)
+	{
+		ft_memcpy(m->lits + m->lits_len, factor, flen);
+		m->lits_len += flen;
+		m->lit_words[m->nlits] = word - m->globs;
+		m->lit_lens[m->nlits++] = flen;
+	}
+	bit = word->used;
+	word->starts |= 1ULL << bit;
+	while ((atom = next_atom(p, len, &i, set, &is_meta)) != ATOM_NONE)
+	{
+		if (atom == ATOM_STAR)
+		{
+			word->loops |= 1ULL << bit;
+			continue;
+		}
+		bit++;
+		for (int c = 0; c < 256; c++)
+			if (set[c >> 6] & (1ULL << (c & 63)))
+				word->masks[c] |= 1ULL << bit;
+	}
+	word->accepts |= 1ULL << bit;
+	word->used = bit + 1;
+	return (0);
+}
+
+/**
+ * Adds a pattern to the matcher. Patterns with a wildcard ('*', '?' or a
+ * bracket expression) are globs and must match the whole name; the others
+ * are literals and match anywhere in the name.
+ * @param	m		The matcher.
+ * @param	pattern	The pattern.
+ * @param	len		The length of the pattern.
+ * @return	FTNM_OK, FTNM_ERR_PATTERN for a glob over 63 characters, or
+ * 			FTNM_ERR_MEMORY.
+ */
+int	ft_matcher_add(t_matcher *m, const char *pattern, size_t len)
+{
+	const unsigned char	*p = (const unsigned char *)pattern;
+	uint64_t			set[4];
+	size_t				i = 0;
+	size_t				natoms = 0;
+	int					atom;
+	int					is_meta;
+	int					glob = 0;
+
+	m->active = 1;
+	while ((atom = next_atom(p, len, &i, set, &is_meta)) != ATOM_NONE)
+	{
+		glob |= is_meta;
+		natoms += (atom == ATOM_CHAR);
+	}
+	if (glob && natoms >= 64)
+		return (FTNM_ERR_PATTERN);
+	if ((glob ? add_glob(m, p, len, natoms) : add_literal(m, p, len)))
+		return (FTNM_ERR_MEMORY);
+	return (FTNM_OK);
+}
+
+/**
+ * Adds the patterns of a file, one per line; empty lines and empty files are
+ * ignored. "-" reads the patterns from the standard input.
+ * @param	m		The matcher.
+ * @param	path	The path of the file.
+ * @param	pool	The buffer pool of the run, used to read the file.
+ * @return	FTNM_OK, FTNM_ERR_NOENT or FTNM_ERR_READ if the file cannot be
+ * 			read, or the error of ft_matcher_add.
+ */
+int	ft_matcher_load(t_matcher *m, const char *path, t_input_pool *pool)
+{
+	t_input		in;
+	const char	*data;
+	int			fd = STDIN_FILENO;
+	int			ret = FTNM_OK;
+
+	m->active = 1;
+	if (ft_strncmp(path, "-", 2) != 0 && (fd = open(path, O_RDONLY)) < 0)
+		return (FTNM_ERR_NOENT);
+	ret = ft_input_open(&in, fd, pool, 0);
+	if (ret == INPUT_ERR_EMPTY)
+	{
+		if (fd != STDIN_FILENO)
+			close(fd);
+		return (FTNM_OK);
+	}
+	if (ret != 0 || (data = ft_input_range(&in, 0, in.size)) == NULL)
+		ret = FTNM_ERR_READ;
+	for (size_t start = 0, end; !ret && start < in.size; start = end + 1)
+	{
+		size_t	len;
+
+		end = start;
+		while (end < in.size && data[end] != '\n')
+			end++;
+		len = end - start;
+		if (len && data[start + len - 1] == '\r')
+			len--;
+		if (len)
+			ret = ft_matcher_add(m, data + start, len);
+	}
+	ft_input_close(&in);
+	if (fd != STDIN_FILENO)
+		close(fd);
+	return (ret);
+}
+
+/**
+ * Links each state to the glob words guarded by a factor ending there: its
+ * own guards, then through guard_link those of the longest proper suffix
+ * having some. Called once the failure links are known, in BFS order.
+ * @param	m		The matcher.
+ * @param	state	The state.
+ * @param	fail	The failure state of the state.
+ */
+static void	link_guards(t_matcher *m, size_t state, size_t fail)
+{
+	m->guard_link[state] = (m->guards[fail] >= 0) ? (int32_t)fail : m->guard_link[fail];
+}
+
+/**
+ * Allocates the tables of the automaton, for at most max_states states.
+ * @param	m			The matcher.
+ * @param	max_states	The number of states of the trie, at most.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	alloc_automaton(t_matcher *m, size_t max_states)
+{
+	m->next = malloc(sizeof(int32_t) * max_states * m->nclasses);
+	m->final = ft_calloc(max_states, 1);
+	m->guards = malloc(sizeof(int32_t) * max_states);
+	m->guard_link = malloc(sizeof(int32_t) * max_states);
+	m->guard_word = malloc(sizeof(int32_t) * (m->nlits + 1));
+	m->guard_next = malloc(sizeof(int32_t) * (m->nlits + 1));
+	if (m->next == NULL || m->final == NULL || m->guards == NULL || m->guard_link == NULL
+		|| m->guard_word == NULL || m->guard_next == NULL)
+		return (1);
+	ft_memset(m->next, 0xff, sizeof(int32_t) * max_states * m->nclasses);
+	ft_memset(m->guards, 0xff, sizeof(int32_t) * max_states);
+	ft_memset(m->guard_link, 0xff, sizeof(int32_t) * max_states);
+	return (0);
+}
+
+/**
+ * Builds the Aho-Corasick automaton of the literals and of the factors
+ * guarding globs once every pattern has been added. Bytes that appear in no
+ * string share class 0, so the transition table is nstates x nclasses
+ * instead of nstates x 256, and every transition is resolved up front:
+ * matching is one table lookup per byte. A state ending a literal is final;
+ * one ending a factor lists the glob word it guards.
+ * @param	m	The matcher.
+ * @return	FTNM_OK or FTNM_ERR_MEMORY.
+ */
+int	ft_matcher_finish(t_matcher *m)
+{
+	size_t	max_states = m->lits_len + 1;
+	size_t	*fail;
+	size_t	*queue;
+	size_t	head = 0;
+	size_t	tail = 0;
+
+	if (m->nlits == 0)
+		return (FTNM_OK);
+	m->nclasses = 1;
+	for (size_t i = 0; i < m->lits_len; i++)
+		if (m->classes[(unsigned char)m->lits[i]] == 0)
+			m->classes[(unsigned char)m->lits[i]] = m->nclasses++;
+	fail = malloc(sizeof(size_t) * max_states);
+	queue = malloc(sizeof(size_t) * max_states);
+	if (alloc_automaton(m, max_states) || fail == NULL || queue == NULL)
+	{
+		free(fail);
+		free(queue);
+		return (FTNM_ERR_MEMORY);
+	}
+	m->nstates = 1;
+	for (size_t k = 0, pos = 0; k < m->nlits; pos += m->lit_lens[k++])
+	{
+		size_t	state = 0;
+
+		for (size_t i = pos; i < pos + m->lit_lens[k]; i++)
+		{
+			int32_t	*slot = &m->next[state * m->nclasses + m->classes[(unsigned char)m->lits[i]]];
+
+			if (*slot < 0)
+				*slot = m->nstates++;
+			state = *slot;
+		}
+		if (m->lit_words[k] < 0)
+			m->final[state] = 1;
+		else
+		{
+			m->guard_word[k] = m->lit_words[k];
+			m->guard_next[k] = m->guards[state];
+			m->guards[state] = k;
+		}
+	}
+	for (size_t c = 0; c < m->nclasses; c++)
+	{
+		int32_t	*slot = &m->next[c];
+
+		if (*slot < 0)
+			*slot = 0;
+		else
+		{
+			fail[*slot] = 0;
+			link_guards(m, *slot, 0);
+			queue[tail++] = *slot;
+		}
+	}
+	while (head < tail)
+	{
+		size_t	state = queue[head++];
+
+		for (size_t c = 0; c < m->nclasses; c++)
+		{
+			int32_t	*slot = &m->next[state * m->nclasses + c];
+			int32_t	through_fail = m->next[fail[state] * m->nclasses + c];
+
+			if (*slot < 0)
+				*slot = through_fail;
+			else
+			{
+				fail[*slot] = through_fail;
+				m->final[*slot] |= m->final[through_fail];
+				link_guards(m, *slot, through_fail);
+				queue[tail++] = *slot;
+			}
+		}
+	}
+	free(fail);
+	free(queue);
+	return (FTNM_OK);
+}
+
+/**
+ * Runs the bit-parallel automaton of a glob word over a name.
+ * @param	word	The word.
+ * @param	p		The name.
+ * @param	len		The length of the name.
+ * @return	1 if one of the globs of the word matches the name, 0 otherwise.
+ */
+static int	run_word(const t_globword *word, const unsigned char *p, size_t len)
+{
+	uint64_t	d = word->starts;
+
+	for (size_t i = 0; i < len && d; i++)
+		d = ((d << 1) & word->masks[p[i]]) | (d & word->loops);
+	return ((d & word->accepts) != 0);
+}
+
+/**
+ * Notes the glob words guarded by the factors ending at a state, once each.
+ * @param	m		The matcher.
+ * @param	state	The state.
+ * @param	cands	The candidate words.
+ * @param	n		The number of candidates; set past MATCH_CANDIDATES when
+ * 					there are too many to note, every guarded word being run
+ * 					then.
+ */
+static void	add_candidates(const t_matcher *m, int32_t state, int32_t *cands, size_t *n)
+{
+	if (m->guards[state] < 0)
+		state = m->guard_link[state];
+	for (; state >= 0 && *n <= MATCH_CANDIDATES; state = m->guard_link[state])
+		for (int32_t g = m->guards[state]; g >= 0 && *n <= MATCH_CANDIDATES; g = m->guard_next[g])
+		{
+			size_t	j = 0;
+
+			while (j < *n && cands[j] != m->guard_word[g])
+				j++;
+			if (j == *n && (*n)++ < MATCH_CANDIDATES)
+				cands[j] = m->guard_word[g];
+		}
+}
+
+/**
+ * Tells if a name matches one of the patterns. The literals, and the plain
+ * factors guarding the globs, run through the Aho-Corasick automaton, each
+ * byte of the name being read once. Then only the glob words a factor was
+ * found for, and those of the globs without plain characters, run their
+ * bit-parallel automata: with many globs, the cost grows with the globs that
+ * may match, not with all of them.
+ * @param	m		The matcher.
+ * @param	name	The name (not necessarily NUL-terminated).
+ * @param	len		The length of the name.
+ * @return	1 if the name matches, 0 otherwise.
+ */
+int	ft_match_name(const t_matcher *m, const char *name, size_t len)
+{
+	const unsigned char	*p = (const unsigned char *)name;
+	int32_t				cands[MATCH_CANDIDATES];
+	size_t				n = 0;
+	size_t				state = 0;
+
+	if (m->nstates)
+	{
+		if (m->final[0])
+			return (1);
+		for (size_t i = 0; i < len; i++)
+		{
+			state = m->next[state * m->nclasses + m->classes[p[i]]];
+			if (m->final[state])
+				return (1);
+			if (n <= MATCH_CANDIDATES && (m->guards[state] >= 0 || m->guard_link[state] >= 0))
+				add_candidates(m, state, cands, &n);
+		}
+	}
+	for (size_t j = 0; j < n && n <= MATCH_CANDIDATES; j++)
+		if (run_word(&m->globs[cands[j]], p, len))
+			return (1);
+	for (size_t w = 0; w < m->nglobs; w++)
+		if ((!m->globs[w].guarded || n > MATCH_CANDIDATES) && run_word(&m->globs[w], p, len))
+			return (1);
+	return (0);
+}
+
+/**
+ * Frees the tables of a matcher.
+ * @param	m	The matcher.
+ */
+void	ft_matcher_free(t_matcher *m)
+{
+	free(m->lits);
+	free(m->lit_lens);
+	free(m->lit_words);
+	free(m->next);
+	free(m->final);
+	free(m->guards);
+	free(m->guard_link);
+	free(m->guard_word);
+	free(m->guard_next);
+	free(m->globs);
+	ft_bzero(m, sizeof(t_matcher));
+}
@@ -6,89 +6,441 @@
 /*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
 /*                                                +#+#+#+#+#+   +#+           */
 /*   Created: 2023/08/09 13:56:36 by jbertin           #+#    #+#             */
-/*   Updated: 2023/08/09 15:06:31 by jbertin          ###   ########.fr       */
+/*   Updated: 2026/10/19 19:45:13 by jbertin          ###   ########.fr       */
 /*                                                                            */
 /* ************************************************************************** */
 
+
 #include "includes/nm.h"
 
 /**
- * Reads the symbol table of an ELF32 file, retrieves each symbol's name and
- * type, and adds it to a list of symbols. It returns the updated symbols list.
- * @param	map					A pointer to the mapped ELF32 file in memory.
+ * Resolves the name of the section a symbol belongs to, from its section
+ * index. Special indexes get the names used by objdump. The index and the
+ * name offset are in range once validate_tables has passed.
+ * @param	elf		The ELF32 file (section headers and their string table).
+ * @param	shndx	The section index of the symbol.
+ * @return	The section name, or NULL if it cannot be resolved.
+ */
+static const char	*section_name(t_elf *elf, uint16_t shndx)
+{
+	Elf32_Shdr	*section_headers = elf->shdrs;
+
+	if (shndx == SHN_UNDEF)
+		return ("*UND*");
+	if (shndx == SHN_ABS)
+		return ("*ABS*");
+	if (shndx == SHN_COMMON)
+		return ("*COM*");
+	if (shndx >= SHN_LORESERVE || elf->shstrtab == NULL)
+		return (NULL);
+	return (elf->shstrtab + section_headers[shndx].sh_name);
+}
+
+/**
+ * Classifies a block of kept symbols and stores their type letters. Undefined
+ * symbols get a null value.
+ * @param	elf			The ELF32 file.
+ * @param	classifier	The per-section class table.
+ * @param	block		Copies of the kept symbols, contiguous.
+ * @param	n			The number of symbols in the block.
+ * @param	entries		The entries of the symbols, in the same order.
+ */
+static void	classify_pending(t_elf *elf, t_classifier *classifier, Elf32_Sym *block, size_t n, t_symbol *entries)
+{
+	unsigned char	letters[CLASSIFY_BLOCK];
+
+	ft_classify_block32(classifier, block, n, elf->endian, letters);
+	for (size_t j = 0; j < n; j++)
+	{
+		entries[j].type = letters[j];
+		if (letters[j] == 'U')
+			entries[j].value = 0;
+	}
+}
+
+/**
+ * Resolves the name of a symbol as a span: the name of its section for an
+ * unnamed symbol (kept with -a). The name is known to be in the string table,
+ * and terminated within it, once validate_tables has passed.
+ * @param	elf		The ELF32 file.
+ * @param	strtab	The string table of the symbols.
+ * @param	st_name	The st_name of the symbol.
+ * @param	shndx	The section index of the symbol.
+ * @param	entry	The entry whose name and name_len are set.
+ */
+static void	symbol_name(t_elf *elf, t_strtab *strtab, uint32_t st_name, uint16_t shndx, t_symbol *entry)
+{
+	if (st_name == 0)
+	{
+		entry->name = section_name(elf, shndx);
+		if (entry->name == NULL)
+			entry->name = "";
+		entry->name_len = ft_strlen(entry->name);
+	}
+	else
+	{
+		entry->name = strtab->data + st_name;
+		entry->name_len = ft_strtab_name_len(strtab, st_name);
+	}
+}
+
+/**
+ * Finds the source line of a symbol for -l: through the relocations against
+ * it for an undefined symbol, from its declaration or address otherwise.
+ * Symbols of reserved sections have none.
+ * @param	elf		The ELF32 file, with its DWARF context.
+ * @param	symbol	The symbol.
+ * @param	index	The index of the symbol in the table.
+ * @param	shndx	The section index of the symbol.
+ * @param	entry	The entry of the symbol, its name set.
+ * @return	The location, or NULL if none is known.
+ */
+static const t_line_row	*symbol_line(t_elf *elf, Elf32_Sym *symbol, size_t index, uint16_t shndx,
+	const t_symbol *entry)
+{
+	unsigned char	type = ELF32_ST_TYPE(symbol->st_info);
+
+	if (shndx == SHN_UNDEF)
+		return (ft_dwarf_undefined(elf->dwarf, index));
+	if (shndx >= SHN_LORESERVE)
+		return (NULL);
+	return (ft_dwarf_symbol(elf->dwarf, shndx, symbol->st_value, entry, type == STT_FUNC || type == STT_GNU_IFUNC));
+}
+
+/**
+ * Validates the structure of an ELF32 file once, before its symbols are read,
+ * so that the loops over them need no bounds checks: the symbol table has
+ * the entry size of an Elf32_Sym and links to a section, both tables lie in
+ * the file, the string tables end with a NUL byte, every section name is in
+ * the section string table, and every symbol has its name in the string
+ * table and a section index that is either a section or a reserved one.
+ * The tables are then set in the ELF context. Under a memory budget, the
+ * symbols are checked by strides of half the budget, the pages read being
+ * dropped after each one.
+ * @param	elf					The ELF32 file.
  * @param	symbol_table_header	A pointer to the symbol table header.
- * @param	section_headers		A pointer to the array of section headers in the ELF32 file.
- * @param	o_sec				A pointer to the section headers.
- * @param	symbols				A pointer to the current symbols list.
- * @return	The updated list of symbols after processing the symbol table.
+ * @return	FTNM_OK, or FTNM_ERR_CORRUPT if the file is malformed.
  */
-static t_symbol	*process_symbol_table(void *map, Elf32_Shdr *symbol_table_header, Elf32_Shdr *section_headers, Elf32_Shdr *o_sec, t_symbol *symbols)
+static int	validate_tables(t_elf *elf, Elf32_Shdr *symbol_table_header)
 {
-	int			endian = ((Elf32_Ehdr *)map)->e_ident[EI_DATA];
-	Elf32_Sym	*symbol_table = (Elf32_Sym *) ((char *) map + symbol_table_header->sh_offset);
-	Elf32_Shdr	*strtab_header = &section_headers[symbol_table_header->sh_link];
-	char		*strtab = (char *) map + strtab_header->sh_offset;
+	Elf32_Shdr	*section_headers = elf->shdrs;
+	Elf32_Shdr	*strtab_header;
+	Elf32_Sym	*symbol_table;
+	size_t		stride;
+	uint32_t	bad = 0;
 
-	for (long unsigned int i = 0; i < symbol_table_header->sh_size / sizeof(Elf32_Sym); ++i)
+	if (symbol_table_header->sh_entsize != sizeof(Elf32_Sym) || symbol_table_header->sh_link >= elf->shnum)
+		return (FTNM_ERR_CORRUPT);
+	if (elf->shstrtab && (elf->shstrtab_size == 0 || elf->shstrtab[elf->shstrtab_size - 1] != '\0'))
+		return (FTNM_ERR_CORRUPT);
+	for (size_t i = 0; elf->shstrtab && i < elf->shnum; i++)
+		bad |= (section_headers[i].sh_name >= elf->shstrtab_size);
+	strtab_header = &section_headers[symbol_table_header->sh_link];
+	elf->nsyms = symbol_table_header->sh_size / sizeof(Elf32_Sym);
+	stride = elf->config->max_memory ? elf->config->max_memory / (2 * sizeof(Elf32_Sym)) : elf->nsyms;
+	elf->strtab_size = strtab_header->sh_size;
+	elf->symtab = ft_input_range(elf->in, symbol_table_header->sh_offset, elf->nsyms * sizeof(Elf32_Sym));
+	elf->strtab = ft_input_range(elf->in, strtab_header->sh_offset, elf->strtab_size);
+	if (bad || elf->symtab == NULL || elf->strtab == NULL
+		|| (elf->strtab_size && elf->strtab[elf->strtab_size - 1] != '\0'))
+		return (FTNM_ERR_CORRUPT);
+	symbol_table = elf->symtab;
+	for (size_t start = 0; start < elf->nsyms; start += stride)
 	{
-		Elf32_Sym		*symbol = &symbol_table[i];
-		char			*symbol_name = strtab + symbol->st_name;
-		unsigned char	symbol_type = ft_define_symbol32(symbol, o_sec, endian);
+		for (size_t i = start; i < elf->nsyms && i < start + stride; i++)
+		{
+			uint16_t	shndx = ft_read_uint16(&symbol_table[i].st_shndx, elf->endian);
+
+			bad |= (symbol_table[i].st_name != 0) & (symbol_table[i].st_name >= elf->strtab_size);
+			bad |= (shndx >= elf->shnum) & (shndx < SHN_LORESERVE);
+		}
+		if (elf->config->max_memory)
+			ft_input_release(elf->in);
+	}
+	return (bad ? FTNM_ERR_CORRUPT : FTNM_OK);
+}
+
+/**
+ * Counts a block of kept symbols into the summary of the run, once typed.
+ * Symbols hidden from the listing (null absolute symbols without -a) are left
+ * out, so that the counts match it.
+ * @param	elf			The ELF32 file.
+ * @param	classifier	The per-section class table.
+ * @param	block		Copies of the kept symbols, contiguous.
+ * @param	n			The number of symbols in the block.
+ */
+static void	summarize_pending(t_elf *elf, t_classifier *classifier, Elf32_Sym *block, size_t n)
+{
+	unsigned char	letters[CLASSIFY_BLOCK];
 
-		if (symbol->st_name == 0)
+	ft_classify_block32(classifier, block, n, elf->endian, letters);
+	for (size_t j = 0; j < n; j++)
+	{
+		if ((letters[j] == 'A' || letters[j] == 'a') && block[j].st_value == 0 && !elf->config->debug_syms)
 			continue;
+		ft_summary_add(elf->config->summary, letters[j], block[j].st_info, block[j].st_other,
+			ft_read_uint16(&block[j].st_shndx, elf->endian), block[j].st_size);
+	}
+}
 
-		if (symbol_type == 'U')
-			symbols = ft_add_symbol_to_list(symbols, ft_strdup(symbol_name), symbol_type, ft_st_value_to_string(0, 8));
-		else
-			symbols = ft_add_symbol_to_list(symbols, ft_strdup(symbol_name), symbol_type, ft_st_value_to_string(symbol->st_value, 8));
+/**
+ * Summarizes the symbol table of an ELF32 file in a single streaming pass:
+ * the symbols kept by the filters are typed a block at a time and counted,
+ * without being collected, sorted or named (names are only looked at for
+ * --match). The section names of the summary point into the input.
+ * @param	elf		The ELF32 file, its tables validated.
+ * @return	FTNM_OK or FTNM_ERR_MEMORY.
+ */
+static int	summarize_symbol_table(t_elf *elf)
+{
+	size_t			nsyms = elf->nsyms;
+	Elf32_Sym		*symbol_table = elf->symtab;
+	t_strtab		strtab;
+	t_classifier	classifier;
+	Elf32_Sym		block[CLASSIFY_BLOCK];
+	size_t			pending = 0;
+	int				named = (elf->config->matcher != NULL);
+
+	if (named && (elf->config->filter & FTNM_FILTER_UNDEFINED))
+		ft_strtab_init_unscanned(&strtab, elf->strtab, elf->strtab_size);
+	else if (named && ft_strtab_init(&strtab, elf->strtab, elf->strtab_size, elf->arena))
+		return (FTNM_ERR_MEMORY);
+	if (ft_summary_reset(elf->config->summary, elf->shnum)
+		|| ft_classify_init(&classifier, elf->shdrs, elf->shnum, 0, elf->arena))
+	{
+		if (named)
+			ft_strtab_free(&strtab);
+		return (FTNM_ERR_MEMORY);
 	}
+	for (size_t i = 0; i < elf->shnum; i++)
+	{
+		elf->config->summary->names[i] = section_name(elf, i);
+		if (elf->config->summary->names[i] == NULL)
+			elf->config->summary->names[i] = "";
+	}
+	for (size_t i = 0; i < nsyms; ++i)
+	{
+		Elf32_Sym	*symbol = &symbol_table[i];
+		uint16_t	shndx = ft_read_uint16(&symbol->st_shndx, elf->endian);
+		t_symbol	entry;
 
-	return symbols;
+		if (!ft_filter_keep(elf->config, symbol->st_name, symbol->st_info, shndx))
+			continue;
+		if (elf->config->newer_than && !ft_versions_newer(&elf->versions, i))
+			continue;
+		if (named)
+		{
+			symbol_name(elf, &strtab, symbol->st_name, shndx, &entry);
+			if (!ft_match_name(elf->config->matcher, entry.name, entry.name_len))
+				continue;
+		}
+		block[pending++] = *symbol;
+		if (pending == CLASSIFY_BLOCK)
+		{
+			summarize_pending(elf, &classifier, block, pending);
+			pending = 0;
+		}
+	}
+	summarize_pending(elf, &classifier, block, pending);
+	ft_classify_free(&classifier);
+	if (named)
+		ft_strtab_free(&strtab);
+	return (FTNM_OK);
 }
 
 /**
- * Reads an ELF32 file, identifies its symbol table, and processes it to retrieve
- * and print the symbols it contains. If no symbols are found, a corresponding
- * message is printed.
- * @param	map				A pointer to the mapped ELF32 file in memory.
- * @param	filename		The name of the ELF32 file being processed.
- * @param	filesize		The size of the ELF32 file in bytes.
- * @param	multiple_files	Flag to indicate if there are multiple files to process.
+ * Reads the symbol table of an ELF32 file, retrieves each symbol's name and
+ * type, and stores it in an array of symbols. The -u, -g and --defined-only
+ * filters are applied first, from st_info and st_shndx alone, so that symbols
+ * left out cost no name or type work; the --match patterns then run on the
+ * name span, before classification. The linked string table is scanned once
+ * up front: every name is then a span of known length pointing into the
+ * input.
+ * Kept symbols are typed a block at a time from a per-section class table,
+ * ft_define_symbol32 being the fallback if it cannot be built.
+ * With a spill state, the array only holds a chunk within the memory budget:
+ * once full, it is sorted and spilled as a run, the pages of the input read
+ * so far are dropped, and ft_spill_finish ends the table. The string table
+ * is then not scanned up front, its bitmap growing with the file: each name
+ * length is found from the name bytes. So it is with -u, where only the
+ * names of the imports are looked up.
+ * @param	elf			The ELF32 file, its tables validated.
+ * @param	symbols		Set to the array of symbols (NULL if spilled).
+ * @param	count		Set to the number of symbols stored.
+ * @param	spill		The spill state, NULL without a budget.
+ * @return	FTNM_OK, FTNM_ERR_MEMORY or FTNM_ERR_TEMP.
  */
-void	ft_nm32(void *map, char *filename, long unsigned int filesize, int multiple_files)
+static int	process_symbol_table(t_elf *elf, t_symbol **symbols_out, size_t *count, t_spill *spill)
 {
-	Elf32_Ehdr	*elf_header = (Elf32_Ehdr *) map;
-	Elf32_Shdr	*section_headers = (Elf32_Shdr *) ((char *) map + elf_header->e_shoff);
-	Elf32_Shdr	*o_sec = section_headers;
-	Elf32_Shdr	*symbol_table_header = NULL;
+	Elf32_Shdr		*section_headers = elf->shdrs;
+	size_t			nsyms = elf->nsyms;
+	Elf32_Sym		*symbol_table = elf->symtab;
+	t_strtab		strtab;
+	t_symbol		*symbols;
+	t_classifier	classifier;
+	int				batched;
+	Elf32_Sym		block[CLASSIFY_BLOCK];
+	size_t			pending = 0;
+	size_t			capacity;
+	int				ret = FTNM_OK;
+	int				scanned = !spill && !(elf->config->filter & FTNM_FILTER_UNDEFINED);
+
+	*count = 0;
+	capacity = spill ? ft_spill_capacity(spill, nsyms) : nsyms;
+	symbols = ft_arena_alloc(elf->arena, sizeof(t_symbol) * (capacity ? capacity : 1));
+	if (!scanned)
+		ft_strtab_init_unscanned(&strtab, elf->strtab, elf->strtab_size);
+	if (symbols == NULL || (scanned && ft_strtab_init(&strtab, elf->strtab, elf->strtab_size, elf->arena)))
+	{
+		ft_arena_drop(elf->arena, symbols);
+		return (FTNM_ERR_MEMORY);
+	}
+
+	batched = !ft_classify_init(&classifier, section_headers, elf->shnum, 0, elf->arena);
+	for (long unsigned int i = 0; i < nsyms; ++i)
+	{
+		Elf32_Sym		*symbol = &symbol_table[i];
+		t_symbol		*entry = &symbols[*count + pending];
+		uint16_t		shndx = ft_read_uint16(&symbol->st_shndx, elf->endian);
 
-	if (elf_header->e_shoff > filesize)
+		if (!ft_filter_keep(elf->config, symbol->st_name, symbol->st_info, shndx))
+			continue;
+		if (elf->config->newer_than && !ft_versions_newer(&elf->versions, i))
+			continue;
+
+		symbol_name(elf, &strtab, symbol->st_name, shndx, entry);
+		if (elf->config->matcher && !ft_match_name(elf->config->matcher, entry->name, entry->name_len))
+			continue;
+		entry->line = elf->dwarf ? symbol_line(elf, symbol, i, shndx, entry) : NULL;
+		if ((elf->dwarf && elf->dwarf->failed)
+			|| (elf->config->symbol_versions && ft_versions_name(&elf->versions, i, shndx, entry)))
+		{
+			ret = FTNM_ERR_MEMORY;
+			break;
+		}
+		entry->value = symbol->st_value;
+		entry->size = symbol->st_size;
+		entry->section = section_name(elf, shndx);
+		if (!batched)
+		{
+			entry->type = ft_define_symbol32(symbol, section_headers, elf->endian);
+			if (entry->type == 'U')
+				entry->value = 0;
+			(*count)++;
+		}
+		else
+			block[pending++] = *symbol;
+		if (pending == CLASSIFY_BLOCK)
+		{
+			classify_pending(elf, &classifier, block, pending, &symbols[*count]);
+			*count += pending;
+			pending = 0;
+		}
+		if (spill && pending == 0 && ft_spill_full(spill, symbols, *count))
+		{
+			if ((ret = ft_spill_chunk(spill, symbols, count)) != FTNM_OK)
+				break;
+			ft_input_release(elf->in);
+			if (elf->arena == NULL && elf->versions.strings)
+				ft_arena_reset(elf->versions.strings);
+		}
+	}
+	if (batched)
 	{
-		ft_printf("nm: %s: no symbols\n", filename);
-		return;
+		if (pending)
+			classify_pending(elf, &classifier, block, pending, &symbols[*count]);
+		*count += pending;
+		ft_classify_free(&classifier);
 	}
+	ft_strtab_free(&strtab);
+	if (spill && ret == FTNM_OK && (ret = ft_spill_finish(spill, &symbols, count)) == FTNM_OK
+		&& symbols == NULL)
+		ft_input_release(elf->in);
+	if (ret != FTNM_OK)
+	{
+		ft_arena_drop(elf->arena, symbols);
+		*count = 0;
+		return (ret);
+	}
+	*symbols_out = symbols;
+	return (FTNM_OK);
+}
+
+/**
+ * Reads an ELF32 file, identifies its symbol table, and processes it to
+ * retrieve the symbols it contains. Only the header, the section header table,
+ * the symbol table and the string tables are read from the input; the header
+ * table must hold whole Elf32_Shdr entries within the file, and the tables
+ * are validated before any symbol is read.
+ * @param	handle		The handle of the file: its input is read, and its
+ * 						symbols (allocated from the arena of the configuration
+ * 						if it has one), spill state, arena of versioned names
+ * 						and DWARF context for -l are used.
+ * @param	config		The table to read and the filters applied to its symbols.
+ * @return	FTNM_OK, or the FTNM_ERR_* code describing why the symbols cannot
+ * 			be read.
+ */
+int	ft_nm32(t_ftnm *handle, const t_ftnm_config *config)
+{
+	t_input		*in = &handle->in;
+	Elf32_Ehdr	*elf_header = (Elf32_Ehdr *) in->header;
+	Elf32_Shdr	*section_headers;
+	Elf32_Shdr	*symbol_table_header = NULL;
+	t_elf		elf;
+	int			ret;
+
+	if (elf_header->e_shoff > in->size)
+		return (FTNM_ERR_NO_SYMBOLS);
+	else if (elf_header->e_shnum && elf_header->e_shentsize != sizeof(Elf32_Shdr))
+		return (FTNM_ERR_CORRUPT);
+	else if ((uint64_t)elf_header->e_shnum * elf_header->e_shentsize > in->size - elf_header->e_shoff)
+		return (FTNM_ERR_TRUNCATED);
+
+	section_headers = ft_input_range(in, elf_header->e_shoff, elf_header->e_shnum * sizeof(Elf32_Shdr));
+	if (section_headers == NULL)
+		return (FTNM_ERR_CORRUPT);
 
 	for (long unsigned int i = 0; i < elf_header->e_shnum; ++i)
 	{
 		Elf32_Shdr	*section_header = &section_headers[i];
 
-		if (section_header->sh_type == SHT_SYMTAB)
+		if (section_header->sh_type == (config->dynamic ? SHT_DYNSYM : SHT_SYMTAB))
 			symbol_table_header = section_header;
 	}
 
 	if (symbol_table_header == NULL)
+		return (FTNM_ERR_NO_SYMBOLS);
+
+	elf.in = in;
+	elf.config = config;
+	elf.arena = config->max_memory ? NULL : config->arena;
+	elf.shdrs = section_headers;
+	elf.shnum = elf_header->e_shnum;
+	elf.endian = elf_header->e_ident[EI_DATA];
+	elf.shstrtab = NULL;
+	elf.shstrtab_size = 0;
+	if (elf_header->e_shstrndx < elf_header->e_shnum)
 	{
-		ft_printf("nm: %s: no symbols\n", filename);
-		return;
+		elf.shstrtab_size = section_headers[elf_header->e_shstrndx].sh_size;
+		elf.shstrtab = ft_input_range(in, section_headers[elf_header->e_shstrndx].sh_offset, elf.shstrtab_size);
 	}
 
-	t_symbol	*symbols = NULL;
-
-	if (symbol_table_header != NULL)
-		symbols = process_symbol_table(map, symbol_table_header, section_headers, o_sec, symbols);
-
-	ft_sort_symbols_by_name(symbols);
-	ft_print_symbols_list(symbols, 32, filename, multiple_files);
-	ft_free_symbols_list(symbols);
+	handle->symbols = NULL;
+	handle->count = 0;
+	if (validate_tables(&elf, symbol_table_header) != FTNM_OK)
+		return (FTNM_ERR_CORRUPT);
+	elf.dwarf = handle->dwarf;
+	if (elf.dwarf && ft_dwarf_init(elf.dwarf, &elf, 0, symbol_table_header - section_headers, elf.arena))
+		return (FTNM_ERR_MEMORY);
+	ft_bzero(&elf.versions, sizeof(t_versions));
+	if ((config->symbol_versions || config->newer_than)
+		&& ft_versions_init(&elf.versions, &elf, 0, symbol_table_header - section_headers,
+			elf.arena ? elf.arena : &handle->names))
+		return (FTNM_ERR_MEMORY);
+	if (config->summary)
+		ret = summarize_symbol_table(&elf);
+	else
+		ret = process_symbol_table(&elf, &handle->symbols, &handle->count, handle->spill);
+	ft_versions_free(&elf.versions);
+	return (ret);
 }
@@ -0,0 +1,436 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_options.c                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:04:31 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:25:46 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/**
+ * Prints the list of supported options.
+ */
+static void	print_usage(void)
+{
+	ft_printf("Usage: nm [option(s)] [file(s)]\n");
+	ft_printf(" List symbols in [file(s)] (a.out by default).\n");
+	ft_printf(" The options are:\n");
+	ft_printf("  -a, --debug-syms       Display debugger-only symbols\n");
+	ft_printf("  -g, --extern-only      Display only external symbols\n");
+	ft_printf("  -u, --undefined-only   Display only undefined symbols\n");
+	ft_printf("  -U, --defined-only     Display only defined symbols\n");
+	ft_printf("  -D, --dynamic          Display dynamic symbols instead of normal symbols\n");
+	ft_printf("  -l, --line-numbers     Use debugging information to find a filename and\n");
+	ft_printf("                         line number for each symbol\n");
+	ft_printf("      --with-symbol-versions  Display the version of versioned symbols\n");
+	ft_printf("                         (name@@VERSION, or name@VERSION if hidden or\n");
+	ft_printf("                         undefined)\n");
+	ft_printf("      --newer-than=VERSION  Display only symbols whose version is newer\n");
+	ft_printf("                         than VERSION, with the same prefix (as in\n");
+	ft_printf("                         GLIBC_2.17)\n");
+	ft_printf("      --diff OLD NEW     Report the symbols added, removed or changed\n");
+	ft_printf("                         (type, size, address) from OLD to NEW\n");
+	ft_printf("      --addr2sym=FILE    Map the hexadecimal addresses read from FILE (\"-\"\n");
+	ft_printf("                         for the standard input) to symbol+offset\n");
+	ft_printf("      --counts           With --addr2sym, count the addresses per symbol\n");
+	ft_printf("      --summary          Display counts per type, binding, visibility and\n");
+	ft_printf("                         section instead of the symbols\n");
+	ft_printf("      --max-memory=SIZE  Keep the symbols of a file within about SIZE\n");
+	ft_printf("                         bytes (K, M or G suffixes), dropping input\n");
+	ft_printf("                         pages as they are read and spilling sorted\n");
+	ft_printf("                         runs of bigger tables to $TMPDIR\n");
+	ft_printf("      --match=PATTERN    Display only symbols matching PATTERN: a glob\n");
+	ft_printf("                         (*, ?, [...]) matches the whole name, a plain\n");
+	ft_printf("                         string any part of it. May be repeated\n");
+	ft_printf("      --match-file=FILE  Read patterns from FILE, one per line\n");
+	ft_printf("      --serve=SOCKET     Answer list, find and filter requests on the Unix\n");
+	ft_printf("                         socket SOCKET, keeping parsed files in memory\n");
+	ft_printf("      --files-from=FILE  Read more input files from FILE (\"-\" for the\n");
+	ft_printf("                         standard input), one per line or NUL-separated\n");
+	ft_printf("      --dedup-content    List byte-identical copies of a file once, by a\n");
+	ft_printf("                         hash of their headers and symbol tables (files\n");
+	ft_printf("                         given twice through links always are)\n");
+	ft_printf("  @FILE                  Read options and files from FILE\n");
+	ft_printf("  -R DIR                 List the ELF files found under DIR, recursively\n");
+	ft_printf("      --collation=ORDER  Sort names in ORDER: `compat' (the default, as GNU\n");
+	ft_printf("                         nm in en_US.UTF-8), `c' (byte order) or `locale'\n");
+	ft_printf("                         (the LC_COLLATE locale)\n");
+	ft_printf("  -f, --format=FORMAT    Use the output format FORMAT. FORMAT can be `bsd',\n");
+	ft_printf("                         `json' or `ndjson'. The default is `bsd'\n");
+	ft_printf("  -o, --output=FILE      Write the listing to FILE instead of the standard\n");
+	ft_printf("                         output\n");
+	ft_printf("      --stats            Report page faults, I/O and system calls per file\n");
+	ft_printf("                         on stderr\n");
+	ft_printf("      --populate         Prefault mapped ranges (MAP_POPULATE) instead of\n");
+	ft_printf("                         asking for readahead\n");
+	ft_printf("      --io-uring         Open, stat and read small files in batches through\n");
+	ft_printf("                         io_uring, when the kernel allows it\n");
+}
+
+/**
+ * Sets the output format from its name.
+ * @param	opts	The options to fill.
+ * @param	name	The name of the format.
+ * @return	0 on success, 1 if the format is unknown.
+ */
+static int	set_format(t_options *opts, const char *name)
+{
+	if (ft_strncmp(name, "bsd", 4) == 0)
+		opts->format = FORMAT_BSD;
+	else if (ft_strncmp(name, "json", 5) == 0)
+		opts->format = FORMAT_JSON;
+	else if (ft_strncmp(name, "ndjson", 7) == 0)
+		opts->format = FORMAT_NDJSON;
+	else
+	{
+		ft_printf("nm: %s: Invalid output format\n", (char *)name);
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * Sets the name order of the sort from its name.
+ * @param	opts	The options to fill.
+ * @param	name	The name of the order.
+ * @return	0 on success, 1 if the order is unknown.
+ */
+static int	set_collation(t_options *opts, const char *name)
+{
+	if (ft_strncmp(name, "compat", 7) == 0)
+		opts->config.collation = FTNM_COLLATE_COMPAT;
+	else if (ft_strncmp(name, "c", 2) == 0)
+		opts->config.collation = FTNM_COLLATE_C;
+	else if (ft_strncmp(name, "locale", 7) == 0)
+		opts->config.collation = FTNM_COLLATE_LOCALE;
+	else
+	{
+		ft_printf("nm: %s: Invalid collation\n", (char *)name);
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * Sets the memory budget of the sort from a size: a number of bytes,
+ * optionally followed by K, M or G.
+ * @param	opts	The options to fill.
+ * @param	value	The size.
+ * @return	0 on success, 1 if the size is invalid.
+ */
+static int	set_max_memory(t_options *opts, const char *value)
+{
+	static const char	units[] = "KMG";
+	const char			*unit;
+	size_t				size = 0;
+	int					shift = 0;
+	int					i = 0;
+
+	while (ft_isdigit(value[i]) && size <= SIZE_MAX / 10)
+		size = size * 10 + (value[i++] - '0');
+	if (i > 0 && value[i] && (unit = ft_strchr(units, ft_toupper(value[i]))) != NULL)
+	{
+		shift = (unit - units + 1) * 10;
+		i++;
+	}
+	if (i == 0 || value[i] || size == 0 || size > (SIZE_MAX >> shift))
+	{
+		ft_printf("nm: %s: invalid memory size\n", (char *)value);
+		return (1);
+	}
+	opts->config.max_memory = size << shift;
+	return (0);
+}
+
+/**
+ * Handles a long option (starting with "--"). Options taking a value accept
+ * both "--opt=value" and "--opt value".
+ * @param	opts	The options to fill.
+ * @param	argv	The command line arguments.
+ * @param	i		Pointer to the index of the current argument, moved past
+ * 					a separate value if one is consumed.
+ * @return	0 on success, 1 on error.
+ */
+static int	parse_long_option(t_options *opts, char **argv, int *i)
+{
+	char	*arg = argv[*i] + 2;
+	char	*value = ft_strchr(arg, '=');
+	size_t	len = value ? (size_t)(value - arg) : ft_strlen(arg);
+
+	if (value)
+		value++;
+	if (len == 6 && ft_strncmp(arg, "format", 6) == 0)
+	{
+		if (!value && !(value = argv[++(*i)]))
+		{
+			ft_printf("nm: option '--format' requires an argument\n");
+			return (1);
+		}
+		return (set_format(opts, value));
+	}
+	if (len == 9 && ft_strncmp(arg, "collation", 9) == 0)
+	{
+		if (!value && !(value = argv[++(*i)]))
+		{
+			ft_printf("nm: option '--collation' requires an argument\n");
+			return (1);
+		}
+		return (set_collation(opts, value));
+	}
+	if (len == 6 && ft_strncmp(arg, "output", 6) == 0)
+	{
+		if (!value && !(value = argv[++(*i)]))
+		{
+			ft_printf("nm: option '--output' requires an argument\n");
+			return (1);
+		}
+		opts->output = value;
+		return (0);
+	}
+	if (len == 5 && ft_strncmp(arg, "serve", 5) == 0)
+	{
+		if (!value && !(value = argv[++(*i)]))
+		{
+			ft_printf("nm: option '--serve' requires an argument\n");
+			return (1);
+		}
+		opts->serve = value;
+		return (0);
+	}
+	if (len == 10 && ft_strncmp(arg, "max-memory", 10) == 0)
+	{
+		if (!value && !(value = argv[++(*i)]))
+		{
+			ft_printf("nm: option '--max-memory' requires an argument\n");
+			return (1);
+		}
+		return (set_max_memory(opts, value));
+	}
+	if (len == 8 && ft_strncmp(arg, "addr2sym", 8) == 0)
+	{
+		if (!value && !(value = argv[++(*i)]))
+		{
+			ft_printf("nm: option '--addr2sym' requires an argument\n");
+			return (1);
+		}
+		opts->addr2sym = value;
+		return (0);
+	}
+	if (len == 10 && ft_strncmp(arg, "newer-than", 10) == 0)
+	{
+		if (!value && !(value = argv[++(*i)]))
+		{
+			ft_printf("nm: option '--newer-than' requires an argument\n");
+			return (1);
+		}
+		opts->config.newer_than = value;
+		return (0);
+	}
+	if (len == 10 && ft_strncmp(arg, "files-from", 10) == 0)
+	{
+		if (!value && !(value = argv[++(*i)]))
+		{
+			ft_printf("nm: option '--files-from' requires an argument\n");
+			return (1);
+		}
+		opts->files_from[opts->nfiles_from++] = value;
+		return (0);
+	}
+	if ((len == 5 && ft_strncmp(arg, "match", 5) == 0)
+		|| (len == 10 && ft_strncmp(arg, "match-file", 10) == 0))
+	{
+		if (!value && !(value = argv[++(*i)]))
+		{
+			ft_printf("nm: option '--%s' requires an argument\n", (len == 5) ? "match" : "match-file");
+			return (1);
+		}
+		if (len == 5)
+			opts->patterns[opts->npatterns++] = value;
+		else
+			opts->pattern_files[opts->npattern_files++] = value;
+		return (0);
+	}
+	if (len == 10 && ft_strncmp(arg, "debug-syms", 10) == 0 && !value)
+		opts->config.debug_syms = 1;
+	else if (len == 11 && ft_strncmp(arg, "extern-only", 11) == 0 && !value)
+		opts->config.filter |= FTNM_FILTER_EXTERNAL;
+	else if (len == 14 && ft_strncmp(arg, "undefined-only", 14) == 0 && !value)
+		opts->config.filter |= FTNM_FILTER_UNDEFINED;
+	else if (len == 12 && ft_strncmp(arg, "defined-only", 12) == 0 && !value)
+		opts->config.filter |= FTNM_FILTER_DEFINED;
+	else if (len == 5 && ft_strncmp(arg, "stats", 5) == 0 && !value)
+		opts->stats = 1;
+	else if (len == 8 && ft_strncmp(arg, "populate", 8) == 0 && !value)
+		opts->config.populate = 1;
+	else if (len == 8 && ft_strncmp(arg, "io-uring", 8) == 0 && !value)
+		opts->uring = 1;
+	else if (len == 7 && ft_strncmp(arg, "dynamic", 7) == 0 && !value)
+		opts->config.dynamic = 1;
+	else if (len == 12 && ft_strncmp(arg, "line-numbers", 12) == 0 && !value)
+		opts->config.line_numbers = 1;
+	else if (len == 20 && ft_strncmp(arg, "with-symbol-versions", 20) == 0 && !value)
+		opts->config.symbol_versions = 1;
+	else if (len == 4 && ft_strncmp(arg, "diff", 4) == 0 && !value)
+		opts->diff = 1;
+	else if (len == 7 && ft_strncmp(arg, "summary", 7) == 0 && !value)
+		opts->summary = 1;
+	else if (len == 6 && ft_strncmp(arg, "counts", 6) == 0 && !value)
+		opts->counts = 1;
+	else if (len == 13 && ft_strncmp(arg, "dedup-content", 13) == 0 && !value)
+		opts->dedup_content = 1;
+	else if (len == 4 && ft_strncmp(arg, "help", 4) == 0)
+	{
+		print_usage();
+		exit(0);
+	}
+	else
+	{
+		ft_printf("nm: unrecognized option '%s'\n", argv[*i]);
+		print_usage();
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * Handles a cluster of short options (like "-gu" or "-f json").
+ * @param	opts	The options to fill.
+ * @param	argv	The command line arguments.
+ * @param	i		Pointer to the index of the current argument.
+ * @return	0 on success, 1 on error.
+ */
+static int	parse_short_options(t_options *opts, char **argv, int *i)
+{
+	char	*arg = argv[*i];
+
+	for (int j = 1; arg[j]; j++)
+	{
+		if (arg[j] == 'f' || arg[j] == 'R' || arg[j] == 'o')
+		{
+			char	*value = arg[j + 1] ? &arg[j + 1] : argv[++(*i)];
+
+			if (!value)
+			{
+				ft_printf("nm: option requires an argument -- '%c'\n", arg[j]);
+				return (1);
+			}
+			if (arg[j] == 'R')
+			{
+				opts->dirs[opts->ndirs++] = value;
+				return (0);
+			}
+			if (arg[j] == 'o')
+			{
+				opts->output = value;
+				return (0);
+			}
+			return (set_format(opts, value));
+		}
+		else if (arg[j] == 'a')
+		{
+			opts->config.debug_syms = 1;
+			continue;
+		}
+		else if (arg[j] == 'D')
+		{
+			opts->config.dynamic = 1;
+			continue;
+		}
+		else if (arg[j] == 'l')
+		{
+			opts->config.line_numbers = 1;
+			continue;
+		}
+		else if (arg[j] == 'g' || arg[j] == 'u' || arg[j] == 'U')
+		{
+			opts->config.filter |= (arg[j] == 'g') ? FTNM_FILTER_EXTERNAL
+				: (arg[j] == 'u') ? FTNM_FILTER_UNDEFINED : FTNM_FILTER_DEFINED;
+			continue;
+		}
+		else if (arg[j] == 'h')
+		{
+			print_usage();
+			exit(0);
+		}
+		ft_printf("nm: invalid option -- '%c'\n", arg[j]);
+		print_usage();
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * Parses the command line. Options may appear anywhere; every other argument
+ * is an input file, "--" ending the options. The directories given with -R,
+ * the --match patterns and files and the --files-from lists are collected in
+ * opts, which the caller frees with ft_free_options.
+ * @param	argc	The number of command line arguments.
+ * @param	argv	The array of command line arguments.
+ * @param	opts	The options to fill.
+ * @param	files	Set to a malloc'ed, NULL-terminated array of the files.
+ * @return	The number of input files, or -1 on error.
+ */
+int	ft_parse_options(int argc, char **argv, t_options *opts, char ***files)
+{
+	int	count = 0;
+	int	only_files = 0;
+
+	ft_bzero(opts, sizeof(t_options));
+	*files = malloc(sizeof(char *) * argc);
+	opts->dirs = malloc(sizeof(char *) * argc);
+	opts->patterns = malloc(sizeof(char *) * argc);
+	opts->pattern_files = malloc(sizeof(char *) * argc);
+	opts->files_from = malloc(sizeof(char *) * argc);
+	if (*files == NULL || opts->dirs == NULL || opts->patterns == NULL || opts->pattern_files == NULL
+		|| opts->files_from == NULL)
+	{
+		free(*files);
+		*files = NULL;
+		ft_free_options(opts);
+		return (-1);
+	}
+
+	for (int i = 1; i < argc; i++)
+	{
+		int	ret = 0;
+
+		if (only_files || argv[i][0] != '-' || argv[i][1] == '\0')
+			(*files)[count++] = argv[i];
+		else if (ft_strncmp(argv[i], "--", 3) == 0)
+			only_files = 1;
+		else if (argv[i][1] == '-')
+			ret = parse_long_option(opts, argv, &i);
+		else
+			ret = parse_short_options(opts, argv, &i);
+		if (ret)
+		{
+			free(*files);
+			*files = NULL;
+			ft_free_options(opts);
+			return (-1);
+		}
+	}
+	(*files)[count] = NULL;
+	return (count);
+}
+
+/**
+ * Frees the lists collected by ft_parse_options.
+ * @param	opts	The options.
+ */
+void	ft_free_options(t_options *opts)
+{
+	free(opts->dirs);
+	free(opts->patterns);
+	free(opts->pattern_files);
+	free(opts->files_from);
+	opts->dirs = NULL;
+	opts->patterns = NULL;
+	opts->pattern_files = NULL;
+	opts->files_from = NULL;
+}
@@ -0,0 +1,125 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_prefetch.c                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:30:30 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 17:36:32 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#define _GNU_SOURCE
+#include "includes/nm.h"
+
+/**
+ * Opens the files of the window that are not open yet and asks the kernel to
+ * start reading them: whole files when they will be read whole, only the
+ * head and the tail (ELF header, section headers) of larger ones, which are
+ * mapped and faulted in on demand.
+ * @param	pf	The prefetcher.
+ */
+static void	open_ahead(t_prefetch *pf)
+{
+	while (pf->opened < pf->count && pf->opened < pf->taken + PREFETCH_DEPTH)
+	{
+		t_fetched	*file = &pf->files[pf->opened % PREFETCH_DEPTH];
+		const char	*path = pf->paths[pf->opened++];
+		struct stat	st;
+
+		ft_bzero(file, sizeof(t_fetched));
+		if (ft_strncmp(path, "-", 2) == 0)
+		{
+			file->fd = STDIN_FILENO;
+			continue;
+		}
+		file->fd = open(path, O_RDONLY | O_CLOEXEC);
+		file->syscalls = 2;
+		if (file->fd < 0)
+		{
+			file->err = errno;
+			file->syscalls = 1;
+			continue;
+		}
+		if (fstat(file->fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+			continue;
+		file->syscalls++;
+		if ((size_t)st.st_size <= INPUT_WHOLE_MAX)
+			readahead(file->fd, 0, st.st_size);
+		else
+		{
+			readahead(file->fd, 0, PREFETCH_EDGE);
+			readahead(file->fd, st.st_size - PREFETCH_EDGE, PREFETCH_EDGE);
+			file->syscalls++;
+		}
+	}
+}
+
+/**
+ * Starts prefetching a list of input files. With uring set, the files are
+ * opened, measured and, when small, read in batches through io_uring; the
+ * descriptors are then opened one window ahead with plain system calls if
+ * io_uring is not available.
+ * @param	pf		The prefetcher to initialize.
+ * @param	paths	The paths of the files, "-" standing for the standard
+ * 					input; borrowed until ft_prefetch_close.
+ * @param	count	The number of paths.
+ * @param	uring	Whether to try the io_uring backend.
+ */
+void	ft_prefetch_init(t_prefetch *pf, char **paths, size_t count, int uring)
+{
+	ft_bzero(pf, sizeof(t_prefetch));
+	pf->paths = paths;
+	pf->count = count;
+	if (uring)
+		pf->ring = ft_uring_init(&pf->syscalls);
+	if (pf->ring == NULL)
+		open_ahead(pf);
+}
+
+/**
+ * Takes the next file of the list, and opens the files that enter the window.
+ * The file comes either as the contents read ahead (data set, fd -1) or as a
+ * descriptor, -1 with err set if it could not be opened. The caller closes
+ * the descriptor unless it is the standard input; the contents stay valid
+ * until the next call.
+ * @param	pf		The prefetcher.
+ * @return	The file, or NULL past the end of the list.
+ */
+const t_fetched	*ft_prefetch_take(t_prefetch *pf)
+{
+	if (pf->taken >= pf->count)
+		return (NULL);
+	if (pf->ring && pf->taken == pf->opened && ft_uring_fetch(pf))
+	{
+		ft_uring_free(pf);
+		open_ahead(pf);
+	}
+	pf->current = pf->files[pf->taken % (pf->ring ? PREFETCH_BATCH : PREFETCH_DEPTH)];
+	pf->taken++;
+	if (!pf->ring)
+		open_ahead(pf);
+	return (&pf->current);
+}
+
+/**
+ * Closes the descriptors of the files opened ahead but never taken, and
+ * releases the buffers and the ring.
+ * @param	pf	The prefetcher.
+ */
+void	ft_prefetch_close(t_prefetch *pf)
+{
+	while (pf->taken < pf->opened)
+	{
+		t_fetched	*file = &pf->files[pf->taken++ % (pf->ring ? PREFETCH_BATCH : PREFETCH_DEPTH)];
+
+		if (file->fd > STDIN_FILENO)
+			close(file->fd);
+	}
+	if (pf->ring)
+		ft_uring_free(pf);
+	for (size_t i = 0; i < PREFETCH_BATCH; i++)
+		free(pf->bufs[i]);
+	ft_bzero(pf->bufs, sizeof(pf->bufs));
+}
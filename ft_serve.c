@@ -0,0 +1,806 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_serve.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:27:00 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:49:04 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#define _GNU_SOURCE
+#include "includes/nm.h"
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static const char	*g_socket_path;
+
+typedef struct s_request
+{
+	char				*fields[3];
+	size_t				lens[3];
+	size_t				nfields;
+	char				**patterns;
+	size_t				npatterns;
+}	t_request;
+
+/**
+ * Hashes a path for the cache (FNV-1a).
+ * @param	path	The path.
+ * @return	The bucket of the path.
+ */
+static size_t	path_bucket(const char *path)
+{
+	uint64_t	hash = 0xcbf29ce484222325ULL;
+
+	while (*path)
+		hash = (hash ^ (unsigned char)*path++) * 0x100000001b3ULL;
+	return (hash % SERVE_BUCKETS);
+}
+
+/**
+ * Orders two symbols by their raw names, for the lookup index of find.
+ * @param	a	Pointer to the first symbol pointer.
+ * @param	b	Pointer to the second symbol pointer.
+ * @return	The byte order of the names, shorter first on a common prefix.
+ */
+static int	name_cmp(const void *a, const void *b)
+{
+	const t_symbol	*s1 = *(const t_symbol * const *)a;
+	const t_symbol	*s2 = *(const t_symbol * const *)b;
+	size_t			n = (s1->name_len < s2->name_len) ? s1->name_len : s2->name_len;
+	int				ret = ft_memcmp(s1->name, s2->name, n);
+
+	if (ret == 0 && s1->name_len != s2->name_len)
+		ret = (s1->name_len < s2->name_len) ? -1 : 1;
+	return (ret);
+}
+
+/**
+ * Drops a reference to a cache entry, freeing it with the last one. Called
+ * with the lock of the server held.
+ * @param	entry	The entry.
+ */
+static void	entry_unref(t_cache_entry *entry)
+{
+	if (--entry->refs > 0)
+		return;
+	ftnm_close(entry->handle);
+	free(entry->by_name);
+	free(entry->path);
+	free(entry);
+}
+
+/**
+ * Parses and sorts a file for the cache, and indexes its symbols by name.
+ * @param	server	The server.
+ * @param	path	The path of the file.
+ * @param	st		The identity of the file when it was looked up.
+ * @param	entry	Set to the new entry, holding one reference.
+ * @return	FTNM_OK or an FTNM_ERR_* code.
+ */
+static int	entry_load(t_server *server, const char *path, struct stat *st, t_cache_entry **entry)
+{
+	t_cache_entry	*e = ft_calloc(1, sizeof(t_cache_entry));
+	int				ret;
+
+	if (e == NULL || (e->path = ft_strdup(path)) == NULL)
+	{
+		free(e);
+		return (FTNM_ERR_MEMORY);
+	}
+	ret = ftnm_open_path(&e->handle, path, &server->config);
+	if (ret == FTNM_OK)
+		ret = ftnm_sort(e->handle);
+	if (ret == FTNM_OK)
+	{
+		e->by_name = malloc(sizeof(t_symbol *) * (e->handle->count + 1));
+		if (e->by_name == NULL)
+			ret = FTNM_ERR_MEMORY;
+	}
+	if (ret != FTNM_OK)
+	{
+		e->refs = 1;
+		entry_unref(e);
+		return (ret);
+	}
+	for (size_t i = 0; i < e->handle->count; i++)
+		e->by_name[i] = &e->handle->symbols[i];
+	qsort(e->by_name, e->handle->count, sizeof(t_symbol *), name_cmp);
+	e->dev = st->st_dev;
+	e->ino = st->st_ino;
+	e->mtime = st->st_mtim;
+	e->size = st->st_size;
+	e->refs = 1;
+	*entry = e;
+	return (FTNM_OK);
+}
+
+/**
+ * Tells if a cache entry still describes a file.
+ * @param	entry	The entry.
+ * @param	st		The current identity of the file.
+ * @return	1 if the inode, size and modification time are unchanged.
+ */
+static int	entry_fresh(t_cache_entry *entry, struct stat *st)
+{
+	return (entry->dev == st->st_dev && entry->ino == st->st_ino
+		&& entry->size == st->st_size
+		&& entry->mtime.tv_sec == st->st_mtim.tv_sec
+		&& entry->mtime.tv_nsec == st->st_mtim.tv_nsec);
+}
+
+/**
+ * Takes an entry out of the recency list of the cache. Called with the lock
+ * of the server held.
+ * @param	server	The server.
+ * @param	entry	The entry.
+ */
+static void	lru_unlink(t_server *server, t_cache_entry *entry)
+{
+	if (entry->newer)
+		entry->newer->older = entry->older;
+	else
+		server->newest = entry->older;
+	if (entry->older)
+		entry->older->newer = entry->newer;
+	else
+		server->oldest = entry->newer;
+	entry->newer = NULL;
+	entry->older = NULL;
+}
+
+/**
+ * Puts an entry at the head of the recency list of the cache. Called with
+ * the lock of the server held.
+ * @param	server	The server.
+ * @param	entry	The entry, not in the list.
+ */
+static void	lru_push(t_server *server, t_cache_entry *entry)
+{
+	entry->older = server->newest;
+	if (server->newest)
+		server->newest->newer = entry;
+	else
+		server->oldest = entry;
+	server->newest = entry;
+}
+
+/**
+ * Removes an entry from the cache and drops the reference of the cache on
+ * it; workers still answering from it keep it alive until they are done.
+ * Called with the lock of the server held.
+ * @param	server	The server.
+ * @param	entry	The entry.
+ */
+static void	cache_remove(t_server *server, t_cache_entry *entry)
+{
+	t_cache_entry	**link = &server->buckets[path_bucket(entry->path)];
+
+	while (*link != entry)
+		link = &(*link)->next;
+	*link = entry->next;
+	lru_unlink(server, entry);
+	server->cached--;
+	entry_unref(entry);
+}
+
+/**
+ * Finds the entry of a path in the cache. Called with the lock of the server
+ * held.
+ * @param	server	The server.
+ * @param	path	The path of the file.
+ * @return	The entry, or NULL if the path is not cached.
+ */
+static t_cache_entry	*cache_find(t_server *server, const char *path)
+{
+	for (t_cache_entry *e = server->buckets[path_bucket(path)]; e; e = e->next)
+	{
+		if (ft_strncmp(e->path, path, (size_t)-1) == 0)
+			return (e);
+	}
+	return (NULL);
+}
+
+/**
+ * Finds the parsed and sorted symbols of a file in the cache, parsing the
+ * file again if it is missing or its inode or modification time changed.
+ * Parsing happens outside the lock, so workers only wait on each other for
+ * the table lookups. If another worker cached the file meanwhile and its
+ * entry still matches the file, that entry is kept and the new parse
+ * dropped. The cache keeps at most SERVE_CACHE_MAX files, dropping the
+ * least recently asked for first.
+ * @param	server	The server.
+ * @param	path	The path of the file.
+ * @param	entry	Set to the entry, holding a reference for the caller.
+ * @return	FTNM_OK or an FTNM_ERR_* code.
+ */
+static int	cache_get(t_server *server, const char *path, t_cache_entry **entry)
+{
+	size_t			bucket = path_bucket(path);
+	t_cache_entry	*fresh = NULL;
+	t_cache_entry	*e;
+	struct stat		st;
+	int				ret;
+
+	if (stat(path, &st) < 0)
+		return ((errno == ENOENT) ? FTNM_ERR_NOENT : FTNM_ERR_STAT);
+	pthread_mutex_lock(&server->lock);
+	e = cache_find(server, path);
+	if (e == NULL || !entry_fresh(e, &st))
+	{
+		pthread_mutex_unlock(&server->lock);
+		ret = entry_load(server, path, &st, &fresh);
+		if (ret != FTNM_OK)
+			return (ret);
+		if (stat(path, &st) < 0)
+			ft_bzero(&st, sizeof(st));
+		pthread_mutex_lock(&server->lock);
+		e = cache_find(server, path);
+		if (e && !entry_fresh(e, &st))
+		{
+			cache_remove(server, e);
+			e = NULL;
+		}
+		if (e == NULL)
+		{
+			e = fresh;
+			fresh = NULL;
+			e->next = server->buckets[bucket];
+			server->buckets[bucket] = e;
+			lru_push(server, e);
+			if (++server->cached > SERVE_CACHE_MAX)
+				cache_remove(server, server->oldest);
+		}
+	}
+	lru_unlink(server, e);
+	lru_push(server, e);
+	e->refs++;
+	*entry = e;
+	pthread_mutex_unlock(&server->lock);
+	if (fresh)
+		entry_unref(fresh);
+	return (FTNM_OK);
+}
+
+/**
+ * Releases the reference of a worker on a cache entry.
+ * @param	server	The server.
+ * @param	entry	The entry.
+ */
+static void	cache_put(t_server *server, t_cache_entry *entry)
+{
+	pthread_mutex_lock(&server->lock);
+	entry_unref(entry);
+	pthread_mutex_unlock(&server->lock);
+}
+
+/**
+ * Tells if a cached symbol passes the -u, -g and -U filters, from its type
+ * letter (the symbol table entry is not kept once parsed).
+ * @param	symbol	The symbol.
+ * @param	filter	The FTNM_FILTER_* flags.
+ * @return	1 if the symbol is kept.
+ */
+static int	keep_cached(const t_symbol *symbol, int filter)
+{
+	int	undefined = (symbol->type == 'U' || symbol->type == 'w' || symbol->type == 'v');
+	int	external = (symbol->type >= 'A' && symbol->type <= 'Z')
+		|| symbol->type == 'u' || symbol->type == 'v' || symbol->type == 'w';
+
+	if ((filter & FTNM_FILTER_UNDEFINED) && !undefined)
+		return (0);
+	if ((filter & FTNM_FILTER_DEFINED) && undefined)
+		return (0);
+	if ((filter & FTNM_FILTER_EXTERNAL) && !external)
+		return (0);
+	return (1);
+}
+
+/**
+ * Builds the symbols answered by a request, as a view sharing the class of
+ * the cached handle:
+ *  list	every symbol;
+ *  find	the symbols named exactly like the argument, by binary search;
+ *  filter	the symbols passing the flags ("u", "g", "U", "-" for none) and
+ * 			matching one of the patterns, if any.
+ * @param	entry	The cache entry of the file.
+ * @param	req		The request.
+ * @param	view	Filled with the symbols to print; its array is malloc'ed.
+ * @return	FTNM_OK, FTNM_ERR_PATTERN or FTNM_ERR_MEMORY.
+ */
+static int	select_symbols(t_cache_entry *entry, t_request *req, t_ftnm *view)
+{
+	const t_ftnm	*handle = entry->handle;
+	t_matcher		matcher;
+	int				filter = 0;
+	int				ret = FTNM_OK;
+
+	ft_bzero(view, sizeof(t_ftnm));
+	view->bits = handle->bits;
+	view->symbols = malloc(sizeof(t_symbol) * (handle->count + 1));
+	if (view->symbols == NULL)
+		return (FTNM_ERR_MEMORY);
+	if (ft_strncmp(req->fields[0], "find", 5) == 0)
+	{
+		t_symbol	key;
+		const t_symbol	*pkey = &key;
+		size_t		lo = 0;
+		size_t		hi = handle->count;
+
+		key.name = req->fields[2];
+		key.name_len = req->lens[2];
+		while (lo < hi)
+		{
+			size_t	mid = lo + (hi - lo) / 2;
+
+			if (name_cmp(&entry->by_name[mid], &pkey) < 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		while (lo < handle->count && name_cmp(&entry->by_name[lo], &pkey) == 0)
+			view->symbols[view->count++] = *entry->by_name[lo++];
+		return (FTNM_OK);
+	}
+	if (ft_strncmp(req->fields[0], "list", 5) == 0)
+	{
+		ft_memcpy(view->symbols, handle->symbols, sizeof(t_symbol) * handle->count);
+		view->count = handle->count;
+		return (FTNM_OK);
+	}
+	for (const char *f = req->fields[2]; *f; f++)
+		filter |= (*f == 'u') ? FTNM_FILTER_UNDEFINED
+			: (*f == 'U') ? FTNM_FILTER_DEFINED : (*f == 'g') ? FTNM_FILTER_EXTERNAL : 0;
+	ft_bzero(&matcher, sizeof(matcher));
+	for (size_t i = 0; ret == FTNM_OK && i < req->npatterns; i++)
+		ret = ft_matcher_add(&matcher, req->patterns[i], ft_strlen(req->patterns[i]));
+	if (ret == FTNM_OK)
+		ret = ft_matcher_finish(&matcher);
+	for (size_t i = 0; ret == FTNM_OK && i < handle->count; i++)
+	{
+		const t_symbol	*symbol = &handle->symbols[i];
+
+		if (keep_cached(symbol, filter)
+			&& (!matcher.active || ft_match_name(&matcher, symbol->name, symbol->name_len)))
+			view->symbols[view->count++] = *symbol;
+	}
+	ft_matcher_free(&matcher);
+	return (ret);
+}
+
+/**
+ * Splits a request payload into its newline-separated fields: the command,
+ * the path, then the argument of find or the flags and patterns of filter.
+ * The payload is modified in place; the array of patterns is malloc'ed.
+ * @param	payload	The payload, NUL-terminated.
+ * @param	req		The request to fill.
+ * @return	0 if the request is well formed, 1 otherwise.
+ */
+static int	parse_request(char *payload, t_request *req)
+{
+	char	*line = payload;
+	char	*end;
+	size_t	nlines = 1;
+
+	ft_bzero(req, sizeof(t_request));
+	for (char *c = payload; *c; c++)
+		nlines += (*c == '\n');
+	req->patterns = malloc(sizeof(char *) * nlines);
+	if (req->patterns == NULL)
+		return (1);
+	while (line)
+	{
+		end = ft_strchr(line, '\n');
+		if (end)
+			*end++ = '\0';
+		if (req->nfields < 3)
+		{
+			req->fields[req->nfields] = line;
+			req->lens[req->nfields++] = ft_strlen(line);
+		}
+		else if (*line)
+			req->patterns[req->npatterns++] = line;
+		line = end;
+	}
+	if (req->nfields < 2 || req->lens[1] == 0)
+		return (1);
+	if (ft_strncmp(req->fields[0], "list", 5) == 0)
+		return (0);
+	if (ft_strncmp(req->fields[0], "find", 5) == 0)
+		return (req->nfields < 3);
+	if (ft_strncmp(req->fields[0], "filter", 7) == 0)
+	{
+		if (req->nfields < 3)
+			req->fields[2] = "-";
+		return (0);
+	}
+	return (1);
+}
+
+/**
+ * Answers one request into the memory writer of the worker: "ok\n" followed
+ * by the listing in the output format of the server, or "error: ...\n".
+ * @param	server	The server.
+ * @param	ctx		The context of the worker (options and memory writer).
+ * @param	payload	The payload of the request, NUL-terminated.
+ */
+static void	answer(t_server *server, t_nm *ctx, char *payload)
+{
+	t_request		req;
+	t_cache_entry	*entry;
+	t_ftnm			view;
+	int				ret;
+
+	if (parse_request(payload, &req))
+	{
+		free(req.patterns);
+		ft_writer_putstr(&ctx->out, "error: bad request\n");
+		return;
+	}
+	ret = cache_get(server, req.fields[1], &entry);
+	if (ret == FTNM_OK)
+	{
+		ret = select_symbols(entry, &req, &view);
+		if (ret == FTNM_OK)
+		{
+			ft_writer_put(&ctx->out, "ok\n", 3);
+			ft_json_begin(ctx);
+			ft_print_symbols_list(&view, req.fields[1], ctx);
+			ft_json_end(ctx);
+		}
+		free(view.symbols);
+		cache_put(server, entry);
+	}
+	free(req.patterns);
+	if (ret != FTNM_OK)
+	{
+		ft_writer_put(&ctx->out, "error: ", 7);
+		ft_writer_putstr(&ctx->out, ftnm_strerror(ret));
+		ft_writer_putc(&ctx->out, '\n');
+	}
+}
+
+/**
+ * Reads exactly size bytes from a socket.
+ * @param	fd		The socket.
+ * @param	buf		The destination.
+ * @param	size	The number of bytes to read.
+ * @return	0 on success, 1 on error or end of stream.
+ */
+static int	read_full(int fd, void *buf, size_t size)
+{
+	size_t	done = 0;
+	ssize_t	ret;
+
+	while (done < size)
+	{
+		ret = read(fd, (char *)buf + done, size - done);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return (1);
+		done += ret;
+	}
+	return (0);
+}
+
+/**
+ * Writes exactly size bytes to a socket.
+ * @param	fd		The socket.
+ * @param	buf		The bytes to write.
+ * @param	size	The number of bytes to write.
+ * @return	0 on success, 1 on error.
+ */
+static int	write_full(int fd, const void *buf, size_t size)
+{
+	size_t	done = 0;
+	ssize_t	ret;
+
+	while (done < size)
+	{
+		ret = send(fd, (const char *)buf + done, size - done, MSG_NOSIGNAL);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return (1);
+		done += ret;
+	}
+	return (0);
+}
+
+/**
+ * Serves one request of a connection. Every frame, in both directions, is a
+ * 4-byte big-endian length followed by the payload. A client stalling in the
+ * middle of a frame for SERVE_IO_TIMEOUT seconds is dropped.
+ * @param	server	The server.
+ * @param	ctx		The context of the worker.
+ * @param	fd		The connection, with a request to read.
+ * @return	0 if the connection stays open, 1 if it is to be closed.
+ */
+static int	serve_request(t_server *server, t_nm *ctx, int fd)
+{
+	unsigned char	header[4];
+	uint32_t		len;
+	char			*payload;
+
+	if (read_full(fd, header, 4))
+		return (1);
+	len = ((uint32_t)header[0] << 24) | ((uint32_t)header[1] << 16)
+		| ((uint32_t)header[2] << 8) | header[3];
+	if (len > SERVE_MAX_REQUEST || (payload = malloc(len + 1)) == NULL)
+		return (1);
+	if (read_full(fd, payload, len))
+	{
+		free(payload);
+		return (1);
+	}
+	payload[len] = '\0';
+	ctx->out.mem_len = 0;
+	answer(server, ctx, payload);
+	free(payload);
+	ft_writer_flush(&ctx->out);
+	header[0] = ctx->out.mem_len >> 24;
+	header[1] = ctx->out.mem_len >> 16;
+	header[2] = ctx->out.mem_len >> 8;
+	header[3] = ctx->out.mem_len;
+	return (write_full(fd, header, 4) || write_full(fd, ctx->out.mem, ctx->out.mem_len));
+}
+
+/**
+ * Worker loop: takes the connections the dispatcher found readable off the
+ * ready queue, answers one request of each, then hands the connection back
+ * to the dispatcher through its wake pipe (-1 for a connection closed), so
+ * that idle clients hold no worker. Answers are formatted into the memory
+ * writer of the worker. The loop ends when the server stops.
+ * @param	arg	The server.
+ * @return	NULL.
+ */
+static void	*serve_worker(void *arg)
+{
+	t_server	*server = arg;
+	t_nm		*ctx = ft_calloc(1, sizeof(t_nm));
+	int			fd;
+
+	if (ctx == NULL)
+		return (NULL);
+	ctx->opts = server->opts;
+	ctx->opts.multiple_files = 0;
+	ft_writer_init_memory(&ctx->out);
+	while (1)
+	{
+		pthread_mutex_lock(&server->queue_lock);
+		while (server->queued == 0 && !server->stopping)
+			pthread_cond_wait(&server->queue_ready, &server->queue_lock);
+		if (server->stopping)
+		{
+			pthread_mutex_unlock(&server->queue_lock);
+			break;
+		}
+		fd = server->queue[server->queue_head];
+		server->queue_head = (server->queue_head + 1) % SERVE_MAX_CLIENTS;
+		server->queued--;
+		pthread_mutex_unlock(&server->queue_lock);
+		if (serve_request(server, ctx, fd))
+		{
+			close(fd);
+			fd = -1;
+		}
+		while (write(server->wake[1], &fd, sizeof(fd)) < 0 && errno == EINTR)
+			;
+	}
+	ft_writer_free_memory(&ctx->out);
+	free(ctx);
+	return (NULL);
+}
+
+/**
+ * Puts a readable connection on the ready queue and wakes a worker. The
+ * queue holds SERVE_MAX_CLIENTS connections, as many as can be open.
+ * @param	server	The server.
+ * @param	fd		The connection.
+ */
+static void	queue_push(t_server *server, int fd)
+{
+	pthread_mutex_lock(&server->queue_lock);
+	server->queue[(server->queue_head + server->queued) % SERVE_MAX_CLIENTS] = fd;
+	server->queued++;
+	pthread_cond_signal(&server->queue_ready);
+	pthread_mutex_unlock(&server->queue_lock);
+}
+
+/**
+ * Accepts a connection, refusing it past SERVE_MAX_CLIENTS open ones, with
+ * send and receive timeouts of SERVE_IO_TIMEOUT seconds.
+ * @param	server	The server.
+ * @param	open	The number of open connections, updated.
+ * @return	The connection, or -1.
+ */
+static int	accept_client(t_server *server, size_t *open)
+{
+	struct timeval	timeout = {SERVE_IO_TIMEOUT, 0};
+	int				fd = accept4(server->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+
+	if (fd < 0)
+		return (-1);
+	if (*open >= SERVE_MAX_CLIENTS)
+	{
+		close(fd);
+		return (-1);
+	}
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+	(*open)++;
+	return (fd);
+}
+
+/**
+ * Dispatcher loop: polls the listening socket, the wake pipe and the idle
+ * connections. New connections join the idle set; an idle connection with
+ * a request (or a hang-up) waiting leaves it for the ready queue, and comes
+ * back through the wake pipe once a worker has answered.
+ * @param	server	The server.
+ * @return	1 if polling fails.
+ */
+static int	dispatch(t_server *server)
+{
+	static struct pollfd	fds[SERVE_MAX_CLIENTS + 2];
+	size_t					nidle = 0;
+	size_t					open = 0;
+	int						back[64];
+	ssize_t					n;
+	int						fd;
+
+	fds[0] = (struct pollfd){server->wake[0], POLLIN, 0};
+	fds[1] = (struct pollfd){server->listen_fd, POLLIN, 0};
+	while (1)
+	{
+		if (poll(fds, nidle + 2, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return (1);
+		}
+		for (size_t i = 2; i < nidle + 2; i++)
+		{
+			if (fds[i].revents == 0)
+				continue;
+			queue_push(server, fds[i].fd);
+			fds[i--] = fds[--nidle + 2];
+		}
+		if (fds[0].revents & POLLIN)
+		{
+			n = read(server->wake[0], back, sizeof(back));
+			for (ssize_t i = 0; i < n / (ssize_t)sizeof(int); i++)
+			{
+				if (back[i] < 0)
+					open--;
+				else
+					fds[2 + nidle++] = (struct pollfd){back[i], POLLIN, 0};
+			}
+		}
+		if ((fds[1].revents & POLLIN) && (fd = accept_client(server, &open)) >= 0)
+			fds[2 + nidle++] = (struct pollfd){fd, POLLIN, 0};
+	}
+}
+
+/**
+ * Removes the socket file when the daemon is told to stop.
+ * @param	sig	The signal.
+ */
+static void	stop_server(int sig)
+{
+	(void)sig;
+	unlink(g_socket_path);
+	_exit(0);
+}
+
+/**
+ * Tells if a daemon is still listening on a socket file, by connecting to
+ * it. A socket nobody listens on any more refuses the connection.
+ * @param	addr	The address of the socket.
+ * @return	1 if the connection is accepted, 0 otherwise.
+ */
+static int	socket_in_use(const struct sockaddr_un *addr)
+{
+	int	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	int	ret;
+
+	if (fd < 0)
+		return (0);
+	ret = connect(fd, (const struct sockaddr *)addr, sizeof(*addr));
+	close(fd);
+	return (ret == 0 || errno != ECONNREFUSED);
+}
+
+/**
+ * Runs the query daemon: listens on a Unix socket and answers list, find and
+ * filter requests from SERVE_WORKERS threads, handed one request at a time
+ * by the dispatcher polling the connections. Parsed and sorted symbol tables
+ * are kept in memory, keyed by path and checked against the inode, size and
+ * modification time of the file on every request. A stale socket file left
+ * at the path, one that refuses connections, is replaced; a socket another
+ * daemon still listens on is left alone. The socket is removed on SIGINT or
+ * SIGTERM.
+ * @param	path	The path of the socket.
+ * @param	opts	The options of the run (output format, -a, -D,
+ * 					--with-symbol-versions, -l, --collation).
+ * @return	1 if the socket or the workers cannot be set up, or if polling
+ * 			fails; otherwise the daemon runs until it is told to stop.
+ */
+int	ft_serve(const char *path, const t_options *opts)
+{
+	static t_server		server;
+	struct sockaddr_un	addr;
+	struct stat			st;
+	pthread_t			workers[SERVE_WORKERS];
+	int					started = 0;
+
+	if (ft_strlen(path) >= sizeof(addr.sun_path))
+	{
+		ft_printf("nm: %s: socket path too long\n", (char *)path);
+		return (1);
+	}
+	ft_bzero(&addr, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	ft_memcpy(addr.sun_path, path, ft_strlen(path));
+	if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+	{
+		if (socket_in_use(&addr))
+		{
+			ft_printf("nm: %s: socket already in use\n", (char *)path);
+			return (1);
+		}
+		unlink(path);
+	}
+	server.listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (server.listen_fd < 0
+		|| bind(server.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+		|| listen(server.listen_fd, SOMAXCONN) < 0)
+	{
+		ft_printf("nm: %s: cannot listen on socket\n", (char *)path);
+		if (server.listen_fd >= 0)
+			close(server.listen_fd);
+		return (1);
+	}
+	g_socket_path = path;
+	signal(SIGPIPE, SIG_IGN);
+	signal(SIGINT, stop_server);
+	signal(SIGTERM, stop_server);
+	pthread_mutex_init(&server.lock, NULL);
+	pthread_mutex_init(&server.queue_lock, NULL);
+	pthread_cond_init(&server.queue_ready, NULL);
+	server.opts = *opts;
+	server.config.debug_syms = opts->config.debug_syms;
+	server.config.populate = opts->config.populate;
+	server.config.dynamic = opts->config.dynamic;
+	server.config.symbol_versions = opts->config.symbol_versions;
+	server.config.newer_than = opts->config.newer_than;
+	server.config.line_numbers = opts->config.line_numbers;
+	server.config.collation = opts->config.collation;
+	if (pipe2(server.wake, O_CLOEXEC) == 0)
+	{
+		while (started < SERVE_WORKERS
+			&& pthread_create(&workers[started], NULL, serve_worker, &server) == 0)
+			started++;
+		if (started > 0)
+			dispatch(&server);
+		else
+			ft_printf("nm: %s: cannot start workers\n", (char *)path);
+		pthread_mutex_lock(&server.queue_lock);
+		server.stopping = 1;
+		pthread_cond_broadcast(&server.queue_ready);
+		pthread_mutex_unlock(&server.queue_lock);
+		for (int i = 0; i < started; i++)
+			pthread_join(workers[i], NULL);
+		close(server.wake[0]);
+		close(server.wake[1]);
+	}
+	close(server.listen_fd);
+	unlink(path);
+	return (1);
+}
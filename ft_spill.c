@@ -0,0 +1,549 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_spill.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:46:03 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:46:28 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/*
+ * A spilled symbol, as written in a run: the fixed fields, then the collation
+ * key and the name, NUL-terminated as the comparisons expect. The section is a pointer into the input (or a static
+ * string), and the line of -l one into the line tables of the handle, both valid as long as the handle is open.
+ */
+typedef struct s_spill_record
+{
+	uint64_t			value;
+	uint64_t			size;
+	const char			*section;
+	const t_line_row	*line;
+	uint32_t			name_len;
+	uint32_t			key_len;
+	unsigned char		type;
+}	t_spill_record;
+
+/*
+ * A read position in one run of the temporary file, holding the record it
+ * stands on (current) in its buffer.
+ */
+typedef struct s_spill_cursor
+{
+	uint64_t		off;
+	uint64_t		end;
+	char			*buf;
+	size_t			cap;
+	size_t			len;
+	size_t			pos;
+	size_t			used;
+	size_t			run;
+	t_symbol		current;
+}	t_spill_cursor;
+
+/**
+ * Opens an unlinked temporary file for the runs, in $TMPDIR or /tmp.
+ * @return	The file descriptor, or -1 on error.
+ */
+static int	open_temp(void)
+{
+	const char	*dir = getenv("TMPDIR");
+	char		path[PATH_MAX];
+	int			fd;
+
+	ft_strlcpy(path, (dir && *dir) ? dir : "/tmp", sizeof(path));
+	if (ft_strlcat(path, "/ft_nm.XXXXXX", sizeof(path)) >= sizeof(path))
+		return (-1);
+	fd = mkstemp(path);
+	if (fd >= 0)
+		unlink(path);
+	return (fd);
+}
+
+/**
+ * Appends the end offset of a run to a list of run bounds.
+ * @param	bounds	The list, starting with the offset of the first run.
+ * @param	n		The number of bounds in the list.
+ * @param	cap		The capacity of the list.
+ * @param	off		The offset to append.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	add_bound(uint64_t **bounds, size_t *n, size_t *cap, uint64_t off)
+{
+	if (*n == *cap)
+	{
+		size_t		grown = *cap ? *cap * 2 : 64;
+		uint64_t	*list = ft_heap_alloc(sizeof(uint64_t) * grown);
+
+		if (list == NULL)
+			return (1);
+		ft_memcpy(list, *bounds, sizeof(uint64_t) * *n);
+		free(*bounds);
+		*bounds = list;
+		*cap = grown;
+	}
+	(*bounds)[(*n)++] = off;
+	return (0);
+}
+
+/**
+ * Writes a symbol as a record of a run.
+ * @param	w		The writer of the temporary file.
+ * @param	symbol	The symbol, with its collation key.
+ * @return	The size of the record.
+ */
+static size_t	put_record(t_writer *w, const t_symbol *symbol)
+{
+	t_spill_record	record;
+
+	ft_bzero(&record, sizeof(record));
+	record.value = symbol->value;
+	record.size = symbol->size;
+	record.section = symbol->section;
+	record.line = symbol->line;
+	record.name_len = symbol->name_len;
+	record.key_len = symbol->key_len;
+	record.type = symbol->type;
+	ft_writer_put(w, (const char *)&record, sizeof(record));
+	ft_writer_put(w, symbol->key, symbol->key_len);
+	ft_writer_put(w, symbol->name, symbol->name_len);
+	ft_writer_putc(w, '\0');
+	return (sizeof(record) + symbol->key_len + symbol->name_len + 1);
+}
+
+/**
+ * Flushes the writer of a temporary file and checks that everything reached
+ * it, the writer dropping what it fails to write.
+ * @param	w		The writer.
+ * @param	end		The offset the file must end at.
+ * @return	0 on success, 1 on write error.
+ */
+static int	flush_checked(t_writer *w, uint64_t end)
+{
+	ft_writer_flush(w);
+	return (lseek(w->fd, 0, SEEK_CUR) != (off_t)end);
+}
+
+/**
+ * Makes sure that the buffer of a cursor holds need bytes from its position,
+ * moving the unread bytes to its front and reading the run past them.
+ * @param	fd		The temporary file.
+ * @param	c		The cursor.
+ * @param	need	The number of bytes needed.
+ * @return	0 on success, 1 at the end of the run or on error.
+ */
+static int	cursor_fill(int fd, t_spill_cursor *c, size_t need)
+{
+	ssize_t	ret;
+
+	if (c->len - c->pos >= need)
+		return (0);
+	ft_memmove(c->buf, c->buf + c->pos, c->len - c->pos);
+	c->len -= c->pos;
+	c->pos = 0;
+	if (need > c->cap)
+	{
+		char	*grown = ft_heap_alloc(need);
+
+		if (grown == NULL)
+			return (1);
+		ft_memcpy(grown, c->buf, c->len);
+		free(c->buf);
+		c->buf = grown;
+		c->cap = need;
+	}
+	while (c->len < need && c->off < c->end)
+	{
+		size_t	size = c->cap - c->len;
+
+		if (size > c->end - c->off)
+			size = c->end - c->off;
+		ret = pread(fd, c->buf + c->len, size, c->off);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return (1);
+		c->len += ret;
+		c->off += ret;
+	}
+	return (c->len < need);
+}
+
+/**
+ * Moves a cursor to the next record of its run.
+ * @param	fd	The temporary file.
+ * @param	c	The cursor.
+ * @return	1 if the cursor stands on a record, 0 at the end of the run (or if
+ * 			it cannot be read).
+ */
+static int	cursor_load(int fd, t_spill_cursor *c)
+{
+	t_spill_record	record;
+	size_t			size;
+
+	c->pos += c->used;
+	c->used = 0;
+	if (cursor_fill(fd, c, sizeof(record)))
+		return (0);
+	ft_memcpy(&record, c->buf + c->pos, sizeof(record));
+	size = sizeof(record) + record.key_len + record.name_len + 1;
+	if (cursor_fill(fd, c, size))
+		return (0);
+	c->current.value = record.value;
+	c->current.size = record.size;
+	c->current.section = record.section;
+	c->current.line = record.line;
+	c->current.type = record.type;
+	c->current.key_len = record.key_len;
+	c->current.key = c->buf + c->pos + sizeof(record);
+	c->current.name_len = record.name_len;
+	c->current.name = c->current.key + record.key_len;
+	c->used = size;
+	return (1);
+}
+
+/**
+ * Tells if a cursor comes after another in the merge: in the listing order,
+ * then in run order, so that the merge is as stable as the in-memory sort.
+ * @param	a			The first cursor.
+ * @param	b			The second cursor.
+ * @param	collation	The FTNM_COLLATE_* order of the listing.
+ * @return	1 if the record of a must be placed after the one of b.
+ */
+static int	cursor_after(const t_spill_cursor *a, const t_spill_cursor *b, int collation)
+{
+	if (ft_collate_after(&a->current, &b->current, collation))
+		return (1);
+	if (ft_collate_after(&b->current, &a->current, collation))
+		return (0);
+	return (a->run > b->run);
+}
+
+/**
+ * Moves an entry of the merge heap down to its place.
+ * @param	spill	The spill state, its heap of cursors smallest record first.
+ * @param	i		The index of the entry.
+ */
+static void	sift_down(t_spill *spill, size_t i)
+{
+	t_spill_cursor	**heap = spill->heap;
+	size_t			n = spill->nheap;
+	t_spill_cursor	*entry = heap[i];
+
+	while (2 * i + 1 < n)
+	{
+		size_t	child = 2 * i + 1;
+
+		if (child + 1 < n && cursor_after(heap[child], heap[child + 1], spill->collation))
+			child++;
+		if (!cursor_after(entry, heap[child], spill->collation))
+			break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = entry;
+}
+
+/**
+ * Starts a k-way merge of consecutive runs: a cursor is put on the first
+ * record of each, and the cursors are arranged into a heap.
+ * @param	spill	The spill state.
+ * @param	first	The index of the first run.
+ * @param	n		The number of runs, at most the number of cursors.
+ */
+static void	merge_open(t_spill *spill, size_t first, size_t n)
+{
+	spill->nheap = 0;
+	spill->pending = NULL;
+	for (size_t i = 0; i < n; i++)
+	{
+		t_spill_cursor	*c = &spill->cursors[i];
+
+		c->off = spill->bounds[first + i];
+		c->end = spill->bounds[first + i + 1];
+		c->len = 0;
+		c->pos = 0;
+		c->used = 0;
+		c->run = i;
+		if (cursor_load(spill->fd, c))
+			spill->heap[spill->nheap++] = c;
+	}
+	for (size_t i = spill->nheap / 2; i-- > 0;)
+		sift_down(spill, i);
+}
+
+/**
+ * Fetches the next record of the merge. The record stays valid until the
+ * next call: its cursor is only advanced then.
+ * @param	spill	The spill state.
+ * @return	The cursor standing on the record, or NULL once the runs are
+ * 			exhausted.
+ */
+static t_spill_cursor	*merge_next(t_spill *spill)
+{
+	if (spill->pending)
+	{
+		if (!cursor_load(spill->fd, spill->pending))
+			spill->heap[0] = spill->heap[--spill->nheap];
+		if (spill->nheap)
+			sift_down(spill, 0);
+		spill->pending = NULL;
+	}
+	if (spill->nheap == 0)
+		return (NULL);
+	spill->pending = spill->heap[0];
+	return (spill->pending);
+}
+
+/**
+ * Sets up the spill state of a handle.
+ * @param	spill	The spill state.
+ * @param	budget		The memory budget of the sort, raised to SPILL_MIN_BUDGET.
+ * @param	collation	The FTNM_COLLATE_* order of the listing.
+ */
+void	ft_spill_init(t_spill *spill, size_t budget, int collation)
+{
+	ft_bzero(spill, sizeof(t_spill));
+	if (budget < SPILL_MIN_BUDGET)
+		budget = SPILL_MIN_BUDGET;
+	spill->limit = budget - SPILL_RESERVE;
+	spill->cap = spill->limit / (2 * sizeof(t_symbol) + sizeof(Elf64_Sym));
+	spill->fan_in = spill->limit / SPILL_MIN_BUFFER;
+	spill->fd = -1;
+	spill->collation = collation;
+}
+
+/**
+ * Tells how many symbols the array of a symbol table must hold: the symbols
+ * of a chunk, plus a classification block of room past it.
+ * @param	spill	The spill state.
+ * @param	nsyms	The number of entries of the symbol table.
+ * @return	The number of entries to allocate.
+ */
+size_t	ft_spill_capacity(const t_spill *spill, size_t nsyms)
+{
+	if (nsyms > spill->cap + CLASSIFY_BLOCK)
+		return (spill->cap + CLASSIFY_BLOCK);
+	return (nsyms);
+}
+
+/**
+ * Tells if the chunk being collected has reached the budget: its symbols,
+ * the scratch copy of the sort and the keys, sized from the names, and the
+ * pages of the input read for them (symbol entries and names), which stay
+ * resident until the chunk is spilled and they are dropped.
+ * @param	spill	The spill state.
+ * @param	symbols	The symbols of the chunk.
+ * @param	count	The number of symbols of the chunk.
+ * @return	1 if the chunk must be spilled before collecting more.
+ */
+int	ft_spill_full(t_spill *spill, const t_symbol *symbols, size_t count)
+{
+	for (; spill->seen < count; spill->seen++)
+		spill->bytes += 2 * sizeof(t_symbol) + sizeof(Elf64_Sym) + 2 * symbols[spill->seen].name_len + 1;
+	return (count > spill->cap || spill->bytes > spill->limit);
+}
+
+/**
+ * Sorts a chunk of symbols and appends it as a run to the temporary file,
+ * created on the first one. The chunk is then empty.
+ * @param	spill	The spill state.
+ * @param	symbols	The symbols of the chunk.
+ * @param	count	The number of symbols of the chunk, set to 0.
+ * @return	FTNM_OK, FTNM_ERR_MEMORY or FTNM_ERR_TEMP.
+ */
+int	ft_spill_chunk(t_spill *spill, t_symbol *symbols, size_t *count)
+{
+	t_writer	*w;
+	char		*keys;
+	uint64_t	end;
+
+	if (spill->fd < 0 && (spill->fd = open_temp()) < 0)
+		return (FTNM_ERR_TEMP);
+	if (spill->nbounds == 0 && add_bound(&spill->bounds, &spill->nbounds, &spill->bounds_cap, 0))
+		return (FTNM_ERR_MEMORY);
+	w = ft_heap_alloc(sizeof(t_writer));
+	if (w == NULL || ft_sort_symbols_with_keys(symbols, *count, spill->collation, &keys))
+	{
+		free(w);
+		return (FTNM_ERR_MEMORY);
+	}
+	ft_writer_init(w, spill->fd);
+	end = spill->bounds[spill->nbounds - 1];
+	for (size_t i = 0; i < *count; i++)
+		end += put_record(w, &symbols[i]);
+	free(keys);
+	if (flush_checked(w, end))
+	{
+		free(w);
+		return (FTNM_ERR_TEMP);
+	}
+	free(w);
+	if (add_bound(&spill->bounds, &spill->nbounds, &spill->bounds_cap, end))
+		return (FTNM_ERR_MEMORY);
+	spill->total += *count;
+	*count = 0;
+	spill->seen = 0;
+	spill->bytes = 0;
+	return (FTNM_OK);
+}
+
+/**
+ * Merges the runs by groups of fan_in into a new temporary file, which
+ * replaces the current one.
+ * @param	spill	The spill state.
+ * @param	w		A writer for the new file.
+ * @return	FTNM_OK, FTNM_ERR_MEMORY or FTNM_ERR_TEMP.
+ */
+static int	merge_pass(t_spill *spill, t_writer *w)
+{
+	uint64_t		*bounds = NULL;
+	size_t			nbounds = 0;
+	size_t			cap = 0;
+	uint64_t		end = 0;
+	t_spill_cursor	*c;
+	int				fd = open_temp();
+	int				ret = FTNM_OK;
+
+	if (fd < 0)
+		return (FTNM_ERR_TEMP);
+	ft_writer_init(w, fd);
+	for (size_t first = 0; ret == FTNM_OK && first + 1 < spill->nbounds; first += spill->fan_in)
+	{
+		size_t	n = spill->nbounds - 1 - first;
+
+		if (add_bound(&bounds, &nbounds, &cap, end))
+			ret = FTNM_ERR_MEMORY;
+		merge_open(spill, first, (n < spill->fan_in) ? n : spill->fan_in);
+		while (ret == FTNM_OK && (c = merge_next(spill)) != NULL)
+			end += put_record(w, &c->current);
+	}
+	if (ret == FTNM_OK && add_bound(&bounds, &nbounds, &cap, end))
+		ret = FTNM_ERR_MEMORY;
+	if (ret == FTNM_OK && flush_checked(w, end))
+		ret = FTNM_ERR_TEMP;
+	if (ret != FTNM_OK)
+	{
+		close(fd);
+		free(bounds);
+		return (ret);
+	}
+	close(spill->fd);
+	free(spill->bounds);
+	spill->fd = fd;
+	spill->bounds = bounds;
+	spill->nbounds = nbounds;
+	spill->bounds_cap = cap;
+	return (FTNM_OK);
+}
+
+/**
+ * Gives each merge cursor its share of the budget as a read buffer.
+ * @param	spill	The spill state.
+ * @param	n		The number of cursors.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	alloc_cursors(t_spill *spill, size_t n)
+{
+	spill->cursors = ft_heap_calloc(n, sizeof(t_spill_cursor));
+	spill->heap = ft_heap_alloc(sizeof(t_spill_cursor *) * n);
+	if (spill->cursors == NULL || spill->heap == NULL)
+		return (1);
+	spill->ncursors = n;
+	for (size_t i = 0; i < n; i++)
+	{
+		spill->cursors[i].cap = spill->limit / n;
+		spill->cursors[i].buf = ft_heap_alloc(spill->cursors[i].cap);
+		if (spill->cursors[i].buf == NULL)
+			return (1);
+	}
+	return (0);
+}
+
+/**
+ * Ends the collection of a symbol table. If no chunk was spilled, the
+ * symbols stay in memory and nothing changes. Otherwise the last chunk is
+ * spilled too, the array is released, and the runs are merged by groups
+ * until a single k-way merge within the budget can stream them all.
+ * @param	spill	The spill state.
+ * @param	symbols	The array of symbols, freed and set to NULL if spilled.
+ * @param	count	The number of symbols, set to the total if spilled.
+ * @return	FTNM_OK, FTNM_ERR_MEMORY or FTNM_ERR_TEMP.
+ */
+int	ft_spill_finish(t_spill *spill, t_symbol **symbols, size_t *count)
+{
+	t_writer	*w;
+	int			ret = FTNM_OK;
+
+	if (spill->nbounds == 0)
+		return (FTNM_OK);
+	if (*count && (ret = ft_spill_chunk(spill, *symbols, count)) != FTNM_OK)
+		return (ret);
+	free(*symbols);
+	*symbols = NULL;
+	*count = spill->total;
+	if (alloc_cursors(spill, (spill->nbounds - 1 < spill->fan_in) ? spill->nbounds - 1 : spill->fan_in))
+		return (FTNM_ERR_MEMORY);
+	w = (spill->nbounds - 1 > spill->fan_in) ? ft_heap_alloc(sizeof(t_writer)) : NULL;
+	if (spill->nbounds - 1 > spill->fan_in && w == NULL)
+		return (FTNM_ERR_MEMORY);
+	while (ret == FTNM_OK && spill->nbounds - 1 > spill->fan_in)
+		ret = merge_pass(spill, w);
+	free(w);
+	return (ret);
+}
+
+/**
+ * Starts the merge of the runs, from the first symbol in sorted order.
+ * @param	spill	The spill state of a spilled handle.
+ */
+void	ft_spill_rewind(t_spill *spill)
+{
+	merge_open(spill, 0, spill->nbounds - 1);
+}
+
+/**
+ * Fetches the next symbol of the merge. Its name stays valid until the next
+ * call.
+ * @param	spill	The spill state of a spilled handle.
+ * @param	symbol	Filled with the symbol.
+ * @return	1 if a symbol was fetched, 0 at the end of the symbols.
+ */
+int	ft_spill_next(t_spill *spill, t_ftnm_symbol *symbol)
+{
+	t_spill_cursor	*c = merge_next(spill);
+
+	if (c == NULL)
+		return (0);
+	symbol->name = c->current.name;
+	symbol->name_len = c->current.name_len;
+	symbol->value = c->current.value;
+	symbol->size = c->current.size;
+	symbol->type = c->current.type;
+	symbol->section = c->current.section;
+	symbol->file = c->current.line ? c->current.line->file : NULL;
+	symbol->line = c->current.line ? c->current.line->line : 0;
+	return (1);
+}
+
+/**
+ * Releases a spill state: its temporary file, run bounds and cursors.
+ * @param	spill	The spill state, may be NULL.
+ */
+void	ft_spill_free(t_spill *spill)
+{
+	if (spill == NULL)
+		return;
+	if (spill->fd >= 0)
+		close(spill->fd);
+	for (size_t i = 0; spill->cursors && i < spill->ncursors; i++)
+		free(spill->cursors[i].buf);
+	free(spill->cursors);
+	free(spill->heap);
+	free(spill->bounds);
+	free(spill);
+}
@@ -0,0 +1,163 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_stats.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:15:03 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:46:28 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+#include <sys/resource.h>
+
+/**
+ * Gives the writer the statistics are reported through (standard error).
+ * @return	The writer.
+ */
+static t_writer	*stats_writer(void)
+{
+	static t_writer	err;
+	static int		ready = 0;
+
+	if (!ready)
+	{
+		ft_writer_init(&err, STDERR_FILENO);
+		ready = 1;
+	}
+	return (&err);
+}
+
+/**
+ * Writes ", <label> <value>" to the statistics writer.
+ * @param	w		The writer.
+ * @param	label	The label of the field.
+ * @param	value	The value of the field.
+ */
+static void	put_field(t_writer *w, const char *label, uint64_t value)
+{
+	ft_writer_put(w, ", ", 2);
+	ft_writer_putstr(w, label);
+	ft_writer_putc(w, ' ');
+	ft_writer_putnbr(w, value);
+}
+
+/**
+ * Writes ", <label> <value>" with value given in hundredths, as a decimal
+ * number with two digits after the point.
+ * @param	w		The writer.
+ * @param	label	The label of the field.
+ * @param	value	The value of the field, in hundredths.
+ */
+static void	put_hundredths(t_writer *w, const char *label, uint64_t value)
+{
+	put_field(w, label, value / 100);
+	ft_writer_putc(w, '.');
+	ft_writer_putc(w, '0' + value / 10 % 10);
+	ft_writer_putc(w, '0' + value % 10);
+}
+
+/**
+ * Starts the clock of the run, for the files per second of the totals.
+ * @param	stats	The statistics of the run.
+ */
+void	ft_stats_start(t_stats *stats)
+{
+	clock_gettime(CLOCK_MONOTONIC, &stats->start);
+}
+
+/**
+ * Samples the page fault counters of the process and the heap allocation
+ * counter before a file is handled.
+ * @param	stats	The statistics of the run.
+ */
+void	ft_stats_file_begin(t_stats *stats)
+{
+	struct rusage	usage;
+
+	getrusage(RUSAGE_SELF, &usage);
+	stats->file_minflt = usage.ru_minflt;
+	stats->file_majflt = usage.ru_majflt;
+	stats->file_allocs = ft_heap_allocs();
+}
+
+/**
+ * Reports the page faults taken while handling a file (parsing, sorting and
+ * printing), how much of it was mapped or read, the system calls made on it
+ * and the heap allocations it cost, arena blocks, spill and DWARF tables
+ * and output buffers alike (none once the arena fits the files of the run
+ * and nothing spills), then adds them to the totals of the run. The system
+ * calls of the prefetcher were already counted by the caller, and include
+ * the close of the descriptor that follows.
+ * @param	stats		The statistics of the run.
+ * @param	handle		The handle of the file.
+ * @param	file		The file as prefetched.
+ * @param	filename	The name of the file.
+ */
+void	ft_stats_file_end(t_stats *stats, const t_ftnm *handle, const t_fetched *file, char *filename)
+{
+	t_writer		*w = stats_writer();
+	struct rusage	usage;
+	long			minflt;
+	long			majflt;
+	uint64_t		mapped;
+	uint64_t		read;
+	uint64_t		syscalls = handle->in.syscalls + (file->fd > STDIN_FILENO);
+	uint64_t		allocs = ft_heap_allocs() - stats->file_allocs;
+
+	ftnm_io_counters(handle, &mapped, &read);
+	if (file->data)
+		read += file->size;
+	getrusage(RUSAGE_SELF, &usage);
+	minflt = usage.ru_minflt - stats->file_minflt;
+	majflt = usage.ru_majflt - stats->file_majflt;
+	stats->files++;
+	stats->minflt += minflt;
+	stats->majflt += majflt;
+	stats->mapped += mapped;
+	stats->read += read;
+	stats->syscalls += syscalls;
+	stats->allocs += allocs;
+	ft_writer_put(w, "nm: stats: ", 11);
+	ft_writer_putstr(w, filename);
+	ft_writer_put(w, ": minor faults ", 15);
+	ft_writer_putnbr(w, minflt);
+	put_field(w, "major faults", majflt);
+	put_field(w, "bytes mapped", mapped);
+	put_field(w, "bytes read", read);
+	put_field(w, "syscalls", syscalls + file->syscalls);
+	put_field(w, "allocations", allocs);
+	ft_writer_putc(w, '\n');
+	ft_writer_flush(w);
+}
+
+/**
+ * Reports the totals of the run, with the system calls per file and the
+ * files per second since ft_stats_start.
+ * @param	stats	The statistics of the run.
+ */
+void	ft_stats_print(t_stats *stats)
+{
+	t_writer		*w = stats_writer();
+	struct timespec	now;
+	uint64_t		elapsed;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = (now.tv_sec - stats->start.tv_sec) * 1000000000ULL + now.tv_nsec - stats->start.tv_nsec;
+	ft_writer_put(w, "nm: stats: total: files ", 24);
+	ft_writer_putnbr(w, stats->files);
+	put_field(w, "minor faults", stats->minflt);
+	put_field(w, "major faults", stats->majflt);
+	put_field(w, "bytes mapped", stats->mapped);
+	put_field(w, "bytes read", stats->read);
+	put_field(w, "syscalls", stats->syscalls);
+	put_hundredths(w, "syscalls/file", stats->files ? stats->syscalls * 100 / stats->files : 0);
+	put_field(w, "allocations", stats->allocs);
+	put_hundredths(w, "files/sec", elapsed ? stats->files * 100000000000ULL / elapsed : 0);
+	ft_writer_put(w, ", io ", 5);
+	ft_writer_putstr(w, stats->backend ? stats->backend : "syscalls");
+	ft_writer_putc(w, '\n');
+	ft_writer_flush(w);
+}
@@ -0,0 +1,245 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_strtab.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:05:51 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:25:46 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+#if defined(__x86_64__) || defined(__i386__)
+# include <cpuid.h>
+# include <immintrin.h>
+# define STRTAB_X86 1
+#endif
+
+typedef void	(*t_nul_scan)(const char *data, size_t size, uint64_t *bits);
+
+/**
+ * Portable scan: sets the bit of every NUL byte of data in the bitmap, which
+ * must be zeroed beforehand.
+ * @param	data	The string table.
+ * @param	size	The size of the string table.
+ * @param	bits	The bitmap, one bit per byte of data.
+ */
+static void	scan_scalar(const char *data, size_t size, uint64_t *bits)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		if (data[i] == '\0')
+			bits[i >> 6] |= 1ULL << (i & 63);
+	}
+}
+
+#ifdef STRTAB_X86
+
+/**
+ * SSE2 scan: compares 64 bytes per iteration (four 16-byte lanes) against NUL
+ * and stores the four movemasks as one bitmap word.
+ * @param	data	The string table.
+ * @param	size	The size of the string table.
+ * @param	bits	The bitmap, zeroed beforehand.
+ */
+__attribute__((target("sse2")))
+static void	scan_sse2(const char *data, size_t size, uint64_t *bits)
+{
+	const __m128i	zero = _mm_setzero_si128();
+	size_t			i = 0;
+
+	for (; i + 64 <= size; i += 64)
+	{
+		uint64_t	m0 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i)), zero));
+		uint64_t	m1 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i + 16)), zero));
+		uint64_t	m2 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i + 32)), zero));
+		uint64_t	m3 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i + 48)), zero));
+
+		bits[i >> 6] = m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+	}
+	scan_scalar(data + i, size - i, bits + (i >> 6));
+}
+
+/**
+ * AVX2 scan: same as the SSE2 one with two 32-byte lanes per 64 bytes.
+ * @param	data	The string table.
+ * @param	size	The size of the string table.
+ * @param	bits	The bitmap, zeroed beforehand.
+ */
+__attribute__((target("avx2")))
+static void	scan_avx2(const char *data, size_t size, uint64_t *bits)
+{
+	const __m256i	zero = _mm256_setzero_si256();
+	size_t			i = 0;
+
+	for (; i + 64 <= size; i += 64)
+	{
+		uint32_t	lo = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(data + i)), zero));
+		uint32_t	hi = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(data + i + 32)), zero));
+
+		bits[i >> 6] = (uint64_t)lo | ((uint64_t)hi << 32);
+	}
+	scan_scalar(data + i, size - i, bits + (i >> 6));
+}
+
+/**
+ * Tells if the CPU and the OS both support AVX2: cpuid leaf 7 for the
+ * instruction set, OSXSAVE and XCR0 for the saving of the YMM registers.
+ * @return	1 if AVX2 can be used, 0 otherwise.
+ */
+int	ft_cpu_has_avx2(void)
+{
+	unsigned int	a, b, c, d;
+	unsigned int	xcr0_lo, xcr0_hi;
+
+	if (!__get_cpuid(1, &a, &b, &c, &d) || !(c & bit_OSXSAVE) || !(c & bit_AVX))
+		return (0);
+	__asm__ volatile ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+	if ((xcr0_lo & 6) != 6 || __get_cpuid_max(0, NULL) < 7)
+		return (0);
+	__cpuid_count(7, 0, a, b, c, d);
+	return ((b & bit_AVX2) != 0);
+}
+
+/**
+ * Tells if the CPU supports SSE2 (always true on x86-64).
+ * @return	1 if SSE2 can be used, 0 otherwise.
+ */
+int	ft_cpu_has_sse2(void)
+{
+	unsigned int	a, b, c, d;
+
+	if (!__get_cpuid(1, &a, &b, &c, &d))
+		return (0);
+	return ((d & bit_SSE2) != 0);
+}
+
+#else
+
+int	ft_cpu_has_avx2(void)
+{
+	return (0);
+}
+
+int	ft_cpu_has_sse2(void)
+{
+	return (0);
+}
+
+#endif
+
+static pthread_once_t	g_scan_once = PTHREAD_ONCE_INIT;
+static t_nul_scan		g_scan;
+
+/**
+ * Picks the widest scan the CPU supports.
+ */
+static void	pick_scan(void)
+{
+	g_scan = scan_scalar;
+#ifdef STRTAB_X86
+	if (ft_cpu_has_avx2())
+		g_scan = scan_avx2;
+	else if (ft_cpu_has_sse2())
+		g_scan = scan_sse2;
+#endif
+}
+
+/**
+ * Gives the scan function, picked once per run by the first caller of any
+ * thread.
+ * @return	The scan function to use.
+ */
+static t_nul_scan	select_scan(void)
+{
+	pthread_once(&g_scan_once, pick_scan);
+	return (g_scan);
+}
+
+/**
+ * Scans a whole string table once and records the position of every NUL
+ * terminator in a bitmap, so that the length of any name is then found
+ * without touching the name bytes again.
+ * @param	st		The string table to initialize.
+ * @param	data	A pointer to the string table in the mapped file.
+ * @param	size	The size of the string table (sh_size).
+ * @param	arena	The arena of the file the bitmap is allocated from, or NULL.
+ * @return	0 on success, 1 if the bitmap cannot be allocated.
+ */
+int	ft_strtab_init(t_strtab *st, const char *data, size_t size, t_arena *arena)
+{
+	size_t	words = (size + 63) / 64 + 1;
+
+	st->data = data;
+	st->size = size;
+	st->arena = arena;
+	st->nul_bits = ft_arena_alloc(arena, words * sizeof(uint64_t));
+	if (st->nul_bits == NULL)
+		return (1);
+	ft_bzero(st->nul_bits, words * sizeof(uint64_t));
+	select_scan()(data, size, st->nul_bits);
+	return (0);
+}
+
+/**
+ * Initializes a string table without the terminator bitmap: the length of a
+ * name is then found by looking for its terminator. Used under a memory
+ * budget, where the bitmap, one bit per byte of the table, would not fit and
+ * the name bytes are read anyway.
+ * @param	st		The string table to initialize.
+ * @param	data	A pointer to the string table in the mapped file.
+ * @param	size	The size of the string table (sh_size).
+ */
+void	ft_strtab_init_unscanned(t_strtab *st, const char *data, size_t size)
+{
+	st->data = data;
+	st->size = size;
+	st->arena = NULL;
+	st->nul_bits = NULL;
+}
+
+/**
+ * Releases the bitmap of a string table.
+ * @param	st	The string table.
+ */
+void	ft_strtab_free(t_strtab *st)
+{
+	ft_arena_drop(st->arena, st->nul_bits);
+	st->nul_bits = NULL;
+}
+
+/**
+ * Gives the length of the name starting at offset, from the terminator
+ * bitmap, or from the name bytes if the table was not scanned. This is also
+ * the bounds check of the name: it must start inside the table and be
+ * terminated before its end.
+ * @param	st		The scanned string table.
+ * @param	offset	The offset of the name (st_name).
+ * @return	The length of the name, or -1 if it does not fit in the table.
+ */
+long	ft_strtab_name_len(t_strtab *st, size_t offset)
+{
+	size_t		nwords = (st->size + 63) / 64;
+	size_t		w = offset >> 6;
+	uint64_t	word;
+
+	if (offset >= st->size)
+		return (-1);
+	if (st->nul_bits == NULL)
+	{
+		const char	*end = ft_memchr(st->data + offset, '\0', st->size - offset);
+
+		return (end ? end - (st->data + offset) : -1);
+	}
+	word = st->nul_bits[w] >> (offset & 63);
+	if (word)
+		return (__builtin_ctzll(word));
+	while (++w < nwords)
+	{
+		if (st->nul_bits[w])
+			return ((long)((w << 6) + __builtin_ctzll(st->nul_bits[w]) - offset));
+	}
+	return (-1);
+}
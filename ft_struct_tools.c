@@ -6,187 +6,222 @@
 /*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
 /*                                                +#+#+#+#+#+   +#+           */
 /*   Created: 2023/08/09 13:56:50 by jbertin           #+#    #+#             */
-/*   Updated: 2023/08/09 14:49:39 by jbertin          ###   ########.fr       */
+/*   Updated: 2026/10/19 19:46:28 by jbertin          ###   ########.fr       */
 /*                                                                            */
 /* ************************************************************************** */
 
 #include "includes/nm.h"
 
 /**
- * Prints out symbols from the given list based on their types (32 or 64).
- * If `multiple_files` is set, the filename will be printed as a header.
- * @param	list			A pointer to the first t_symbol in the list.
- * @param	type			Specifies the type (32 bits / 64 bits) of the list.
- * @param	filename		The name of the file containing the symbols.
- * @param	multiple_files	A flag indicating if there are multiple files.
+ * Writes one BSD line to the output writer, formatted in place in its buffer
+ * (through a temporary block for a line bigger than the buffer).
+ * @param	out		The output writer.
+ * @param	value	The value column.
+ * @param	symbol	The symbol (type letter, name span and source).
  */
-void	ft_print_symbols_list(t_symbol *list, int type, char *filename, int multiple_files)
+static void	print_line(t_writer *out, const char *value, const t_ftnm_symbol *symbol)
 {
-	t_symbol	*tmp;
-
-	if (multiple_files)
-		ft_printf("\n%s:\n", filename);
+	size_t	len = ft_format_line_length(value, symbol);
+	char	*line;
 
-	for (tmp = list; tmp; tmp = tmp->next)
+	if (len > WRITER_SIZE - out->len)
+		ft_writer_flush(out);
+	if (len <= WRITER_SIZE)
 	{
-		if (type == 32)
-		{
-			if (tmp->type == 'w')
-				ft_printf("         %c %s\n", tmp->type, tmp->name);
-			else if (tmp->type != 'A' && tmp->type != 'w')
-				ft_printf("%s %c %s\n", tmp->value, tmp->type, tmp->name);
-			else if (tmp->type == 'A' && ft_strncmp(tmp->value, "        ", 8) != 0)
-				ft_printf("%s %c %s\n", tmp->value, tmp->type, tmp->name);
-		}
-		else if (type == 64)
-		{
-			if (tmp->type == 'U')
-				ft_printf("                 %c %s\n", tmp->type, tmp->name);
-			else if (tmp->type == 'A' && ft_strncmp(tmp->value, "                ", 16) == 0)
-				continue;
-			else if (tmp->type != 'T' && tmp->type != 'U' && tmp->type != 'b')
-				ft_printf("%s %c %s\n", tmp->value, tmp->type, tmp->name);
-			else if ((tmp->type == 'T' || tmp->type == 'b') && ft_strncmp(tmp->value, "                ", 16) != 0)
-				ft_printf("%s %c %s\n", tmp->value, tmp->type, tmp->name);
-			else if ((tmp->type == 'T' || tmp->type == 'b') && ft_strncmp(tmp->value, "                ", 16) == 0)
-				ft_printf("0000000000000000 %c %s\n", tmp->type, tmp->name);
-		}
+		ft_format_line(out->buf + out->len, value, symbol);
+		out->len += len;
+		return;
+	}
+	line = ft_heap_alloc(len);
+	if (line == NULL)
+	{
+		ft_printf("Error allocating memory\n");
+		return;
 	}
+	ft_format_line(line, value, symbol);
+	ft_writer_put(out, line, len);
+	free(line);
+}
+
+/**
+ * Tells if a symbol is left out of the listing, as nm does for absolute
+ * symbols with a null value (mostly STT_FILE entries) unless -a is given.
+ * @param	symbol	The symbol to check.
+ * @param	opts	The options of the run.
+ * @return	1 if the symbol must not be displayed, 0 otherwise.
+ */
+int	ft_symbol_is_hidden(const t_ftnm_symbol *symbol, const t_options *opts)
+{
+	return (!opts->config.debug_syms && (symbol->type == 'A' || symbol->type == 'a') && symbol->value == 0);
 }
 
 /**
- * Appends a new symbol to the provided list.
- * @param	list	A pointer to the first t_symbol in the list.
- * @param	name	The name of the symbol.
- * @param	type	The type of the symbol.
- * @param	value	The value of the symbol.
- * @returns	The head of the symbols list.
+ * Prints the "filename:" header a listing gets when the run has several
+ * files.
+ * @param	filename	The name of the file.
+ * @param	nm			The run context (options and output writer).
  */
-t_symbol	*ft_add_symbol_to_list(t_symbol *list, char *name, unsigned char type, char *value)
+void	ft_print_file_header(char *filename, t_nm *nm)
 {
-	t_symbol	*new_symbol = malloc(sizeof(t_symbol));
-	if (new_symbol == NULL)
+	if (nm->opts.multiple_files)
 	{
-		ft_printf("Error allocating memory\n");
-		return NULL;
+		ft_writer_putc(&nm->out, '\n');
+		ft_writer_putstr(&nm->out, filename);
+		ft_writer_put(&nm->out, ":\n", 2);
 	}
+}
 
-	new_symbol->name = name;
-	new_symbol->type = type;
-	new_symbol->value = value;
-	new_symbol->next = NULL;
+/**
+ * Writes the lines of the BSD listing of an open file, in the order of the
+ * handle (sorted if ftnm_sort was called), as 32 or 64-bit values depending
+ * on its class, then flushes the writer. Big tables held in memory are
+ * formatted on several threads (ft_format_parallel).
+ * @param	handle	The handle of the file.
+ * @param	out		The output writer.
+ * @param	opts	The options of the run.
+ */
+void	ft_print_symbols(const t_ftnm *handle, t_writer *out, const t_options *opts)
+{
+	int				type = ftnm_class(handle);
+	t_ftnm_iter		iter;
+	t_ftnm_symbol	symbol;
+	char			value[17];
 
-	if (list == NULL)
-		return (new_symbol);
-	else
+	if (ft_format_parallel(handle, out, opts) != 0)
 	{
-		t_symbol *tmp = list;
-		while (tmp->next)
-			tmp = tmp->next;
-		tmp->next = new_symbol;
-		return (list);
+		ftnm_iter_init(&iter, handle);
+		while (ftnm_iter_next(&iter, &symbol))
+		{
+			const char	*column = ft_format_value(value, &symbol, type, opts);
+
+			if (column)
+				print_line(out, column, &symbol);
+		}
 	}
+	ft_writer_flush(out);
 }
 
 /**
- * Frees all the memory occupied by the symbols list.
- * @param	list	A pointer to the first t_symbol in the list.
+ * Prints out the symbols of an open file in the format of the run.
+ * If `multiple_files` is set, the filename will be printed as a header.
+ * Lines go through the buffered writer of `nm`, flushed once the list is done.
+ * @param	handle			The handle of the file.
+ * @param	filename		The name of the file containing the symbols.
+ * @param	nm				The run context (options and output writer).
  */
-void	ft_free_symbols_list(t_symbol *list)
+void	ft_print_symbols_list(const t_ftnm *handle, char *filename, t_nm *nm)
 {
-	t_symbol	*tmp;
-
-	while (list)
+	if (nm->opts.format != FORMAT_BSD)
 	{
-		tmp = list;
-		list = list->next;
-		free(tmp->name);
-		free(tmp->value);
-		free(tmp);
+		ft_print_symbols_json(handle, filename, nm);
+		return;
 	}
+	ft_print_file_header(filename, nm);
+	ft_print_symbols(handle, &nm->out, &nm->opts);
 }
 
 /**
- * Removes underscores, dots, and '@' symbols from a string.
- * @param	str	The original string.
- * @return	A new string without underscores, dots, and '@' symbols.
+ * Writes a number right-aligned in a column of the given width, always
+ * preceded by at least one space.
+ * @param	out		The output writer.
+ * @param	n		The number.
+ * @param	width	The width of the column.
  */
-static char	*clean_string(char *str)
+static void	put_column(t_writer *out, uint64_t n, int width)
 {
-	int		j = 0;
-	char	*new_str = malloc(ft_strlen(str) + 1);
-	if (new_str == NULL)
+	uint64_t	rest = n;
+	int			digits = 1;
+
+	while (rest >= 10)
 	{
-		ft_printf("Error allocating memory\n");
-		return (NULL);
+		rest /= 10;
+		digits++;
 	}
+	do
+		ft_writer_putc(out, ' ');
+	while (++digits < width);
+	ft_writer_putnbr(out, n);
+}
 
-	for(int i = 0; str[i]; i++)
+/**
+ * Writes " name count" for each non-zero counter of a list.
+ * @param	out		The output writer.
+ * @param	names	The names of the counters.
+ * @param	counts	The counters.
+ * @param	n		The number of counters.
+ */
+static void	put_counts(t_writer *out, const char **names, const uint64_t *counts, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
 	{
-		if(str[i] != '_' && str[i] != '.' && str[i] != '@')
-		{
-			new_str[j] = str[i];
-			j++;
-		}
+		if (counts[i] == 0)
+			continue;
+		ft_writer_putc(out, ' ');
+		ft_writer_putstr(out, names[i]);
+		ft_writer_putc(out, ' ');
+		ft_writer_putnbr(out, counts[i]);
 	}
-	new_str[j] = '\0';
-
-	return (new_str);
 }
 
 /**
- * Sorts symbols by their name, considering symbol names with
- * and without underscores, in a case-insensitive manner. If names are equal,
- * it further sorts them based on their type.
- * @param	list	A pointer to the first t_symbol in the list.
+ * Prints the summary of a file, filled by the library while it read the
+ * symbols: the symbol and undefined counts, the counts per type letter,
+ * binding and visibility, then a table of the symbols and st_size total of
+ * each section holding any. With a JSON format, one object is printed
+ * instead.
+ * @param	filename	The name of the file.
+ * @param	nm			The run context.
  */
-void	ft_sort_symbols_by_name(t_symbol *list)
+void	ft_print_summary(char *filename, t_nm *nm)
 {
-	t_symbol	*tmp;
-	char		*tmp_name;
-	char		tmp_type;
-	char		*tmp_value;
-	int			sorted = 0;
+	static const char	*bindings[] = {"local", "global", "weak", "unique", "other"};
+	static const char	*visibility[] = {"default", "internal", "hidden", "protected"};
+	t_summary			*summary = &nm->summary;
+	t_writer			*out = &nm->out;
+	uint64_t			binds[5] = {0};
 
-	while (!sorted)
+	if (nm->opts.format != FORMAT_BSD)
 	{
-		sorted = 1;
-		for (tmp = list; tmp->next; tmp = tmp->next)
-		{
-			char	*name1 = clean_string(tmp->name);
-			char	*name2 = clean_string(tmp->next->name);
-			int		comparison = 0;
-
-			if (ft_strncmp(name1, name2, INT_MAX) == 0 && ft_strncmp(tmp->name, tmp->next->name, INT_MAX) != 0)
-				comparison = ft_strncmp(tmp->name, tmp->next->name, INT_MAX);
-			else
-			{
-				comparison = ft_strncasecmp(name1, name2, INT_MAX);
-				if (tmp->type == tmp->next->type)
-				{
-					if (ft_strncasecmp(tmp->name, tmp->next->name, INT_MAX) == 0)
-						comparison = ft_strncmp(tmp->name, tmp->next->name, INT_MAX) * -1;
-				}
-			}
-
-			if (comparison > 0 || (comparison == 0 && tmp->type > tmp->next->type))
-			{
-				tmp_name = tmp->name;
-				tmp_type = tmp->type;
-				tmp_value = tmp->value;
-
-				tmp->name = tmp->next->name;
-				tmp->type = tmp->next->type;
-				tmp->value = tmp->next->value;
-
-				tmp->next->name = tmp_name;
-				tmp->next->type = tmp_type;
-				tmp->next->value = tmp_value;
-
-				sorted = 0;
-			}
-			free(name1);
-			free(name2);
-		}
+		ft_print_summary_json(filename, nm);
+		return;
+	}
+	for (int i = 0; i < 16; i++)
+		binds[(i <= STB_WEAK) ? i : (i == STB_GNU_UNIQUE) ? 3 : 4] += summary->bindings[i];
+	if (nm->opts.multiple_files)
+	{
+		ft_writer_putc(out, '\n');
+		ft_writer_putstr(out, filename);
+		ft_writer_put(out, ":\n", 2);
+	}
+	ft_writer_put(out, "symbols ", 8);
+	ft_writer_putnbr(out, summary->symbols);
+	ft_writer_put(out, ", undefined ", 12);
+	ft_writer_putnbr(out, summary->undefined);
+	ft_writer_put(out, "\ntypes:     ", 12);
+	for (int c = 0; c < 256; c++)
+	{
+		if (summary->types[c] == 0)
+			continue;
+		ft_writer_putc(out, ' ');
+		ft_writer_putc(out, c);
+		ft_writer_putc(out, ' ');
+		ft_writer_putnbr(out, summary->types[c]);
+	}
+	ft_writer_put(out, "\nbinding:   ", 12);
+	put_counts(out, bindings, binds, 5);
+	ft_writer_put(out, "\nvisibility:", 12);
+	put_counts(out, visibility, summary->visibility, 4);
+	ft_writer_putstr(out, "\nsection                          symbols                 size\n");
+	for (size_t i = 0; i < summary->nslots; i++)
+	{
+		size_t	len = ft_strlen(summary->names[i]);
+
+		if (summary->counts[i] == 0)
+			continue;
+		ft_writer_put(out, summary->names[i], len);
+		put_column(out, summary->counts[i], (len < 40) ? 40 - len : 0);
+		put_column(out, summary->sizes[i], 21);
+		ft_writer_putc(out, '\n');
 	}
+	ft_writer_flush(out);
 }
@@ -0,0 +1,96 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_summary.c                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:40:56 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:46:28 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/**
+ * Prepares a summary for a file with shnum sections: the counters are
+ * cleared and there is one slot per section, then one for absolute, one for
+ * common and one for any other special section index. The slot arrays are
+ * kept from a file to the next and only grow.
+ * @param	summary	The summary.
+ * @param	shnum	The number of sections of the file.
+ * @return	0 on success, 1 on allocation failure.
+ */
+int	ft_summary_reset(t_summary *summary, size_t shnum)
+{
+	size_t	nslots = shnum + 3;
+
+	if (nslots > summary->cap)
+	{
+		ft_summary_free(summary);
+		summary->counts = ft_heap_alloc(sizeof(uint64_t) * nslots);
+		summary->sizes = ft_heap_alloc(sizeof(uint64_t) * nslots);
+		summary->names = ft_heap_alloc(sizeof(char *) * nslots);
+		if (summary->counts == NULL || summary->sizes == NULL || summary->names == NULL)
+		{
+			ft_summary_free(summary);
+			return (1);
+		}
+		summary->cap = nslots;
+	}
+	summary->symbols = 0;
+	summary->undefined = 0;
+	ft_bzero(summary->types, sizeof(summary->types));
+	ft_bzero(summary->bindings, sizeof(summary->bindings));
+	ft_bzero(summary->visibility, sizeof(summary->visibility));
+	ft_bzero(summary->counts, sizeof(uint64_t) * nslots);
+	ft_bzero(summary->sizes, sizeof(uint64_t) * nslots);
+	summary->nslots = nslots;
+	summary->names[shnum] = "*ABS*";
+	summary->names[shnum + 1] = "*COM*";
+	summary->names[shnum + 2] = "*OTHER*";
+	return (0);
+}
+
+/**
+ * Counts a symbol: its type letter, its binding and visibility, and its
+ * section with its st_size.
+ * @param	summary	The summary.
+ * @param	type	The type letter of the symbol.
+ * @param	info	The st_info of the symbol.
+ * @param	other	The st_other of the symbol.
+ * @param	shndx	The st_shndx of the symbol, in host byte order.
+ * @param	size	The st_size of the symbol.
+ */
+void	ft_summary_add(t_summary *summary, unsigned char type, unsigned char info, unsigned char other,
+	uint16_t shndx, uint64_t size)
+{
+	size_t	shnum = summary->nslots - 3;
+	size_t	slot = shndx;
+
+	if (shndx >= shnum)
+		slot = (shndx == SHN_ABS) ? shnum : (shndx == SHN_COMMON) ? shnum + 1 : shnum + 2;
+	summary->symbols++;
+	summary->undefined += (shndx == SHN_UNDEF);
+	summary->types[type]++;
+	summary->bindings[info >> 4]++;
+	summary->visibility[other & 3]++;
+	summary->counts[slot]++;
+	summary->sizes[slot] += size;
+}
+
+/**
+ * Releases the slot arrays of a summary.
+ * @param	summary	The summary.
+ */
+void	ft_summary_free(t_summary *summary)
+{
+	free(summary->counts);
+	free(summary->sizes);
+	free(summary->names);
+	summary->counts = NULL;
+	summary->sizes = NULL;
+	summary->names = NULL;
+	summary->cap = 0;
+	summary->nslots = 0;
+}
@@ -6,7 +6,7 @@
 /*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
 /*                                                +#+#+#+#+#+   +#+           */
 /*   Created: 2023/08/09 13:56:54 by jbertin           #+#    #+#             */
-/*   Updated: 2023/08/09 15:25:29 by jbertin          ###   ########.fr       */
+/*   Updated: 2026/10/19 18:44:04 by jbertin          ###   ########.fr       */
 /*                                                                            */
 /* ************************************************************************** */
 
@@ -53,29 +53,53 @@ uint16_t	ft_read_uint16(void *pos, int endian)
 }
 
 /**
- * Converts a given value to an [size]-character hexadecimal string.
+ * Reads the header of a section of an ELF32 or ELF64 file, whatever its
+ * class.
+ * @param	shdrs	The section header table.
+ * @param	index	The index of the section.
+ * @param	is_64	1 for ELF64, 0 for ELF32.
+ * @param	sec		The fields to fill.
+ */
+void	ft_section_header(const void *shdrs, size_t index, int is_64, t_section *sec)
+{
+	if (is_64)
+	{
+		const Elf64_Shdr	*shdr = (const Elf64_Shdr *)shdrs + index;
+
+		*sec = (t_section){shdr->sh_name, shdr->sh_type, shdr->sh_flags, shdr->sh_offset, shdr->sh_size,
+			shdr->sh_link, shdr->sh_info, shdr->sh_addralign, shdr->sh_entsize};
+	}
+	else
+	{
+		const Elf32_Shdr	*shdr = (const Elf32_Shdr *)shdrs + index;
+
+		*sec = (t_section){shdr->sh_name, shdr->sh_type, shdr->sh_flags, shdr->sh_offset, shdr->sh_size,
+			shdr->sh_link, shdr->sh_info, shdr->sh_addralign, shdr->sh_entsize};
+	}
+}
+
+/**
+ * Converts a given value to an [size]-character hexadecimal string written
+ * into dst, which must hold at least [size + 1] characters.
  * The result string is space-padded to [size] characters for value 0.
+ * @param	dst		The destination buffer.
  * @param	value	The value to be converted to a hex string.
- * @return	A pointer to the hexadecimal string, or NULL if memory allocation fails.
+ * @param	size	The number of characters to produce (8 or 16).
  */
-char	*ft_st_value_to_string(unsigned long long value, int size)
+void	ft_st_value_to_string(char *dst, unsigned long long value, int size)
 {
-	char *hex = malloc((size + 1) * sizeof(char));
-	if (!hex)
-		return (NULL);
-
 	if (value == 0)
 	{
 		for (int i = 0; i < size; ++i)
-			hex[i] = ' ';
-		return (hex);
+			dst[i] = ' ';
+		dst[size] = '\0';
+		return;
 	}
 
 	for (int i = (size - 1); i >= 0; --i, value >>= 4)
-		hex[i] = "0123456789abcdef"[value & 0xF];
+		dst[i] = "0123456789abcdef"[value & 0xF];
 
-	hex[size] = '\0';
-	return (hex);
+	dst[size] = '\0';
 }
 
 /**
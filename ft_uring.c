@@ -0,0 +1,334 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_uring.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:35:05 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 17:36:32 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#define _GNU_SOURCE
+#include "includes/nm.h"
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+
+#define URING_ENTRIES	128
+#define URING_OPEN		1
+#define URING_STAT		2
+#define URING_READ		3
+#define URING_CLOSE		4
+
+typedef struct s_uring
+{
+	int					fd;
+	void				*sq_map;
+	size_t				sq_len;
+	void				*cq_map;
+	size_t				cq_len;
+	struct io_uring_sqe	*sqes;
+	size_t				sqes_len;
+	unsigned			*sq_tail;
+	unsigned			*sq_mask;
+	unsigned			*sq_array;
+	unsigned			*cq_head;
+	unsigned			*cq_tail;
+	unsigned			*cq_mask;
+	struct io_uring_cqe	*cqes;
+	unsigned			queued;
+	unsigned			inflight;
+	size_t				want[PREFETCH_BATCH];
+	struct statx		stx[PREFETCH_BATCH];
+}	t_uring;
+
+/**
+ * Checks that the kernel supports every operation the prefetcher submits
+ * (openat, statx, read and close appeared together in Linux 5.6).
+ * @param	ring		The ring.
+ * @param	syscalls	The system call counter of the prefetcher.
+ * @return	1 if they are all supported, 0 otherwise.
+ */
+static int	uring_supported(t_uring *ring, uint64_t *syscalls)
+{
+	static const int		ops[] = {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE};
+	struct io_uring_probe	*probe;
+	int						ok;
+
+	probe = malloc(sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op));
+	if (probe == NULL)
+		return (0);
+	ft_bzero(probe, sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op));
+	ok = (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, 256) == 0);
+	(*syscalls)++;
+	for (size_t i = 0; ok && i < sizeof(ops) / sizeof(ops[0]); i++)
+		ok = (ops[i] <= probe->last_op && (probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED));
+	free(probe);
+	return (ok);
+}
+
+/**
+ * Unmaps the rings and closes the io_uring instance.
+ * @param	ring		The ring.
+ * @param	syscalls	The system call counter of the prefetcher.
+ */
+static void	uring_destroy(t_uring *ring, uint64_t *syscalls)
+{
+	if (ring->sqes)
+		munmap(ring->sqes, ring->sqes_len);
+	if (ring->cq_map && ring->cq_map != ring->sq_map)
+		munmap(ring->cq_map, ring->cq_len);
+	if (ring->sq_map)
+		munmap(ring->sq_map, ring->sq_len);
+	close(ring->fd);
+	*syscalls += 2 + (ring->sqes != NULL) + (ring->cq_map && ring->cq_map != ring->sq_map);
+	free(ring);
+}
+
+/**
+ * Sets up an io_uring instance for the prefetcher, without liburing: the
+ * submission and completion rings are mapped by hand.
+ * @param	syscalls	The system call counter of the prefetcher.
+ * @return	The ring, or NULL if io_uring is not available (old kernel,
+ * 			seccomp filter, missing operations) or cannot be set up.
+ */
+t_uring	*ft_uring_init(uint64_t *syscalls)
+{
+	struct io_uring_params	p;
+	t_uring					*ring = malloc(sizeof(t_uring));
+
+	if (ring == NULL)
+		return (NULL);
+	ft_bzero(ring, sizeof(t_uring));
+	ft_bzero(&p, sizeof(p));
+	ring->fd = syscall(__NR_io_uring_setup, URING_ENTRIES, &p);
+	(*syscalls)++;
+	if (ring->fd < 0)
+	{
+		free(ring);
+		return (NULL);
+	}
+	ring->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		ring->sq_len = (ring->cq_len > ring->sq_len) ? ring->cq_len : ring->sq_len;
+	ring->sq_map = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			ring->fd, IORING_OFF_SQ_RING);
+	ring->cq_map = ring->sq_map;
+	if (ring->sq_map != MAP_FAILED && !(p.features & IORING_FEAT_SINGLE_MMAP))
+		ring->cq_map = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+				ring->fd, IORING_OFF_CQ_RING);
+	ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			ring->fd, IORING_OFF_SQES);
+	*syscalls += 2 + !(p.features & IORING_FEAT_SINGLE_MMAP);
+	if (ring->sq_map == MAP_FAILED || ring->cq_map == MAP_FAILED || ring->sqes == MAP_FAILED
+		|| !uring_supported(ring, syscalls))
+	{
+		ring->sq_map = (ring->sq_map == MAP_FAILED) ? NULL : ring->sq_map;
+		ring->cq_map = (ring->cq_map == MAP_FAILED) ? NULL : ring->cq_map;
+		ring->sqes = (ring->sqes == MAP_FAILED) ? NULL : ring->sqes;
+		uring_destroy(ring, syscalls);
+		return (NULL);
+	}
+	ring->sq_tail = (unsigned *)((char *)ring->sq_map + p.sq_off.tail);
+	ring->sq_mask = (unsigned *)((char *)ring->sq_map + p.sq_off.ring_mask);
+	ring->sq_array = (unsigned *)((char *)ring->sq_map + p.sq_off.array);
+	ring->cq_head = (unsigned *)((char *)ring->cq_map + p.cq_off.head);
+	ring->cq_tail = (unsigned *)((char *)ring->cq_map + p.cq_off.tail);
+	ring->cq_mask = (unsigned *)((char *)ring->cq_map + p.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)((char *)ring->cq_map + p.cq_off.cqes);
+	return (ring);
+}
+
+/**
+ * Queues an operation. A batch queues at most two operations per file plus
+ * the closes of the previous batch, which always fits in the ring.
+ * @param	ring	The ring.
+ * @param	opcode	The IORING_OP_* operation.
+ * @param	fd		The file descriptor the operation works on.
+ * @param	kind	The URING_* kind of the operation.
+ * @param	slot	The slot of the file in the batch.
+ * @return	The entry to fill in.
+ */
+static struct io_uring_sqe	*uring_queue(t_uring *ring, int opcode, int fd, int kind, size_t slot)
+{
+	unsigned			tail = *ring->sq_tail;
+	unsigned			index = tail & *ring->sq_mask;
+	struct io_uring_sqe	*sqe = &ring->sqes[index];
+
+	ft_bzero(sqe, sizeof(struct io_uring_sqe));
+	sqe->opcode = opcode;
+	sqe->fd = fd;
+	sqe->user_data = ((uint64_t)kind << 32) | slot;
+	ring->sq_array[index] = index;
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	ring->queued++;
+	return (sqe);
+}
+
+/**
+ * Records the result of a completed operation in the slot of its file.
+ * @param	pf		The prefetcher.
+ * @param	cqe		The completion.
+ */
+static void	uring_complete(t_prefetch *pf, const struct io_uring_cqe *cqe)
+{
+	t_uring		*ring = pf->ring;
+	int			kind = cqe->user_data >> 32;
+	size_t		slot = cqe->user_data & 0xffffffff;
+	t_fetched	*file = &pf->files[slot];
+
+	if (kind == URING_OPEN && cqe->res < 0)
+		file->err = -cqe->res;
+	else if (kind == URING_OPEN)
+		file->fd = cqe->res;
+	else if (kind == URING_STAT)
+	{
+		ring->want[slot] = 0;
+		if (cqe->res == 0 && S_ISREG(ring->stx[slot].stx_mode))
+			ring->want[slot] = ring->stx[slot].stx_size;
+	}
+	else if (kind == URING_READ && cqe->res >= 0 && (size_t)cqe->res == ring->want[slot])
+	{
+		file->data = pf->bufs[slot];
+		file->size = cqe->res;
+	}
+}
+
+/**
+ * Submits the queued operations and waits until every operation in flight
+ * has completed, handling the completions as they come.
+ * @param	pf	The prefetcher.
+ * @return	0 on success, 1 if io_uring_enter fails.
+ */
+static int	uring_run(t_prefetch *pf)
+{
+	t_uring		*ring = pf->ring;
+	unsigned	head;
+	unsigned	tail;
+	int			ret;
+
+	while (ring->queued || ring->inflight)
+	{
+		ret = syscall(__NR_io_uring_enter, ring->fd, ring->queued, ring->queued + ring->inflight,
+				IORING_ENTER_GETEVENTS, NULL, 0);
+		pf->syscalls++;
+		if (ret < 0 && errno != EINTR)
+			return (1);
+		if (ret > 0)
+		{
+			ring->queued -= ret;
+			ring->inflight += ret;
+		}
+		head = *ring->cq_head;
+		tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+		for (; head != tail; head++, ring->inflight--)
+			uring_complete(pf, &ring->cqes[head & *ring->cq_mask]);
+		__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+	}
+	return (0);
+}
+
+/**
+ * Grows the pooled buffer of a slot to hold a file, keeping it for the
+ * next batches.
+ * @param	pf		The prefetcher.
+ * @param	slot	The slot.
+ * @param	size	The size of the file.
+ * @return	0 on success, 1 on allocation failure.
+ */
+static int	reserve_buffer(t_prefetch *pf, size_t slot, size_t size)
+{
+	if (pf->caps[slot] >= size)
+		return (0);
+	free(pf->bufs[slot]);
+	pf->bufs[slot] = malloc(size);
+	pf->caps[slot] = pf->bufs[slot] ? size : 0;
+	return (pf->bufs[slot] == NULL);
+}
+
+/**
+ * Gives up on a batch after a failure of the ring, closing the files it
+ * opened so that they can be opened again without it.
+ * @param	pf	The prefetcher.
+ * @param	n	The number of files of the batch.
+ * @return	1.
+ */
+static int	abandon_batch(t_prefetch *pf, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		if (pf->files[i].fd > STDIN_FILENO)
+			close(pf->files[i].fd);
+	return (1);
+}
+
+/**
+ * Fetches the next batch of files through io_uring: every file is opened
+ * and measured at once (openat and statx), then the small regular ones are
+ * read whole into the pooled buffers of their slots, also at once. Their
+ * descriptors are closed through the ring along with the next batch; the
+ * others are handed to the caller to go through the usual input layer.
+ * @param	pf	The prefetcher.
+ * @return	0 on success, 1 if the ring failed and the batch must be opened
+ * 			again without it.
+ */
+int	ft_uring_fetch(t_prefetch *pf)
+{
+	t_uring				*ring = pf->ring;
+	struct io_uring_sqe	*sqe;
+	size_t				n = pf->count - pf->opened;
+
+	n = (n > PREFETCH_BATCH) ? PREFETCH_BATCH : n;
+	for (size_t i = 0; i < n; i++)
+	{
+		const char	*path = pf->paths[pf->opened + i];
+
+		ft_bzero(&pf->files[i], sizeof(t_fetched));
+		ring->want[i] = 0;
+		pf->files[i].fd = (ft_strncmp(path, "-", 2) == 0) ? STDIN_FILENO : -1;
+		if (pf->files[i].fd == STDIN_FILENO)
+			continue;
+		sqe = uring_queue(ring, IORING_OP_OPENAT, AT_FDCWD, URING_OPEN, i);
+		sqe->addr = (uintptr_t)path;
+		sqe->open_flags = O_RDONLY | O_CLOEXEC;
+		sqe = uring_queue(ring, IORING_OP_STATX, AT_FDCWD, URING_STAT, i);
+		sqe->addr = (uintptr_t)path;
+		sqe->len = STATX_TYPE | STATX_SIZE;
+		sqe->off = (uintptr_t)&ring->stx[i];
+	}
+	if (uring_run(pf))
+		return (abandon_batch(pf, n));
+	for (size_t i = 0; i < n; i++)
+	{
+		if (pf->files[i].fd <= STDIN_FILENO || ring->want[i] == 0 || ring->want[i] > PREFETCH_READ_MAX
+			|| reserve_buffer(pf, i, ring->want[i]))
+			continue;
+		sqe = uring_queue(ring, IORING_OP_READ, pf->files[i].fd, URING_READ, i);
+		sqe->addr = (uintptr_t)pf->bufs[i];
+		sqe->len = ring->want[i];
+	}
+	if (uring_run(pf))
+		return (abandon_batch(pf, n));
+	for (size_t i = 0; i < n; i++)
+	{
+		if (pf->files[i].data == NULL)
+			continue;
+		uring_queue(ring, IORING_OP_CLOSE, pf->files[i].fd, URING_CLOSE, i);
+		pf->files[i].fd = -1;
+	}
+	pf->opened += n;
+	return (0);
+}
+
+/**
+ * Waits for the operations still in flight and releases the ring.
+ * @param	pf	The prefetcher.
+ */
+void	ft_uring_free(t_prefetch *pf)
+{
+	uring_run(pf);
+	uring_destroy(pf->ring, &pf->syscalls);
+	pf->ring = NULL;
+}
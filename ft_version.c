@@ -0,0 +1,310 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_version.c                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:58:03 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 18:44:04 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/**
+ * Maps the string table a version section links to. It must end with a NUL
+ * byte, so that every name found in range is terminated.
+ * @param	elf		The ELF file.
+ * @param	is_64	1 for ELF64, 0 for ELF32.
+ * @param	link	The sh_link of the version section.
+ * @param	size	Set to the size of the string table.
+ * @return	The string table, or NULL if it cannot be used.
+ */
+static const char	*link_strtab(t_elf *elf, int is_64, uint32_t link, size_t *size)
+{
+	t_section	sec;
+	const char	*data;
+
+	if (link >= elf->shnum)
+		return (NULL);
+	ft_section_header(elf->shdrs, link, is_64, &sec);
+	data = ft_input_range(elf->in, sec.offset, sec.size);
+	if (data == NULL || sec.size == 0 || data[sec.size - 1] != '\0')
+		return (NULL);
+	*size = sec.size;
+	return (data);
+}
+
+/**
+ * Records the name of a version index, or only accounts for the index when
+ * the table is not allocated yet.
+ * @param	v		The version table.
+ * @param	index	The version index (vd_ndx or vna_other).
+ * @param	strtab	The linked string table.
+ * @param	size	The size of the string table.
+ * @param	name	The offset of the name in the string table.
+ * @param	flags	VERSION_NEEDED for a requirement, 0 for a definition.
+ */
+static void	record(t_versions *v, uint16_t index, const char *strtab, size_t size, uint32_t name, int flags)
+{
+	index &= VERSYM_INDEX;
+	if (v->names == NULL)
+	{
+		if (index >= v->count)
+			v->count = index + 1;
+	}
+	else if (index < v->count && name < size)
+	{
+		v->names[index] = strtab + name;
+		v->flags[index] = flags;
+	}
+}
+
+/**
+ * Walks the version definitions (.gnu.version_d): each one names the version
+ * of its index in its first auxiliary entry. Entries out of the section end
+ * the walk.
+ * @param	v		The version table.
+ * @param	elf		The ELF file.
+ * @param	is_64	1 for ELF64, 0 for ELF32.
+ * @param	sec		The version definition section.
+ */
+static void	walk_verdef(t_versions *v, t_elf *elf, int is_64, t_section *sec)
+{
+	const char	*data = ft_input_range(elf->in, sec->offset, sec->size);
+	const char	*strtab;
+	size_t		strsize;
+	uint64_t	off = 0;
+
+	if (data == NULL || (strtab = link_strtab(elf, is_64, sec->link, &strsize)) == NULL)
+		return;
+	for (uint32_t n = 0; n < sec->info && off + sizeof(Elf64_Verdef) <= sec->size; n++)
+	{
+		Elf64_Verdef	*def = (Elf64_Verdef *)(data + off);
+		uint64_t		aux = off + ft_read_uint32(&def->vd_aux, elf->endian);
+		uint32_t		next = ft_read_uint32(&def->vd_next, elf->endian);
+
+		if (aux + sizeof(Elf64_Verdaux) <= sec->size)
+			record(v, ft_read_uint16(&def->vd_ndx, elf->endian), strtab, strsize,
+				ft_read_uint32(&((Elf64_Verdaux *)(data + aux))->vda_name, elf->endian), 0);
+		if (next == 0)
+			break;
+		off += next;
+	}
+}
+
+/**
+ * Walks the version requirements (.gnu.version_r): each file needed lists the
+ * versions it must provide, one auxiliary entry per version index. Entries
+ * out of the section end the walk.
+ * @param	v		The version table.
+ * @param	elf		The ELF file.
+ * @param	is_64	1 for ELF64, 0 for ELF32.
+ * @param	sec		The version requirement section.
+ */
+static void	walk_verneed(t_versions *v, t_elf *elf, int is_64, t_section *sec)
+{
+	const char	*data = ft_input_range(elf->in, sec->offset, sec->size);
+	const char	*strtab;
+	size_t		strsize;
+	uint64_t	off = 0;
+
+	if (data == NULL || (strtab = link_strtab(elf, is_64, sec->link, &strsize)) == NULL)
+		return;
+	for (uint32_t n = 0; n < sec->info && off + sizeof(Elf64_Verneed) <= sec->size; n++)
+	{
+		Elf64_Verneed	*need = (Elf64_Verneed *)(data + off);
+		uint16_t		cnt = ft_read_uint16(&need->vn_cnt, elf->endian);
+		uint64_t		aux = off + ft_read_uint32(&need->vn_aux, elf->endian);
+		uint32_t		next = ft_read_uint32(&need->vn_next, elf->endian);
+
+		for (uint16_t k = 0; k < cnt && aux + sizeof(Elf64_Vernaux) <= sec->size; k++)
+		{
+			Elf64_Vernaux	*vna = (Elf64_Vernaux *)(data + aux);
+			uint32_t		vna_next = ft_read_uint32(&vna->vna_next, elf->endian);
+
+			record(v, ft_read_uint16(&vna->vna_other, elf->endian), strtab, strsize,
+				ft_read_uint32(&vna->vna_name, elf->endian), VERSION_NEEDED);
+			if (vna_next == 0)
+				break;
+			aux += vna_next;
+		}
+		if (next == 0)
+			break;
+		off += next;
+	}
+}
+
+/**
+ * Splits a version name into its prefix (up to its first digit, as "GLIBC_"
+ * in "GLIBC_2.17") and compares the numbers that follow, component by
+ * component.
+ * @param	a	A version name.
+ * @param	b	Another version name.
+ * @return	1 if both have the same prefix and a is newer than b, 0 otherwise.
+ */
+int	ft_version_newer(const char *a, const char *b)
+{
+	while (*a && *a == *b && !ft_isdigit(*a))
+	{
+		a++;
+		b++;
+	}
+	if (!ft_isdigit(*a) || !ft_isdigit(*b))
+		return (0);
+	while (*a || *b)
+	{
+		uint64_t	na = 0;
+		uint64_t	nb = 0;
+
+		while (ft_isdigit(*a))
+			na = na * 10 + (*a++ - '0');
+		while (ft_isdigit(*b))
+			nb = nb * 10 + (*b++ - '0');
+		if (na != nb)
+			return (na > nb);
+		if (*a)
+			a++;
+		if (*b)
+			b++;
+	}
+	return (0);
+}
+
+/**
+ * Builds the version table of a symbol table: the index to name table of the
+ * version definitions and requirements, telling requirements apart, built
+ * once so that each symbol is then annotated with a lookup, and the
+ * .gnu.version array (one index per symbol) that links to the symbol table.
+ * With a newer_than version in the configuration, the indexes of the
+ * versions newer than it are flagged too. A table without .gnu.version gets
+ * no versions. The index table comes from the arena of the file.
+ * @param	v		The version table to initialize.
+ * @param	elf		The ELF file, its tables validated.
+ * @param	is_64	1 for ELF64, 0 for ELF32.
+ * @param	symtab	The index of the symbol table section.
+ * @param	strings	The arena versioned names are allocated from.
+ * @return	0 on success, 1 if the table cannot be allocated.
+ */
+int	ft_versions_init(t_versions *v, t_elf *elf, int is_64, size_t symtab, t_arena *strings)
+{
+	t_section	sec;
+
+	ft_bzero(v, sizeof(t_versions));
+	v->arena = elf->arena;
+	v->strings = strings;
+	v->endian = elf->endian;
+	for (size_t i = 0; i < elf->shnum; i++)
+	{
+		ft_section_header(elf->shdrs, i, is_64, &sec);
+		if (sec.type == SHT_GNU_versym && sec.link == symtab && sec.size / 2 >= elf->nsyms)
+			v->versym = ft_input_range(elf->in, sec.offset, elf->nsyms * 2);
+	}
+	for (int pass = 0; v->versym && pass < 2; pass++)
+	{
+		if (pass == 1 && v->count == 0)
+			break;
+		if (pass == 1)
+		{
+			v->names = ft_arena_alloc(v->arena, v->count * (sizeof(char *) + 1));
+			if (v->names == NULL)
+				return (1);
+			ft_bzero(v->names, v->count * (sizeof(char *) + 1));
+			v->flags = (unsigned char *)(v->names + v->count);
+		}
+		for (size_t i = 0; i < elf->shnum; i++)
+		{
+			ft_section_header(elf->shdrs, i, is_64, &sec);
+			if (sec.type == SHT_GNU_verdef)
+				walk_verdef(v, elf, is_64, &sec);
+			else if (sec.type == SHT_GNU_verneed)
+				walk_verneed(v, elf, is_64, &sec);
+		}
+	}
+	for (size_t i = 0; elf->config->newer_than && i < v->count; i++)
+		if (v->names[i] && ft_version_newer(v->names[i], elf->config->newer_than))
+			v->flags[i] |= VERSION_NEWER;
+	return (0);
+}
+
+/**
+ * Looks up the version of a symbol.
+ * @param	v		The version table.
+ * @param	i		The index of the symbol in its table.
+ * @param	index	Set to the version index of the symbol, hidden bit cleared.
+ * @return	The version .gnu.version gives the symbol, or NULL if it has none
+ * 			(local or global index, unknown index, no .gnu.version).
+ */
+static const char	*version_of(const t_versions *v, size_t i, uint16_t *index)
+{
+	uint16_t	raw;
+
+	if (v->versym == NULL)
+		return (NULL);
+	raw = ft_read_uint16((void *)&v->versym[i], v->endian);
+	*index = raw & VERSYM_INDEX;
+	if (*index <= VER_NDX_GLOBAL || *index >= v->count)
+		return (NULL);
+	return (v->names[*index]);
+}
+
+/**
+ * Tells whether a symbol needs a version newer than the newer_than version
+ * of the configuration.
+ * @param	v	The version table, built with a newer_than version.
+ * @param	i	The index of the symbol in its table.
+ * @return	1 if it does, 0 otherwise.
+ */
+int	ft_versions_newer(const t_versions *v, size_t i)
+{
+	uint16_t	index;
+
+	return (version_of(v, i, &index) != NULL && (v->flags[index] & VERSION_NEWER));
+}
+
+/**
+ * Appends the version of a symbol to its name, as nm does: "name@@VERSION"
+ * for the default version of a defined symbol, "name@VERSION" for a hidden
+ * one, an undefined one or one versioned by a requirement (as a copy
+ * relocation is). The name is copied to the strings arena of the
+ * table; a symbol without a version keeps its name.
+ * @param	v		The version table.
+ * @param	i		The index of the symbol in its table.
+ * @param	shndx	The section index of the symbol.
+ * @param	entry	The entry whose name and name_len are updated.
+ * @return	0 on success, 1 on allocation failure.
+ */
+int	ft_versions_name(t_versions *v, size_t i, uint16_t shndx, t_symbol *entry)
+{
+	uint16_t	index;
+	const char	*version = version_of(v, i, &index);
+	int			hidden;
+	size_t		vlen;
+	char		*name;
+
+	if (version == NULL)
+		return (0);
+	hidden = (shndx == SHN_UNDEF) || (v->flags[index] & VERSION_NEEDED)
+		|| (ft_read_uint16((void *)&v->versym[i], v->endian) & VERSYM_HIDDEN);
+	vlen = ft_strlen(version);
+	name = ft_arena_alloc(v->strings, entry->name_len + vlen + 3);
+	if (name == NULL)
+		return (1);
+	ft_memcpy(name, entry->name, entry->name_len);
+	ft_memcpy(name + entry->name_len, "@@", 2 - hidden);
+	ft_memcpy(name + entry->name_len + 2 - hidden, version, vlen + 1);
+	entry->name = name;
+	entry->name_len += 2 - hidden + vlen;
+	return (0);
+}
+
+/**
+ * Releases the index to name table of a version table.
+ * @param	v	The version table.
+ */
+void	ft_versions_free(t_versions *v)
+{
+	ft_arena_drop(v->arena, v->names);
+	v->names = NULL;
+}
@@ -0,0 +1,327 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_walk.c                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:15:50 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 17:15:17 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#define WALK_MAX_WORKERS	8
+#define WALK_DENTS_SIZE		32768
+
+typedef struct s_dirent64
+{
+	uint64_t		d_ino;
+	int64_t			d_off;
+	unsigned short	d_reclen;
+	unsigned char	d_type;
+	char			d_name[];
+}	t_dirent64;
+
+typedef struct s_walk
+{
+	pthread_mutex_t	lock;
+	pthread_cond_t	cond;
+	char			**queue;
+	size_t			queued;
+	size_t			queue_cap;
+	size_t			busy;
+	int				failed;
+	t_pathlist		found;
+}	t_walk;
+
+/**
+ * Appends a path to a path list, growing it as needed.
+ * @param	list	The path list.
+ * @param	path	The path, owned by the list from now on.
+ * @return	0 on success, 1 if the list cannot grow.
+ */
+int	ft_pathlist_add(t_pathlist *list, char *path)
+{
+	char	**grown;
+
+	if (list->count == list->cap)
+	{
+		list->cap = list->cap ? list->cap * 2 : 64;
+		grown = malloc(sizeof(char *) * list->cap);
+		if (grown == NULL)
+			return (1);
+		ft_memcpy(grown, list->paths, sizeof(char *) * list->count);
+		free(list->paths);
+		list->paths = grown;
+	}
+	list->paths[list->count++] = path;
+	return (0);
+}
+
+/**
+ * Frees a path list and its paths.
+ * @param	list	The path list.
+ */
+void	ft_pathlist_free(t_pathlist *list)
+{
+	for (size_t i = 0; i < list->count; i++)
+		free(list->paths[i]);
+	free(list->paths);
+	ft_bzero(list, sizeof(t_pathlist));
+}
+
+/**
+ * Joins a directory path and an entry name with a '/'.
+ * @param	dir		The directory path.
+ * @param	name	The entry name.
+ * @return	The new path, or NULL if it cannot be allocated.
+ */
+static char	*join_path(const char *dir, const char *name)
+{
+	size_t	dlen = ft_strlen(dir);
+	size_t	nlen = ft_strlen(name);
+	char	*path = malloc(dlen + nlen + 2);
+
+	if (path == NULL)
+		return (NULL);
+	ft_memcpy(path, dir, dlen);
+	if (dlen == 0 || dir[dlen - 1] != '/')
+		path[dlen++] = '/';
+	ft_memcpy(path + dlen, name, nlen + 1);
+	return (path);
+}
+
+/**
+ * Reads the first 64 bytes of a directory entry and tells if it is an ELF
+ * object, so that other files never get mapped. Archives are not kept, ft_nm
+ * not reading them.
+ * @param	dirfd	The directory holding the entry.
+ * @param	name	The name of the entry.
+ * @return	1 for an ELF file, 0 for anything else.
+ */
+static int	sniff_object(int dirfd, const char *name)
+{
+	unsigned char	magic[64];
+	ssize_t			ret;
+	int				fd;
+
+	fd = openat(dirfd, name, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0)
+		return (0);
+	ret = pread(fd, magic, sizeof(magic), 0);
+	close(fd);
+	return (ret >= SELFMAG && ft_memcmp(magic, ELFMAG, SELFMAG) == 0);
+}
+
+/**
+ * Queues a directory for the workers.
+ * @param	walk	The shared walk state (locked by the caller).
+ * @param	path	The path of the directory, owned by the queue.
+ * @return	0 on success, 1 if the queue cannot grow.
+ */
+static int	push_dir(t_walk *walk, char *path)
+{
+	char	**grown;
+
+	if (walk->queued == walk->queue_cap)
+	{
+		walk->queue_cap = walk->queue_cap ? walk->queue_cap * 2 : 64;
+		grown = malloc(sizeof(char *) * walk->queue_cap);
+		if (grown == NULL)
+		{
+			free(path);
+			return (1);
+		}
+		ft_memcpy(grown, walk->queue, sizeof(char *) * walk->queued);
+		free(walk->queue);
+		walk->queue = grown;
+	}
+	walk->queue[walk->queued++] = path;
+	pthread_cond_signal(&walk->cond);
+	return (0);
+}
+
+/**
+ * Lists a directory with getdents64: subdirectories are queued, regular
+ * files are sniffed and kept if they are objects. Entries of unknown type
+ * are resolved with fstatat. Symbolic links are not followed.
+ * @param	walk	The shared walk state.
+ * @param	path	The path of the directory.
+ * @param	found	The worker-local list of objects found.
+ */
+static void	scan_dir(t_walk *walk, const char *path, t_pathlist *found)
+{
+	char		buf[WALK_DENTS_SIZE];
+	long		nread;
+	int			fd;
+
+	fd = openat(AT_FDCWD, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+	while ((nread = syscall(SYS_getdents64, fd, buf, sizeof(buf))) > 0)
+	{
+		for (long pos = 0; pos < nread;)
+		{
+			t_dirent64		*entry = (t_dirent64 *)(buf + pos);
+			unsigned char	type = entry->d_type;
+			struct stat		st;
+
+			pos += entry->d_reclen;
+			if (entry->d_name[0] == '.' && (entry->d_name[1] == '\0'
+				|| (entry->d_name[1] == '.' && entry->d_name[2] == '\0')))
+				continue;
+			if (type == DT_UNKNOWN && fstatat(fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0)
+				type = S_ISDIR(st.st_mode) ? DT_DIR : (S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN);
+			if (type == DT_DIR)
+			{
+				char	*sub = join_path(path, entry->d_name);
+
+				pthread_mutex_lock(&walk->lock);
+				if (sub == NULL || push_dir(walk, sub))
+					walk->failed = 1;
+				pthread_mutex_unlock(&walk->lock);
+			}
+			else if (type == DT_REG && sniff_object(fd, entry->d_name))
+			{
+				char	*file = join_path(path, entry->d_name);
+
+				if (file == NULL || ft_pathlist_add(found, file))
+				{
+					free(file);
+					pthread_mutex_lock(&walk->lock);
+					walk->failed = 1;
+					pthread_mutex_unlock(&walk->lock);
+				}
+			}
+		}
+	}
+	close(fd);
+}
+
+/**
+ * Worker loop: takes directories from the shared queue until it is empty and
+ * no other worker can queue more, then merges its findings.
+ * @param	arg	The shared walk state.
+ * @return	NULL.
+ */
+static void	*walk_worker(void *arg)
+{
+	t_walk		*walk = arg;
+	t_pathlist	found;
+	char		*path;
+
+	ft_bzero(&found, sizeof(found));
+	pthread_mutex_lock(&walk->lock);
+	while (1)
+	{
+		while (walk->queued == 0 && walk->busy > 0)
+			pthread_cond_wait(&walk->cond, &walk->lock);
+		if (walk->queued == 0)
+			break;
+		path = walk->queue[--walk->queued];
+		walk->busy++;
+		pthread_mutex_unlock(&walk->lock);
+		scan_dir(walk, path, &found);
+		free(path);
+		pthread_mutex_lock(&walk->lock);
+		walk->busy--;
+		if (walk->busy == 0 && walk->queued == 0)
+			pthread_cond_broadcast(&walk->cond);
+	}
+	for (size_t i = 0; i < found.count; i++)
+	{
+		if (ft_pathlist_add(&walk->found, found.paths[i]))
+		{
+			free(found.paths[i]);
+			walk->failed = 1;
+		}
+	}
+	pthread_mutex_unlock(&walk->lock);
+	free(found.paths);
+	return (NULL);
+}
+
+/**
+ * Compares two paths by their bytes, for qsort.
+ * @param	a	Pointer to the first path.
+ * @param	b	Pointer to the second path.
+ * @return	The byte order of the paths.
+ */
+static int	path_cmp(const void *a, const void *b)
+{
+	const char	*s1 = *(char * const *)a;
+	const char	*s2 = *(char * const *)b;
+
+	return (ft_strncmp(s1, s2, (size_t)-1));
+}
+
+/**
+ * Walks directory trees in parallel and lists the ELF files they contain,
+ * sorted by path so that the output does not depend on the scheduling of the
+ * workers. Files that are not objects are skipped without being mapped.
+ * @param	dirs	The roots of the walk.
+ * @param	ndirs	The number of roots.
+ * @param	out		The list the object paths are appended to.
+ * @return	0 on success, 1 if a root is not a directory or the walk ran out
+ * 			of memory.
+ */
+int	ft_walk_dirs(char **dirs, size_t ndirs, t_pathlist *out)
+{
+	t_walk		walk;
+	pthread_t	workers[WALK_MAX_WORKERS];
+	long		nworkers = sysconf(_SC_NPROCESSORS_ONLN);
+	long		started = 0;
+	int			ret = 0;
+	struct stat	st;
+
+	ft_bzero(&walk, sizeof(walk));
+	pthread_mutex_init(&walk.lock, NULL);
+	pthread_cond_init(&walk.cond, NULL);
+	for (size_t i = 0; i < ndirs; i++)
+	{
+		char	*root;
+
+		if (stat(dirs[i], &st) < 0 || !S_ISDIR(st.st_mode))
+		{
+			ft_printf("nm: '%s': No such directory\n", dirs[i]);
+			ret = 1;
+			continue;
+		}
+		root = ft_strdup(dirs[i]);
+		if (root == NULL || push_dir(&walk, root))
+			walk.failed = 1;
+	}
+	if (nworkers < 1)
+		nworkers = 1;
+	if (nworkers > WALK_MAX_WORKERS)
+		nworkers = WALK_MAX_WORKERS;
+	while (started < nworkers && pthread_create(&workers[started], NULL, walk_worker, &walk) == 0)
+		started++;
+	if (started == 0)
+		walk_worker(&walk);
+	for (long i = 0; i < started; i++)
+		pthread_join(workers[i], NULL);
+	for (size_t i = 0; i < walk.queued; i++)
+		free(walk.queue[i]);
+	free(walk.queue);
+	pthread_mutex_destroy(&walk.lock);
+	pthread_cond_destroy(&walk.cond);
+	qsort(walk.found.paths, walk.found.count, sizeof(char *), path_cmp);
+	for (size_t i = 0; i < walk.found.count; i++)
+	{
+		if (ft_pathlist_add(out, walk.found.paths[i]))
+		{
+			free(walk.found.paths[i]);
+			walk.failed = 1;
+		}
+	}
+	free(walk.found.paths);
+	if (walk.failed)
+		ft_printf("nm: out of memory while walking directories\n");
+	return (ret | walk.failed);
+}
@@ -0,0 +1,170 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_writer.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:03:47 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:00:40 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "includes/nm.h"
+
+/**
+ * Initializes a buffered writer on the given file descriptor.
+ * @param	w	The writer to initialize.
+ * @param	fd	The file descriptor the writer flushes to.
+ */
+void	ft_writer_init(t_writer *w, int fd)
+{
+	w->fd = fd;
+	w->len = 0;
+	w->mem = NULL;
+	w->mem_len = 0;
+	w->mem_cap = 0;
+	w->failed = 0;
+}
+
+/**
+ * Initializes a buffered writer that flushes into a growing memory block
+ * (mem, mem_len) instead of a file descriptor. If the block cannot grow, the
+ * bytes are dropped and failed is set.
+ * @param	w	The writer to initialize.
+ */
+void	ft_writer_init_memory(t_writer *w)
+{
+	ft_writer_init(w, -1);
+}
+
+/**
+ * Frees the memory block of a memory writer.
+ * @param	w	The writer.
+ */
+void	ft_writer_free_memory(t_writer *w)
+{
+	free(w->mem);
+	w->mem = NULL;
+	w->mem_len = 0;
+	w->mem_cap = 0;
+}
+
+/**
+ * Sends bytes to the destination of the writer: written to its file
+ * descriptor, retrying on partial writes, or appended to its memory block.
+ * @param	w	The writer.
+ * @param	s	The bytes to send.
+ * @param	n	The number of bytes to send.
+ */
+static void	sink(t_writer *w, const char *s, size_t n)
+{
+	ssize_t	ret;
+
+	if (w->fd < 0)
+	{
+		if (w->mem_len + n > w->mem_cap)
+		{
+			size_t	cap = w->mem_cap ? w->mem_cap : WRITER_SIZE;
+			char	*grown;
+
+			while (cap < w->mem_len + n)
+				cap *= 2;
+			grown = malloc(cap);
+			if (grown == NULL)
+			{
+				w->failed = 1;
+				return;
+			}
+			ft_memcpy(grown, w->mem, w->mem_len);
+			free(w->mem);
+			w->mem = grown;
+			w->mem_cap = cap;
+		}
+		ft_memcpy(w->mem + w->mem_len, s, n);
+		w->mem_len += n;
+		return;
+	}
+	while (n > 0)
+	{
+		ret = write(w->fd, s, n);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return;
+		s += ret;
+		n -= ret;
+	}
+}
+
+/**
+ * Sends the pending content of the buffer to the destination of the writer.
+ * @param	w	The writer to flush.
+ */
+void	ft_writer_flush(t_writer *w)
+{
+	sink(w, w->buf, w->len);
+	w->len = 0;
+}
+
+/**
+ * Appends n bytes to the writer. Chunks bigger than the buffer bypass it and
+ * are sent directly once the pending content is flushed.
+ * @param	w	The writer.
+ * @param	s	The bytes to append.
+ * @param	n	The number of bytes to append.
+ */
+void	ft_writer_put(t_writer *w, const char *s, size_t n)
+{
+	if (n > WRITER_SIZE - w->len)
+	{
+		ft_writer_flush(w);
+		if (n > WRITER_SIZE)
+		{
+			sink(w, s, n);
+			return;
+		}
+	}
+	ft_memcpy(w->buf + w->len, s, n);
+	w->len += n;
+}
+
+/**
+ * Appends a single character to the writer.
+ * @param	w	The writer.
+ * @param	c	The character to append.
+ */
+void	ft_writer_putc(t_writer *w, char c)
+{
+	if (w->len == WRITER_SIZE)
+		ft_writer_flush(w);
+	w->buf[w->len++] = c;
+}
+
+/**
+ * Appends a NUL-terminated string to the writer.
+ * @param	w	The writer.
+ * @param	s	The string to append.
+ */
+void	ft_writer_putstr(t_writer *w, const char *s)
+{
+	ft_writer_put(w, s, ft_strlen(s));
+}
+
+/**
+ * Appends the decimal representation of an unsigned number to the writer.
+ * @param	w	The writer.
+ * @param	n	The number to append.
+ */
+void	ft_writer_putnbr(t_writer *w, uint64_t n)
+{
+	char	buf[20];
+	int		i = sizeof(buf);
+
+	do
+	{
+		buf[--i] = '0' + (n % 10);
+		n /= 10;
+	} while (n);
+	ft_writer_put(w, buf + i, sizeof(buf) - i);
+}
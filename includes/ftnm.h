@@ -0,0 +1,160 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ftnm.h                                             :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/19 17:22:44 by jbertin           #+#    #+#             */
+/*   Updated: 2026/10/19 19:50:07 by jbertin          ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FTNM_H
+# define FTNM_H
+
+# include <stddef.h>
+# include <stdint.h>
+
+# define FTNM_OK				0
+# define FTNM_ERR_NOENT			1
+# define FTNM_ERR_OPEN			2
+# define FTNM_ERR_STAT			3
+# define FTNM_ERR_MAP			4
+# define FTNM_ERR_READ			5
+# define FTNM_ERR_FORMAT		6
+# define FTNM_ERR_TRUNCATED		7
+# define FTNM_ERR_CORRUPT		8
+# define FTNM_ERR_NO_SYMBOLS	9
+# define FTNM_ERR_MEMORY		10
+# define FTNM_ERR_PATTERN		11
+# define FTNM_ERR_TEMP			12
+# define FTNM_ERR_BUSY			13
+
+# define FTNM_FILTER_UNDEFINED	1
+# define FTNM_FILTER_DEFINED	2
+# define FTNM_FILTER_EXTERNAL	4
+
+# define FTNM_COLLATE_COMPAT	0
+# define FTNM_COLLATE_C			1
+# define FTNM_COLLATE_LOCALE	2
+
+typedef struct s_ftnm			t_ftnm;
+typedef struct s_matcher		t_ftnm_matcher;
+typedef struct s_input_pool		t_ftnm_pool;
+typedef struct s_summary		t_ftnm_summary;
+typedef struct s_arena			t_ftnm_arena;
+
+/*
+ * Options of a handle. A zeroed configuration lists every named symbol of
+ * the symbol table (.symtab), or of the dynamic symbol table (.dynsym) if
+ * dynamic is set. The matcher, pool, summary and arena are made with their
+ * ftnm_*_new functions. The matcher, if any, keeps only the symbols matching
+ * one of its patterns; the pool, if any, lets handles opened one after the
+ * other reuse the same read buffers, and the arena, if any, holds every
+ * allocation of a handle, released at once when it is closed (handles
+ * sharing a pool must be opened one after the other; an arena serves one
+ * open handle at a time, opening another on it failing with FTNM_ERR_BUSY
+ * until the first is closed, and is not used with max_memory). With a summary, the handle collects no
+ * symbol: the symbols kept are only counted there, in a single pass, and
+ * read back with ftnm_summary_get. With a max_memory
+ * budget (in bytes), the pages of the input are dropped as the symbol table
+ * is read, and symbol tables whose sort would take more are sorted in runs
+ * spilled to a temporary file, then merged while they are iterated.
+ * With symbol_versions, the names of symbols versioned by .gnu.version get
+ * their version appended ("name@@VERSION" or "name@VERSION"); with a
+ * newer_than version (as "GLIBC_2.17"), only the symbols whose version has
+ * the same prefix and is newer are kept. With line_numbers, every symbol
+ * gets the source file and line its DWARF debug information tells (the file
+ * is NULL when none is known). The collation is the name order of ftnm_sort:
+ * FTNM_COLLATE_COMPAT (the default) follows GNU nm under en_US.UTF-8,
+ * FTNM_COLLATE_C compares the bytes of the names, and FTNM_COLLATE_LOCALE
+ * follows strcoll in the LC_COLLATE locale the caller has set.
+ */
+typedef struct s_ftnm_config
+{
+	int						filter;
+	int						debug_syms;
+	int						populate;
+	int						dynamic;
+	const t_ftnm_matcher	*matcher;
+	t_ftnm_pool				*pool;
+	t_ftnm_summary			*summary;
+	size_t					max_memory;
+	t_ftnm_arena			*arena;
+	int						symbol_versions;
+	const char				*newer_than;
+	int						line_numbers;
+	int						collation;
+}	t_ftnm_config;
+
+/*
+ * A symbol as seen through the API. The name is a span of the input, not
+ * NUL-terminated, valid until the handle is closed, as is the source file of
+ * -l (NULL, with a line of 0, when unknown or not asked for).
+ */
+typedef struct s_ftnm_symbol
+{
+	const char				*name;
+	size_t					name_len;
+	uint64_t				value;
+	uint64_t				size;
+	char					type;
+	const char				*section;
+	const char				*file;
+	unsigned int			line;
+}	t_ftnm_symbol;
+
+/*
+ * The counts of a summary, for the last file opened with it: symbols by type
+ * letter, binding (STB_*) and visibility (STV_*), and by section, with the
+ * total st_size of each. The sections are those of the file, then "*ABS*",
+ * "*COM*" and "*OTHER*"; the arrays stay valid until the summary is used
+ * again or freed, and the section names until the handle is closed.
+ */
+typedef struct s_ftnm_counts
+{
+	uint64_t				symbols;
+	uint64_t				undefined;
+	uint64_t				types[256];
+	uint64_t				bindings[16];
+	uint64_t				visibility[4];
+	size_t					nsections;
+	const char *const		*section_names;
+	const uint64_t			*section_counts;
+	const uint64_t			*section_sizes;
+}	t_ftnm_counts;
+
+typedef struct s_ftnm_iter
+{
+	const t_ftnm			*handle;
+	size_t					pos;
+}	t_ftnm_iter;
+
+# pragma GCC visibility push(default)
+
+int				ftnm_open_path(t_ftnm **handle, const char *path, const t_ftnm_config *config);
+int				ftnm_open_fd(t_ftnm **handle, int fd, const t_ftnm_config *config);
+int				ftnm_open_memory(t_ftnm **handle, const void *data, size_t size, const t_ftnm_config *config);
+int				ftnm_sort(t_ftnm *handle);
+int				ftnm_class(const t_ftnm *handle);
+size_t			ftnm_count(const t_ftnm *handle);
+void			ftnm_iter_init(t_ftnm_iter *iter, const t_ftnm *handle);
+int				ftnm_iter_next(t_ftnm_iter *iter, t_ftnm_symbol *symbol);
+void			ftnm_io_counters(const t_ftnm *handle, uint64_t *mapped, uint64_t *read);
+void			ftnm_close(t_ftnm *handle);
+const char		*ftnm_strerror(int code);
+
+int				ftnm_matcher_new(t_ftnm_matcher **matcher, const char *const *patterns, size_t count);
+void			ftnm_matcher_free(t_ftnm_matcher *matcher);
+int				ftnm_pool_new(t_ftnm_pool **pool);
+void			ftnm_pool_free(t_ftnm_pool *pool);
+int				ftnm_summary_new(t_ftnm_summary **summary);
+void			ftnm_summary_get(const t_ftnm_summary *summary, t_ftnm_counts *counts);
+void			ftnm_summary_free(t_ftnm_summary *summary);
+int				ftnm_arena_new(t_ftnm_arena **arena);
+void			ftnm_arena_free(t_ftnm_arena *arena);
+
+# pragma GCC visibility pop
+
+#endif
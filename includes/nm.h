@@ -6,7 +6,7 @@
 /*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
 /*                                                +#+#+#+#+#+   +#+           */
 /*   Created: 2023/08/09 13:55:48 by jbertin           #+#    #+#             */
-/*   Updated: 2023/08/09 15:26:57 by jbertin          ###   ########.fr       */
+/*   Updated: 2026/10/19 19:50:07 by jbertin          ###   ########.fr       */
 /*                                                                            */
 /* ************************************************************************** */
 
@@ -14,6 +14,8 @@
 # define NM_H
 
 # include "libft.h"
+# include "ftnm.h"
+# include "ft_dwarf.h"
 # include <elf.h>
 # include <fcntl.h>
 # include <sys/mman.h>
@@ -21,32 +23,826 @@
 # include <unistd.h>
 # include <errno.h>
 # include <limits.h>
+# include <locale.h>
+# include <string.h>
+# include <pthread.h>
+# include <time.h>
+
+# define FORMAT_BSD		0
+# define FORMAT_JSON	1
+# define FORMAT_NDJSON	2
+
+# define WRITER_SIZE	65536
+# define COLLATE_SLACK	32
+# define COLLATE_LOCALE_RATIO	4
+# define COLLATE_LOCALE_EXTRA	8
+# define COLLATE_RADIX_MIN		32
+# define COLLATE_RADIX_LEVELS	32
+# define CLASSIFY_BLOCK	64
+
+# define PREFETCH_DEPTH		8
+# define PREFETCH_EDGE		(256UL * 1024)
+# define PREFETCH_BATCH		32
+# define PREFETCH_READ_MAX	(256UL * 1024)
+# define ARGS_MAX_DEPTH		16
+
+# define ARENA_MIN			(64UL * 1024)
+# define ARENA_ALIGN		16
+
+# define VERSYM_HIDDEN		0x8000
+# define VERSYM_INDEX		0x7fff
+# define VERSION_NEEDED		1
+# define VERSION_NEWER		2
+
+# define DWARF_NUM			0
+# define DWARF_STR			1
+# define DWARF_STRX			2
+# define DWARF_BLOCK		3
+# define DWARF_REF			4
+# define DWARF_ADDR			5
+# define DWARF_ADDRX		6
+# define DWARF_LISTX		7
+# define DWARF_FILES		1
+# define DWARF_ROWS			2
+# define DWARF_COVERED		4
+# define DWARF_RANGES		1
+# define DWARF_DECLS		2
+# define DWARF_UNDEFINED	4
+# define DWARF_SYMBOLS		8
+# define DWARF_DIE_NAME			0
+# define DWARF_DIE_LINKAGE		1
+# define DWARF_DIE_FILE			2
+# define DWARF_DIE_LINE			3
+# define DWARF_DIE_LOW_PC		4
+# define DWARF_DIE_LOCATION		5
+# define DWARF_DIE_ORIGIN		6
+# define DWARF_DIE_STMT_LIST	7
+# define DWARF_DIE_COMP_DIR		8
+# define DWARF_DIE_STR_OFFSETS	9
+# define DWARF_DIE_ADDR_BASE	10
+# define DWARF_DIE_HIGH_PC		11
+# define DWARF_DIE_EXTERNAL		12
+# define DWARF_DIE_RANGES		13
+# define DWARF_DIE_RNGLISTS		14
+# define DWARF_DIE_SLOTS		15
+
+# define SPILL_MIN_BUDGET	(1UL * 1024 * 1024)
+# define SPILL_RESERVE		(256UL * 1024)
+# define SPILL_MIN_BUFFER	(16UL * 1024)
+
+# define ADDR_BATCH			65536
+# define ADDR_MERGE_MIN		1024
+# define ADDR_MERGE_RATIO	16
+# define ADDR_READ_SIZE		65536
+# define ADDR_TOKEN_MAX		18
+
+# define DEDUP_NONE			SIZE_MAX
+# define DEDUP_PRIME0		0x9e3779b97f4a7c15ULL
+# define DEDUP_PRIME1		0xc2b2ae3d27d4eb4fULL
+
+# define SERVE_WORKERS		4
+# define SERVE_BUCKETS		1024
+# define SERVE_CACHE_MAX		64
+# define SERVE_MAX_REQUEST	(1U << 20)
+# define SERVE_MAX_CLIENTS	1024
+# define SERVE_IO_TIMEOUT	5
+
+# define INPUT_MMAP			0
+# define INPUT_MMAP_RANGES	1
+# define INPUT_PREAD		2
+# define INPUT_MEMORY		3
+# define INPUT_HEADER		64
+# define INPUT_RANGES_MIN	8
+# define INPUT_WHOLE_MAX	(1UL * 1024 * 1024)
+
+# define INPUT_POPULATE		1
+
+# define INPUT_ERR_STAT		1
+# define INPUT_ERR_MAP		2
+# define INPUT_ERR_SPOOL	3
+# define INPUT_ERR_READ		4
+# define INPUT_ERR_EMPTY	5
+
+typedef struct s_section
+{
+	uint32_t			name;
+	uint32_t			type;
+	uint64_t			flags;
+	uint64_t			offset;
+	uint64_t			size;
+	uint32_t			link;
+	uint32_t			info;
+	uint64_t			addralign;
+	uint64_t			entsize;
+}	t_section;
+
+typedef struct s_line_row
+{
+	uint64_t			addr;
+	const char			*file;
+	uint32_t			line;
+	uint16_t			shndx;
+	uint16_t			end;
+}	t_line_row;
 
 typedef struct s_symbol
 {
-	char				*name;
+	const char			*name;
+	size_t				name_len;
+	const char			*key;
+	uint32_t			key_len;
 	unsigned char		type;
-	char				*value;
-	struct s_symbol*	next;
+	uint64_t			value;
+	uint64_t			size;
+	const char			*section;
+	const t_line_row	*line;
 }	t_symbol;
 
+typedef struct s_arena
+{
+	char					*base;
+	size_t					size;
+	size_t					used;
+	struct s_arena_block	*retired;
+	size_t					retired_used;
+	size_t					next_size;
+	int						busy;
+}	t_arena;
+
+typedef struct s_spill
+{
+	size_t					limit;
+	size_t					cap;
+	size_t					fan_in;
+	size_t					bytes;
+	size_t					seen;
+	int						fd;
+	int						collation;
+	uint64_t				*bounds;
+	size_t					nbounds;
+	size_t					bounds_cap;
+	uint64_t				total;
+	struct s_spill_cursor	*cursors;
+	size_t					ncursors;
+	struct s_spill_cursor	**heap;
+	size_t					nheap;
+	struct s_spill_cursor	*pending;
+}	t_spill;
+
+typedef struct s_strtab
+{
+	const char			*data;
+	size_t				size;
+	uint64_t			*nul_bits;
+	t_arena				*arena;
+}	t_strtab;
+
+typedef struct s_summary
+{
+	uint64_t			symbols;
+	uint64_t			undefined;
+	uint64_t			types[256];
+	uint64_t			bindings[16];
+	uint64_t			visibility[4];
+	uint64_t			*counts;
+	uint64_t			*sizes;
+	const char			**names;
+	size_t				nslots;
+	size_t				cap;
+}	t_summary;
+
+typedef struct s_classifier
+{
+	uint8_t				*sec_class;
+	size_t				shnum;
+	const unsigned char	(*letters)[4][3];
+	t_arena				*arena;
+}	t_classifier;
+
+typedef struct s_versions
+{
+	const uint16_t		*versym;
+	const char			**names;
+	unsigned char		*flags;
+	size_t				count;
+	t_arena				*arena;
+	t_arena				*strings;
+	int					endian;
+}	t_versions;
+
+typedef struct s_dwarf_cursor
+{
+	const unsigned char	*base;
+	const unsigned char	*pos;
+	const unsigned char	*end;
+	int					endian;
+	int					bad;
+}	t_dwarf_cursor;
+
+typedef struct s_dwarf_site
+{
+	uint64_t			offset;
+	uint16_t			shndx;
+}	t_dwarf_site;
+
+typedef struct s_dwarf_section
+{
+	const unsigned char	*data;
+	size_t				size;
+	t_dwarf_site		*sites;
+	size_t				nsites;
+}	t_dwarf_section;
+
+typedef struct s_dwarf_value
+{
+	uint64_t			num;
+	const char			*str;
+	const unsigned char	*block;
+	size_t				len;
+	uint16_t			shndx;
+	int					kind;
+}	t_dwarf_value;
+
+typedef struct s_dwarf_abbrev
+{
+	uint64_t			tag;
+	uint64_t			specs;
+	uint8_t				children;
+}	t_dwarf_abbrev;
+
+typedef struct s_dwarf_die
+{
+	uint64_t			tag;
+	uint64_t			next;
+	uint32_t			present;
+	t_dwarf_value		attrs[DWARF_DIE_SLOTS];
+}	t_dwarf_die;
+
+typedef struct s_dwarf_decl
+{
+	t_line_row			loc;
+	uint64_t			hi;
+	uint64_t			reach;
+	const char			*name;
+	uint32_t			order;
+	uint8_t				func;
+}	t_dwarf_decl;
+
+typedef struct s_dwarf_symbol
+{
+	uint64_t			value;
+	uint64_t			size;
+	const char			*name;
+	const char			*file;
+	uint32_t			index;
+	uint16_t			shndx;
+	uint8_t				func;
+	uint8_t				global;
+}	t_dwarf_symbol;
+
+typedef struct s_dwarf_unit
+{
+	uint64_t			offset;
+	uint64_t			end;
+	uint64_t			die;
+	uint64_t			abbrev;
+	uint64_t			stmt_list;
+	uint64_t			str_offsets_base;
+	uint64_t			addr_base;
+	uint64_t			rnglists_base;
+	uint64_t			low_pc;
+	uint16_t			low_shndx;
+	const char			*comp_dir;
+	uint16_t			version;
+	uint8_t				offset_size;
+	uint8_t				addr_size;
+	uint8_t				has_lines;
+	uint8_t				state;
+	const char			**files;
+	size_t				nfiles;
+	t_line_row			*rows;
+	size_t				nrows;
+}	t_dwarf_unit;
+
+typedef struct s_dwarf_range
+{
+	uint64_t			lo;
+	uint64_t			hi;
+	uint64_t			reach;
+	uint32_t			unit;
+	uint16_t			shndx;
+}	t_dwarf_range;
+
+typedef struct s_dwarf
+{
+	t_arena				own;
+	t_arena				*arena;
+	const unsigned char	*image;
+	uint64_t			image_size;
+	void				*shdrs;
+	size_t				shnum;
+	const char			*shstrtab;
+	const void			*symtab;
+	size_t				nsyms;
+	size_t				symtab_index;
+	int					is_64;
+	int					machine;
+	int					endian;
+	int					rel;
+	int					state;
+	int					failed;
+	t_dwarf_section		info;
+	t_dwarf_section		abbrev;
+	t_dwarf_section		line;
+	t_dwarf_section		line_str;
+	t_dwarf_section		str;
+	t_dwarf_section		str_offsets;
+	t_dwarf_section		addr;
+	t_dwarf_section		aranges;
+	t_dwarf_section		rangelists;
+	t_dwarf_section		rnglists;
+	t_dwarf_unit		*units;
+	size_t				nunits;
+	t_dwarf_range		*ranges;
+	size_t				nranges;
+	t_dwarf_decl		*decls;
+	size_t				ndecls;
+	const t_line_row	**undefined;
+	uint64_t			*vmas;
+	t_dwarf_range		*places;
+	size_t				nplaces;
+	t_dwarf_symbol		*aliases;
+	size_t				naliases;
+	t_dwarf_symbol		*funcs;
+	size_t				nfuncs;
+}	t_dwarf;
+
+typedef struct s_writer
+{
+	int					fd;
+	size_t				len;
+	char				*mem;
+	size_t				mem_len;
+	size_t				mem_cap;
+	int					failed;
+	char				buf[WRITER_SIZE];
+}	t_writer;
+
+typedef struct s_pooled
+{
+	void				*buf;
+	size_t				cap;
+}	t_pooled;
+
+typedef struct s_input_pool
+{
+	t_pooled			*bufs;
+	size_t				count;
+	size_t				used;
+}	t_input_pool;
+
+typedef struct s_mapping
+{
+	void				*addr;
+	size_t				len;
+}	t_mapping;
+
+typedef struct s_input
+{
+	int					fd;
+	int					owned_fd;
+	int					mode;
+	int					flags;
+	uint64_t			size;
+	void				*map;
+	t_mapping			*maps;
+	size_t				nmaps;
+	size_t				maps_cap;
+	uint64_t			mapped;
+	uint64_t			read;
+	uint64_t			syscalls;
+	unsigned char		header[INPUT_HEADER];
+	t_input_pool		*pool;
+}	t_input;
+
+typedef struct s_stats
+{
+	size_t				files;
+	long				minflt;
+	long				majflt;
+	uint64_t			mapped;
+	uint64_t			read;
+	uint64_t			syscalls;
+	uint64_t			allocs;
+	long				file_minflt;
+	long				file_majflt;
+	uint64_t			file_allocs;
+	struct timespec		start;
+	const char			*backend;
+}	t_stats;
+
+typedef struct s_globword
+{
+	uint64_t			masks[256];
+	uint64_t			starts;
+	uint64_t			loops;
+	uint64_t			accepts;
+	int					used;
+	int					guarded;
+}	t_globword;
+
+typedef struct s_matcher
+{
+	int					active;
+	char				*lits;
+	size_t				lits_len;
+	size_t				lits_cap;
+	size_t				*lit_lens;
+	size_t				nlits;
+	size_t				lit_lens_cap;
+	int32_t				*lit_words;
+	size_t				lit_words_cap;
+	int32_t				*next;
+	uint8_t				*final;
+	int32_t				*guards;
+	int32_t				*guard_link;
+	int32_t				*guard_word;
+	int32_t				*guard_next;
+	uint8_t				classes[256];
+	size_t				nclasses;
+	size_t				nstates;
+	t_globword			*globs;
+	size_t				nglobs;
+	size_t				globs_cap;
+	size_t				last_free;
+	size_t				last_guarded;
+}	t_matcher;
+
+typedef struct s_options
+{
+	int					format;
+	int					multiple_files;
+	t_ftnm_config		config;
+	int					stats;
+	char				**dirs;
+	size_t				ndirs;
+	char				**patterns;
+	size_t				npatterns;
+	char				**pattern_files;
+	size_t				npattern_files;
+	char				**files_from;
+	size_t				nfiles_from;
+	char				*serve;
+	int					uring;
+	int					diff;
+	int					summary;
+	char				*addr2sym;
+	int					counts;
+	int					dedup_content;
+	char				*output;
+}	t_options;
+
+typedef struct s_elf
+{
+	t_input				*in;
+	const t_ftnm_config	*config;
+	t_arena				*arena;
+	void				*shdrs;
+	size_t				shnum;
+	const char			*shstrtab;
+	size_t				shstrtab_size;
+	void				*symtab;
+	size_t				nsyms;
+	const char			*strtab;
+	size_t				strtab_size;
+	t_versions			versions;
+	t_dwarf				*dwarf;
+	int					endian;
+}	t_elf;
+
+struct s_ftnm
+{
+	t_input				in;
+	t_input_pool		own_pool;
+	int					fd;
+	int					bits;
+	t_symbol			*symbols;
+	size_t				count;
+	int					sorted;
+	int					collation;
+	t_spill				*spill;
+	t_arena				*arena;
+	t_arena				names;
+	t_dwarf				*dwarf;
+};
+
+typedef struct s_cache_entry
+{
+	char					*path;
+	dev_t					dev;
+	ino_t					ino;
+	struct timespec			mtime;
+	off_t					size;
+	t_ftnm					*handle;
+	const t_symbol			**by_name;
+	int						refs;
+	struct s_cache_entry	*next;
+	struct s_cache_entry	*newer;
+	struct s_cache_entry	*older;
+}	t_cache_entry;
+
+typedef struct s_server
+{
+	int					listen_fd;
+	pthread_mutex_t		lock;
+	t_cache_entry		*buckets[SERVE_BUCKETS];
+	t_cache_entry		*newest;
+	t_cache_entry		*oldest;
+	size_t				cached;
+	t_ftnm_config		config;
+	t_options			opts;
+	int					wake[2];
+	pthread_mutex_t		queue_lock;
+	pthread_cond_t		queue_ready;
+	int					queue[SERVE_MAX_CLIENTS];
+	size_t				queue_head;
+	size_t				queued;
+	int					stopping;
+}	t_server;
+
+typedef struct s_pathlist
+{
+	char				**paths;
+	size_t				count;
+	size_t				cap;
+}	t_pathlist;
+
+typedef struct s_fetched
+{
+	int					fd;
+	int					err;
+	void				*data;
+	size_t				size;
+	uint64_t			syscalls;
+}	t_fetched;
+
+typedef struct s_prefetch
+{
+	char				**paths;
+	size_t				count;
+	size_t				taken;
+	size_t				opened;
+	t_fetched			files[PREFETCH_BATCH];
+	t_fetched			current;
+	void				*bufs[PREFETCH_BATCH];
+	size_t				caps[PREFETCH_BATCH];
+	struct s_uring		*ring;
+	uint64_t			syscalls;
+}	t_prefetch;
+
+/*
+ * An input of the run for deduplication: its identity as stat tells it, the
+ * previous inputs sharing its inode and its size, the last input that may
+ * reuse its listing, and that listing once kept.
+ */
+typedef struct s_dedup_file
+{
+	dev_t				dev;
+	ino_t				ino;
+	off_t				size;
+	int					known;
+	size_t				prev_inode;
+	size_t				prev_size;
+	size_t				last;
+	int					hashed;
+	uint64_t			hash[2];
+	int					kept;
+	char				*body;
+	size_t				body_len;
+}	t_dedup_file;
+
+typedef struct s_dedup
+{
+	t_dedup_file		*files;
+	char				**inputs;
+	size_t				count;
+	int					content;
+}	t_dedup;
+
+typedef struct s_nm
+{
+	t_options			opts;
+	t_writer			out;
+	t_input_pool		pool;
+	t_stats				stats;
+	t_matcher			matcher;
+	t_summary			summary;
+	t_arena				arena;
+	t_dedup				dedup;
+	int					out_fd;
+	size_t				json_count;
+}	t_nm;
+
 /* FT_TOOLS */
 uint32_t		ft_read_uint32(void *pos, int endian);
 uint16_t		ft_read_uint16(void *pos, int endian);
-char			*ft_st_value_to_string(unsigned long long value, int size);
+void			ft_section_header(const void *shdrs, size_t index, int is_64, t_section *sec);
+void			ft_st_value_to_string(char *dst, unsigned long long value, int size);
 int				ft_strncasecmp(const char *s1, const char *s2, size_t n);
 
 /* FT_STRUCT_TOOLS */
-t_symbol		*ft_add_symbol_to_list(t_symbol *list, char *name, unsigned char type, char *value);
-void			ft_sort_symbols_by_name(t_symbol *list);
-void			ft_print_symbols_list(t_symbol *list, int type, char *filename, int multiple_files);
-void			ft_free_symbols_list(t_symbol *list);
+int				ft_symbol_is_hidden(const t_ftnm_symbol *symbol, const t_options *opts);
+void			ft_print_file_header(char *filename, t_nm *nm);
+void			ft_print_symbols(const t_ftnm *handle, t_writer *out, const t_options *opts);
+void			ft_print_symbols_list(const t_ftnm *handle, char *filename, t_nm *nm);
+void			ft_print_summary(char *filename, t_nm *nm);
+
+/* FT_FORMAT */
+const char		*ft_format_value(char *buf, const t_ftnm_symbol *symbol, int bits, const t_options *opts);
+size_t			ft_format_line_length(const char *value, const t_ftnm_symbol *symbol);
+char			*ft_format_line(char *dst, const char *value, const t_ftnm_symbol *symbol);
+int				ft_format_parallel(const t_ftnm *handle, t_writer *out, const t_options *opts);
+
+/* FT_STRTAB */
+int				ft_cpu_has_sse2(void);
+int				ft_cpu_has_avx2(void);
+int				ft_strtab_init(t_strtab *st, const char *data, size_t size, t_arena *arena);
+void			ft_strtab_init_unscanned(t_strtab *st, const char *data, size_t size);
+void			ft_strtab_free(t_strtab *st);
+long			ft_strtab_name_len(t_strtab *st, size_t offset);
+
+/* FT_COLLATE */
+size_t			ft_collate_key_scalar(char *dst, const char *src, size_t len);
+# if defined(__x86_64__) || defined(__i386__)
+size_t			ft_collate_key_sse2(char *dst, const char *src, size_t len);
+size_t			ft_collate_key_avx2(char *dst, const char *src, size_t len);
+# endif
+char			*ft_collate_build_keys(t_symbol *list, size_t count, t_arena *arena);
+char			*ft_collate_build_locale_keys(t_symbol *list, size_t count, t_arena *arena);
+int				ft_sort_symbols_by_name(t_symbol *list, size_t count, int collation, t_arena *arena);
+int				ft_collate_cmp_names(const t_symbol *a, const t_symbol *b);
+int				ft_sort_symbols_for_join(t_symbol *list, size_t count, char **keys);
+int				ft_sort_symbols_with_keys(t_symbol *list, size_t count, int collation, char **keys);
+int				ft_collate_after(const t_symbol *a, const t_symbol *b, int collation);
+
+/* FT_ARENA */
+void			*ft_heap_alloc(size_t size);
+void			*ft_heap_calloc(size_t count, size_t size);
+uint64_t		ft_heap_allocs(void);
+void			*ft_arena_alloc(t_arena *arena, size_t size);
+void			ft_arena_drop(t_arena *arena, void *ptr);
+void			ft_arena_reset(t_arena *arena);
+void			ft_arena_free(t_arena *arena);
+
+/* FT_SPILL */
+void			ft_spill_init(t_spill *spill, size_t budget, int collation);
+size_t			ft_spill_capacity(const t_spill *spill, size_t nsyms);
+int				ft_spill_full(t_spill *spill, const t_symbol *symbols, size_t count);
+int				ft_spill_chunk(t_spill *spill, t_symbol *symbols, size_t *count);
+int				ft_spill_finish(t_spill *spill, t_symbol **symbols, size_t *count);
+void			ft_spill_rewind(t_spill *spill);
+int				ft_spill_next(t_spill *spill, t_ftnm_symbol *symbol);
+void			ft_spill_free(t_spill *spill);
+
+/* FT_CLASSIFY */
+int				ft_classify_init(t_classifier *c, void *shdrs, size_t shnum, int is_64, t_arena *arena);
+void			ft_classify_free(t_classifier *c);
+void			ft_classify_block64(t_classifier *c, Elf64_Sym *syms, size_t n, int endian, unsigned char *letters);
+void			ft_classify_block32(t_classifier *c, Elf32_Sym *syms, size_t n, int endian, unsigned char *letters);
+
+/* FT_VERSION */
+int				ft_versions_init(t_versions *v, t_elf *elf, int is_64, size_t symtab, t_arena *strings);
+int				ft_versions_newer(const t_versions *v, size_t i);
+int				ft_versions_name(t_versions *v, size_t i, uint16_t shndx, t_symbol *entry);
+void			ft_versions_free(t_versions *v);
+int				ft_version_newer(const char *a, const char *b);
+
+/* FT_DWARF */
+int				ft_dwarf_init(t_dwarf *d, t_elf *elf, int is_64, size_t symtab, t_arena *arena);
+const t_line_row	*ft_dwarf_symbol(t_dwarf *d, uint16_t shndx, uint64_t addr, const t_symbol *entry, int func);
+const t_line_row	*ft_dwarf_undefined(t_dwarf *d, size_t index);
+const t_line_row	*ft_dwarf_address(t_dwarf *d, uint16_t shndx, uint64_t addr);
+const t_line_row	*ft_dwarf_nearest(t_dwarf *d, uint16_t shndx, uint64_t offset);
+void			ft_dwarf_free(t_dwarf *d);
+int				ft_dwarf_grow(void **table, size_t count, size_t size);
+int				ft_dwarf_relocate(t_dwarf *d, size_t index, t_dwarf_section *slot);
+void			ft_dwarf_read_symbol(const t_dwarf *d, const t_dwarf_section *syms, uint64_t index, Elf64_Sym *sym);
+const t_line_row	*ft_dwarf_elf_function(t_dwarf *d, uint16_t shndx, uint64_t offset);
+const t_dwarf_symbol	*ft_dwarf_alias(t_dwarf *d, uint16_t shndx, uint64_t value);
+const t_line_row	*ft_dwarf_decl(t_dwarf *d, uint16_t shndx, uint64_t addr, const char *name, size_t name_len,
+					int func);
+int				ft_dwarf_scan_decls(t_dwarf *d);
+t_dwarf_abbrev	*ft_dwarf_abbrevs(const t_dwarf *d, uint64_t offset, size_t *count);
+int				ft_dwarf_die(const t_dwarf *d, const t_dwarf_unit *u, const t_dwarf_abbrev *abbrevs, size_t count,
+					uint64_t offset, t_dwarf_die *die);
+const char		*ft_dwarf_value_string(const t_dwarf *d, const t_dwarf_unit *u, const t_dwarf_value *v);
+int				ft_dwarf_unit_files(t_dwarf *d, t_dwarf_unit *u);
+int				ft_dwarf_unit_rows(t_dwarf *d, t_dwarf_unit *u);
+void			ft_dwarf_cursor(t_dwarf_cursor *c, const t_dwarf_section *sec, uint64_t offset, uint64_t end,
+					int endian);
+uint64_t		ft_dwarf_fixed(t_dwarf_cursor *c, int size);
+uint64_t		ft_dwarf_uleb(t_dwarf_cursor *c);
+int64_t			ft_dwarf_sleb(t_dwarf_cursor *c);
+const char		*ft_dwarf_cstr(t_dwarf_cursor *c);
+uint64_t		ft_dwarf_length(t_dwarf_cursor *c, int *offset_size);
+const unsigned char	*ft_dwarf_image(const t_dwarf *d, uint64_t offset, uint64_t size);
+const char		*ft_dwarf_string(const t_dwarf_section *sec, uint64_t offset);
+uint16_t		ft_dwarf_site(const t_dwarf_section *sec, uint64_t offset);
+const char		*ft_dwarf_strx(const t_dwarf *d, const t_dwarf_unit *u, uint64_t index);
+uint64_t		ft_dwarf_addrx(const t_dwarf *d, const t_dwarf_unit *u, uint64_t index, uint16_t *shndx);
+int				ft_dwarf_form(const t_dwarf *d, const t_dwarf_unit *u, t_dwarf_cursor *c, uint64_t form,
+					int64_t implicit, t_dwarf_value *v);
+
+/* FT_FILTER */
+int				ft_filter_keep(const t_ftnm_config *config, uint32_t st_name, unsigned char st_info, uint16_t shndx);
+
+/* FT_MATCH */
+int				ft_matcher_add(t_matcher *m, const char *pattern, size_t len);
+int				ft_matcher_load(t_matcher *m, const char *path, t_input_pool *pool);
+int				ft_matcher_finish(t_matcher *m);
+int				ft_match_name(const t_matcher *m, const char *name, size_t len);
+void			ft_matcher_free(t_matcher *m);
+
+/* FT_SERVE */
+int				ft_serve(const char *path, const t_options *opts);
+
+/* FT_WALK */
+int				ft_pathlist_add(t_pathlist *list, char *path);
+void			ft_pathlist_free(t_pathlist *list);
+int				ft_walk_dirs(char **dirs, size_t ndirs, t_pathlist *out);
+
+/* FT_ARGS */
+int				ft_expand_args(int argc, char **argv, t_pathlist *args, t_input_pool *pool);
+int				ft_read_file_list(const char *path, t_pathlist *out, t_input_pool *pool);
+
+/* FT_PREFETCH */
+void			ft_prefetch_init(t_prefetch *pf, char **paths, size_t count, int uring);
+const t_fetched	*ft_prefetch_take(t_prefetch *pf);
+void			ft_prefetch_close(t_prefetch *pf);
+
+/* FT_URING */
+struct s_uring	*ft_uring_init(uint64_t *syscalls);
+int				ft_uring_fetch(t_prefetch *pf);
+void			ft_uring_free(t_prefetch *pf);
+
+/* FT_OPTIONS */
+int				ft_parse_options(int argc, char **argv, t_options *opts, char ***files);
+void			ft_free_options(t_options *opts);
+
+/* FT_WRITER */
+void			ft_writer_init(t_writer *w, int fd);
+void			ft_writer_init_memory(t_writer *w);
+void			ft_writer_free_memory(t_writer *w);
+void			ft_writer_put(t_writer *w, const char *s, size_t n);
+void			ft_writer_putc(t_writer *w, char c);
+void			ft_writer_putstr(t_writer *w, const char *s);
+void			ft_writer_putnbr(t_writer *w, uint64_t n);
+void			ft_writer_flush(t_writer *w);
+
+/* FT_JSON */
+void			ft_json_escape(t_writer *w, const char *s, size_t len);
+void			ft_json_begin(t_nm *nm);
+void			ft_json_end(t_nm *nm);
+void			ft_print_symbols_json(const t_ftnm *handle, char *filename, t_nm *nm);
+void			ft_print_summary_json(char *filename, t_nm *nm);
+
+/* FT_INPUT */
+int				ft_input_open(t_input *in, int fd, t_input_pool *pool, int flags);
+void			ft_input_open_memory(t_input *in, const void *data, size_t size, t_input_pool *pool);
+void			*ft_input_range(t_input *in, uint64_t offset, uint64_t size);
+void			ft_input_release(t_input *in);
+void			ft_input_close(t_input *in);
+void			ft_input_pool_free(t_input_pool *pool);
+
+/* FT_SUMMARY */
+int				ft_summary_reset(t_summary *summary, size_t shnum);
+void			ft_summary_add(t_summary *summary, unsigned char type, unsigned char info, unsigned char other, uint16_t shndx, uint64_t size);
+void			ft_summary_free(t_summary *summary);
+
+/* FT_DIFF */
+int				ft_diff(t_ftnm *old, t_ftnm *new, char **names, t_nm *nm);
+
+/* FT_ADDR2SYM */
+int				ft_addr2sym(const t_ftnm *handle, const char *path, t_nm *nm);
+
+/* FT_DEDUP */
+int				ft_dedup_init(t_dedup *dd, char **inputs, size_t count, int content, uint64_t *syscalls);
+int				ft_dedup_replay(t_dedup *dd, size_t index, t_ftnm *handle, char *filename, t_nm *nm);
+void			ft_dedup_print(t_dedup *dd, size_t index, const t_ftnm *handle, char *filename, t_nm *nm);
+void			ft_dedup_done(t_dedup *dd, size_t index);
+void			ft_dedup_free(t_dedup *dd);
+
+/* FT_STATS */
+void			ft_stats_start(t_stats *stats);
+void			ft_stats_file_begin(t_stats *stats);
+void			ft_stats_file_end(t_stats *stats, const t_ftnm *handle, const t_fetched *file, char *filename);
+void			ft_stats_print(t_stats *stats);
 
 /* FT_CHECK */
-int				ft_check(int fd, char *filename, int multiple_files);
+int				ft_check(t_ftnm *handle, const t_ftnm_config *config);
 
-void			ft_nm32(void *map, char *filename, long unsigned int filesize, int multiple_files);
-void			ft_nm64(void *map, char *filename, long unsigned int filesize, int multiple_files);
+int				ft_nm32(t_ftnm *handle, const t_ftnm_config *config);
+int				ft_nm64(t_ftnm *handle, const t_ftnm_config *config);
 
 /* FT_DEFINE_SYMBOL */
 unsigned char	ft_define_symbol32(Elf32_Sym *symtab, Elf32_Shdr *o_shdr, int indian);
@@ -6,42 +6,343 @@
 /*   By: jbertin <jbertin@student.42.fr>            +#+  +:+       +#+        */
 /*                                                +#+#+#+#+#+   +#+           */
 /*   Created: 2023/08/09 13:56:58 by jbertin           #+#    #+#             */
-/*   Updated: 2023/08/09 15:24:25 by jbertin          ###   ########.fr       */
+/*   Updated: 2026/10/19 19:49:23 by jbertin          ###   ########.fr       */
 /*                                                                            */
 /* ************************************************************************** */
 
 #include "includes/nm.h"
 
 /**
- * Opens the file with the specified filename and checks its contents using the
- * ft_check function. If the file does not exist, it displays an error message.
+ * Writes a diagnostic, given in up to three parts, to a file descriptor.
+ * @param	fd	The file descriptor (standard output or standard error).
+ * @param	a	The first part.
+ * @param	b	The second part, or NULL.
+ * @param	c	The third part, or NULL.
+ */
+static void	put_error(int fd, const char *a, const char *b, const char *c)
+{
+	ft_putstr_fd((char *)a, fd);
+	if (b)
+		ft_putstr_fd((char *)b, fd);
+	if (c)
+		ft_putstr_fd((char *)c, fd);
+}
+
+/**
+ * Gives the file descriptor the diagnostics of the listing go to: standard
+ * output as nm, or standard error for the JSON formats, which would no
+ * longer parse with messages inside.
+ * @param	nm	The run context.
+ * @return	STDOUT_FILENO or STDERR_FILENO.
+ */
+static int	error_fd(const t_nm *nm)
+{
+	return ((nm->opts.format == FORMAT_BSD) ? STDOUT_FILENO : STDERR_FILENO);
+}
+
+/**
+ * Prints the message of an error of the library for a file, in the words of
+ * nm. Errors that stop before the ELF header is accepted fail the run, as
+ * does a failure to spill to a temporary file; the others only leave the file
+ * without a listing.
+ * @param	code		The FTNM_ERR_* code.
+ * @param	filename	The name of the file.
+ * @param	fd			The file descriptor to print to.
+ * @return	1 if the run fails, 0 otherwise.
+ */
+static int	report_error(int code, char *filename, int fd)
+{
+	if (code == FTNM_ERR_NOENT)
+		put_error(fd, "nm ", filename, ": No such file\n");
+	else if (code == FTNM_ERR_STAT)
+		put_error(fd, "nm: fstat error\n", NULL, NULL);
+	else if (code == FTNM_ERR_MAP)
+		put_error(fd, "nm: mmap error\n", NULL, NULL);
+	else if (code == FTNM_ERR_READ)
+		put_error(fd, "nm: ", filename, ": read error\n");
+	else if (code == FTNM_ERR_NO_SYMBOLS)
+		put_error(fd, "nm: ", filename, ": no symbols\n");
+	else if (code == FTNM_ERR_TEMP)
+	{
+		put_error(fd, "nm: ", filename, ": ");
+		put_error(fd, ftnm_strerror(code), "\n", NULL);
+	}
+	else if (code != FTNM_ERR_OPEN)
+	{
+		if (code == FTNM_ERR_TRUNCATED)
+			put_error(fd, "bfd plugin: ", filename, ": file too short\n");
+		else if (code == FTNM_ERR_MEMORY)
+			put_error(fd, "Error allocating memory\n", NULL, NULL);
+		put_error(fd, "nm: ", filename, ": file format not recognized\n");
+	}
+	return (code <= FTNM_ERR_FORMAT || code == FTNM_ERR_TEMP);
+}
+
+/**
+ * Reads the symbols of a file through the library, from the contents read
+ * ahead or from its already opened descriptor, sorts them and prints them.
+ * With --summary, the library only counts them and the counts are printed.
+ * A file identical to an earlier input (same inode, or same tables with
+ * --dedup-content) gets the listing of that input replayed instead.
  * @param	filename		The name of the file to process.
- * @param	multiple_files	An integer indicating if multiple files are being
- * 							processed. 1 for multiple files, 0 for a single file.
- * @return	Returns 1 if an error occurs, or the result of ft_check otherwise.
+ * @param	index			The index of the file among the inputs.
+ * @param	file			The file as prefetched.
+ * @param	nm				The run context (options and output writer).
+ * @return	Returns 1 if the file cannot be opened or is not an ELF file, 0
+ * 			otherwise.
+ */
+static int	process_file(char *filename, size_t index, const t_fetched *file, t_nm *nm)
+{
+	t_ftnm	*handle;
+	int		ret;
+
+	nm->stats.syscalls += file->syscalls;
+	if (file->data == NULL && file->fd < 0)
+		return (report_error((file->err == ENOENT) ? FTNM_ERR_NOENT : FTNM_ERR_OPEN, filename, error_fd(nm)));
+	if (ft_dedup_replay(&nm->dedup, index, NULL, filename, nm))
+		return (0);
+	if (nm->opts.stats)
+		ft_stats_file_begin(&nm->stats);
+	if (file->data)
+		ret = ftnm_open_memory(&handle, file->data, file->size, &nm->opts.config);
+	else
+		ret = ftnm_open_fd(&handle, file->fd, &nm->opts.config);
+	if (ret != FTNM_OK)
+		return (report_error(ret, filename, error_fd(nm)));
+
+	if (nm->opts.summary)
+		ft_print_summary(filename, nm);
+	else if (!ft_dedup_replay(&nm->dedup, index, handle, filename, nm))
+	{
+		if (ftnm_sort(handle) != FTNM_OK)
+			put_error(error_fd(nm), "Error allocating memory\n", NULL, NULL);
+		ft_dedup_print(&nm->dedup, index, handle, filename, nm);
+	}
+	if (nm->opts.stats)
+		ft_stats_file_end(&nm->stats, handle, file, filename);
+	ftnm_close(handle);
+	return (0);
+}
+
+/**
+ * Processes a list of files in order, the next ones being opened and read
+ * ahead while the current one is listed (in batches through io_uring with
+ * --io-uring). BSD listings of files given more than once are formatted
+ * once, unless the run reports per-file statistics or bounds its memory.
+ * @param	inputs	The paths of the files.
+ * @param	count	The number of files.
+ * @param	nm		The run context.
+ * @return	1 if any file failed, 0 otherwise.
+ */
+static int	process_files(char **inputs, size_t count, t_nm *nm)
+{
+	t_prefetch	pf;
+	int			ret = 0;
+
+	if (nm->opts.format == FORMAT_BSD && !nm->opts.summary && !nm->opts.stats
+		&& !nm->opts.config.max_memory)
+		ft_dedup_init(&nm->dedup, inputs, count, nm->opts.dedup_content, &nm->stats.syscalls);
+	ft_prefetch_init(&pf, inputs, count, nm->opts.uring);
+	for (size_t i = 0; i < count; i++)
+	{
+		const t_fetched	*file = ft_prefetch_take(&pf);
+
+		ret |= process_file(inputs[i], i, file, nm);
+		ft_dedup_done(&nm->dedup, i);
+		if (file->fd > STDIN_FILENO)
+			close(file->fd);
+	}
+	ft_dedup_free(&nm->dedup);
+	nm->stats.backend = pf.ring ? "io_uring" : "syscalls";
+	ft_prefetch_close(&pf);
+	nm->stats.syscalls += pf.syscalls;
+	return (ret);
+}
+
+/**
+ * Gathers the input files of the run: the files of the command line, then
+ * those of the --files-from lists, then the ELF files found under the -R
+ * directories, in path order. "a.out" is the default when none is given.
+ * @param	nm		The run context.
+ * @param	files	The files of the command line.
+ * @param	count	The number of files of the command line.
+ * @param	owned	The list owning the paths read from lists and directories.
+ * @param	inputs	Set to a malloc'ed array of the input files, borrowing
+ * 					their paths.
+ * @param	failed	Set to 1 if a list or a directory could not be read; the
+ * 					files found are still listed.
+ * @return	The number of input files, or -1 on error (message printed).
  */
-static int	process_file(char *filename, int multiple_files)
+static ssize_t	collect_inputs(t_nm *nm, char **files, size_t count, t_pathlist *owned, char ***inputs,
+	int *failed)
 {
-	int	fd;
-	int	ret;
+	static char	*fallback[] = {"a.out"};
+	int			ret = 0;
 
-	fd = open(filename, O_RDONLY);
-	if (fd < 0)
+	for (size_t i = 0; !ret && i < nm->opts.nfiles_from; i++)
+		ret = ft_read_file_list(nm->opts.files_from[i], owned, &nm->pool);
+	if (!ret && nm->opts.ndirs)
+		ret = ft_walk_dirs(nm->opts.dirs, nm->opts.ndirs, owned);
+	if (count == 0 && owned->count == 0 && nm->opts.ndirs == 0 && nm->opts.nfiles_from == 0)
 	{
-		if (errno == ENOENT)
-			ft_printf("nm %s: No such file\n", filename);
+		files = fallback;
+		count = 1;
+	}
+	*inputs = malloc(sizeof(char *) * (count + owned->count + 1));
+	if (*inputs == NULL)
+	{
+		ft_printf("Error allocating memory\n");
+		return (-1);
+	}
+	ft_memcpy(*inputs, files, sizeof(char *) * count);
+	ft_memcpy(*inputs + count, owned->paths, sizeof(char *) * owned->count);
+	count += owned->count;
+	nm->opts.multiple_files = (count > 1 || nm->opts.ndirs > 0);
+	*failed = ret;
+	return (count);
+}
+
+/**
+ * Compiles the --match and --match-file patterns into the matcher of the run.
+ * @param	nm	The run context.
+ * @return	0 on success, 1 on error.
+ */
+static int	build_matcher(t_nm *nm)
+{
+	int	ret = FTNM_OK;
+
+	for (size_t i = 0; ret == FTNM_OK && i < nm->opts.npatterns; i++)
+		ret = ft_matcher_add(&nm->matcher, nm->opts.patterns[i], ft_strlen(nm->opts.patterns[i]));
+	for (size_t i = 0; ret == FTNM_OK && i < nm->opts.npattern_files; i++)
+	{
+		ret = ft_matcher_load(&nm->matcher, nm->opts.pattern_files[i], &nm->pool);
+		if (ret == FTNM_ERR_NOENT || ret == FTNM_ERR_READ)
+		{
+			ft_printf("nm: %s: cannot read patterns\n", nm->opts.pattern_files[i]);
+			return (1);
+		}
+	}
+	if (ret == FTNM_OK)
+		ret = ft_matcher_finish(&nm->matcher);
+	if (ret == FTNM_ERR_PATTERN)
+		ft_printf("nm: pattern too long: globs take at most 63 characters\n");
+	else if (ret == FTNM_ERR_MEMORY)
+		ft_printf("Error allocating memory\n");
+	if (ret != FTNM_OK)
 		return (1);
+	if (nm->matcher.active)
+		nm->opts.config.matcher = &nm->matcher;
+	return (0);
+}
+
+/**
+ * Runs --diff: opens the two files given and reports the differences of
+ * their symbol tables. Each handle gets its own buffer pool, as both stay
+ * open together, and allocates on its own instead of from the arena.
+ * @param	nm		The run context.
+ * @param	files	The files of the command line.
+ * @param	count	The number of files of the command line.
+ * @return	0 if the tables match, 1 if they differ, 2 on error.
+ */
+static int	run_diff(t_nm *nm, char **files, ssize_t count)
+{
+	t_ftnm_config	config = nm->opts.config;
+	t_ftnm			*handles[2] = {NULL, NULL};
+	int				ret = 2;
+	int				code = FTNM_OK;
+
+	if (count != 2 || nm->opts.ndirs || nm->opts.nfiles_from)
+	{
+		ft_printf("nm: --diff takes exactly two files\n");
+		return (2);
+	}
+	config.pool = NULL;
+	config.summary = NULL;
+	config.max_memory = 0;
+	config.arena = NULL;
+	for (int i = 0; i < 2 && code == FTNM_OK; i++)
+	{
+		code = ftnm_open_path(&handles[i], files[i], &config);
+		if (code != FTNM_OK)
+			report_error(code, files[i], STDOUT_FILENO);
 	}
+	if (code == FTNM_OK)
+	{
+		ft_writer_init(&nm->out, nm->out_fd);
+		ret = ft_diff(handles[0], handles[1], files, nm);
+	}
+	ftnm_close(handles[0]);
+	ftnm_close(handles[1]);
+	return (ret);
+}
 
-	ret = ft_check(fd, filename, multiple_files);
-	close(fd);
+/**
+ * Runs --addr2sym: opens the binary given ("a.out" by default) and maps the
+ * addresses of the --addr2sym file to its symbols. The symbols are read
+ * whole, without a memory budget.
+ * @param	nm		The run context.
+ * @param	files	The files of the command line.
+ * @param	count	The number of files of the command line.
+ * @return	0 on success, 1 on error.
+ */
+static int	run_addr2sym(t_nm *nm, char **files, ssize_t count)
+{
+	t_ftnm_config	config = nm->opts.config;
+	t_ftnm			*handle;
+	char			*path = (count > 0) ? files[0] : "a.out";
+	int				code;
+	int				ret;
+
+	if (count > 1 || nm->opts.ndirs || nm->opts.nfiles_from)
+	{
+		ft_printf("nm: --addr2sym takes a single file\n");
+		return (1);
+	}
+	config.summary = NULL;
+	config.max_memory = 0;
+	config.line_numbers = 0;
+	code = ftnm_open_path(&handle, path, &config);
+	if (code != FTNM_OK)
+	{
+		report_error(code, path, STDERR_FILENO);
+		return (1);
+	}
+	ft_writer_init(&nm->out, nm->out_fd);
+	ret = ft_addr2sym(handle, nm->opts.addr2sym, nm);
+	ftnm_close(handle);
 	return (ret);
 }
 
+/**
+ * Opens the output file given with -o, created or truncated. It is opened for
+ * reading too, so that big listings can be mapped into it.
+ * @param	nm	The run context, its out_fd set (the standard output without
+ * 				-o).
+ * @return	0 on success, 1 if the file cannot be opened (message printed).
+ */
+static int	open_output(t_nm *nm)
+{
+	nm->out_fd = STDOUT_FILENO;
+	if (nm->opts.output == NULL)
+		return (0);
+	nm->out_fd = open(nm->opts.output, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (nm->out_fd < 0)
+	{
+		ft_printf("nm: %s: cannot open output file\n", nm->opts.output);
+		nm->out_fd = STDOUT_FILENO;
+		return (1);
+	}
+	return (0);
+}
+
 /**
  * Main function to process files passed as command line arguments.
- * If no file is provided, it processes the default "a.out" file.
- * If multiple files are provided, it processes each file in order.
+ * Response files ("@file") are expanded and options are parsed first; if no
+ * file is provided, it processes the default "a.out" file. Files are processed
+ * in order: the files of the command line, those read with --files-from, and
+ * the ELF files found in the directories given with -R, in path order. With
+ * --serve, the run becomes the query daemon instead, with --diff it
+ * compares two files and with --addr2sym it maps addresses to symbols.
  * @param	argc	The number of command line arguments.
  * @param	argv	The array of command line arguments.
  * @return	Returns 0 if all files are successfully processed, or 1 if an error
@@ -49,21 +350,62 @@ static int	process_file(char *filename, int multiple_files)
  */
 int	main(int argc, char **argv)
 {
-	int	ret = 0;
-	int	multiple_files = 0;
+	static t_nm	nm;
+	t_pathlist	args;
+	t_pathlist	owned;
+	char		**files = NULL;
+	char		**inputs = NULL;
+	ssize_t		count;
+	int			failed = 0;
+	int			ret = 1;
 
-	if (argc < 2)
+	ft_bzero(&owned, sizeof(owned));
+	if (ft_expand_args(argc, argv, &args, &nm.pool))
+		count = -1;
+	else
+		count = ft_parse_options(args.count, args.paths, &nm.opts, &files);
+	if (count >= 0 && nm.opts.config.collation == FTNM_COLLATE_LOCALE)
+		setlocale(LC_COLLATE, "");
+	if (count >= 0 && open_output(&nm))
+		count = -1;
+	if (count >= 0 && nm.opts.serve)
+		ret = ft_serve(nm.opts.serve, &nm.opts);
+	else if (count >= 0)
 	{
-		ret = process_file("a.out", multiple_files);
+		nm.opts.config.pool = &nm.pool;
+		nm.opts.config.arena = &nm.arena;
+		if (nm.opts.summary)
+			nm.opts.config.summary = &nm.summary;
+		if (build_matcher(&nm) != 0)
+			count = -1;
+		else if (nm.opts.diff)
+			ret = run_diff(&nm, files, count);
+		else if (nm.opts.addr2sym)
+			ret = run_addr2sym(&nm, files, count);
+		else
+			count = collect_inputs(&nm, files, count, &owned, &inputs, &failed);
 	}
-	else
+	if (count >= 0 && !nm.opts.serve && !nm.opts.diff && !nm.opts.addr2sym)
 	{
-		if (argc > 2)
-			multiple_files = 1;
-		for (int i = 1; i < argc; i++)
-		{
-			ret |= process_file(argv[i], multiple_files);
-		}
+		if (nm.opts.stats)
+			ft_stats_start(&nm.stats);
+		ft_writer_init(&nm.out, nm.out_fd);
+		ft_json_begin(&nm);
+		ret = process_files(inputs, count, &nm) | failed;
+		ft_json_end(&nm);
+		if (nm.opts.stats)
+			ft_stats_print(&nm.stats);
 	}
+	ft_input_pool_free(&nm.pool);
+	ft_pathlist_free(&owned);
+	ft_pathlist_free(&args);
+	ft_matcher_free(&nm.matcher);
+	ft_summary_free(&nm.summary);
+	ft_arena_free(&nm.arena);
+	if (nm.out_fd > STDOUT_FILENO)
+		close(nm.out_fd);
+	ft_free_options(&nm.opts);
+	free(inputs);
+	free(files);
 	return (ret);
 }